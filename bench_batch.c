@@ -0,0 +1,140 @@
+/*
+ * Throughput of srp_verifier_new_batch() for 1, 2, 4, ... worker threads.
+ *
+ *   cc -O2 -DSRP_PTHREAD bench_batch.c srp.c srp_pool.c -lmbedcrypto -lpthread
+ *   ./a.out [batch size] [max threads]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+
+#include "srp.h"
+
+
+#define TEST_HASH      SRP_SHA256
+#define TEST_NG        SRP_NG_2048
+#define NUSERS         16
+
+unsigned long long get_usec()
+{
+    struct timeval t;
+    gettimeofday(&t, NULL);
+    return (((unsigned long long)t.tv_sec) * 1000000) + t.tv_usec;
+}
+
+
+int main( int argc, char * argv[] )
+{
+    SRPSession    * session;
+    SRPUser       * users[NUSERS];
+    SRPBatchItem  * items;
+
+    const unsigned char * bytes_s[NUSERS];
+    const unsigned char * bytes_v[NUSERS];
+    const unsigned char * bytes_A[NUSERS];
+    const unsigned char * bytes_M = 0;
+    const unsigned char * bytes_HAMK = 0;
+    int len_s[NUSERS], len_v[NUSERS], len_A[NUSERS], len_M;
+
+    char username[NUSERS][16];
+    const char * password = "password";
+
+    int batch = argc > 1 ? atoi(argv[1]) : 256;
+    int max_threads = argc > 2 ? atoi(argv[2]) : (int) sysconf(_SC_NPROCESSORS_ONLN);
+    int nthreads, i, ok;
+    double base = 0;
+
+    if (batch <= 0 || max_threads <= 0)
+    {
+        printf("usage: %s [batch size] [max threads]\n", argv[0]);
+        return 1;
+    }
+
+    session = srp_session_new( TEST_HASH, TEST_NG, NULL, NULL );
+    if (!session) return 1;
+    srp_ng_precompute_g( srp_session_get_ng(session), 0, 0 );
+
+    for (i = 0; i < NUSERS; i++)
+    {
+        sprintf(username[i], "user%d", i);
+        srp_create_salted_verification_key( session, username[i],
+                    (const unsigned char *)password, strlen(password),
+                    &bytes_s[i], &len_s[i], &bytes_v[i], &len_v[i] );
+        users[i] = srp_user_new( session, username[i],
+                    (const unsigned char *)password, strlen(password) );
+        srp_user_start_authentication( users[i], NULL, &bytes_A[i], &len_A[i] );
+    }
+
+    items = (SRPBatchItem *) calloc( batch, sizeof(SRPBatchItem) );
+    if (!items) return 1;
+
+    printf("group %d, batch of %d handshakes\n", TEST_NG, batch);
+    printf("threads  handshakes/s  speedup\n");
+
+    for (nthreads = 1; ; nthreads *= 2)
+    {
+        SRPWorkerPool * pool;
+        unsigned long long start, duration;
+        double rate;
+
+        if (nthreads > max_threads) nthreads = max_threads;
+        pool = srp_worker_pool_new( nthreads );
+
+        for (i = 0; i < batch; i++)
+        {
+            int u = i % NUSERS;
+            items[i].username = username[u];
+            items[i].bytes_s = bytes_s[u]; items[i].len_s = len_s[u];
+            items[i].bytes_v = bytes_v[u]; items[i].len_v = len_v[u];
+            items[i].bytes_A = bytes_A[u]; items[i].len_A = len_A[u];
+        }
+
+        start = get_usec();
+        ok = srp_verifier_new_batch( session, pool, items, batch );
+        duration = get_usec() - start;
+
+        if (ok != batch)
+        {
+            printf("%d of %d handshakes failed\n", batch - ok, batch);
+            return 1;
+        }
+
+        /* spot check: the first user must be able to finish */
+        srp_user_process_challenge( users[0], bytes_s[0], len_s[0],
+                    items[0].bytes_B, items[0].len_B, &bytes_M, &len_M );
+        if ( !bytes_M || !srp_verifier_verify_session( items[0].ver, bytes_M, &bytes_HAMK ) )
+        {
+            printf("batch produced a bad handshake\n");
+            return 1;
+        }
+
+        rate = batch * 1e6 / (double) duration;
+        if (nthreads == 1) base = rate;
+        printf("%7d  %12.1f  %7.2f\n", srp_worker_pool_size(pool), rate, rate / base);
+
+        for (i = 0; i < batch; i++)
+        {
+            srp_verifier_delete( items[i].ver );
+            free( (void *) items[i].bytes_B );
+        }
+        memset( items, 0, batch * sizeof(SRPBatchItem) );
+        srp_worker_pool_delete( pool );
+
+        if (nthreads == max_threads) break;
+    }
+
+    for (i = 0; i < NUSERS; i++)
+    {
+        srp_user_delete( users[i] );
+        free( (char *)bytes_s[i] );
+        free( (char *)bytes_v[i] );
+        free( (char *)bytes_A[i] );
+    }
+    free( items );
+    srp_session_delete( session );
+
+    return 0;
+}
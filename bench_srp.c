@@ -0,0 +1,302 @@
+/*
+ * Per-phase latency of the SRP handshake for every group and hash.
+ *
+ *   cc -O2 bench_srp.c srp.c -lmbedcrypto
+ *   ./a.out [-n iterations] [-g bits|custom] [-a SHA1|...|SHA512] [-e bits] [-t] [-l label] [-o out.json]
+ *
+ * -e sets the size of the private exponents a and b (srp_session_set_exponent_bits(),
+ * the group's default otherwise).
+ * -t builds the fixed base table for g first (srp_ng_precompute_g()). With
+ * -o the results are also written as JSON, one object per group, hash and
+ * phase, so runs against different library versions can be compared.
+ * Percentiles are nearest rank: p999 needs 1000 iterations to be more than
+ * the maximum.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+
+#include "srp.h"
+
+
+#define DEFAULT_ITER   100
+
+enum {
+    PHASE_ENROLL,
+    PHASE_USER_START,
+    PHASE_KEYPAIR_NEW,
+    PHASE_VERIFIER_NEW,
+    PHASE_PROCESS_CHALLENGE,
+    PHASE_VERIFIER_VERIFY,
+    PHASE_USER_VERIFY,
+    PHASE_COUNT
+};
+
+static const char * phase_names[PHASE_COUNT] = {
+    "create_salted_verification_key",
+    "user_start_authentication",
+    "keypair_new",
+    "verifier_new1",
+    "user_process_challenge",
+    "verifier_verify_session",
+    "user_verify_session",
+};
+
+static const char * hash_names[SRP_SHA_LAST] = { "SHA1", "SHA224", "SHA256", "SHA384", "SHA512" };
+static const int    ng_bits[SRP_NG_LAST]     = { 512, 768, 1024, 2048, 3072, 4096, 8192, 0 };
+
+const char * test_n_hex = "EEAF0AB9ADB38DD69C33F80AFA8FC5E86072618775FF3C0B9EA2314C9C256576D674DF7496"
+   "EA81D3383B4813D692C6E0E0D5D8E250B98BE48E495C1D6089DAD15DC7D7B46154D6B6CE8E"
+   "F4AD69B15D4982559B297BCF1885C529F566660E57EC68EDBC3C05726CC02FD4CBF4976EAA"
+   "9AFD5138FE8376435B9FC61D2FC0EB06E3";
+const char * test_g_hex = "2";
+
+typedef struct PhaseStats {
+    double p50, p99, p999;      /* usec */
+    double ops;                 /* per second, from the mean */
+} PhaseStats;
+
+static unsigned long long get_nsec()
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return ((unsigned long long)t.tv_sec) * 1000000000ULL + t.tv_nsec;
+}
+
+static int cmp_ull( const void * a, const void * b )
+{
+    unsigned long long x = *(const unsigned long long *)a;
+    unsigned long long y = *(const unsigned long long *)b;
+    return x < y ? -1 : x > y;
+}
+
+/* nearest rank percentile of n sorted samples */
+static double percentile( const unsigned long long * t, int n, double p )
+{
+    int rank = (int)(p * n + 0.999999);
+    if (rank < 1) rank = 1;
+    if (rank > n) rank = n;
+    return t[rank - 1] / 1000.0;
+}
+
+static void phase_stats( unsigned long long * t, int n, PhaseStats * st )
+{
+    unsigned long long sum = 0;
+    int i;
+
+    qsort(t, n, sizeof(*t), cmp_ull);
+    for (i = 0; i < n; i++) sum += t[i];
+    st->p50  = percentile(t, n, 0.50);
+    st->p99  = percentile(t, n, 0.99);
+    st->p999 = percentile(t, n, 0.999);
+    st->ops  = sum ? n * 1e9 / (double) sum : 0;
+}
+
+/*
+ * Runs niter full handshakes, timing each phase. t holds PHASE_COUNT rows
+ * of niter samples. Returns 0 when every handshake authenticated.
+ */
+static int run( SRP_HashAlgorithm alg, SRP_NGType ng_type, int exp_bits, int table, int niter,
+                unsigned long long * t, int * used_bits )
+{
+    SRPSession  * session;
+    SRPKeyPair  * keys;
+    SRPVerifier * ver;
+    SRPUser     * usr;
+
+    const unsigned char * bytes_s = 0;
+    const unsigned char * bytes_v = 0;
+    const unsigned char * bytes_A = 0;
+    const unsigned char * bytes_B = 0;
+    const unsigned char * bytes_M    = 0;
+    const unsigned char * bytes_HAMK = 0;
+    int len_s, len_v, len_A, len_B, len_M;
+
+    const char * username = "testuser";
+    const char * password = "password";
+    const char * auth_username = 0;
+    unsigned long long t0;
+    int i, rc = 0;
+
+    session = ng_type == SRP_NG_CUSTOM
+            ? srp_session_new( alg, ng_type, test_n_hex, test_g_hex )
+            : srp_session_new( alg, ng_type, NULL, NULL );
+    if (!session) return -1;
+    if (srp_session_set_exponent_bits( session, exp_bits ) != 0)
+    {
+        srp_session_delete( session );
+        return -1;
+    }
+    *used_bits = srp_session_get_exponent_bits( session );
+    if (table) srp_ng_precompute_g( srp_session_get_ng(session), 0, 0 );
+
+    for (i = 0; i < niter && rc == 0; i++)
+    {
+        t0 = get_nsec();
+        srp_create_salted_verification_key( session, username,
+                    (const unsigned char *)password, strlen(password),
+                    &bytes_s, &len_s, &bytes_v, &len_v );
+        t[PHASE_ENROLL * niter + i] = get_nsec() - t0;
+
+        usr = srp_user_new( session, username, (const unsigned char *)password, strlen(password) );
+        t0 = get_nsec();
+        srp_user_start_authentication( usr, &auth_username, &bytes_A, &len_A );
+        t[PHASE_USER_START * niter + i] = get_nsec() - t0;
+
+        t0 = get_nsec();
+        keys = srp_keypair_new( session, bytes_v, len_v, &bytes_B, &len_B );
+        t[PHASE_KEYPAIR_NEW * niter + i] = get_nsec() - t0;
+
+        t0 = get_nsec();
+        ver = srp_verifier_new1( session, username, 0, bytes_s, len_s, bytes_v, len_v,
+                    bytes_A, len_A, NULL, NULL, keys );
+        t[PHASE_VERIFIER_NEW * niter + i] = get_nsec() - t0;
+
+        t0 = get_nsec();
+        srp_user_process_challenge( usr, bytes_s, len_s, bytes_B, len_B, &bytes_M, &len_M );
+        t[PHASE_PROCESS_CHALLENGE * niter + i] = get_nsec() - t0;
+
+        bytes_HAMK = 0;
+        t0 = get_nsec();
+        if (ver && bytes_M) srp_verifier_verify_session( ver, bytes_M, &bytes_HAMK );
+        t[PHASE_VERIFIER_VERIFY * niter + i] = get_nsec() - t0;
+
+        t0 = get_nsec();
+        if (bytes_HAMK) srp_user_verify_session( usr, bytes_HAMK );
+        t[PHASE_USER_VERIFY * niter + i] = get_nsec() - t0;
+
+        if ( !keys || !ver || !bytes_HAMK || !srp_user_is_authenticated(usr) ) rc = -1;
+
+        srp_verifier_delete( ver );
+        srp_keypair_delete( keys );
+        srp_user_delete( usr );
+        free( (char *)bytes_s );
+        free( (char *)bytes_v );
+        free( (char *)bytes_A );
+        free( (char *)bytes_B );
+    }
+
+    srp_session_delete( session );
+    return rc;
+}
+
+/* s as a JSON string: quotes, backslashes and control characters escaped */
+static void put_json_string( FILE * f, const char * s )
+{
+    putc('"', f);
+    for (; *s; s++)
+    {
+        unsigned char c = (unsigned char) *s;
+
+        if (c == '"' || c == '\\') fprintf(f, "\\%c", c);
+        else if (c < 0x20) fprintf(f, "\\u%04x", c);
+        else putc(c, f);
+    }
+    putc('"', f);
+}
+
+static void usage( const char * prog )
+{
+    printf("usage: %s [-n iterations] [-g bits|custom] [-a SHA1|...|SHA512] [-e bits] [-t] [-l label] [-o out.json]\n", prog);
+}
+
+int main( int argc, char * argv[] )
+{
+    unsigned long long * t;
+    PhaseStats st;
+    FILE * json = NULL;
+    const char * label = "";
+    int niter = DEFAULT_ITER, only_ng = -1, only_alg = -1, table = 0, exp_bits = 0, used_bits = 0;
+    int first = 1, failed = 0, opt, ng, alg, p;
+
+    while ((opt = getopt(argc, argv, "n:g:a:e:tl:o:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'n': niter = atoi(optarg); break;
+        case 'g':
+            for (ng = 0; ng < SRP_NG_CUSTOM && ng_bits[ng] != atoi(optarg); ng++) ;
+            if (ng == SRP_NG_CUSTOM && strcmp(optarg, "custom") != 0) { usage(argv[0]); return 1; }
+            only_ng = ng;
+            break;
+        case 'a':
+            for (alg = 0; alg < SRP_SHA_LAST && strcmp(optarg, hash_names[alg]) != 0; alg++) ;
+            if (alg == SRP_SHA_LAST) { usage(argv[0]); return 1; }
+            only_alg = alg;
+            break;
+        case 'e': exp_bits = atoi(optarg); break;
+        case 't': table = 1; break;
+        case 'l': label = optarg; break;
+        case 'o':
+            json = fopen(optarg, "w");
+            if (!json) { perror(optarg); return 1; }
+            break;
+        default: usage(argv[0]); return 1;
+        }
+    }
+    if (niter <= 0) { usage(argv[0]); return 1; }
+
+    t = (unsigned long long *) malloc( PHASE_COUNT * niter * sizeof(*t) );
+    if (!t) return 1;
+
+    if (json)
+    {
+        fputs("{\n  \"label\": ", json);
+        put_json_string(json, label);
+        fprintf(json, ",\n  \"iterations\": %d,\n  \"fixed_base_table\": %s,\n  \"results\": [",
+                niter, table ? "true" : "false");
+    }
+
+    printf("%-6s %-6s %-4s %-32s %10s %10s %10s %10s\n", "group", "hash", "exp", "phase", "p50 us", "p99 us", "p999 us", "ops/s");
+    for (ng = 0; ng < SRP_NG_LAST; ng++)
+    {
+        /* the custom group is the 1024 bit one from RFC 5054, passed as hex */
+        const char * gname = "custom";
+        char gbuf[16];
+
+        if (only_ng >= 0 && ng != only_ng) continue;
+        if (ng != SRP_NG_CUSTOM)
+        {
+            sprintf(gbuf, "%d", ng_bits[ng]);
+            gname = gbuf;
+        }
+
+        for (alg = 0; alg < SRP_SHA_LAST; alg++)
+        {
+            if (only_alg >= 0 && alg != only_alg) continue;
+
+            if (run( (SRP_HashAlgorithm) alg, (SRP_NGType) ng, exp_bits, table, niter, t, &used_bits ) != 0)
+            {
+                printf("%-6s %-6s handshake failed\n", gname, hash_names[alg]);
+                failed = 1;
+                continue;
+            }
+            for (p = 0; p < PHASE_COUNT; p++)
+            {
+                phase_stats( t + p * niter, niter, &st );
+                printf("%-6s %-6s %-4d %-32s %10.1f %10.1f %10.1f %10.1f\n", gname, hash_names[alg],
+                       used_bits, phase_names[p], st.p50, st.p99, st.p999, st.ops);
+                if (json)
+                {
+                    fprintf(json, "%s\n    {\"group\": \"%s\", \"hash\": \"%s\", \"hash_backend\": \"%s\", \"exp_bits\": %d, \"phase\": \"%s\", "
+                                  "\"p50_us\": %.3f, \"p99_us\": %.3f, \"p999_us\": %.3f, \"ops_per_sec\": %.1f}",
+                            first ? "" : ",", gname, hash_names[alg], srp_hash_backend( (SRP_HashAlgorithm) alg ), used_bits, phase_names[p],
+                            st.p50, st.p99, st.p999, st.ops);
+                    first = 0;
+                }
+            }
+            fflush(stdout);
+        }
+    }
+
+    if (json)
+    {
+        fprintf(json, "\n  ]\n}\n");
+        fclose(json);
+    }
+    free(t);
+    return failed;
+}
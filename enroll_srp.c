@@ -0,0 +1,177 @@
+/*
+ * Bulk enrollment: salts and verifiers for many accounts, on all cores.
+ *
+ *   cc -O2 -DSRP_PTHREAD enroll_srp.c srp.c srp_pool.c srp_enroll.c srp_store.c srp_precomp.c srp_hash.c \
+ *      -lmbedcrypto -lpthread
+ *   ./a.out [-g bits] [-a SHA1|...|SHA512] [-t threads] [-s salt bytes] [-T table file]
+ *           [-f csv|store] [-o out] [-q] [in]
+ *
+ * Reads "username,password" lines from in, or stdin. -f csv (the default)
+ * writes "username,salt,verifier" lines in hex to out, or stdout; -f store
+ * writes a verifier store (srp_store.h) and needs -o. -t defaults to one
+ * thread per online CPU. -T maps the table for g from a file written by
+ * srp_ng_save_tables() instead of building it. Progress and the final
+ * throughput go to stderr, -q leaves out the progress.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+#include "srp.h"
+#include "srp_enroll.h"
+#include "srp_precomp.h"
+#include "srp_store.h"
+
+
+static const char * hash_names[SRP_SHA_LAST] = { "SHA1", "SHA224", "SHA256", "SHA384", "SHA512" };
+static const int    ng_bits[SRP_NG_LAST]     = { 512, 768, 1024, 2048, 3072, 4096, 8192, 0 };
+
+typedef struct Output {
+    FILE              * csv;
+    SRPStoreWriter    * store;
+    SRP_NGType          ng;
+    SRP_HashAlgorithm   alg;
+} Output;
+
+static void put_hex( FILE * f, const unsigned char * p, int len )
+{
+    static const char digits[] = "0123456789abcdef";
+    int i;
+
+    for (i = 0; i < len; i++)
+    {
+        putc(digits[p[i] >> 4], f);
+        putc(digits[p[i] & 15], f);
+    }
+}
+
+static int write_record( void * ctx, const char * username,
+                         const unsigned char * bytes_s, int len_s,
+                         const unsigned char * bytes_v, int len_v )
+{
+    Output * out = (Output *) ctx;
+
+    if (out->store)
+        return srp_store_writer_add( out->store, username, out->ng, out->alg, bytes_s, len_s, bytes_v, len_v );
+
+    fputs(username, out->csv);
+    putc(',', out->csv);
+    put_hex(out->csv, bytes_s, len_s);
+    putc(',', out->csv);
+    put_hex(out->csv, bytes_v, len_v);
+    putc('\n', out->csv);
+    return ferror(out->csv) ? -1 : 0;
+}
+
+/* at most one line a second */
+static void show_progress( void * ctx, const SRPEnrollStats * st )
+{
+    double * next = (double *) ctx;
+
+    if (st->seconds < *next) return;
+    *next = st->seconds + 1;
+    fprintf(stderr, "\r%llu enrolled, %llu failed, %.0f/s ", st->enrolled, st->failed,
+            st->enrolled / st->seconds);
+}
+
+static void usage( const char * prog )
+{
+    fprintf(stderr, "usage: %s [-g bits] [-a SHA1|...|SHA512] [-t threads] [-s salt bytes] [-T table file]"
+                    " [-f csv|store] [-o out] [-q] [in]\n", prog);
+}
+
+int main( int argc, char * argv[] )
+{
+    SRPSession     * session;
+    SRPWorkerPool  * pool;
+    SRPEnrollLines * lines;
+    SRPEnrollStats   st;
+    Output           out;
+    FILE           * in = stdin;
+    const char     * out_path = NULL;
+    const char     * table_path = NULL;
+    double           next = 1;
+    int              ng = SRP_NG_2048, alg = SRP_SHA256, nthreads = 0, len_s = 0;
+    int              store = 0, quiet = 0, opt, rc;
+
+    while ((opt = getopt(argc, argv, "g:a:t:s:T:f:o:q")) != -1)
+    {
+        switch (opt)
+        {
+        case 'g':
+            for (ng = 0; ng < SRP_NG_CUSTOM && ng_bits[ng] != atoi(optarg); ng++) ;
+            if (ng == SRP_NG_CUSTOM) { usage(argv[0]); return 1; }
+            break;
+        case 'a':
+            for (alg = 0; alg < SRP_SHA_LAST && strcmp(optarg, hash_names[alg]) != 0; alg++) ;
+            if (alg == SRP_SHA_LAST) { usage(argv[0]); return 1; }
+            break;
+        case 't': nthreads = atoi(optarg); break;
+        case 's': len_s = atoi(optarg); break;
+        case 'T': table_path = optarg; break;
+        case 'f':
+            if (strcmp(optarg, "store") == 0) store = 1;
+            else if (strcmp(optarg, "csv") != 0) { usage(argv[0]); return 1; }
+            break;
+        case 'o': out_path = optarg; break;
+        case 'q': quiet = 1; break;
+        default: usage(argv[0]); return 1;
+        }
+    }
+    if (optind < argc - 1 || (store && !out_path) || len_s < 0 || len_s > 0xffff)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+    if (optind < argc && strcmp(argv[optind], "-") != 0)
+    {
+        in = fopen(argv[optind], "r");
+        if (!in) { perror(argv[optind]); return 1; }
+    }
+
+    memset(&out, 0, sizeof(out));
+    out.ng = (SRP_NGType) ng;
+    out.alg = (SRP_HashAlgorithm) alg;
+    if (store)
+    {
+        out.store = srp_store_writer_open( out_path );
+        if (!out.store) { perror(out_path); return 1; }
+    }
+    else
+    {
+        out.csv = out_path ? fopen(out_path, "w") : stdout;
+        if (!out.csv) { perror(out_path); return 1; }
+    }
+
+    session = srp_session_new( out.alg, out.ng, NULL, NULL );
+    pool = srp_worker_pool_new( nthreads );
+    lines = (SRPEnrollLines *) malloc( sizeof(SRPEnrollLines) );
+    if (!session || !pool || !lines) return 1;
+    srp_enroll_lines_init( lines, in );
+
+    if (table_path && srp_ng_load_tables( srp_session_get_ng(session), table_path ) != 0)
+    {
+        fprintf(stderr, "%s: not a table for this group\n", table_path);
+        return 1;
+    }
+
+    rc = srp_enroll( session, pool, len_s, srp_enroll_read_line, lines, write_record, &out,
+                     quiet ? NULL : show_progress, &next, &st );
+
+    if (out.store && srp_store_writer_close( out.store ) != 0) rc = -1;
+    if (out.csv && fclose(out.csv) != 0) rc = -1;
+
+    fprintf(stderr, "%s%llu enrolled, %llu failed, %llu lines skipped in %.2f s, %.0f/s on %d threads (group %d, %s)\n",
+            quiet ? "" : "\r", st.enrolled, st.failed, lines->skipped, st.seconds,
+            st.seconds > 0 ? st.enrolled / st.seconds : 0.0, srp_worker_pool_size(pool),
+            ng_bits[ng], hash_names[alg]);
+    if (rc != 0) fprintf(stderr, "stopped at line %llu: read or write error\n", lines->line);
+
+    if (in != stdin) fclose(in);
+    free(lines);
+    srp_worker_pool_delete( pool );
+    srp_session_delete( session );
+    return rc != 0 || st.failed != 0;
+}
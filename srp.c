@@ -40,6 +40,7 @@
 
 #include <time.h>
 
+#include <limits.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -54,401 +55,2065 @@
 #include "srp.h"
 #include "srp_internal.h"
 
+#if defined(__GNUC__) && defined(__x86_64__)
+#define SRP_MONT_ADX
+#include <cpuid.h>
+#endif
+
 #ifdef SRP_TEST
 #include "srp_test_config.h"
 #include "tutils.h"
 #endif
 
-static int g_initialized = 0;
-static mbedtls_entropy_context entropy_ctx;
-static mbedtls_ctr_drbg_context ctr_drbg_ctx;
-static mbedtls_mpi * RR;
+#if defined(MBEDTLS_PLATFORM_MEMORY) && !defined(MBEDTLS_PLATFORM_CALLOC_MACRO) && !defined(MBEDTLS_PLATFORM_FREE_MACRO)
+#include "mbedtls/platform.h"
+#define SRP_HOOK_MBEDTLS
+#endif
+
+/*
+ * Every thread gets its own CTR-DRBG, seeded from the shared entropy context
+ * on first use, so threads never contend on the generator. srp_set_rng() and
+ * srp_set_thread_rng() replace it with a caller supplied generator.
+ */
+typedef struct SRPRandom {
+	mbedtls_ctr_drbg_context  drbg;
+	int                       seeded;
+	srp_rng_func              f_rng;    /* srp_set_thread_rng() */
+	void                    * p_rng;
+} SRPRandom;
+
+static int g_initialized = 0;
+static mbedtls_entropy_context entropy_ctx;
+static unsigned char g_pers[128];
+static size_t g_pers_len = 0;
+static srp_rng_func g_f_rng = NULL;
+static void * g_p_rng = NULL;
+
+/* live groups, see srp_ng_new() */
+static NGConstant *g_groups = NULL;
+
+#ifdef SRP_PTHREAD
+static pthread_mutex_t g_groups_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t g_random_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t g_entropy_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t g_random_key;
+#else
+static SRPRandom g_random;
+#endif
+
+#define SRP_DEFAULT_SALT_BYTES 32
+
+
+/*
+ * Big endian bytes of a number that goes into a hash. Numbers that came off
+ * the wire are hashed straight from the caller's buffer; the others are
+ * written out once per handshake into a buffer of the caller, or into a
+ * temporary for groups larger than the built-in ones.
+ */
+typedef struct HashNum {
+    const unsigned char * p;
+    size_t                len;    /* without leading zeros, like mbedtls_mpi_size() */
+    unsigned char       * tmp;
+} HashNum;
+
+static int hn_mpi( HashNum *h, const mbedtls_mpi *X, unsigned char *buf, size_t size );
+static void hn_free( HashNum *h );
+static int H_nn( SRP_HashAlgorithm alg, mbedtls_mpi * r, const HashNum * n1, const HashNum * n2, int do_pad );
+static void hash_num( SRP_HashAlgorithm alg, const HashNum * n, unsigned char * dest );
+static int hash_length( SRP_HashAlgorithm alg );
+static void ng_precomp_init( NGConstant *ng );
+static NGConstant * ng_build( SRP_NGType ng_type, const char * n_hex, const char * g_hex );
+static int ng_default_exp_bits( const NGConstant *ng );
+static void ng_precomp_free( NGConstant *ng );
+static NGPrecomp * ng_precomp_build( NGConstant *ng, SRP_HashAlgorithm alg );
+static void fixed_base_release( SRPFixedBase *fb );
+static SRPMont * mont_new( const mbedtls_mpi *N );
+static SRPMont * mont_new_builtin( const NGBuiltin *b );
+static void mont_free( SRPMont *m );
+static int srp_atomic_add( int *p, int d );
+static int srp_atomic_get( const int *p );
+static void srp_atomic_set( int *p, int v );
+static void * srp_atomic_get_ptr( void * const *p );
+static void * srp_atomic_xchg_ptr( void **p, void *v );
+static void ng_lock( NGConstant *ng );
+static void ng_unlock( NGConstant *ng );
+static SRPMont * ng_mont( const NGConstant *ng );
+static SRPMont * ng_mont_make_locked( NGConstant *ng );
+#ifdef SRP_PTHREAD
+static void random_thread_free( void *p );
+#endif
+static void user_init( SRPUser *usr, SRP_HashAlgorithm hash_alg, NGConstant *ng );
+
+
+/***********************************************************************************************************
+ *
+ *  Memory
+ *
+ ***********************************************************************************************************/
+
+/*
+ * srp_malloc()/srp_free() serve everything that outlives a call.
+ * srp_tmp_calloc()/srp_tmp_free() serve temporaries: while
+ * srp_verifier_init() or srp_user_process_challenge() runs they come from
+ * the arena bound to the calling thread, if any. mbedtls allocates through
+ * the latter when built with MBEDTLS_PLATFORM_MEMORY.
+ */
+struct SRPArena {
+	unsigned char   *base;
+	size_t          size;
+	size_t          used;
+	size_t          peak;
+	int             depth;      /* arena_enter() nesting, allocate only when > 0 */
+};
+
+#define SRP_ARENA_ALIGN 16
+
+static srp_calloc_func g_calloc = calloc;
+static srp_free_func g_free = free;
+
+#ifdef SRP_PTHREAD
+static pthread_once_t g_arena_once = PTHREAD_ONCE_INIT;
+static pthread_key_t g_arena_key;
+
+static void arena_key_create()
+{
+	pthread_key_create(&g_arena_key, NULL);
+}
+#else
+static SRPArena *g_arena = NULL;
+#endif
+
+static SRPArena * arena_current()
+{
+#ifdef SRP_PTHREAD
+	pthread_once(&g_arena_once, arena_key_create);
+	return (SRPArena *) pthread_getspecific(g_arena_key);
+#else
+	return g_arena;
+#endif
+}
+
+static void hook_mbedtls()
+{
+#ifdef SRP_HOOK_MBEDTLS
+	mbedtls_platform_set_calloc_free(srp_tmp_calloc, srp_tmp_free);
+#endif
+}
+
+void * srp_malloc( size_t size )
+{
+	SRP_STAT_ADD(allocs, 1);
+	return g_calloc(1, size);
+}
+
+void srp_free( void *p )
+{
+	if (p) g_free(p);
+}
+
+void * srp_tmp_calloc( size_t n, size_t size )
+{
+	SRPArena *a = arena_current();
+	size_t len;
+
+	SRP_STAT_ADD(allocs, 1);
+	if (a && a->depth > 0 && n && size && n <= ((size_t)-1 - SRP_ARENA_ALIGN) / size) {
+		len = (n * size + SRP_ARENA_ALIGN - 1) & ~(size_t)(SRP_ARENA_ALIGN - 1);
+		if (len <= a->size - a->used) {
+			/* already zero, arena_leave() wipes what was used */
+			void *p = a->base + a->used;
+			a->used += len;
+			if (a->used > a->peak) a->peak = a->used;
+			return p;
+		}
+	}
+	return g_calloc(n, size);
+}
+
+void srp_tmp_free( void *p )
+{
+	SRPArena *a;
+
+	if (!p) return;
+	a = arena_current();
+	if (a && (unsigned char *)p >= a->base && (unsigned char *)p < a->base + a->size) return;
+	g_free(p);
+}
+
+/* start taking temporaries of the calling thread from its arena */
+static SRPArena * arena_enter()
+{
+	SRPArena *a = arena_current();
+	if (a) a->depth++;
+	return a;
+}
+
+/* the outermost leave releases everything taken since the first enter */
+static void arena_leave( SRPArena *a )
+{
+	if (!a || --a->depth > 0) return;
+	memset(a->base, 0, a->used);
+	a->used = 0;
+}
+
+/* X = Y with X meant to outlive the arena scope */
+static int mpi_copy_out( SRPArena *a, mbedtls_mpi *X, const mbedtls_mpi *Y )
+{
+	int rc, depth = 0;
+	if (a) {
+		depth = a->depth;
+		a->depth = 0;
+	}
+	rc = mbedtls_mpi_copy(X, Y);
+	if (a) a->depth = depth;
+	return rc;
+}
+
+void srp_set_allocator( srp_calloc_func f_calloc, srp_free_func f_free )
+{
+	if (!f_calloc || !f_free) {
+		f_calloc = calloc;
+		f_free = free;
+	}
+	g_calloc = f_calloc;
+	g_free = f_free;
+	hook_mbedtls();
+}
+
+SRPArena * srp_arena_new( size_t size )
+{
+	SRPArena *a;
+
+	size = (size + SRP_ARENA_ALIGN - 1) & ~(size_t)(SRP_ARENA_ALIGN - 1);
+	a = (SRPArena *) srp_malloc(sizeof(SRPArena) + size + SRP_ARENA_ALIGN);
+	if (!a) return NULL;
+	memset(a, 0, sizeof(SRPArena));
+	a->base = (unsigned char *)(((size_t)(a + 1) + SRP_ARENA_ALIGN - 1) & ~(size_t)(SRP_ARENA_ALIGN - 1));
+	a->size = size;
+	return a;
+}
+
+void srp_arena_delete( SRPArena *a )
+{
+	if (!a) return;
+	if (arena_current()==a) srp_arena_bind(NULL);
+	srp_free(a);
+}
+
+void srp_arena_bind( SRPArena *a )
+{
+	hook_mbedtls();
+#ifdef SRP_PTHREAD
+	pthread_once(&g_arena_once, arena_key_create);
+	pthread_setspecific(g_arena_key, a);
+#else
+	g_arena = a;
+#endif
+}
+
+size_t srp_arena_peak( SRPArena *a )
+{
+	return a ? a->peak : 0;
+}
+
+
+/***********************************************************************************************************
+ *
+ *  Instrumentation
+ *
+ ***********************************************************************************************************/
+
+#ifdef SRP_STATS
+/*
+ * One block per thread that ever counted something, on a list the snapshot
+ * walks. A thread's counters are folded into g_stats_retired when it exits.
+ * The blocks come straight from calloc: they live as long as their thread,
+ * not as long as any call, and must not count themselves as allocations.
+ */
+typedef struct SRPStatsBlock {
+	SRPStats                s;
+	struct SRPStatsBlock    *prev;
+	struct SRPStatsBlock    *next;
+} SRPStatsBlock;
+
+static srp_phase_func g_phase_begin = NULL;
+static srp_phase_func g_phase_end = NULL;
+static void * g_phase_ctx = NULL;
+
+#define SRP_STATS_WORDS (sizeof(SRPStats) / sizeof(unsigned long long))
+
+#ifdef SRP_PTHREAD
+static pthread_mutex_t g_stats_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t g_stats_once = PTHREAD_ONCE_INIT;
+static pthread_key_t g_stats_key;
+static __thread SRPStatsBlock *t_stats = NULL;
+static SRPStatsBlock *g_stats_list = NULL;
+static SRPStats g_stats_retired;
+
+static void stats_thread_exit( void *p )
+{
+	SRPStatsBlock *b = (SRPStatsBlock *) p;
+	unsigned long long *from = (unsigned long long *) &b->s;
+	unsigned long long *to = (unsigned long long *) &g_stats_retired;
+	size_t i;
+
+	pthread_mutex_lock(&g_stats_lock);
+	for (i=0; i<SRP_STATS_WORDS; i++) to[i] += from[i];
+	if (b->prev) b->prev->next = b->next;
+	else g_stats_list = b->next;
+	if (b->next) b->next->prev = b->prev;
+	pthread_mutex_unlock(&g_stats_lock);
+	t_stats = NULL;
+	free(b);
+}
+
+static void stats_key_create()
+{
+	pthread_key_create(&g_stats_key, stats_thread_exit);
+}
+
+static SRPStatsBlock g_stats_fallback;  /* when calloc fails, shared and racy but harmless */
+
+SRPStats * srp_stats_thread( void )
+{
+	SRPStatsBlock *b = t_stats;
+
+	if (b) return &b->s;
+	b = (SRPStatsBlock *) calloc(1, sizeof(SRPStatsBlock));
+	if (!b) return &g_stats_fallback.s;
+	pthread_once(&g_stats_once, stats_key_create);
+	pthread_mutex_lock(&g_stats_lock);
+	b->next = g_stats_list;
+	if (g_stats_list) g_stats_list->prev = b;
+	g_stats_list = b;
+	pthread_mutex_unlock(&g_stats_lock);
+	pthread_setspecific(g_stats_key, b);
+	t_stats = b;
+	return &b->s;
+}
+#else
+static SRPStatsBlock g_stats_block;
+
+SRPStats * srp_stats_thread( void )
+{
+	return &g_stats_block.s;
+}
+#endif
+
+/* index into SRPStats.exp for the size of N */
+int srp_stats_slot( const NGConstant *ng )
+{
+	switch (mbedtls_mpi_bitlen(ng->N))
+	{
+		case 512:  return SRP_NG_512;
+		case 768:  return SRP_NG_768;
+		case 1024: return SRP_NG_1024;
+		case 2048: return SRP_NG_2048;
+		case 3072: return SRP_NG_3072;
+		case 4096: return SRP_NG_4096;
+		case 8192: return SRP_NG_8192;
+		default:   return SRP_NG_CUSTOM;
+	}
+}
+
+void srp_phase_begin( SRP_Phase phase )
+{
+	if (g_phase_begin) g_phase_begin(g_phase_ctx, phase);
+}
+
+void srp_phase_end( SRP_Phase phase )
+{
+	SRP_STAT_ADD(phases[phase], 1);
+	if (g_phase_end) g_phase_end(g_phase_ctx, phase);
+}
+#endif
+
+int srp_set_phase_hooks( srp_phase_func begin, srp_phase_func end, void * ctx )
+{
+#ifdef SRP_STATS
+	g_phase_begin = begin;
+	g_phase_end = end;
+	g_phase_ctx = ctx;
+	return 0;
+#else
+	(void) begin; (void) end; (void) ctx;
+	return -1;
+#endif
+}
+
+void srp_stats_snapshot( SRPStats * stats )
+{
+#ifdef SRP_STATS
+	unsigned long long *to = (unsigned long long *) stats;
+	const unsigned long long *from;
+	size_t i;
+
+	memset(stats, 0, sizeof(SRPStats));
+#ifdef SRP_PTHREAD
+	{
+		SRPStatsBlock *b;
+		/* the lock only keeps the list still, the counters are read while they move */
+		pthread_mutex_lock(&g_stats_lock);
+		memcpy(stats, &g_stats_retired, sizeof(SRPStats));
+		for (b=g_stats_list; b; b=b->next) {
+			from = (const unsigned long long *) &b->s;
+			for (i=0; i<SRP_STATS_WORDS; i++) to[i] += __atomic_load_n(&from[i], __ATOMIC_RELAXED);
+		}
+		pthread_mutex_unlock(&g_stats_lock);
+		from = (const unsigned long long *) &g_stats_fallback.s;
+	}
+#else
+	from = (const unsigned long long *) &g_stats_block.s;
+#endif
+	for (i=0; i<SRP_STATS_WORDS; i++) to[i] += __atomic_load_n(&from[i], __ATOMIC_RELAXED);
+#else
+	memset(stats, 0, sizeof(SRPStats));
+#endif
+}
+
+
+
+
+
+/*
+ * The groups of RFC 5054, Appendix A, with their Montgomery constants. The
+ * hex strings live in gen_groups.c, which writes srp_groups.h.
+ */
+#include "srp_groups.h"
+
+
+/*
+ * Groups are interned: srp_ng_new() hands out another reference to a live
+ * group with the same N and g instead of building a new one, and
+ * srp_ng_new1() only takes a reference. An entry leaves g_groups with its
+ * last reference; a lookup never revives one that already dropped to zero.
+ */
+static void groups_lock( void )
+{
+#ifdef SRP_PTHREAD
+	pthread_mutex_lock(&g_groups_lock);
+#endif
+}
+
+static void groups_unlock( void )
+{
+#ifdef SRP_PTHREAD
+	pthread_mutex_unlock(&g_groups_lock);
+#endif
+}
+
+/* refs+1 unless ng is already on its way out */
+static int ng_ref_live( NGConstant *ng )
+{
+#if defined(__GNUC__)
+	int r = __atomic_load_n(&ng->refs, __ATOMIC_RELAXED);
+	while (r > 0) {
+		if (__atomic_compare_exchange_n(&ng->refs, &r, r + 1, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+			return 1;
+	}
+	return 0;
+#else
+	if (ng->refs <= 0) return 0;
+	ng->refs++;
+	return 1;
+#endif
+}
+
+static void ng_destroy( NGConstant *ng )
+{
+	mbedtls_mpi_free( ng->N );
+	mbedtls_mpi_free( ng->g );
+	ng_precomp_free(ng);
+	srp_free(ng->N);
+	srp_free(ng->g);
+	srp_free(ng);
+}
+
+/* N, g, R^2 mod N and the SRPMont of a built-in group, copied from srp_groups.h */
+static int ng_builtin_load( NGConstant *ng, const NGBuiltin *b )
+{
+	if (mbedtls_mpi_grow(ng->N, b->limbs)!=0 || mbedtls_mpi_grow(&ng->RR, b->limbs)!=0) return -1;
+	memcpy(ng->N->p, b->N, b->limbs * sizeof(mbedtls_mpi_uint));
+	memcpy(ng->RR.p, b->RR, b->limbs * sizeof(mbedtls_mpi_uint));
+	if (mbedtls_mpi_lset(ng->g, b->g)!=0) return -1;
+	/* optional, ng_precomp_build() tries again */
+	ng->mont = mont_new_builtin(b);
+	return 0;
+}
+
+NGConstant * srp_ng_new( SRP_NGType ng_type, const char * n_hex, const char * g_hex )
+{
+	NGConstant *ng, *it;
+
+	if ((unsigned)ng_type>=(unsigned)SRP_NG_LAST) return NULL;
+
+	if ( ng_type != SRP_NG_CUSTOM )
+	{
+		/* built-in groups are found by type, without parsing anything */
+		groups_lock();
+		for (it=g_groups; it; it=it->next)
+			if (it->type==ng_type && ng_ref_live(it)) break;
+		groups_unlock();
+		if (it) return it;
+	}
+
+	ng = ng_build(ng_type, n_hex, g_hex);
+	if (!ng) return NULL;
+
+	/* someone may have registered the same group meanwhile, or as a custom one */
+	groups_lock();
+	for (it=g_groups; it; it=it->next) {
+		if (mbedtls_mpi_cmp_mpi(it->N, ng->N)==0 && mbedtls_mpi_cmp_mpi(it->g, ng->g)==0 && ng_ref_live(it)) {
+			if (it->type==SRP_NG_CUSTOM) it->type = ng_type;
+			break;
+		}
+	}
+	if (!it) {
+		ng->next = g_groups;
+		ng->interned = 1;
+		g_groups = ng;
+	}
+	groups_unlock();
+
+	if (it) {
+		ng_destroy(ng);
+		return it;
+	}
+	return ng;
+}
+
+/* a group of its own, outside g_groups */
+static NGConstant * ng_build( SRP_NGType ng_type, const char * n_hex, const char * g_hex )
+{
+	NGConstant *ng;
+
+	if ((unsigned)ng_type>=(unsigned)SRP_NG_LAST) return NULL;
+	if (ng_type==SRP_NG_CUSTOM && (!n_hex || !g_hex)) return NULL;
+
+	ng = (NGConstant *) srp_malloc( sizeof(NGConstant) );
+	if( !ng )
+		return NULL;
+	ng->N = (mbedtls_mpi *) srp_malloc(sizeof(mbedtls_mpi));
+	ng->g = (mbedtls_mpi *) srp_malloc(sizeof(mbedtls_mpi));
+	if( !ng->N || !ng->g ) {
+		srp_free(ng->N);
+		srp_free(ng->g);
+		srp_free(ng);
+		return NULL;
+	}
+	mbedtls_mpi_init(ng->N);
+	mbedtls_mpi_init(ng->g);
+	ng_precomp_init(ng);
+
+	if (ng_type != SRP_NG_CUSTOM) {
+		if (ng_builtin_load(ng, &srp_groups[ng_type])!=0) {
+			ng_destroy(ng);
+			return NULL;
+		}
+	}
+	else if (mbedtls_mpi_read_string( ng->N, 16, n_hex)!=0 || mbedtls_mpi_read_string( ng->g, 16, g_hex)!=0) {
+		ng_destroy(ng);
+		return NULL;
+	}
+	ng->type = ng_type;
+	ng->refs = 1;
+	ng->exp_bits = ng_default_exp_bits(ng);
+	return ng;
+}
+
+NGConstant * srp_ng_new_private( SRP_NGType ng_type, const char * n_hex, const char * g_hex )
+{
+	return ng_build(ng_type, n_hex, g_hex);
+}
+
+/*
+ * Takes ng out of g_groups so that tuning it affects nobody else: 0 when the
+ * caller holds the only reference, -1 otherwise. A group outside the
+ * registry is shared too once srp_ng_new1() handed it to a user or a pool.
+ */
+static int ng_make_private( NGConstant *ng )
+{
+	NGConstant **pp;
+	int rc = 0;
+
+	groups_lock();
+	if (srp_atomic_get(&ng->refs)!=1) {
+		rc = -1;
+	} else if (ng->interned) {
+		for (pp=&g_groups; *pp; pp=&(*pp)->next) {
+			if (*pp==ng) {
+				*pp = ng->next;
+				break;
+			}
+		}
+		ng->next = NULL;
+		ng->interned = 0;
+	}
+	groups_unlock();
+	return rc;
+}
+
+NGConstant * srp_ng_new1( NGConstant * copy_from_ng)
+{
+	if (!copy_from_ng) return NULL;
+	srp_atomic_add(&copy_from_ng->refs, 1);
+	return copy_from_ng;
+}
+
+void srp_ng_delete( NGConstant * ng )
+{
+	NGConstant **pp;
+
+	if (!ng || srp_atomic_add(&ng->refs, -1) > 0) return;
+
+	groups_lock();
+	for (pp=&g_groups; ng->interned && *pp; pp=&(*pp)->next) {
+		if (*pp==ng) {
+			*pp = ng->next;
+			break;
+		}
+	}
+	groups_unlock();
+	ng_destroy(ng);
+}
+
+static void ng_precomp_init( NGConstant *ng )
+{
+	int i;
+	mbedtls_mpi_init(&ng->RR);
+	for (i=0; i<SRP_SHA_LAST; i++) {
+		ng->pre[i].ready=0;
+		mbedtls_mpi_init(&ng->pre[i].k);
+	}
+	ng->mont=NULL;
+	ng->gtab=NULL;
+#ifdef SRP_PTHREAD
+	pthread_mutex_init(&ng->lock, NULL);
+#endif
+}
+
+static void ng_precomp_free( NGConstant *ng )
+{
+	int i;
+	mbedtls_mpi_free(&ng->RR);
+	for (i=0; i<SRP_SHA_LAST; i++) {
+		ng->pre[i].ready=0;
+		mbedtls_mpi_free(&ng->pre[i].k);
+	}
+	fixed_base_release(ng->gtab);
+	ng->gtab=NULL;
+	mont_free(ng->mont);
+	ng->mont=NULL;
+#ifdef SRP_PTHREAD
+	pthread_mutex_destroy(&ng->lock);
+#endif
+}
+
+/*
+ * Return the per hash algorithm precomputation block of ng, building it on
+ * first use. Also makes sure ng->RR is filled so every later
+ * mbedtls_mpi_exp_mod() on this modulus can skip computing R^2 mod N.
+ */
+NGPrecomp * srp_ng_precomp( NGConstant *ng, SRP_HashAlgorithm alg )
+{
+	NGPrecomp *pre;
+
+	if ((unsigned)alg>=(unsigned)SRP_SHA_LAST) return NULL;
+	pre=&ng->pre[alg];
+	if (srp_atomic_get(&pre->ready)) return pre;
+
+#ifdef SRP_PTHREAD
+	pthread_mutex_lock(&ng->lock);
+	if (pre->ready) {
+		pthread_mutex_unlock(&ng->lock);
+		return pre;
+	}
+#endif
+	pre = ng_precomp_build(ng, alg);
+#ifdef SRP_PTHREAD
+	pthread_mutex_unlock(&ng->lock);
+#endif
+	return pre;
+}
+
+static NGPrecomp * ng_precomp_build( NGConstant *ng, SRP_HashAlgorithm alg )
+{
+	unsigned char H_N[ SHA512_DIGEST_LENGTH ];
+	unsigned char H_g[ SHA512_DIGEST_LENGTH ];
+	unsigned char buf_N[ SRP_MAX_N_BYTES ], buf_g[ SRP_MAX_N_BYTES ];
+	NGPrecomp *pre=&ng->pre[alg];
+	HashNum hN = { NULL, 0, NULL }, hg = { NULL, 0, NULL };
+	int i;
+
+	if (ng->RR.p==NULL) {
+		/* let mbedtls compute R^2 mod N exactly the way exp_mod expects it */
+		mbedtls_mpi one, tmp;
+		int rc;
+		mbedtls_mpi_init(&one);
+		mbedtls_mpi_init(&tmp);
+		rc=mbedtls_mpi_lset(&one, 1);
+		if (rc==0) rc=mbedtls_mpi_exp_mod(&tmp, ng->g, &one, ng->N, &ng->RR);
+		mbedtls_mpi_free(&one);
+		mbedtls_mpi_free(&tmp);
+		if (rc!=0) return NULL;
+	}
+
+	/* optional: without it the multi-exponentiation falls back to mbedtls */
+	ng_mont_make_locked(ng);
+
+	if (hn_mpi(&hN, ng->N, buf_N, sizeof(buf_N))!=0 || hn_mpi(&hg, ng->g, buf_g, sizeof(buf_g))!=0 ||
+	    H_nn(alg, &pre->k, &hN, &hg, 1)!=0) {
+		hn_free(&hN);
+		hn_free(&hg);
+		return NULL;
+	}
+
+	hash_num( alg, &hN, H_N );
+	hash_num( alg, &hg, H_g );
+	hn_free(&hN);
+	hn_free(&hg);
+	for (i=0; i < hash_length(alg); i++ )
+		pre->H_xor[i] = H_N[i] ^ H_g[i];
+
+	srp_atomic_set(&pre->ready, 1);
+	return pre;
+}
+
+
+/***********************************************************************************************************
+ *
+ *  Montgomery arithmetic and fixed base tables
+ *
+ ***********************************************************************************************************/
+
+#define biL    (sizeof(mbedtls_mpi_uint) << 3)
+#define biH    (sizeof(mbedtls_mpi_uint) << 2)
+
+/* largest modulus the stack based helpers below handle, in limbs */
+#define SRP_MONT_MAX_LIMBS  (8192 / biL)
+
+#define SRP_FIXED_BASE_DEFAULT_W     4
+#define SRP_FIXED_BASE_DEFAULT_BITS  (8*SHA512_DIGEST_LENGTH)
+
+static int srp_atomic_add( int *p, int d )
+{
+#if defined(__GNUC__)
+	return __atomic_add_fetch(p, d, __ATOMIC_ACQ_REL);
+#else
+	return *p += d;
+#endif
+}
+
+static int srp_atomic_get( const int *p )
+{
+#if defined(__GNUC__)
+	return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+#else
+	return *p;
+#endif
+}
+
+static void srp_atomic_set( int *p, int v )
+{
+#if defined(__GNUC__)
+	__atomic_store_n(p, v, __ATOMIC_RELEASE);
+#else
+	*p = v;
+#endif
+}
+
+static void * srp_atomic_get_ptr( void * const *p )
+{
+#if defined(__GNUC__)
+	return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+#else
+	return *p;
+#endif
+}
+
+static void * srp_atomic_xchg_ptr( void **p, void *v )
+{
+#if defined(__GNUC__)
+	return __atomic_exchange_n(p, v, __ATOMIC_ACQ_REL);
+#else
+	void *old = *p;
+	*p = v;
+	return old;
+#endif
+}
+
+static void ng_lock( NGConstant *ng )
+{
+#ifdef SRP_PTHREAD
+	pthread_mutex_lock(&ng->lock);
+#else
+	(void) ng;
+#endif
+}
+
+static void ng_unlock( NGConstant *ng )
+{
+#ifdef SRP_PTHREAD
+	pthread_mutex_unlock(&ng->lock);
+#else
+	(void) ng;
+#endif
+}
+
+/*
+ * ng->mont and ng->gtab may be set up while other threads use the group:
+ * both are only written under ng->lock and published with a release store,
+ * and readers load them once per operation. A table for g that gets
+ * replaced stays alive until the last reader drops its reference.
+ */
+static SRPMont * ng_mont( const NGConstant *ng )
+{
+	return (SRPMont *) srp_atomic_get_ptr((void * const *) &ng->mont);
+}
+
+/* with ng->lock held */
+static SRPMont * ng_mont_make_locked( NGConstant *ng )
+{
+	SRPMont *m = ng->mont;
+
+	if (!m && (m = mont_new(ng->N)))
+		srp_atomic_xchg_ptr((void **) &ng->mont, m);
+	return m;
+}
+
+/* (*hi,*lo) = a*b + c + d, which always fits in two limbs */
+static inline void mont_muladd( mbedtls_mpi_uint *hi, mbedtls_mpi_uint *lo,
+	mbedtls_mpi_uint a, mbedtls_mpi_uint b, mbedtls_mpi_uint c, mbedtls_mpi_uint d )
+{
+#if defined(MBEDTLS_HAVE_UDBL)
+	mbedtls_t_udbl r = (mbedtls_t_udbl)a * b + c + d;
+	*lo = (mbedtls_mpi_uint)r;
+	*hi = (mbedtls_mpi_uint)(r >> biL);
+#else
+	const mbedtls_mpi_uint lm = ((mbedtls_mpi_uint)1 << biH) - 1;
+	mbedtls_mpi_uint a0 = a & lm, a1 = a >> biH;
+	mbedtls_mpi_uint b0 = b & lm, b1 = b >> biH;
+	mbedtls_mpi_uint p00 = a0*b0, p01 = a0*b1, p10 = a1*b0, p11 = a1*b1;
+	mbedtls_mpi_uint mid = (p00 >> biH) + (p01 & lm) + (p10 & lm);
+	mbedtls_mpi_uint l = (p00 & lm) | (mid << biH);
+	mbedtls_mpi_uint h = p11 + (p01 >> biH) + (p10 >> biH) + (mid >> biH);
+	l += c; h += (l < c);
+	l += d; h += (l < d);
+	*lo = l;
+	*hi = h;
+#endif
+}
+
+/*
+ * The kernels below take the limb count as an argument and are always
+ * inlined, so the copies for the standard group sizes further down get it
+ * as a constant and the compiler unrolls the inner loops.
+ */
+#if defined(__GNUC__)
+#define MONT_INLINE  static inline __attribute__((always_inline))
+#define MONT_UNROLL  _Pragma("GCC unroll 8")
+#else
+#define MONT_INLINE  static inline
+#define MONT_UNROLL
+#endif
+
+/* r = t - N unless that borrows out of top, with t < 2N. Branch free. */
+MONT_INLINE void mont_reduce_final( mbedtls_mpi_uint *r, const mbedtls_mpi_uint *t, mbedtls_mpi_uint top,
+	const SRPMont *m, size_t n )
+{
+	size_t j;
+	mbedtls_mpi_uint d, lo, borrow, mask;
+
+	borrow=0;
+	MONT_UNROLL
+	for (j=0; j<n; j++) {
+		d = t[j] - m->N[j];
+		lo = (t[j] < m->N[j]);
+		lo |= (d < borrow);
+		r[j] = d - borrow;
+		borrow = lo;
+	}
+	mask = (mbedtls_mpi_uint)0 - (top | (borrow ^ 1));
+	MONT_UNROLL
+	for (j=0; j<n; j++) r[j] = (r[j] & mask) | (t[j] & ~mask);
+}
+
+/*
+ * r = a*b*R^-1 mod N (CIOS). a, b < N. r may alias a or b.
+ * t is scratch of n+2 limbs. The final subtraction is branch free.
+ */
+MONT_INLINE void mont_mul_n( mbedtls_mpi_uint *r, const mbedtls_mpi_uint *a, const mbedtls_mpi_uint *b,
+	const SRPMont *m, mbedtls_mpi_uint *t, size_t n )
+{
+	size_t i, j;
+	mbedtls_mpi_uint c, u, lo;
+
+	memset(t, 0, (n+2)*sizeof(mbedtls_mpi_uint));
+	for (i=0; i<n; i++) {
+		c=0;
+		MONT_UNROLL
+		for (j=0; j<n; j++) mont_muladd(&c, &t[j], a[j], b[i], t[j], c);
+		t[n] += c;
+		t[n+1] = (t[n] < c);
+
+		u = t[0] * m->mm;
+		mont_muladd(&c, &lo, u, m->N[0], t[0], 0);
+		MONT_UNROLL
+		for (j=1; j<n; j++) mont_muladd(&c, &t[j-1], u, m->N[j], t[j], c);
+		t[n-1] = t[n] + c;
+		t[n] = t[n+1] + (t[n-1] < c);
+	}
+
+	mont_reduce_final(r, t, t[n], m, n);
+}
+
+/*
+ * r = a*a*R^-1 mod N. The cross products are computed once and doubled,
+ * then reduced a limb at a time (SOS). t is scratch of 2n limbs, r may
+ * alias a.
+ */
+MONT_INLINE void mont_sqr_n( mbedtls_mpi_uint *r, const mbedtls_mpi_uint *a, const SRPMont *m,
+	mbedtls_mpi_uint *t, size_t n )
+{
+	size_t i, j;
+	mbedtls_mpi_uint c, c2, u, hi, s;
+
+	memset(t, 0, 2*n*sizeof(mbedtls_mpi_uint));
+	for (i=0; i+1<n; i++) {
+		c=0;
+		for (j=i+1; j<n; j++) mont_muladd(&c, &t[i+j], a[i], a[j], t[i+j], c);
+		t[i+n] = c;
+	}
+	for (i=2*n-1; i>0; i--) t[i] = (t[i] << 1) | (t[i-1] >> (biL - 1));
+	t[0] <<= 1;
+	c=0;
+	for (i=0; i<n; i++) {
+		mont_muladd(&hi, &t[2*i], a[i], a[i], t[2*i], c);
+		s = t[2*i+1] + hi;
+		c = (s < hi);
+		t[2*i+1] = s;
+	}
+
+	/* c2 carries out of t[i+n] into the next row */
+	c2=0;
+	for (i=0; i<n; i++) {
+		u = t[i] * m->mm;
+		c=0;
+		MONT_UNROLL
+		for (j=0; j<n; j++) mont_muladd(&c, &t[i+j], u, m->N[j], t[i+j], c);
+		s = t[i+n] + c;
+		hi = (s < c);
+		t[i+n] = s + c2;
+		c2 = hi + (t[i+n] < c2);
+	}
+	mont_reduce_final(r, t + n, c2, m, n);
+}
+
+static void mont_mul_any( mbedtls_mpi_uint *r, const mbedtls_mpi_uint *a, const mbedtls_mpi_uint *b,
+	const SRPMont *m, mbedtls_mpi_uint *t )
+{
+	mont_mul_n(r, a, b, m, t, m->n);
+}
+
+static void mont_sqr_any( mbedtls_mpi_uint *r, const mbedtls_mpi_uint *a, const SRPMont *m,
+	mbedtls_mpi_uint *t )
+{
+	mont_sqr_n(r, a, m, t, m->n);
+}
+
+/* mont_mul_2048(), mont_sqr_2048() and so on, for a modulus of exactly bits bits */
+#define MONT_FIXED( bits )                                                                           \
+static void mont_mul_##bits( mbedtls_mpi_uint *r, const mbedtls_mpi_uint *a,                          \
+	const mbedtls_mpi_uint *b, const SRPMont *m, mbedtls_mpi_uint *t )                            \
+{                                                                                                    \
+	mont_mul_n(r, a, b, m, t, (bits) / biL);                                                      \
+}                                                                                                    \
+static void mont_sqr_##bits( mbedtls_mpi_uint *r, const mbedtls_mpi_uint *a, const SRPMont *m,       \
+	mbedtls_mpi_uint *t )                                                                         \
+{                                                                                                    \
+	mont_sqr_n(r, a, m, t, (bits) / biL);                                                         \
+}
+
+MONT_FIXED(2048)
+MONT_FIXED(3072)
+MONT_FIXED(4096)
+
+#ifdef SRP_MONT_ADX
+/*
+ * out[j] = in[j] + a[j]*b plus carries for j < 8*blocks, returns the carry
+ * limb. The products go through MULX, and ADCX/ADOX keep two carry chains
+ * apart: CF for in[j], OF for the high half of the previous product. No
+ * instruction in the loop touches the flags otherwise, the counter lives in
+ * rcx for JRCXZ. out may be in or in - 1.
+ */
+__attribute__((target("bmi2,adx")))
+static uint64_t adx_row( uint64_t *out, const uint64_t *in, const uint64_t *a, uint64_t b, size_t blocks )
+{
+	uint64_t hi, lo, prev, zero;
+
+#define ADX_STEP(k)                                     \
+	"mulxq " #k "*8(%[a]), %[lo], %[hi]\n\t"        \
+	"adcxq " #k "*8(%[in]), %[lo]\n\t"              \
+	"adoxq %[prev], %[lo]\n\t"                      \
+	"movq %[lo], " #k "*8(%[out])\n\t"              \
+	"movq %[hi], %[prev]\n\t"
+
+	__asm__ volatile(
+		"xorl %k[zero], %k[zero]\n\t"
+		"movq %[zero], %[prev]\n\t"
+		"1:\n\t"
+		ADX_STEP(0) ADX_STEP(1) ADX_STEP(2) ADX_STEP(3)
+		ADX_STEP(4) ADX_STEP(5) ADX_STEP(6) ADX_STEP(7)
+		"leaq 64(%[a]), %[a]\n\t"
+		"leaq 64(%[in]), %[in]\n\t"
+		"leaq 64(%[out]), %[out]\n\t"
+		"leaq -1(%[blocks]), %[blocks]\n\t"
+		"jrcxz 2f\n\t"
+		"jmp 1b\n\t"
+		"2:\n\t"
+		"adoxq %[zero], %[prev]\n\t"
+		"adcxq %[zero], %[prev]\n\t"
+		: [a] "+r" (a), [in] "+r" (in), [out] "+r" (out), [blocks] "+c" (blocks),
+		  [hi] "=&r" (hi), [lo] "=&r" (lo), [prev] "=&r" (prev), [zero] "=&r" (zero)
+		: "d" (b)
+		: "cc", "memory");
+#undef ADX_STEP
+	return prev;
+}
+
+/*
+ * CIOS as in mont_mul_n() with a row of adx_row() per pass; the reduction
+ * row writes one limb lower, which does the shift. n is a multiple of 8 and
+ * t is scratch of n+3 limbs.
+ */
+static void mont_mul_adx( mbedtls_mpi_uint *r, const mbedtls_mpi_uint *a, const mbedtls_mpi_uint *b,
+	const SRPMont *m, mbedtls_mpi_uint *t )
+{
+	size_t i, n = m->n;
+	uint64_t *T = (uint64_t *)t + 1, c, u;
+
+	memset(T, 0, (n+2)*sizeof(uint64_t));
+	for (i=0; i<n; i++) {
+		c = adx_row(T, T, (const uint64_t *)a, b[i], n / 8);
+		T[n] += c;
+		T[n+1] = (T[n] < c);
+
+		u = T[0] * m->mm;
+		c = adx_row(T - 1, T, (const uint64_t *)m->N, u, n / 8);
+		T[n-1] = T[n] + c;
+		T[n] = T[n+1] + (T[n-1] < c);
+	}
+	mont_reduce_final(r, (mbedtls_mpi_uint *)T, T[n], m, n);
+}
+
+static void mont_sqr_adx( mbedtls_mpi_uint *r, const mbedtls_mpi_uint *a, const SRPMont *m,
+	mbedtls_mpi_uint *t )
+{
+	mont_mul_adx(r, a, a, m, t);
+}
+
+static int mont_cpu_adx( void )
+{
+	static int cpu = -1;
+	unsigned int a, b, c, d;
+	int f = __atomic_load_n(&cpu, __ATOMIC_RELAXED);
+
+	if (f < 0) {
+		/* leaf 7: BMI2 is bit 8 of ebx, ADX bit 19 */
+		f = __get_cpuid_count(7, 0, &a, &b, &c, &d) && (b & (1u << 8)) && (b & (1u << 19));
+		__atomic_store_n(&cpu, f, __ATOMIC_RELAXED);
+	}
+	return f;
+}
+#endif /* SRP_MONT_ADX */
+
+static const struct {
+	const char  *name;
+	size_t       bits;      /* 0: any size */
+	void       (*mul)( mbedtls_mpi_uint *, const mbedtls_mpi_uint *, const mbedtls_mpi_uint *,
+	                   const SRPMont *, mbedtls_mpi_uint * );
+	void       (*sqr)( mbedtls_mpi_uint *, const mbedtls_mpi_uint *, const SRPMont *, mbedtls_mpi_uint * );
+} mont_kernels[] = {
+#ifdef SRP_MONT_ADX
+	{ "adx",  0,    mont_mul_adx,  mont_sqr_adx },
+#endif
+	{ "2048", 2048, mont_mul_2048, mont_sqr_2048 },
+	{ "3072", 3072, mont_mul_3072, mont_sqr_3072 },
+	{ "4096", 4096, mont_mul_4096, mont_sqr_4096 },
+	{ "any",  0,    mont_mul_any,  mont_sqr_any },
+};
+
+static int mont_kernel_fits( int k, size_t n )
+{
+#ifdef SRP_MONT_ADX
+	if (mont_kernels[k].mul == mont_mul_adx)
+		return sizeof(mbedtls_mpi_uint)==8 && n % 8 == 0 && mont_cpu_adx();
+#endif
+	return mont_kernels[k].bits==0 || mont_kernels[k].bits==n * biL;
+}
+
+/* the first kernel in mont_kernels[] that fits, or the one called name */
+static int mont_set_kernel( SRPMont *m, const char *name )
+{
+	int k;
+	for (k=0; k < (int)(sizeof(mont_kernels) / sizeof(mont_kernels[0])); k++) {
+		if (name && strcmp(name, mont_kernels[k].name)!=0) continue;
+		if (!mont_kernel_fits(k, m->n)) continue;
+		m->mul = mont_kernels[k].mul;
+		m->sqr = mont_kernels[k].sqr;
+		m->kernel = mont_kernels[k].name;
+		return 0;
+	}
+	return -1;
+}
+
+/* r = a*b*R^-1 mod N through the kernel of m. t is scratch of n+3 limbs */
+static inline void mont_mul( mbedtls_mpi_uint *r, const mbedtls_mpi_uint *a, const mbedtls_mpi_uint *b,
+	const SRPMont *m, mbedtls_mpi_uint *t )
+{
+	m->mul(r, a, b, m, t);
+}
+
+/* r = a*a*R^-1 mod N. t is scratch of 2n limbs */
+static inline void mont_sqr( mbedtls_mpi_uint *r, const mbedtls_mpi_uint *a, const SRPMont *m,
+	mbedtls_mpi_uint *t )
+{
+	m->sqr(r, a, m, t);
+}
+
+static int mpi_to_limbs( mbedtls_mpi_uint *dst, size_t n, const mbedtls_mpi *X )
+{
+	size_t i;
+	if (X->s < 0 || mbedtls_mpi_bitlen(X) > n*biL) return -1;
+	for (i=0; i<n; i++) dst[i] = (i < X->n) ? X->p[i] : 0;
+	return 0;
+}
+
+static int limbs_to_mpi( mbedtls_mpi *X, const mbedtls_mpi_uint *src, size_t n )
+{
+	if (mbedtls_mpi_grow(X, n)!=0) return -1;
+	memset(X->p, 0, X->n * sizeof(mbedtls_mpi_uint));
+	memcpy(X->p, src, n * sizeof(mbedtls_mpi_uint));
+	X->s = 1;
+	return 0;
+}
+
+static void mont_free( SRPMont *m )
+{
+	if (m) {
+		srp_free(m->N);
+		srp_free(m);
+	}
+}
+
+static SRPMont * mont_alloc( size_t n )
+{
+	SRPMont *m;
+
+	if (n==0 || n > SRP_MONT_MAX_LIMBS) return NULL;
+	m = (SRPMont *) srp_malloc(sizeof(SRPMont));
+	if (!m) return NULL;
+	m->n = n;
+	m->N = (mbedtls_mpi_uint *) srp_malloc(3 * n * sizeof(mbedtls_mpi_uint));
+	if (!m->N) {
+		srp_free(m);
+		return NULL;
+	}
+	m->RR  = m->N + n;
+	m->one = m->N + 2*n;
+	return m;
+}
+
+static SRPMont * mont_new( const mbedtls_mpi *N )
+{
+	SRPMont *m;
+	mbedtls_mpi T;
+	mbedtls_mpi_uint inv;
+	size_t n = (mbedtls_mpi_bitlen(N) + biL - 1) / biL;
+	int i, rc;
+
+	if (mbedtls_mpi_get_bit(N, 0)!=1) return NULL;
+	m = mont_alloc(n);
+	if (!m) return NULL;
+	mpi_to_limbs(m->N, n, N);
+	mont_set_kernel(m, NULL);
+
+	/* Newton iteration, every round doubles the correct low bits of N0^-1 */
+	inv = m->N[0];
+	for (i=0; i<7; i++) inv *= 2 - m->N[0] * inv;
+	m->mm = (mbedtls_mpi_uint)0 - inv;
+
+	mbedtls_mpi_init(&T);
+	rc = mbedtls_mpi_lset(&T, 1);
+	if (rc==0) rc = mbedtls_mpi_shift_l(&T, n * biL);
+	if (rc==0) rc = mbedtls_mpi_mod_mpi(&T, &T, N);
+	if (rc==0) rc = mpi_to_limbs(m->one, n, &T);
+	if (rc==0) rc = mbedtls_mpi_lset(&T, 1);
+	if (rc==0) rc = mbedtls_mpi_shift_l(&T, 2 * n * biL);
+	if (rc==0) rc = mbedtls_mpi_mod_mpi(&T, &T, N);
+	if (rc==0) rc = mpi_to_limbs(m->RR, n, &T);
+	mbedtls_mpi_free(&T);
+
+	if (rc!=0) {
+		mont_free(m);
+		return NULL;
+	}
+	return m;
+}
+
+/* mont_new() for a built-in group: all constants come from srp_groups.h */
+static SRPMont * mont_new_builtin( const NGBuiltin *b )
+{
+	SRPMont *m = mont_alloc(b->limbs);
+
+	if (!m) return NULL;
+	memcpy(m->N, b->N, b->limbs * sizeof(mbedtls_mpi_uint));
+	memcpy(m->RR, b->RR, b->limbs * sizeof(mbedtls_mpi_uint));
+	memcpy(m->one, b->one, b->limbs * sizeof(mbedtls_mpi_uint));
+	m->mm = b->mm;
+	mont_set_kernel(m, NULL);
+	return m;
+}
+
+static void fixed_base_release( SRPFixedBase *fb )
+{
+	if (fb && srp_atomic_add(&fb->refs, -1)==0) {
+		if (fb->unmap) fb->unmap(fb->mem, fb->mem_len);
+		else srp_free(fb->mem);
+		srp_free(fb);
+	}
+}
+
+/* build a table for base mod N covering exponents of up to ebits bits */
+static SRPFixedBase * fixed_base_new( const SRPMont *m, const mbedtls_mpi *N, const mbedtls_mpi *base, int w, size_t ebits )
+{
+	mbedtls_mpi_uint t[SRP_MONT_MAX_LIMBS + 3];
+	mbedtls_mpi_uint rb[SRP_MONT_MAX_LIMBS];
+	SRPFixedBase *fb;
+	mbedtls_mpi B;
+	mbedtls_mpi_uint *e;
+	size_t line = SRP_CACHE_LINE / sizeof(mbedtls_mpi_uint);
+	size_t n = m->n, nent, r, j;
+	int rc;
+
+	if (w < 1 || w > 8 || ebits==0) return NULL;
+
+	fb = (SRPFixedBase *) srp_malloc(sizeof(SRPFixedBase));
+	if (!fb) return NULL;
+	fb->refs   = 1;
+	fb->w      = w;
+	fb->rows   = (int)((ebits + w - 1) / w);
+	fb->n      = n;
+	fb->stride = (n + line - 1) / line * line;
+	nent = (size_t)fb->rows << w;
+	fb->mem = srp_malloc(nent * fb->stride * sizeof(mbedtls_mpi_uint) + SRP_CACHE_LINE);
+	if (!fb->mem) {
+		srp_free(fb);
+		return NULL;
+	}
+	fb->tab = (mbedtls_mpi_uint *)(((size_t)fb->mem + SRP_CACHE_LINE - 1) & ~(size_t)(SRP_CACHE_LINE - 1));
+
+	mbedtls_mpi_init(&B);
+	rc = mbedtls_mpi_mod_mpi(&B, base, N);
+	if (rc==0) rc = mpi_to_limbs(rb, n, &B);
+	mbedtls_mpi_free(&B);
+	if (rc!=0) {
+		fixed_base_release(fb);
+		return NULL;
+	}
+	mont_mul(rb, rb, m->RR, m, t);
+
+	e = fb->tab;
+	for (r=0; r<(size_t)fb->rows; r++) {
+		/* row r: rb^j with rb = base^(2^(r*w)) */
+		memcpy(e, m->one, n * sizeof(mbedtls_mpi_uint));
+		e += fb->stride;
+		for (j=1; j < ((size_t)1 << w); j++) {
+			mont_mul(e, e - fb->stride, rb, m, t);
+			e += fb->stride;
+		}
+		mont_mul(rb, e - fb->stride, rb, m, t);
+	}
+	return fb;
+}
+
+/* w bits of E starting at bit pos */
+static unsigned int exp_window( const mbedtls_mpi *E, size_t pos, int w )
+{
+	size_t limb = pos / biL, off = pos % biL;
+	mbedtls_mpi_uint v = 0;
+	if (limb < E->n) v = E->p[limb] >> off;
+	if (off + w > biL && limb + 1 < E->n) v |= E->p[limb+1] << (biL - off);
+	return (unsigned int)(v & (((mbedtls_mpi_uint)1 << w) - 1));
+}
+
+/*
+ * sel = entry d of count entries stride limbs apart. Reads every entry so
+ * the memory access pattern does not depend on d.
+ */
+static void table_select( mbedtls_mpi_uint *sel, const mbedtls_mpi_uint *tab, size_t stride,
+	size_t n, size_t count, unsigned int d )
+{
+	const mbedtls_mpi_uint *e;
+	mbedtls_mpi_uint mask;
+	size_t j, k;
+
+	memset(sel, 0, n * sizeof(mbedtls_mpi_uint));
+	for (j=0, e=tab; j < count; j++, e += stride) {
+		mask = (mbedtls_mpi_uint)(j ^ d);
+		mask = (mbedtls_mpi_uint)0 - ((mask - 1) >> (biL - 1));
+		for (k=0; k<n; k++) sel[k] |= e[k] & mask;
+	}
+}
+
+/* window of the multi-exponentiation, 2^w entries per base */
+#define SRP_MULTI_EXP_W  5
+
+/*
+ * An exponentiation in Montgomery form that can stop after any
+ * multiplication or squaring and resume later: either Straus over one or two
+ * bases with tables of 2^SRP_MULTI_EXP_W entries, or a walk over the rows of
+ * a fixed base table. mont_exp_step() drives it.
+ */
+enum { MEXP_TABLE, MEXP_WINDOWS, MEXP_FINAL, MEXP_DONE };
+
+typedef struct MontExp {
+	const SRPMont          *m;
+	const SRPFixedBase     *fb;          /* set for a fixed base walk */
+	const mbedtls_mpi      *e[2];        /* exponents, must outlive the run */
+	mbedtls_mpi_uint       *tab;         /* Straus: 2^w entries per base */
+	size_t                  nbases;
+	size_t                  nwin[2];     /* windows (rows) per exponent */
+	size_t                  windows;
+	size_t                  pos;         /* next table entry, or windows done */
+	int                     sub;         /* operation within the current window */
+	int                     secret;
+	int                     stage;
+	mbedtls_mpi_uint        acc[SRP_MONT_MAX_LIMBS];
+	mbedtls_mpi_uint        sel[SRP_MONT_MAX_LIMBS];
+	mbedtls_mpi_uint        t[2*SRP_MONT_MAX_LIMBS + 2];
+} MontExp;
+
+/*
+ * Starts X = base^E mod N over the table. With secret set every row is
+ * scanned in full so the memory access pattern does not depend on E; a
+ * public E such as u indexes the rows directly.
+ * Returns 1 when E does not fit the table.
+ */
+static int mont_exp_start_fixed( MontExp *x, const SRPFixedBase *fb, const SRPMont *m, const mbedtls_mpi *E, int secret )
+{
+	size_t bits = mbedtls_mpi_bitlen(E);
+
+	if (E->s < 0) return 1;
+	if (bits > (size_t)fb->rows * fb->w) return 1;
+	x->m = m;
+	x->fb = fb;
+	x->e[0] = E;
+	x->nbases = 1;
+	x->windows = x->nwin[0] = (bits + fb->w - 1) / fb->w;
+	x->pos = 0;
+	x->secret = secret;
+	x->stage = MEXP_WINDOWS;
+	memcpy(x->acc, m->one, m->n * sizeof(mbedtls_mpi_uint));
+	return 0;
+}
+
+/*
+ * Starts X = A^a * B^b mod N (Straus). Both exponents share one chain of
+ * squarings and each window costs one multiplication per base, with table
+ * entries picked by table_select(). B may be NULL for a plain A^a. tab holds
+ * 2^SRP_MULTI_EXP_W * n limbs per base.
+ */
+static int mont_exp_start( MontExp *x, const SRPMont *m, const mbedtls_mpi *N, mbedtls_mpi_uint *tab,
+	const mbedtls_mpi *A, const mbedtls_mpi *a, const mbedtls_mpi *B, const mbedtls_mpi *b )
+{
+	const size_t w = SRP_MULTI_EXP_W, count = (size_t)1 << SRP_MULTI_EXP_W;
+	const mbedtls_mpi *base[2] = { A, B };
+	size_t n = m->n, i;
+	mbedtls_mpi R;
+	int rc = 0;
+
+	if (a->s < 0 || (B && b->s < 0)) return -1;
+	x->m = m;
+	x->fb = NULL;
+	x->tab = tab;
+	x->e[0] = a;
+	x->e[1] = b;
+	x->nbases = B ? 2 : 1;
+	x->nwin[0] = (mbedtls_mpi_bitlen(a) + w - 1) / w;
+	x->nwin[1] = B ? (mbedtls_mpi_bitlen(b) + w - 1) / w : 0;
+	x->windows = x->nwin[0] > x->nwin[1] ? x->nwin[0] : x->nwin[1];
+	x->pos = 0;
+	x->sub = 0;
+	x->secret = 1;
+	x->stage = MEXP_TABLE;
+
+	/* entries 0 and 1 of each table, the rest is built step by step */
+	mbedtls_mpi_init(&R);
+	for (i=0; i<x->nbases && rc==0; i++) {
+		mbedtls_mpi_uint *e = tab + i * count * n;
+		rc = mbedtls_mpi_mod_mpi(&R, base[i], N);
+		if (rc==0) rc = mpi_to_limbs(e + n, n, &R);
+		if (rc!=0) break;
+		memcpy(e, m->one, n * sizeof(mbedtls_mpi_uint));
+		mont_mul(e + n, e + n, m->RR, m, x->t);
+	}
+	mbedtls_mpi_free(&R);
+	memcpy(x->acc, m->one, n * sizeof(mbedtls_mpi_uint));
+	return rc==0 ? 0 : -1;
+}
+
+/*
+ * Runs at most budget multiplications and squarings (at least one). Returns 1
+ * once the result is ready for mont_exp_result(), 0 when there is more to do.
+ */
+static int mont_exp_step( MontExp *x, int budget )
+{
+	const SRPMont *m = x->m;
+	const size_t w = x->fb ? (size_t)x->fb->w : SRP_MULTI_EXP_W;
+	const size_t count = (size_t)1 << w, n = m->n;
+	const mbedtls_mpi_uint *row;
+	mbedtls_mpi_uint *e;
+	unsigned int d;
+	size_t j, k;
+	int ops = 0;
+
+	while (x->stage != MEXP_DONE && (ops < budget || ops == 0)) {
+		if (x->stage == MEXP_TABLE) {
+			/* tab[j] = tab[j-1] * tab[1] */
+			if (x->pos == x->nbases * (count - 2)) {
+				x->pos = 0;
+				x->stage = MEXP_WINDOWS;
+				continue;
+			}
+			e = x->tab + (x->pos / (count - 2)) * count * n;
+			j = 2 + x->pos % (count - 2);
+			mont_mul(e + j*n, e + (j-1)*n, e + n, m, x->t);
+			x->pos++;
+			ops++;
+		} else if (x->stage == MEXP_WINDOWS) {
+			if (x->pos == x->windows) {
+				x->stage = MEXP_FINAL;
+				continue;
+			}
+			if (x->fb) {
+				/* row pos of the fixed base table */
+				row = x->fb->tab + (x->pos << w) * x->fb->stride;
+				d = exp_window(x->e[0], x->pos * w, (int) w);
+				if (x->secret) {
+					table_select(x->sel, row, x->fb->stride, n, count, d);
+					mont_mul(x->acc, x->acc, x->sel, m, x->t);
+					ops++;
+				} else if (d) {
+					mont_mul(x->acc, x->acc, row + d * x->fb->stride, m, x->t);
+					ops++;
+				}
+				x->pos++;
+			} else if (x->sub < (int) w) {
+				/* window pos, most significant first: w squarings ... */
+				if (x->pos > 0) {
+					mont_sqr(x->acc, x->acc, m, x->t);
+					ops++;
+					x->sub++;
+				} else {
+					x->sub = (int) w;
+				}
+			} else {
+				/* ... then one multiplication per base; windows above an
+				 * exponent's length are zero, skip them */
+				j = x->windows - 1 - x->pos;
+				k = (size_t)(x->sub - (int) w);
+				if (j < x->nwin[k]) {
+					d = exp_window(x->e[k], j*w, (int) w);
+					table_select(x->sel, x->tab + k * count * n, n, n, count, d);
+					mont_mul(x->acc, x->acc, x->sel, m, x->t);
+					ops++;
+				}
+				if (++x->sub == (int)(w + x->nbases)) {
+					x->sub = 0;
+					x->pos++;
+				}
+			}
+		} else {
+			/* leave Montgomery form */
+			memset(x->sel, 0, n * sizeof(mbedtls_mpi_uint));
+			x->sel[0] = 1;
+			mont_mul(x->acc, x->acc, x->sel, m, x->t);
+			ops++;
+			x->stage = MEXP_DONE;
+		}
+	}
+	return x->stage == MEXP_DONE;
+}
+
+static int mont_exp_result( MontExp *x, mbedtls_mpi *X )
+{
+	return limbs_to_mpi(X, x->acc, x->m->n)==0 ? 0 : -1;
+}
+
+/*
+ * X = base^E mod N using the table, see mont_exp_start_fixed().
+ * Returns 1 when E does not fit the table, the caller falls back to
+ * mbedtls_mpi_exp_mod() then.
+ */
+static int fixed_base_exp( mbedtls_mpi *X, const SRPFixedBase *fb, const SRPMont *m, const mbedtls_mpi *E, int secret )
+{
+	MontExp x;
+
+	if (mont_exp_start_fixed(&x, fb, m, E, secret)!=0) return 1;
+	mont_exp_step(&x, INT_MAX);
+	return mont_exp_result(&x, X);
+}
 
-#define SRP_BITS_IN_PRIVKEY 256
-#define SRP_BYTES_IN_PRIVKEY (SRP_BITS_IN_PRIVKEY/8)
-#define SRP_DEFAULT_SALT_BYTES 32
+/* X = A^a * B^b mod N in one go, see mont_exp_start() */
+static int mont_exp2( mbedtls_mpi *X, const SRPMont *m, const mbedtls_mpi *N,
+	const mbedtls_mpi *A, const mbedtls_mpi *a, const mbedtls_mpi *B, const mbedtls_mpi *b )
+{
+	const size_t count = (size_t)1 << SRP_MULTI_EXP_W;
+	size_t size = (B ? 2 : 1) * count * m->n * sizeof(mbedtls_mpi_uint);
+	/* on the stack, 64 KiB for 8192 bit groups, so the *_init API stays off the heap */
+	mbedtls_mpi_uint tab[2 * ((size_t)1 << SRP_MULTI_EXP_W) * SRP_MONT_MAX_LIMBS];
+	MontExp x;
+	int rc;
+
+	rc = mont_exp_start(&x, m, N, tab, A, a, B, b);
+	if (rc==0) {
+		mont_exp_step(&x, INT_MAX);
+		rc = mont_exp_result(&x, X);
+	}
+	memset(tab, 0, size);
+	return rc;
+}
 
+/* X = g^E mod N, through the fixed base table when there is one */
+int srp_ng_exp_g( NGConstant *ng, mbedtls_mpi *X, const mbedtls_mpi *E )
+{
+	SRPMont *m = ng_mont(ng);
+	SRPFixedBase *fb;
+	int rc;
+
+	SRP_STAT_EXP(ng);
+	if (m && (fb = srp_ng_gtab_get(ng))) {
+		rc = fixed_base_exp(X, fb, m, E, 1);
+		fixed_base_release(fb);
+		if (rc==0) return 0;
+	}
+	if (m) return mont_exp2(X, m, ng->N, ng->g, E, NULL, NULL);
+	return mbedtls_mpi_exp_mod(X, ng->g, E, ng->N, &ng->RR);
+}
 
-static mbedtls_mpi * H_nn( SRP_HashAlgorithm alg, const mbedtls_mpi * n1, const mbedtls_mpi * n2,int do_pad );
-
-
-
-
-/* All constants here were pulled from Appendix A of RFC 5054 */
-static NGHex global_Ng_constants[] = {
- { /* 512 */
-  "D66AAFE8E245F9AC245A199F62CE61AB8FA90A4D80C71CD2ADFD0B9DA163B29F2A34AFBDB3B"
-  "1B5D0102559CE63D8B6E86B0AA59C14E79D4AA62D1748E4249DF3",
-  "2"
- },
- { /* 768 */
-   "B344C7C4F8C495031BB4E04FF8F84EE95008163940B9558276744D91F7CC9F402653BE7147F"
-   "00F576B93754BCDDF71B636F2099E6FFF90E79575F3D0DE694AFF737D9BE9713CEF8D837ADA"
-   "6380B1093E94B6A529A8C6C2BE33E0867C60C3262B",
-   "2"
- },
- { /* 1024 */
-   "EEAF0AB9ADB38DD69C33F80AFA8FC5E86072618775FF3C0B9EA2314C9C256576D674DF7496"
-   "EA81D3383B4813D692C6E0E0D5D8E250B98BE48E495C1D6089DAD15DC7D7B46154D6B6CE8E"
-   "F4AD69B15D4982559B297BCF1885C529F566660E57EC68EDBC3C05726CC02FD4CBF4976EAA"
-   "9AFD5138FE8376435B9FC61D2FC0EB06E3",
-   "2"
- },
- { /* 2048 */
-   "AC6BDB41324A9A9BF166DE5E1389582FAF72B6651987EE07FC3192943DB56050A37329CBB4"
-   "A099ED8193E0757767A13DD52312AB4B03310DCD7F48A9DA04FD50E8083969EDB767B0CF60"
-   "95179A163AB3661A05FBD5FAAAE82918A9962F0B93B855F97993EC975EEAA80D740ADBF4FF"
-   "747359D041D5C33EA71D281E446B14773BCA97B43A23FB801676BD207A436C6481F1D2B907"
-   "8717461A5B9D32E688F87748544523B524B0D57D5EA77A2775D2ECFA032CFBDBF52FB37861"
-   "60279004E57AE6AF874E7303CE53299CCC041C7BC308D82A5698F3A8D0C38271AE35F8E9DB"
-   "FBB694B5C803D89F7AE435DE236D525F54759B65E372FCD68EF20FA7111F9E4AFF73",
-   "2"
- },
- { /* 3072 */
-   "FFFFFFFFFFFFFFFFC90FDAA22168C234C4C6628B80DC1CD129024E08"
-   "8A67CC74020BBEA63B139B22514A08798E3404DDEF9519B3CD3A431B"
-   "302B0A6DF25F14374FE1356D6D51C245E485B576625E7EC6F44C42E9"
-   "A637ED6B0BFF5CB6F406B7EDEE386BFB5A899FA5AE9F24117C4B1FE6"
-   "49286651ECE45B3DC2007CB8A163BF0598DA48361C55D39A69163FA8"
-   "FD24CF5F83655D23DCA3AD961C62F356208552BB9ED529077096966D"
-   "670C354E4ABC9804F1746C08CA18217C32905E462E36CE3BE39E772C"
-   "180E86039B2783A2EC07A28FB5C55DF06F4C52C9DE2BCBF695581718"
-   "3995497CEA956AE515D2261898FA051015728E5A8AAAC42DAD33170D"
-   "04507A33A85521ABDF1CBA64ECFB850458DBEF0A8AEA71575D060C7D"
-   "B3970F85A6E1E4C7ABF5AE8CDB0933D71E8C94E04A25619DCEE3D226"
-   "1AD2EE6BF12FFA06D98A0864D87602733EC86A64521F2B18177B200C"
-   "BBE117577A615D6C770988C0BAD946E208E24FA074E5AB3143DB5BFC"
-   "E0FD108E4B82D120A93AD2CAFFFFFFFFFFFFFFFF",
-    "5"
- },
- { /* 4096 */
-   "FFFFFFFFFFFFFFFFC90FDAA22168C234C4C6628B80DC1CD129024E08"
-   "8A67CC74020BBEA63B139B22514A08798E3404DDEF9519B3CD3A431B"
-   "302B0A6DF25F14374FE1356D6D51C245E485B576625E7EC6F44C42E9"
-   "A637ED6B0BFF5CB6F406B7EDEE386BFB5A899FA5AE9F24117C4B1FE6"
-   "49286651ECE45B3DC2007CB8A163BF0598DA48361C55D39A69163FA8"
-   "FD24CF5F83655D23DCA3AD961C62F356208552BB9ED529077096966D"
-   "670C354E4ABC9804F1746C08CA18217C32905E462E36CE3BE39E772C"
-   "180E86039B2783A2EC07A28FB5C55DF06F4C52C9DE2BCBF695581718"
-   "3995497CEA956AE515D2261898FA051015728E5A8AAAC42DAD33170D"
-   "04507A33A85521ABDF1CBA64ECFB850458DBEF0A8AEA71575D060C7D"
-   "B3970F85A6E1E4C7ABF5AE8CDB0933D71E8C94E04A25619DCEE3D226"
-   "1AD2EE6BF12FFA06D98A0864D87602733EC86A64521F2B18177B200C"
-   "BBE117577A615D6C770988C0BAD946E208E24FA074E5AB3143DB5BFC"
-   "E0FD108E4B82D120A92108011A723C12A787E6D788719A10BDBA5B26"
-   "99C327186AF4E23C1A946834B6150BDA2583E9CA2AD44CE8DBBBC2DB"
-   "04DE8EF92E8EFC141FBECAA6287C59474E6BC05D99B2964FA090C3A2"
-   "233BA186515BE7ED1F612970CEE2D7AFB81BDD762170481CD0069127"
-   "D5B05AA993B4EA988D8FDDC186FFB7DC90A6C08F4DF435C934063199"
-   "FFFFFFFFFFFFFFFF",
-   "5"
- },
- { /* 8192 */
-   "FFFFFFFFFFFFFFFFC90FDAA22168C234C4C6628B80DC1CD129024E08"
-   "8A67CC74020BBEA63B139B22514A08798E3404DDEF9519B3CD3A431B"
-   "302B0A6DF25F14374FE1356D6D51C245E485B576625E7EC6F44C42E9"
-   "A637ED6B0BFF5CB6F406B7EDEE386BFB5A899FA5AE9F24117C4B1FE6"
-   "49286651ECE45B3DC2007CB8A163BF0598DA48361C55D39A69163FA8"
-   "FD24CF5F83655D23DCA3AD961C62F356208552BB9ED529077096966D"
-   "670C354E4ABC9804F1746C08CA18217C32905E462E36CE3BE39E772C"
-   "180E86039B2783A2EC07A28FB5C55DF06F4C52C9DE2BCBF695581718"
-   "3995497CEA956AE515D2261898FA051015728E5A8AAAC42DAD33170D"
-   "04507A33A85521ABDF1CBA64ECFB850458DBEF0A8AEA71575D060C7D"
-   "B3970F85A6E1E4C7ABF5AE8CDB0933D71E8C94E04A25619DCEE3D226"
-   "1AD2EE6BF12FFA06D98A0864D87602733EC86A64521F2B18177B200C"
-   "BBE117577A615D6C770988C0BAD946E208E24FA074E5AB3143DB5BFC"
-   "E0FD108E4B82D120A92108011A723C12A787E6D788719A10BDBA5B26"
-   "99C327186AF4E23C1A946834B6150BDA2583E9CA2AD44CE8DBBBC2DB"
-   "04DE8EF92E8EFC141FBECAA6287C59474E6BC05D99B2964FA090C3A2"
-   "233BA186515BE7ED1F612970CEE2D7AFB81BDD762170481CD0069127"
-   "D5B05AA993B4EA988D8FDDC186FFB7DC90A6C08F4DF435C934028492"
-   "36C3FAB4D27C7026C1D4DCB2602646DEC9751E763DBA37BDF8FF9406"
-   "AD9E530EE5DB382F413001AEB06A53ED9027D831179727B0865A8918"
-   "DA3EDBEBCF9B14ED44CE6CBACED4BB1BDB7F1447E6CC254B33205151"
-   "2BD7AF426FB8F401378CD2BF5983CA01C64B92ECF032EA15D1721D03"
-   "F482D7CE6E74FEF6D55E702F46980C82B5A84031900B1C9E59E7C97F"
-   "BEC7E8F323A97A7E36CC88BE0F1D45B7FF585AC54BD407B22B4154AA"
-   "CC8F6D7EBF48E1D814CC5ED20F8037E0A79715EEF29BE32806A1D58B"
-   "B7C5DA76F550AA3D8A1FBFF0EB19CCB1A313D55CDA56C9EC2EF29632"
-   "387FE8D76E3C0468043E8F663F4860EE12BF2D5B0B7474D6E694F91E"
-   "6DBE115974A3926F12FEE5E438777CB6A932DF8CD8BEC4D073B931BA"
-   "3BC832B68D9DD300741FA7BF8AFC47ED2576F6936BA424663AAB639C"
-   "5AE4F5683423B4742BF1C978238F16CBE39D652DE3FDB8BEFC848AD9"
-   "22222E04A4037C0713EB57A81A23F0C73473FC646CEA306B4BCBC886"
-   "2F8385DDFA9D4B7FA2C087E879683303ED5BDD3A062B3CF5B3A278A6"
-   "6D2A13F83F44F82DDF310EE074AB6A364597E899A0255DC164F31CC5"
-   "0846851DF9AB48195DED7EA1B1D510BD7EE74D73FAF36BC31ECFA268"
-   "359046F4EB879F924009438B481C6CD7889A002ED5EE382BC9190DA6"
-   "FC026E479558E4475677E9AA9E3050E2765694DFC81F56E880B96E71"
-   "60C980DD98EDD3DFFFFFFFFFFFFFFFFF",
-   "13"
- },
- {0,0} /* null sentinel */
-};
+/* X = A^a * B^b mod N, two mbedtls_mpi_exp_mod() calls when there is no SRPMont */
+int srp_ng_exp_mod2( NGConstant *ng, mbedtls_mpi *X, const mbedtls_mpi *A, const mbedtls_mpi *a,
+	const mbedtls_mpi *B, const mbedtls_mpi *b )
+{
+	SRPMont *m = ng_mont(ng);
+	mbedtls_mpi T1, T2;
+	int rc;
+
+
+	SRP_STAT_EXP(ng);
+	if (m) return mont_exp2(X, m, ng->N, A, a, B, b);
+
+	mbedtls_mpi_init(&T1);
+	mbedtls_mpi_init(&T2);
+	rc = mbedtls_mpi_exp_mod(&T1, A, a, ng->N, &ng->RR);
+	if (rc==0) rc = mbedtls_mpi_exp_mod(&T2, B, b, ng->N, &ng->RR);
+	if (rc==0) rc = mbedtls_mpi_mul_mpi(&T1, &T1, &T2);
+	if (rc==0) rc = mbedtls_mpi_mod_mpi(X, &T1, ng->N);
+	mbedtls_mpi_free(&T1);
+	mbedtls_mpi_free(&T2);
+	return rc;
+}
 
+/* X = A^a mod N, a may be secret */
+int srp_ng_exp_mod( NGConstant *ng, mbedtls_mpi *X, const mbedtls_mpi *A, const mbedtls_mpi *a )
+{
+	SRPMont *m = ng_mont(ng);
 
-NGConstant * srp_ng_new( SRP_NGType ng_type, const char * n_hex, const char * g_hex )
+	SRP_STAT_EXP(ng);
+	if (m) return mont_exp2(X, m, ng->N, A, a, NULL, NULL);
+	return mbedtls_mpi_exp_mod(X, A, a, ng->N, &ng->RR);
+}
+
+const char * srp_ng_mont_kernel( const NGConstant *ng )
 {
-	if ((unsigned)ng_type>=(unsigned)SRP_NG_LAST) return NULL;
+	SRPMont *m = ng_mont(ng);
 
-    NGConstant * ng   = (NGConstant *) malloc( sizeof(NGConstant) );
-    if( !ng )
-       return NULL;
+	return m ? m->kernel : NULL;
+}
 
-    ng->N = (mbedtls_mpi *) malloc(sizeof(mbedtls_mpi));
-	if (!ng->N) { 
-		free(ng); 
-		return NULL;
-	}
-    ng->g = (mbedtls_mpi *) malloc(sizeof(mbedtls_mpi));
-    if( !ng->g ) {
-		free(ng->N);
-		free(ng);
-		return 0;
-	}
+int srp_ng_set_mont_kernel( NGConstant *ng, const char *name )
+{
+	SRPMont *m = ng_mont(ng);
 
-    mbedtls_mpi_init(ng->N);
-    mbedtls_mpi_init(ng->g);
+	/* the kernel pointers are not swapped under running exponentiations */
+	if (!m || ng_make_private(ng)!=0) return -1;
+	return mont_set_kernel(m, name);
+}
 
+/* a fixed base table for base mod N on top of the group's SRPMont */
+SRPFixedBase * srp_ng_table_new( NGConstant *ng, const mbedtls_mpi *base, int window_bits, int max_exp_bits )
+{
+	SRPMont *m = ng_mont(ng);
 
-    if ( ng_type != SRP_NG_CUSTOM )
-    {
-        n_hex = global_Ng_constants[ ng_type ].n_hex;
-        g_hex = global_Ng_constants[ ng_type ].g_hex;
-    }
+	if (!m) return NULL;
+	return fixed_base_new(m, ng->N, base, window_bits, (size_t) max_exp_bits);
+}
 
-    mbedtls_mpi_read_string( ng->N, 16, n_hex);
-    mbedtls_mpi_read_string( ng->g, 16, g_hex);
+/* X = base^E mod N for a public E, -1 if E does not fit the table */
+int srp_ng_table_exp( NGConstant *ng, const SRPFixedBase *fb, mbedtls_mpi *X, const mbedtls_mpi *E )
+{
+	SRPMont *m = ng_mont(ng);
 
-    return ng;
+	if (!m || fb->n != m->n) return -1;
+	SRP_STAT_EXP(ng);
+	return fixed_base_exp(X, fb, m, E, 0)==0 ? 0 : -1;
 }
 
-NGConstant * srp_ng_new1( NGConstant * copy_from_ng)
+void srp_ng_table_release( SRPFixedBase *fb )
 {
-    NGConstant * ng   = (NGConstant *) malloc( sizeof(NGConstant) );
-    if( !ng ) {
-		return 0;
+	fixed_base_release(fb);
+}
+
+int srp_ng_precompute_g( NGConstant *ng, int window_bits, int max_exp_bits )
+{
+	SRPFixedBase *fb;
+	SRPMont *m;
+	int rc = -1;
+
+	if (!ng) return -1;
+	if (window_bits<=0) window_bits=SRP_FIXED_BASE_DEFAULT_W;
+	if (max_exp_bits<=0) max_exp_bits=SRP_FIXED_BASE_DEFAULT_BITS;
+	if (max_exp_bits<srp_atomic_get(&ng->exp_bits)) max_exp_bits=srp_atomic_get(&ng->exp_bits);
+
+	/* one build at a time, so two callers do not both replace the table */
+	ng_lock(ng);
+	fb = ng->gtab;
+	if (fb && fb->w==window_bits && (size_t)fb->rows * window_bits >= (size_t)max_exp_bits) {
+		rc = 0;
+	} else if ((m = ng_mont_make_locked(ng)) && (fb = fixed_base_new(m, ng->N, ng->g, window_bits, max_exp_bits))) {
+		fixed_base_release((SRPFixedBase *) srp_atomic_xchg_ptr((void **) &ng->gtab, fb));
+		rc = 0;
 	}
+	ng_unlock(ng);
+	return rc;
+}
 
-    ng->N = (mbedtls_mpi *) malloc(sizeof(mbedtls_mpi));
-    ng->g = (mbedtls_mpi *) malloc(sizeof(mbedtls_mpi));
+SRPFixedBase * srp_ng_gtab_once( NGConstant *ng )
+{
+	SRPFixedBase *fb;
+	SRPMont *m;
+	int bits = SRP_FIXED_BASE_DEFAULT_BITS;
 
-    if( !ng->N || !ng->g ) {
-		if (ng->N) free(ng->N);
-		if (ng->g) free(ng->g);
-		free(ng);
-		return 0;
-	}
-    mbedtls_mpi_init(ng->N);
-    mbedtls_mpi_init(ng->g);
+	if (!ng) return NULL;
+	if (bits<srp_atomic_get(&ng->exp_bits)) bits=srp_atomic_get(&ng->exp_bits);
+
+	/* build and install in one locked step, and keep whatever is there */
+	ng_lock(ng);
+	fb = ng->gtab;
+	if (!fb && (m = ng_mont_make_locked(ng))
+			&& (fb = fixed_base_new(m, ng->N, ng->g, SRP_FIXED_BASE_DEFAULT_W, bits)))
+		srp_atomic_xchg_ptr((void **) &ng->gtab, fb);
+	if (fb) srp_atomic_add(&fb->refs, 1);
+	ng_unlock(ng);
+	return fb;
+}
 
-	if(!(mbedtls_mpi_copy(ng->N,copy_from_ng->N)==0  && mbedtls_mpi_copy(ng->g,copy_from_ng->g)==0)){
-		srp_ng_delete(ng);
-		return 0;
+SRPFixedBase * srp_ng_gtab_get( NGConstant *ng )
+{
+	SRPFixedBase *fb;
+
+	/* most groups never get a table, skip the lock for them */
+	if (!srp_atomic_get_ptr((void * const *) &ng->gtab)) return NULL;
+	ng_lock(ng);
+	fb = ng->gtab;
+	if (fb) srp_atomic_add(&fb->refs, 1);
+	ng_unlock(ng);
+	return fb;
+}
+
+int srp_ng_set_gtab( NGConstant *ng, SRPFixedBase *fb )
+{
+	SRPFixedBase *old;
+	SRPMont *m;
+
+	ng_lock(ng);
+	m = ng_mont_make_locked(ng);
+	if (!m || fb->n != m->n) {
+		ng_unlock(ng);
+		return -1;
 	}
+	old = (SRPFixedBase *) srp_atomic_xchg_ptr((void **) &ng->gtab, fb);
+	ng_unlock(ng);
+	/* readers hold references of their own */
+	fixed_base_release(old);
+	return 0;
+}
 
-    return ng;
+int srp_ng_size( NGConstant *ng )
+{
+	return (int) mbedtls_mpi_size(ng->N);
 }
 
-void srp_ng_delete( NGConstant * ng )
+/*
+ * Twice the security level of N (NIST SP 800-57) so the exponent is never the
+ * weaker part, and never below SRP_BITS_IN_PRIVKEY for the small groups.
+ */
+static int ng_default_exp_bits( const NGConstant *ng )
+{
+	size_t nbits = mbedtls_mpi_bitlen(ng->N);
+
+	if (nbits > 4096) return 400;
+	if (nbits > 3072) return 320;
+	return SRP_BITS_IN_PRIVKEY;
+}
+
+/* bits rounded up to whole bytes, 0 for the default of ng, -1 when out of range */
+static int exp_bits_check( const NGConstant *ng, int bits )
 {
-   if (ng)
-   {
-      mbedtls_mpi_free( ng->N );
-      mbedtls_mpi_free( ng->g );
-      free(ng->N);
-      free(ng->g);
-      free(ng);
-   }
+	if (bits<=0) return 0;
+	bits = (bits + 7) & ~7;
+	if (bits < 128 || (size_t) bits >= mbedtls_mpi_bitlen(ng->N)) return -1;
+	return bits;
 }
 
+int srp_ng_set_exponent_bits( NGConstant *ng, int bits )
+{
+	if (!ng || (bits = exp_bits_check(ng, bits)) < 0) return -1;
+	if (ng_make_private(ng)!=0) return -1;
+	srp_atomic_set(&ng->exp_bits, bits ? bits : ng_default_exp_bits(ng));
+	return 0;
+}
 
+int srp_ng_get_exponent_bits( NGConstant *ng )
+{
+	return ng ? srp_atomic_get(&ng->exp_bits) : -1;
+}
 
-SRPKeyPair * srp_keypair_new(SRPSession *session,const unsigned char * bytes_v, int len_v, const unsigned char ** bytes_B, int * len_B){
+int srp_ng_exp_bytes( const NGConstant *ng )
+{
+	return srp_atomic_get(&ng->exp_bits) / 8;
+}
 
-    mbedtls_mpi *k= 0;
-    mbedtls_mpi *tmp1=0;
-    mbedtls_mpi *tmp2=0;
-    mbedtls_mpi *v=0;
-	SRPKeyPair * keys=0;
+int srp_session_set_exponent_bits( SRPSession *session, int bits )
+{
+	if (!session || (bits = exp_bits_check(session->ng, bits)) < 0) return -1;
+	session->exp_bits = bits;
+	return 0;
+}
 
+int srp_session_get_exponent_bits( SRPSession *session )
+{
+	if (!session) return -1;
+	return session->exp_bits ? session->exp_bits : srp_ng_get_exponent_bits(session->ng);
+}
 
-    k = (mbedtls_mpi *) malloc(sizeof(mbedtls_mpi));
-	if (!k) goto cleanup;
-    mbedtls_mpi_init(k);
+int srp_session_exp_bytes( const SRPSession *session )
+{
+	return session->exp_bits ? session->exp_bits / 8 : srp_ng_exp_bytes(session->ng);
+}
 
-    tmp1 = (mbedtls_mpi *) malloc(sizeof(mbedtls_mpi));
-	if (!tmp1) goto cleanup;
-    mbedtls_mpi_init(tmp1);
 
-    tmp2 = (mbedtls_mpi *) malloc(sizeof(mbedtls_mpi));
-	if (!tmp1) goto cleanup;
-    mbedtls_mpi_init(tmp2);
+SRPKeyPair * srp_keypair_new(SRPSession *session,const unsigned char * bytes_v, int len_v, const unsigned char ** bytes_B, int * len_B){
+	return srp_keypair_new_from(session, NULL, NULL, bytes_v, len_v, bytes_B, len_B);
+}
 
-    v = (mbedtls_mpi *) malloc(sizeof(mbedtls_mpi));
-	if (!tmp1) goto cleanup;
-    mbedtls_mpi_init(v);
-	if(mbedtls_mpi_read_binary( v, bytes_v, len_v )!=0) goto cleanup;
+/*
+ * keys = (b, B = kv + g^b). (b, gb) are swapped in when gb is set, otherwise
+ * b is random. kv is k*v mod N when the caller has it, NULL to compute it.
+ * B is written to bytes_B when that is not NULL.
+ */
+static int keypair_init_v( SRPKeyPair *keys, SRPSession *session, mbedtls_mpi *b, mbedtls_mpi *gb,
+	const mbedtls_mpi *v, const mbedtls_mpi *kv, unsigned char * bytes_B, int * len_B )
+{
+	mbedtls_mpi tmp1, tmp2;
+	NGPrecomp  *pre;
+	int rc = -1;
 
+	mbedtls_mpi_init(&keys->B);
+	mbedtls_mpi_init(&keys->b);
 
-	keys   = (SRPKeyPair *) malloc( sizeof(SRPKeyPair) );
-	if (!keys) goto cleanup;
+	pre = srp_ng_precomp(session->ng, session->hash_alg);
+	if (!pre) return -1;
 
-    keys->B = (mbedtls_mpi *) malloc(sizeof(mbedtls_mpi));
-    keys->b = (mbedtls_mpi *) malloc(sizeof(mbedtls_mpi));
-	if (keys->B ==0 || keys->b==0){
-		if (keys->B) free (keys->B);
-		if (keys->b) free (keys->b);
-		free(keys);
-		keys=0;
-		goto cleanup;
-	}
-    mbedtls_mpi_init(keys->B);
-    mbedtls_mpi_init(keys->b);
+	SRP_PHASE_BEGIN(SRP_PHASE_KEYPAIR);
+	mbedtls_mpi_init(&tmp1);
+	mbedtls_mpi_init(&tmp2);
 
+	if (gb) {
+		mbedtls_mpi_swap( &keys->b, b );
+		mbedtls_mpi_swap( &tmp2, gb );
+	} else {
 #ifdef SRP_TEST_FIXED_b
-	mbedtls_mpi_read_string(keys->b,16,SRP_TEST_FIXED_b_STR);
+		mbedtls_mpi_read_string(&keys->b,16,SRP_TEST_FIXED_b_STR);
 #else 
-	mbedtls_mpi_fill_random( keys->b, SRP_BYTES_IN_PRIVKEY,
-                     &mbedtls_ctr_drbg_random,
-                     &ctr_drbg_ctx );
+		if (srp_fill_random( &keys->b, srp_session_exp_bytes(session) )!=0) goto cleanup;
 #endif
-	k = H_nn(session->hash_alg, session->ng->N, session->ng->g,1);
+		if (srp_ng_exp_g( session->ng, &tmp2, &keys->b )!=0) goto cleanup;
+	}
 
 	/* B = kv + g^b */
-	mbedtls_mpi_mul_mpi( tmp1, k, v);
-	mbedtls_mpi_exp_mod( tmp2, session->ng->g, keys->b, session->ng->N, RR );
-	mbedtls_mpi_add_mpi( tmp1, tmp1, tmp2 );
-	mbedtls_mpi_mod_mpi( keys->B, tmp1, session->ng->N );
+	if (kv) {
+		if (mbedtls_mpi_add_mpi( &tmp1, kv, &tmp2 )!=0) goto cleanup;
+	} else {
+		if (mbedtls_mpi_mul_mpi( &tmp1, &pre->k, v)!=0) goto cleanup;
+		if (mbedtls_mpi_add_mpi( &tmp1, &tmp1, &tmp2 )!=0) goto cleanup;
+	}
+	if (mbedtls_mpi_mod_mpi( &keys->B, &tmp1, session->ng->N )!=0) goto cleanup;
 
 #ifdef SRP_TEST_PRINT_b
-	tutils_mpi_print ("server priv (b)",keys->b);
+	tutils_mpi_print ("server priv (b)",&keys->b);
 #endif
 #ifdef SRP_TEST_PRINT_B
-	tutils_mpi_print ("server pub (B)",keys->B);
+	tutils_mpi_print ("server pub (B)",&keys->B);
 #endif
 
 	if (bytes_B) {
-		*len_B   = mbedtls_mpi_size(keys->B);
-		*bytes_B = malloc( *len_B );
-
-		if( !*bytes_B ){
-			if (keys->B) free (keys->B);
-			if (keys->b) free (keys->b);
-			free(keys);
-			keys=0;
-			goto cleanup;
-		}
-		mbedtls_mpi_write_binary( keys->B, (unsigned char *)*bytes_B, *len_B );
+		if (*len_B < (int)mbedtls_mpi_size(&keys->B)) goto cleanup;
+		*len_B = mbedtls_mpi_size(&keys->B);
+		mbedtls_mpi_write_binary( &keys->B, bytes_B, *len_B );
 	}
+	rc = 0;
 
 cleanup:
-	if (tmp1) {
-		mbedtls_mpi_free(tmp1);
-		free(tmp1);
+	mbedtls_mpi_free(&tmp1);
+	mbedtls_mpi_free(&tmp2);
+	if (rc!=0) srp_keypair_free(keys);
+	SRP_PHASE_END(SRP_PHASE_KEYPAIR);
+	return rc;
+}
+
+static int keypair_init_from( SRPKeyPair *keys, SRPSession *session, mbedtls_mpi *b, mbedtls_mpi *gb,
+	const unsigned char * bytes_v, int len_v, unsigned char * bytes_B, int * len_B )
+{
+	mbedtls_mpi v;
+	int rc;
+
+	mbedtls_mpi_init(&v);
+	rc = mbedtls_mpi_read_binary( &v, bytes_v, len_v );
+	if (rc==0) {
+		rc = keypair_init_v(keys, session, b, gb, &v, NULL, bytes_B, len_B);
+	} else {
+		mbedtls_mpi_init(&keys->B);
+		mbedtls_mpi_init(&keys->b);
+		rc = -1;
 	}
+	mbedtls_mpi_free(&v);
+	return rc;
+}
+
+int srp_keypair_init( SRPKeyPair * keys, SRPSession *session, const unsigned char * bytes_v, int len_v,
+	unsigned char * bytes_B, int * len_B )
+{
+	if (!keys || !session) return -1;
+	return keypair_init_from(keys, session, NULL, NULL, bytes_v, len_v, bytes_B, len_B);
+}
+
+SRPKeyPair * srp_keypair_new_from(SRPSession *session, mbedtls_mpi *b, mbedtls_mpi *gb,
+	const unsigned char * bytes_v, int len_v, const unsigned char ** bytes_B, int * len_B){
 
-	if (tmp2) {
-		mbedtls_mpi_free(tmp2);
-		free(tmp2);
+	SRPKeyPair    *keys;
+	unsigned char *buf = NULL;
+	int            len = 0;
+
+	if (bytes_B) {
+		*bytes_B = NULL;
+		*len_B = 0;
 	}
 
-	if (v) {
-		mbedtls_mpi_free(v);
-		free(v);
+	keys = (SRPKeyPair *) srp_malloc( sizeof(SRPKeyPair) );
+	if (!keys) return NULL;
+
+	if (bytes_B) {
+		len = srp_ng_size(session->ng);
+		buf = (unsigned char *) srp_malloc( len );
+		if (!buf) {
+			srp_free(keys);
+			return NULL;
+		}
 	}
 
-	if (k) {
-		mbedtls_mpi_free(k);
-		free(k);
+	if (keypair_init_from(keys, session, b, gb, bytes_v, len_v, buf, &len)!=0) {
+		srp_free(buf);
+		srp_free(keys);
+		return NULL;
+	}
+	if (bytes_B) {
+		*bytes_B = buf;
+		*len_B = len;
 	}
 	return keys;
 }
 
+void srp_keypair_free( SRPKeyPair * keys ) {
+	if (keys) {
+		mbedtls_mpi_free( &keys->B );
+		mbedtls_mpi_free( &keys->b );
+	}
+}
+
 void srp_keypair_delete( SRPKeyPair * keys ) {
 	if (keys) {
-		mbedtls_mpi_free( keys->B );
-		mbedtls_mpi_free( keys->b );
-		free(keys->B);
-		free(keys->b);
-		free(keys);
+		srp_keypair_free(keys);
+		srp_free(keys);
 	}
 }
 
 
 
-static void hash_init( SRP_HashAlgorithm alg, HashCTX *c )
+/*
+ * Every hash goes through an SRPHashImpl, picked once per algorithm: the
+ * mbedtls code, or with -DSRP_HASH_ACCEL whatever srp_hash.c has for this CPU.
+ */
+static void mbed_sha1_init( HashCTX *c )
 {
-	switch (alg) {
-		case SRP_SHA1  : {
-			mbedtls_sha1_init( &c->sha );
-			mbedtls_sha1_starts( &c->sha );
-			break;
-		}
-		case SRP_SHA224:
-		case SRP_SHA256: {
-			mbedtls_sha256_init( &c->sha256 );
-			if (alg==SRP_SHA224) {
-				mbedtls_sha256_starts( &c->sha256, 1 );
-			} else {
-				mbedtls_sha256_starts( &c->sha256, 0 );
-			}
-			break;
-		}
-		case SRP_SHA384:
-		case SRP_SHA512:{
-			mbedtls_sha512_init( &c->sha512 );
-			if (alg==SRP_SHA384) {
-				mbedtls_sha512_starts( &c->sha512, 1 );
-			} else {
-				mbedtls_sha512_starts( &c->sha512, 0 );
-			}
-			break;
-		}
-    	default:
-			return;
-	};
+	mbedtls_sha1_init( &c->u.sha );
+	mbedtls_sha1_starts( &c->u.sha );
+}
+static void mbed_sha224_init( HashCTX *c )
+{
+	mbedtls_sha256_init( &c->u.sha256 );
+	mbedtls_sha256_starts( &c->u.sha256, 1 );
+}
+static void mbed_sha256_init( HashCTX *c )
+{
+	mbedtls_sha256_init( &c->u.sha256 );
+	mbedtls_sha256_starts( &c->u.sha256, 0 );
+}
+static void mbed_sha384_init( HashCTX *c )
+{
+	mbedtls_sha512_init( &c->u.sha512 );
+	mbedtls_sha512_starts( &c->u.sha512, 1 );
+}
+static void mbed_sha512_init( HashCTX *c )
+{
+	mbedtls_sha512_init( &c->u.sha512 );
+	mbedtls_sha512_starts( &c->u.sha512, 0 );
+}
+static void mbed_sha1_update( HashCTX *c, const void *data, size_t len )
+{
+	mbedtls_sha1_update( &c->u.sha, data, len );
+}
+static void mbed_sha256_update( HashCTX *c, const void *data, size_t len )
+{
+	mbedtls_sha256_update( &c->u.sha256, data, len );
+}
+static void mbed_sha512_update( HashCTX *c, const void *data, size_t len )
+{
+	mbedtls_sha512_update( &c->u.sha512, data, len );
+}
+static void mbed_sha1_final( HashCTX *c, unsigned char *md )
+{
+	mbedtls_sha1_finish( &c->u.sha, md );
+}
+static void mbed_sha256_final( HashCTX *c, unsigned char *md )
+{
+	mbedtls_sha256_finish( &c->u.sha256, md );
+}
+static void mbed_sha512_final( HashCTX *c, unsigned char *md )
+{
+	mbedtls_sha512_finish( &c->u.sha512, md );
+}
+
+static const SRPHashImpl g_mbed_hash[SRP_SHA_LAST] = {
+	{ "mbedtls", mbed_sha1_init,   mbed_sha1_update,   mbed_sha1_final },
+	{ "mbedtls", mbed_sha224_init, mbed_sha256_update, mbed_sha256_final },
+	{ "mbedtls", mbed_sha256_init, mbed_sha256_update, mbed_sha256_final },
+	{ "mbedtls", mbed_sha384_init, mbed_sha512_update, mbed_sha512_final },
+	{ "mbedtls", mbed_sha512_init, mbed_sha512_update, mbed_sha512_final },
+};
+
+static const SRPHashImpl * g_hash_impl[SRP_SHA_LAST];
+static int g_hash_ready = 0;
+#ifdef SRP_PTHREAD
+static pthread_once_t g_hash_once = PTHREAD_ONCE_INIT;
+#endif
+
+static void hash_select_once( void )
+{
+	int i;
+	for (i=0; i<SRP_SHA_LAST; i++) {
+		const SRPHashImpl *impl = NULL;
+#ifdef SRP_HASH_ACCEL
+		impl = srp_hash_accel((SRP_HashAlgorithm) i);
+#endif
+		g_hash_impl[i] = impl ? impl : &g_mbed_hash[i];
+	}
+	srp_atomic_set(&g_hash_ready, 1);
+}
+
+static const SRPHashImpl * hash_impl( SRP_HashAlgorithm alg )
+{
+	if ((unsigned) alg >= SRP_SHA_LAST) return NULL;
+	if (!srp_atomic_get(&g_hash_ready)) {
+#ifdef SRP_PTHREAD
+		pthread_once(&g_hash_once, hash_select_once);
+#else
+		hash_select_once();
+#endif
+	}
+	return g_hash_impl[alg];
 }
 
+const char * srp_hash_backend( SRP_HashAlgorithm alg )
+{
+	const SRPHashImpl *impl = hash_impl(alg);
+	return impl ? impl->name : NULL;
+}
 
+static void hash_init( SRP_HashAlgorithm alg, HashCTX *c )
+{
+	c->impl = hash_impl(alg);
+	if (c->impl) c->impl->init( c );
+}
 static void hash_update( SRP_HashAlgorithm alg, HashCTX *c, const void *data, size_t len )
 {
-    switch (alg)
-    {
-      case SRP_SHA1  : mbedtls_sha1_update( &c->sha, data, len ); break;
-      case SRP_SHA224: mbedtls_sha256_update( &c->sha256, data, len ); break;
-      case SRP_SHA256: mbedtls_sha256_update( &c->sha256, data, len ); break;
-      case SRP_SHA384: mbedtls_sha512_update( &c->sha512, data, len ); break;
-      case SRP_SHA512: mbedtls_sha512_update( &c->sha512, data, len ); break;
-      default:
-        return;
-    };
+    (void) alg;
+    SRP_STAT_ADD(bytes_hashed, len);
+    if (c->impl) c->impl->update( c, data, len );
 }
 static void hash_final( SRP_HashAlgorithm alg, HashCTX *c, unsigned char *md )
 {
-    switch (alg)
-    {
-      case SRP_SHA1  : mbedtls_sha1_finish( &c->sha, md ); break;
-      case SRP_SHA224: mbedtls_sha256_finish( &c->sha256, md ); break;
-      case SRP_SHA256: mbedtls_sha256_finish( &c->sha256, md ); break;
-      case SRP_SHA384: mbedtls_sha512_finish( &c->sha512, md ); break;
-      case SRP_SHA512: mbedtls_sha512_finish( &c->sha512, md ); break;
-      default:
-        return;
-    };
+    (void) alg;
+    if (c->impl) c->impl->final( c, md );
 }
 static void hash( SRP_HashAlgorithm alg, const unsigned char *d, size_t n, unsigned char *md )
 {
-    switch (alg)
-    {
-      case SRP_SHA1  : mbedtls_sha1( d, n, md ); break;
-      case SRP_SHA224: mbedtls_sha256( d, n, md, 1); break;
-      case SRP_SHA256: mbedtls_sha256( d, n, md, 0); break;
-      case SRP_SHA384: mbedtls_sha512( d, n, md, 1 ); break;
-      case SRP_SHA512: mbedtls_sha512( d, n, md, 0 ); break;
-      default:
-        return;
-    };
+    HashCTX c;
+
+    hash_init( alg, &c );
+    hash_update( alg, &c, d, n );
+    hash_final( alg, &c, md );
+}
+
+/* HMAC (RFC 2104) of d under key */
+void srp_hmac( SRP_HashAlgorithm alg, const unsigned char *key, size_t key_len,
+	const unsigned char *d, size_t n, unsigned char *md )
+{
+	unsigned char pad[128], kh[SHA512_DIGEST_LENGTH];
+	size_t block = (alg==SRP_SHA384 || alg==SRP_SHA512) ? 128 : 64, i;
+	HashCTX c;
+
+	if (key_len > block) {
+		hash( alg, key, key_len, kh );
+		key = kh;
+		key_len = hash_length( alg );
+	}
+	memset(pad, 0, block);
+	memcpy(pad, key, key_len);
+	for (i=0; i<block; i++) pad[i] ^= 0x36;
+	hash_init( alg, &c );
+	hash_update( alg, &c, pad, block );
+	hash_update( alg, &c, d, n );
+	hash_final( alg, &c, md );
+
+	for (i=0; i<block; i++) pad[i] ^= 0x36 ^ 0x5c;
+	hash_init( alg, &c );
+	hash_update( alg, &c, pad, block );
+	hash_update( alg, &c, md, hash_length( alg ) );
+	hash_final( alg, &c, md );
+	memset(pad, 0, sizeof(pad));
+	memset(kh, 0, sizeof(kh));
 }
 static int hash_length( SRP_HashAlgorithm alg )
 {
@@ -463,58 +2128,92 @@ static int hash_length( SRP_HashAlgorithm alg )
         return -1;
     };
 }
+void srp_hash( SRP_HashAlgorithm alg, const unsigned char *d, size_t n, unsigned char *md )
+{
+    hash(alg, d, n, md);
+}
 int srp_hash_length( SRPSession *ses ) {
 	return hash_length(ses->hash_alg);
 }
 
-static mbedtls_mpi * H_nn( SRP_HashAlgorithm alg, const mbedtls_mpi * n1, const mbedtls_mpi * n2,int do_pad )
+/* a number that goes into a hash, as big endian bytes; see hn_bytes() and hn_mpi() */
+static void hn_bytes( HashNum *h, const unsigned char *bytes, size_t len )
+{
+    while (len > 0 && *bytes == 0) {
+        bytes++;
+        len--;
+    }
+    h->p = bytes;
+    h->len = len;
+    h->tmp = NULL;
+}
+
+static int hn_mpi( HashNum *h, const mbedtls_mpi *X, unsigned char *buf, size_t size )
+{
+    size_t len = mbedtls_mpi_size(X);
+
+    h->tmp = NULL;
+    if (len > size) {
+        buf = h->tmp = (unsigned char *) srp_tmp_calloc( 1, len );
+        if (!buf)
+           return -1;
+    }
+    h->p = buf;
+    h->len = len;
+    return mbedtls_mpi_write_binary( X, buf, len );
+}
+
+static void hn_free( HashNum *h )
+{
+    if (h->tmp) srp_tmp_free(h->tmp);
+    h->tmp = NULL;
+}
+
+/* h left padded with zeros to len bytes */
+static void hash_update_num( SRP_HashAlgorithm alg, HashCTX *ctx, const HashNum *h, size_t len )
+{
+    static const unsigned char zeros[64];
+    size_t n;
+
+    for (; len > h->len; len -= n) {
+        n = len - h->len < sizeof(zeros) ? len - h->len : sizeof(zeros);
+        hash_update( alg, ctx, zeros, n );
+    }
+    hash_update( alg, ctx, h->p, h->len );
+}
+
+static int H_nn( SRP_HashAlgorithm alg, mbedtls_mpi * r, const HashNum * n1, const HashNum * n2, int do_pad )
 {
     unsigned char   buff[ SHA512_DIGEST_LENGTH ];
-    int             len_n1 = mbedtls_mpi_size(n1);
-    int             len_n2 = mbedtls_mpi_size(n2);
-	int             nbytes = len_n1 + len_n2;
-	int kldiff;
+    size_t          len_n1 = n1->len;
+    size_t          len_n2 = n2->len;
+    HashCTX         ctx;
+
 	if (do_pad) {
-		kldiff= len_n1 - len_n2;
-		if (kldiff<0) return 0;
-		nbytes +=kldiff;
-	} else kldiff=0;
-    unsigned char * bin    = (unsigned char *) malloc( nbytes );
-    if (!bin)
-       return 0;
-	if (kldiff) memset(bin+len_n1,0,kldiff);
-    mbedtls_mpi_write_binary( n1, bin, len_n1 );
-    mbedtls_mpi_write_binary( n2, bin+len_n1+kldiff, len_n2 );
-    hash( alg, bin, nbytes, buff );
-    free(bin);
-    mbedtls_mpi * bn;
-    bn = (mbedtls_mpi *) malloc(sizeof(mbedtls_mpi));
-    mbedtls_mpi_init(bn);
-    mbedtls_mpi_read_binary( bn, buff, hash_length(alg) );
-    return bn;
-}
-
-static mbedtls_mpi * H_ns( SRP_HashAlgorithm alg, const mbedtls_mpi * n, const unsigned char * bytes, int len_bytes )
+		/* left pad the shorter one */
+		if (len_n1 < len_n2) len_n1 = len_n2;
+		else len_n2 = len_n1;
+	}
+    hash_init( alg, &ctx );
+    hash_update_num( alg, &ctx, n1, len_n1 );
+    hash_update_num( alg, &ctx, n2, len_n2 );
+    hash_final( alg, &ctx, buff );
+    return mbedtls_mpi_read_binary( r, buff, hash_length(alg) );
+}
+
+static int H_ns( SRP_HashAlgorithm alg, mbedtls_mpi * r, const HashNum * n, const unsigned char * bytes, int len_bytes )
 {
     unsigned char   buff[ SHA512_DIGEST_LENGTH ];
-    int             len_n  = mbedtls_mpi_size(n);
-    int             nbytes = len_n + len_bytes;
-    unsigned char * bin    = (unsigned char *) malloc( nbytes );
-    if (!bin)
-       return 0;
-    mbedtls_mpi_write_binary( n, bin, len_n );
-    memcpy( bin + len_n, bytes, len_bytes );
-    hash( alg, bin, nbytes, buff );
-    free(bin);
+    HashCTX         ctx;
 
-    mbedtls_mpi * bn;
-    bn = (mbedtls_mpi *) malloc(sizeof(mbedtls_mpi));
-    mbedtls_mpi_init(bn);
-    mbedtls_mpi_read_binary( bn, buff, hash_length(alg) );
-    return bn;
+    hash_init( alg, &ctx );
+    hash_update_num( alg, &ctx, n, n->len );
+    hash_update( alg, &ctx, bytes, len_bytes );
+    hash_final( alg, &ctx, buff );
+    return mbedtls_mpi_read_binary( r, buff, hash_length(alg) );
 }
 
-static mbedtls_mpi * calculate_x( SRP_HashAlgorithm alg, const mbedtls_mpi * salt, const char * username, const unsigned char * password, int password_len )
+static int calculate_x( SRP_HashAlgorithm alg, mbedtls_mpi * x, const HashNum * salt, const char * username, const unsigned char * password, int password_len )
 {
     unsigned char ucp_hash[SHA512_DIGEST_LENGTH];
     HashCTX       ctx;
@@ -535,57 +2234,42 @@ static mbedtls_mpi * calculate_x( SRP_HashAlgorithm alg, const mbedtls_mpi * sal
 #ifdef SRP_TEST_DBG_VER
 	tutils_array_print("VER:username",username, strlen(username));
 	tutils_array_print("VAR:password",password, password_len);
-	tutils_mpi_print("VAR:salt",salt);
+	tutils_array_print("VAR:salt",salt->p, salt->len);
 	tutils_array_print("VAR:ucp_hash",ucp_hash, hash_length(alg));
 #endif
-    return H_ns( alg, salt, ucp_hash, hash_length(alg) );
+    return H_ns( alg, x, salt, ucp_hash, hash_length(alg) );
 }
 
-static void update_hash_n( SRP_HashAlgorithm alg, HashCTX *ctx, const mbedtls_mpi * n )
+static void update_hash_n( SRP_HashAlgorithm alg, HashCTX *ctx, const HashNum * n )
 {
-    unsigned long len = mbedtls_mpi_size(n);
-    unsigned char * n_bytes = (unsigned char *) malloc( len );
-    if (!n_bytes)
-       return;
-    mbedtls_mpi_write_binary( n, n_bytes, len );
-    hash_update(alg, ctx, n_bytes, len);
-    free(n_bytes);
+    hash_update_num( alg, ctx, n, n->len );
 }
 
-static void hash_num( SRP_HashAlgorithm alg, const mbedtls_mpi * n, unsigned char * dest )
+static void hash_num( SRP_HashAlgorithm alg, const HashNum * n, unsigned char * dest )
 {
-    int             nbytes = mbedtls_mpi_size(n);
-    unsigned char * bin    = (unsigned char *) malloc( nbytes );
-    if(!bin)
-       return;
-    mbedtls_mpi_write_binary( n, bin, nbytes );
-    hash( alg, bin, nbytes, dest );
-    free(bin);
+    HashCTX ctx;
+
+    hash_init( alg, &ctx );
+    update_hash_n( alg, &ctx, n );
+    hash_final( alg, &ctx, dest );
 }
 
-static void calculate_M( SRP_HashAlgorithm alg, NGConstant *ng, unsigned char * dest, const char * I, const mbedtls_mpi * s,
-                         const mbedtls_mpi * A, const mbedtls_mpi * B, const unsigned char * K )
+/*
+ * M = H(H(N) xor H(g), H(I), s, A, B, K) and H_AMK = H(A, M, K) start with
+ * different inputs, so they cannot share a running hash context.
+ */
+static void calculate_M( SRP_HashAlgorithm alg, const NGPrecomp *pre, unsigned char * dest, const char * I, const HashNum * s,
+                         const HashNum * A, const HashNum * B, const unsigned char * K )
 {
-    unsigned char H_N[ SHA512_DIGEST_LENGTH ];
-    unsigned char H_g[ SHA512_DIGEST_LENGTH ];
     unsigned char H_I[ SHA512_DIGEST_LENGTH ];
-    unsigned char H_xor[ SHA512_DIGEST_LENGTH ];
     HashCTX       ctx;
-    int           i = 0;
     int           hash_len = hash_length(alg);
 
-    hash_num( alg, ng->N, H_N );
-    hash_num( alg, ng->g, H_g );
-
     hash(alg, (const unsigned char *)I, strlen(I), H_I);
 
-
-    for (i=0; i < hash_len; i++ )
-        H_xor[i] = H_N[i] ^ H_g[i];
-
     hash_init( alg, &ctx );
 
-    hash_update( alg, &ctx, H_xor, hash_len );
+    hash_update( alg, &ctx, pre->H_xor, hash_len );
     hash_update( alg, &ctx, H_I,   hash_len );
     update_hash_n( alg, &ctx, s );
     update_hash_n( alg, &ctx, A );
@@ -595,52 +2279,143 @@ static void calculate_M( SRP_HashAlgorithm alg, NGConstant *ng, unsigned char *
     hash_final( alg, &ctx, dest );
 }
 
-static void calculate_H_AMK( SRP_HashAlgorithm alg, unsigned char *dest, const mbedtls_mpi * A, const unsigned char * M, const unsigned char * K )
+static void calculate_H_AMK( SRP_HashAlgorithm alg, unsigned char *dest, const HashNum * A, const unsigned char * M, const unsigned char * K )
+{
+    HashCTX ctx;
+
+    hash_init( alg, &ctx );
+
+    update_hash_n( alg, &ctx, A );
+    hash_update( alg, &ctx, M, hash_length(alg) );
+    hash_update( alg, &ctx, K, hash_length(alg) );
+
+    hash_final( alg, &ctx, dest );
+}
+
+
+static void init_random_once()
+{
+     mbedtls_entropy_init( &entropy_ctx );
+
+     static const unsigned char hotBits[128] = {
+    82, 42, 71, 87, 124, 241, 30, 1, 54, 239, 240, 121, 89, 9, 151, 11, 60,
+    226, 142, 47, 115, 157, 100, 126, 242, 132, 46, 12, 56, 197, 194, 76,
+    198, 122, 90, 241, 255, 43, 120, 209, 69, 21, 195, 212, 100, 251, 18,
+    111, 30, 238, 24, 199, 238, 236, 138, 225, 45, 15, 42, 83, 114, 132,
+    165, 141, 32, 185, 167, 100, 131, 23, 236, 9, 11, 51, 130, 136, 97, 161,
+    36, 174, 129, 234, 2, 54, 119, 184, 70, 103, 118, 109, 122, 15, 24, 23,
+    166, 203, 102, 160, 77, 100, 17, 4, 132, 138, 215, 204, 109, 245, 122,
+    9, 184, 89, 70, 247, 125, 97, 213, 240, 85, 243, 91, 226, 127, 64, 136,
+    37, 154, 232
+};
+	memcpy(g_pers, hotBits, sizeof(hotBits));
+	g_pers_len = sizeof(hotBits);
+
+#ifdef SRP_PTHREAD
+	pthread_key_create(&g_random_key, random_thread_free);
+#endif
+	srp_atomic_set(&g_initialized, 1);
+}
+
+static void init_random()
+{
+#ifdef SRP_PTHREAD
+	pthread_once(&g_random_once, init_random_once);
+#else
+	if (!g_initialized) init_random_once();
+#endif
+}
+
+/* the entropy context is shared, reseeds from any thread go through here */
+static int locked_entropy_func( void *data, unsigned char *output, size_t len )
+{
+	int rc;
+#ifdef SRP_PTHREAD
+	pthread_mutex_lock(&g_entropy_lock);
+#endif
+	rc = mbedtls_entropy_func(data, output, len);
+#ifdef SRP_PTHREAD
+	pthread_mutex_unlock(&g_entropy_lock);
+#endif
+	return rc;
+}
+
+#ifdef SRP_PTHREAD
+static void random_thread_free( void *p )
+{
+	SRPRandom *r = (SRPRandom *)p;
+	if (r) {
+		mbedtls_ctr_drbg_free(&r->drbg);
+		memset(r, 0, sizeof(SRPRandom));
+		srp_free(r);
+	}
+}
+#endif
+
+/* this thread's generator state, created on first use */
+static SRPRandom * random_thread()
 {
-    HashCTX ctx;
-
-    hash_init( alg, &ctx );
-
-    update_hash_n( alg, &ctx, A );
-    hash_update( alg, &ctx, M, hash_length(alg) );
-    hash_update( alg, &ctx, K, hash_length(alg) );
-
-    hash_final( alg, &ctx, dest );
+	SRPRandom *r;
+
+	init_random();
+#ifdef SRP_PTHREAD
+	r = (SRPRandom *) pthread_getspecific(g_random_key);
+	if (r) return r;
+	r = (SRPRandom *) srp_malloc(sizeof(SRPRandom));
+	if (!r) return NULL;
+	memset(r, 0, sizeof(SRPRandom));
+	mbedtls_ctr_drbg_init(&r->drbg);
+	if (pthread_setspecific(g_random_key, r)!=0) {
+		random_thread_free(r);
+		return NULL;
+	}
+#else
+	r = &g_random;
+	if (!r->seeded && !r->f_rng) mbedtls_ctr_drbg_init(&r->drbg);
+#endif
+	return r;
 }
 
+static int random_thread_seed( SRPRandom *r, const unsigned char *pers, size_t pers_len )
+{
+	unsigned char buf[sizeof(g_pers) + sizeof(void *)];
+	int rc;
+
+	/* mix in the state address so threads never share a personalization */
+	if (pers_len > sizeof(g_pers)) pers_len = sizeof(g_pers);
+	memcpy(buf, pers, pers_len);
+	memcpy(buf + pers_len, &r, sizeof(void *));
+
+	rc = mbedtls_ctr_drbg_seed(&r->drbg, locked_entropy_func, &entropy_ctx, buf, pers_len + sizeof(void *));
+	memset(buf, 0, sizeof(buf));
+	if (rc==0) r->seeded = 1;
+	return rc;
+}
 
-static void init_random()
+int srp_fill_random( mbedtls_mpi *X, size_t size )
 {
-    if (g_initialized)
-        return;
+	SRPRandom *r;
 
-     mbedtls_entropy_init( &entropy_ctx );
-     mbedtls_ctr_drbg_init( &ctr_drbg_ctx );
+	if (g_f_rng) return mbedtls_mpi_fill_random(X, size, g_f_rng, g_p_rng);
 
-     unsigned char hotBits[128] = {
-    82, 42, 71, 87, 124, 241, 30, 1, 54, 239, 240, 121, 89, 9, 151, 11, 60,
-    226, 142, 47, 115, 157, 100, 126, 242, 132, 46, 12, 56, 197, 194, 76,
-    198, 122, 90, 241, 255, 43, 120, 209, 69, 21, 195, 212, 100, 251, 18,
-    111, 30, 238, 24, 199, 238, 236, 138, 225, 45, 15, 42, 83, 114, 132,
-    165, 141, 32, 185, 167, 100, 131, 23, 236, 9, 11, 51, 130, 136, 97, 161,
-    36, 174, 129, 234, 2, 54, 119, 184, 70, 103, 118, 109, 122, 15, 24, 23,
-    166, 203, 102, 160, 77, 100, 17, 4, 132, 138, 215, 204, 109, 245, 122,
-    9, 184, 89, 70, 247, 125, 97, 213, 240, 85, 243, 91, 226, 127, 64, 136,
-    37, 154, 232
-};
+	r = random_thread();
+	if (!r) return MBEDTLS_ERR_MPI_ALLOC_FAILED;
+	if (r->f_rng) return mbedtls_mpi_fill_random(X, size, r->f_rng, r->p_rng);
+	if (!r->seeded && random_thread_seed(r, g_pers, g_pers_len)!=0) return -1;
+	return mbedtls_mpi_fill_random(X, size, mbedtls_ctr_drbg_random, &r->drbg);
+}
 
-     mbedtls_ctr_drbg_seed(
-        &ctr_drbg_ctx,
-        mbedtls_entropy_func,
-        &entropy_ctx,
-        hotBits,
-        128
-    );
+int srp_random_bytes( unsigned char *buf, size_t len )
+{
+	SRPRandom *r;
 
-    RR = (mbedtls_mpi *) malloc(sizeof(mbedtls_mpi));
-    mbedtls_mpi_init(RR);
-    g_initialized = 1;
+	if (g_f_rng) return g_f_rng(g_p_rng, buf, len);
 
+	r = random_thread();
+	if (!r) return -1;
+	if (r->f_rng) return r->f_rng(r->p_rng, buf, len);
+	if (!r->seeded && random_thread_seed(r, g_pers, g_pers_len)!=0) return -1;
+	return mbedtls_ctr_drbg_random(&r->drbg, buf, len);
 }
 
 
@@ -659,7 +2434,7 @@ SRPSession * srp_session_new( SRP_HashAlgorithm alg,
 
     SRPSession * session;
 
-    session = (SRPSession *)malloc(sizeof(SRPSession));
+    session = (SRPSession *)srp_malloc(sizeof(SRPSession));
 
 	if (!session) return NULL;
 
@@ -668,7 +2443,7 @@ SRPSession * srp_session_new( SRP_HashAlgorithm alg,
     session->hash_alg = alg;
     session->ng  = srp_ng_new( ng_type, n_hex, g_hex );
 	if (!session->ng) {
-		free(session);
+		srp_free(session);
 		return NULL;
 	}
     init_random(); /* Only happens once */
@@ -679,25 +2454,52 @@ SRPSession * srp_session_new( SRP_HashAlgorithm alg,
 void srp_session_delete(SRPSession *session)
 {
     srp_ng_delete( session->ng );
-    free(session);
+    srp_free(session);
 }
 
 int srp_random_seeded(){
-	return g_initialized;
+	return srp_atomic_get(&g_initialized);
 }
 
 void srp_random_seed( const unsigned char * random_data, int data_length )
 {
-    g_initialized = 1;
+	SRPRandom *r;
 
+	init_random();
+	if (!random_data || data_length<=0) return;
 
-   if( mbedtls_ctr_drbg_seed( &ctr_drbg_ctx, mbedtls_entropy_func, &entropy_ctx,
-                           (const unsigned char *) random_data,
-                           data_length )  != 0 )
-    {
-        return;
-    }
+	/* becomes the personalization string of threads seeded from now on */
+#ifdef SRP_PTHREAD
+	pthread_mutex_lock(&g_entropy_lock);
+#endif
+	g_pers_len = (size_t)data_length < sizeof(g_pers) ? (size_t)data_length : sizeof(g_pers);
+	memcpy(g_pers, random_data, g_pers_len);
+#ifdef SRP_PTHREAD
+	pthread_mutex_unlock(&g_entropy_lock);
+#endif
+
+	r = random_thread();
+	if (!r) return;
+	if (r->seeded) {
+		mbedtls_ctr_drbg_reseed(&r->drbg, random_data, data_length);
+	} else {
+		random_thread_seed(r, random_data, data_length);
+	}
+}
+
+void srp_set_rng( srp_rng_func f_rng, void * p_rng )
+{
+	init_random();
+	g_p_rng = p_rng;
+	g_f_rng = f_rng;
+}
 
+void srp_set_thread_rng( srp_rng_func f_rng, void * p_rng )
+{
+	SRPRandom *r = random_thread();
+	if (!r) return;
+	r->p_rng = p_rng;
+	r->f_rng = f_rng;
 }
 
 void srp_create_salted_verification_key( SRPSession *session,
@@ -716,88 +2518,126 @@ void srp_create_salted_verification_key1( SRPSession *session,
                                          const unsigned char ** bytes_s, int  len_s,
                                          const unsigned char ** bytes_v, int * len_v)
 {
+	unsigned char *s, *v;
+	int vlen;
 
 	*bytes_s=NULL;
 	*bytes_v=NULL;
-	if( !session) return;
+	if( !session || len_s<=0 ) return;
+
+	vlen = srp_ng_size(session->ng);
+	s = (unsigned char *) srp_malloc( len_s );
+	v = (unsigned char *) srp_malloc( vlen );
+	if (s && v && srp_create_salted_verification_key2(session, username, password, len_password, s, len_s, v, &vlen)==0) {
+		*bytes_s = s;
+		*bytes_v = v;
+		*len_v = vlen;
+		return;
+	}
+	srp_free(s);
+	srp_free(v);
+}
+
+int srp_create_salted_verification_key2( SRPSession *session,
+                                         const char * username,
+                                         const unsigned char * password, int len_password,
+                                         unsigned char * bytes_s, int  len_s,
+                                         unsigned char * bytes_v, int * len_v)
+{
+    mbedtls_mpi     s, v, x;
+    HashNum         hs;
+    int             rc = -1;
 
-    mbedtls_mpi     * s=NULL;
-    mbedtls_mpi     * v=NULL;
-    mbedtls_mpi     * x=NULL;
+	if( !session) return -1;
+	if( !srp_ng_precomp(session->ng, session->hash_alg)) return -1;
 
-    s = (mbedtls_mpi *) malloc(sizeof(mbedtls_mpi));
-	if (s) {
-	    mbedtls_mpi_init(s);
-	} else {
-		goto cleanup_and_exit;
-	}
+    SRP_PHASE_BEGIN(SRP_PHASE_CREATE_VERIFIER);
+    mbedtls_mpi_init(&s);
+    mbedtls_mpi_init(&v);
+    mbedtls_mpi_init(&x);
 
-    v = (mbedtls_mpi *) malloc(sizeof(mbedtls_mpi));
-    if( v ){
-	    mbedtls_mpi_init(v);
-	} else {
-		goto cleanup_and_exit;
-	}
 #ifdef SRP_TEST_FIXED_SALT
-	mbedtls_mpi_read_string(s,16,SRP_TEST_FIXED_SALT_STR);
+	mbedtls_mpi_read_string(&s,16,SRP_TEST_FIXED_SALT_STR);
 #else
-    mbedtls_mpi_fill_random( s, len_s,
-                     &mbedtls_ctr_drbg_random,
-                     &ctr_drbg_ctx );
+    if (srp_fill_random( &s, len_s )!=0)
+       goto cleanup_and_exit;
 #endif
 
 #ifdef SRP_TEST_PRINT_SALT
-	tutils_mpi_print ("salt (s)",s);
+	tutils_mpi_print ("salt (s)",&s);
 #endif
 
-    x = calculate_x( session->hash_alg, s, username, password, len_password );
-
-    if( !x )
+    /* x hashes the salt as it goes out */
+    if (mbedtls_mpi_write_binary( &s, bytes_s, len_s )!=0)
+       goto cleanup_and_exit;
+    hn_bytes( &hs, bytes_s, len_s );
+    if (calculate_x( session->hash_alg, &x, &hs, username, password, len_password )!=0)
        goto cleanup_and_exit;
 
-    mbedtls_mpi_exp_mod(v, session->ng->g, x, session->ng->N, RR);
+    if (srp_ng_exp_g(session->ng, &v, &x)!=0)
+       goto cleanup_and_exit;
 
 #ifdef SRP_TEST_PRINT_v
-	tutils_mpi_print ("verifier (v)",v);
+	tutils_mpi_print ("verifier (v)",&v);
 #endif
 
-    *bytes_s = (const unsigned char *) malloc( len_s );
-	if (*bytes_s==NULL) {
-		 goto cleanup_and_exit;
-	}
-
-    *len_v   = mbedtls_mpi_size(v);
-    *bytes_v = (const unsigned char *) malloc( *len_v );
-	if (*bytes_v==NULL) {
-		free((void*)(*bytes_s));
-		*bytes_s=NULL;
-		 goto cleanup_and_exit;
-	}
-
+    if (*len_v < (int)mbedtls_mpi_size(&v))
+       goto cleanup_and_exit;
+    *len_v = mbedtls_mpi_size(&v);
+    mbedtls_mpi_write_binary( &v, bytes_v, *len_v );
+    rc = 0;
 
+ cleanup_and_exit:
+    mbedtls_mpi_free(&s);
+    mbedtls_mpi_free(&v);
+    mbedtls_mpi_free(&x);
+    SRP_PHASE_END(SRP_PHASE_CREATE_VERIFIER);
+    return rc;
+}
 
-    mbedtls_mpi_write_binary( s, (unsigned char *)*bytes_s, len_s );
-    mbedtls_mpi_write_binary( v, (unsigned char *)*bytes_v, *len_v );
 
- cleanup_and_exit:
-	if (s) {
-    	mbedtls_mpi_free(s);
-    	free(s);
-	}
 
-    if (v) {
-		mbedtls_mpi_free(v);
-    	free(v);
-	}
+/* len_s bytes of salt as srp_create_salted_verification_key2() draws them */
+int srp_salt( unsigned char *bytes_s, int len_s )
+{
+    mbedtls_mpi s;
+    int         rc = -1;
 
-    if (x) {
-		mbedtls_mpi_free(x);
-	    free(x);
-	}
-    //TODO: BN_CTX_free(ctx);
+    if (len_s <= 0) return -1;
+    mbedtls_mpi_init(&s);
+#ifdef SRP_TEST_FIXED_SALT
+    if (mbedtls_mpi_read_string(&s,16,SRP_TEST_FIXED_SALT_STR)==0)
+#else
+    if (srp_fill_random( &s, len_s )==0)
+#endif
+        rc = mbedtls_mpi_write_binary( &s, bytes_s, len_s )==0 ? 0 : -1;
+    mbedtls_mpi_free(&s);
+    return rc;
 }
 
-
+/* the v = g^x half of srp_create_salted_verification_key2(), x hashed by the caller */
+int srp_verification_key_x( SRPSession *session, const unsigned char *bytes_x, int len_x,
+                            unsigned char *bytes_v, int *len_v )
+{
+    mbedtls_mpi v, x;
+    int         rc = -1;
+
+    if (!session || !bytes_x || len_x!=hash_length(session->hash_alg)) return -1;
+
+    SRP_PHASE_BEGIN(SRP_PHASE_CREATE_VERIFIER);
+    mbedtls_mpi_init(&v);
+    mbedtls_mpi_init(&x);
+    if (mbedtls_mpi_read_binary( &x, bytes_x, len_x )==0
+        && srp_ng_exp_g(session->ng, &v, &x)==0
+        && *len_v >= (int)mbedtls_mpi_size(&v)) {
+        *len_v = mbedtls_mpi_size(&v);
+        rc = mbedtls_mpi_write_binary( &v, bytes_v, *len_v )==0 ? 0 : -1;
+    }
+    mbedtls_mpi_free(&v);
+    mbedtls_mpi_free(&x);
+    SRP_PHASE_END(SRP_PHASE_CREATE_VERIFIER);
+    return rc;
+}
 
 /* Out: bytes_B, len_B.
  *
@@ -830,140 +2670,406 @@ SRPVerifier *  srp_verifier_new1( SRPSession *session,
                                         const unsigned char ** bytes_B, int * len_B,
                                         SRPKeyPair *keys)
 {
+	SRPVerifier   *ver;
+	unsigned char *buf = NULL;
+	char          *uname = NULL;
+	int            len = 0;
+
 	if (bytes_B) {
 		*bytes_B=NULL;
 		*len_B=0;
 	}
 
 	if( session==NULL ) return NULL;
+	if (srp_ng_precomp(session->ng, session->hash_alg)==NULL) return NULL;
 
-    mbedtls_mpi *s;
-    s = (mbedtls_mpi *) malloc(sizeof(mbedtls_mpi));
-    mbedtls_mpi_init(s);
-    mbedtls_mpi_read_binary(s, bytes_s, len_s);
+	ver = (SRPVerifier *) srp_malloc( sizeof(SRPVerifier) );
+	if (!ver) return NULL;
 
-    mbedtls_mpi *v;
-    v = (mbedtls_mpi *) malloc(sizeof(mbedtls_mpi));
-    mbedtls_mpi_init(v);
-    mbedtls_mpi_read_binary(v, bytes_v, len_v);
+	if (bytes_B && !keys) {
+		len = srp_ng_size(session->ng);
+		buf = (unsigned char *) srp_malloc( len );
+		if (!buf) goto err_exit;
+	}
+
+	if (copy_username){
+		int ulen = strlen(username) + 1;
+		uname = (char *) srp_malloc( ulen );
+		if (!uname) goto err_exit;
+		memcpy( uname, username, ulen );
+		username = uname;
+	}
+
+	/* on failure ver stays around with empty proofs, as it always did */
+	if (srp_verifier_init(ver, session, username, bytes_s, len_s, bytes_v, len_v,
+		bytes_A, len_A, buf, &len, keys)==0 && buf) {
+		*bytes_B = buf;
+		*len_B = len;
+	} else {
+		srp_free(buf);
+	}
+	ver->owns_username = copy_username;
+	return ver;
 
-    mbedtls_mpi *A;
-    A = (mbedtls_mpi *) malloc(sizeof(mbedtls_mpi));
-    mbedtls_mpi_init(A);
-    mbedtls_mpi_read_binary(A, bytes_A, len_A);
+err_exit:
+	srp_free(buf);
+	srp_free(ver);
+	return NULL;
+}
+
+int srp_verifier_init( SRPVerifier * ver, SRPSession * session,
+                                        const char * username,
+                                        const unsigned char * bytes_s, int len_s,
+                                        const unsigned char * bytes_v, int len_v,
+                                        const unsigned char * bytes_A, int len_A,
+                                        unsigned char * bytes_B, int * len_B,
+                                        SRPKeyPair * keys )
+{
+	SRPArena    *arena;
+	mbedtls_mpi  v;
+	int          rc = -1;
 
-    mbedtls_mpi             *u    = 0;
+	if (!ver || !session) return -1;
+	memset(ver,0,sizeof(SRPVerifier));
+	ver->hash_alg = session->hash_alg;
+	ver->ng       = session->ng;
+	ver->username = username;
+	if (srp_ng_precomp(session->ng, session->hash_alg)==NULL) return -1;
+
+	arena = arena_enter();
+	mbedtls_mpi_init(&v);
+	if (mbedtls_mpi_read_binary(&v, bytes_v, len_v)==0) {
+		rc = srp_verifier_init_v(ver, session, username, bytes_s, len_s, bytes_A, len_A,
+			bytes_B, len_B, keys, &v, NULL, NULL);
+	}
+	mbedtls_mpi_free(&v);
+	arena_leave(arena);
+	return rc;
+}
 
+/*
+ * srp_verifier_init() on a decoded v. kv = k*v mod N and vtab, a fixed base
+ * table for v covering the hash length, are optional.
+ */
+int srp_verifier_init_v( SRPVerifier * ver, SRPSession * session, const char * username,
+	const unsigned char * bytes_s, int len_s, const unsigned char * bytes_A, int len_A,
+	unsigned char * bytes_B, int * len_B, SRPKeyPair * keys,
+	const mbedtls_mpi *v, const mbedtls_mpi *kv, const SRPFixedBase *vtab )
+{
+	SRPKeyPair   tmp_keys;
+	SRPArena    *arena;
+	NGPrecomp   *pre;
+	mbedtls_mpi  A, u, S, tmp1;
+	unsigned char buf_B[ SRP_MAX_N_BYTES ], buf_S[ SRP_MAX_N_BYTES ];
+	HashNum      hs, hA, hB, hS;
+	int          rc = -1;
 
-    mbedtls_mpi             *S;
-    S = (mbedtls_mpi *) malloc(sizeof(mbedtls_mpi));
-    mbedtls_mpi_init(S);
+	if (!ver || !session) return -1;
 
+	memset(ver,0,sizeof(SRPVerifier));
+	ver->hash_alg = session->hash_alg;
+	ver->ng       = session->ng;
+	ver->username = username;
+
+	pre = srp_ng_precomp(session->ng, session->hash_alg);
+	if (pre==NULL) return -1;
+
+	SRP_PHASE_BEGIN(SRP_PHASE_VERIFIER);
+	/* nothing computed below outlives the call: B and the proofs are bytes */
+	arena = arena_enter();
+	mbedtls_mpi_init(&A);
+	mbedtls_mpi_init(&u);
+	mbedtls_mpi_init(&S);
+	mbedtls_mpi_init(&tmp1);
+	hB.tmp = hS.tmp = NULL;
+
+	/* s and A are hashed as they came in, s is never needed as a number */
+	hn_bytes(&hs, bytes_s, len_s);
+	hn_bytes(&hA, bytes_A, len_A);
+	if (mbedtls_mpi_read_binary(&A, bytes_A, len_A)!=0) goto cleanup_and_exit;
+
+	/* SRP-6a safety check */
+	mbedtls_mpi_mod_mpi( &tmp1, &A, session->ng->N );
+	if ( mbedtls_mpi_cmp_int( &tmp1, 0 ) == 0 ) {
+		SRP_STAT_ADD(rejected, 1);
+		goto cleanup_and_exit;
+	}
 
-    //mbedtls_mpi             *k    = 0;
+	if (keys==NULL) {
+		if (keypair_init_v(&tmp_keys, session, NULL, NULL, v, kv, bytes_B, len_B)!=0) goto cleanup_and_exit;
+		keys = &tmp_keys;
+	}
+	if (keys==&tmp_keys && bytes_B) {
+		hn_bytes(&hB, bytes_B, *len_B);
+	} else if (hn_mpi(&hB, &keys->B, buf_B, sizeof(buf_B))!=0) {
+		goto cleanup_and_exit;
+	}
 
-    mbedtls_mpi             *tmp1;
-    tmp1 = (mbedtls_mpi *) malloc(sizeof(mbedtls_mpi));
-    mbedtls_mpi_init(tmp1);
+	if (H_nn(session->hash_alg, &u, &hA, &hB, 1)!=0) goto cleanup_and_exit;
 
-    mbedtls_mpi             *tmp2;
-    tmp2 = (mbedtls_mpi *) malloc(sizeof(mbedtls_mpi));
-    mbedtls_mpi_init(tmp2);
+	if (vtab && srp_ng_table_exp(session->ng, vtab, &tmp1, &u)==0) {
+		/* S = (A * v^u) ^ b, v^u from the table costs no squarings */
+		if (mbedtls_mpi_mul_mpi(&tmp1, &tmp1, &A)!=0) goto cleanup_and_exit;
+		if (mbedtls_mpi_mod_mpi(&tmp1, &tmp1, session->ng->N)!=0) goto cleanup_and_exit;
+		if (srp_ng_exp_mod(session->ng, &S, &tmp1, &keys->b)!=0) goto cleanup_and_exit;
+	} else {
+		/* S = (A *(v^u)) ^ b = A^b * v^(u*b) */
+		if (mbedtls_mpi_mul_mpi(&u, &u, &keys->b)!=0) goto cleanup_and_exit;
+		if (srp_ng_exp_mod2(session->ng, &S, &A, &keys->b, v, &u)!=0) goto cleanup_and_exit;
+	}
 
+	if (hn_mpi(&hS, &S, buf_S, sizeof(buf_S))!=0) goto cleanup_and_exit;
+	hash_num(session->hash_alg, &hS, ver->session_key);
 
-    SRPVerifier *ver ;
-    ver = (SRPVerifier *) malloc( sizeof(SRPVerifier) );
+	calculate_M( session->hash_alg, pre, ver->M, username, &hs, &hA, &hB, ver->session_key );
+	calculate_H_AMK( session->hash_alg, ver->H_AMK, &hA, ver->M, ver->session_key );
+	rc = 0;
 
-    if(!S || !tmp1 || !tmp2 || !ver ) {
-		if (ver) {free(ver); ver=NULL; };
-       goto cleanup_and_exit;
-    }
+ cleanup_and_exit:
+	if (keys==&tmp_keys) srp_keypair_free(&tmp_keys);
+	hn_free(&hB);
+	hn_free(&hS);
+	mbedtls_mpi_free(&A);
+	mbedtls_mpi_free(&u);
+	mbedtls_mpi_free(&S);
+	mbedtls_mpi_free(&tmp1);
+	arena_leave(arena);
+	SRP_PHASE_END(SRP_PHASE_VERIFIER);
+	return rc;
+}
 
-	memset(ver,0,sizeof(SRPVerifier));
-    ver->hash_alg = session->hash_alg;
-    ver->ng       = session->ng;
+void srp_verifier_free( SRPVerifier * ver ){
+	if (ver) memset(ver, 0, sizeof(*ver));
+}
 
-	if (copy_username){
-		int ulen = strlen(username) + 1;
-		ver->username = (char *) malloc( ulen ); // FIXME
-		if (!ver->username) {
-			free(ver);
-			ver = 0;
-			goto cleanup_and_exit;
-		}
-		memcpy( (char*)ver->username, username, ulen );
+void srp_verifier_delete( SRPVerifier * ver ){
+	if (ver) {
+		/* ver->ng is the session's group, srp_session_delete() frees it */
+		if (ver->owns_username) srp_free( (char *) ver->username );
+		srp_verifier_free( ver );
+		srp_free( ver );
 	}
+}
 
-    /* SRP-6a safety check */
-    mbedtls_mpi_mod_mpi( tmp1, A, session->ng->N );
-    if ( mbedtls_mpi_cmp_int( tmp1, 0 )  != 0)
-    {
-		int temp_keys;
-		if (keys==NULL) {
-			temp_keys=1;
-			keys=srp_keypair_new(session,bytes_v,len_v,bytes_B,len_B);
-			if (keys==NULL) goto cleanup_and_exit;
-		} else temp_keys=0;
-		/*
-        mbedtls_mpi_fill_random( b, SRP_BYTES_IN_PRIVKEY,
-                     &mbedtls_ctr_drbg_random,
-                     &ctr_drbg_ctx );
-
-       //k = H_nn(session->hash_alg, session->ng->N, session->ng->g);
-
-       // B = kv + g^b 
-       //mbedtls_mpi_mul_mpi( tmp1, k, v);
-       //mbedtls_mpi_exp_mod( tmp2, session->ng->g, b, session->ng->N, RR );
-       //mbedtls_mpi_add_mpi( tmp1, tmp1, tmp2 );
-       //mbedtls_mpi_mod_mpi( B, tmp1, session->ng->N );
-		*/
-
-       u = H_nn(session->hash_alg, A, keys->B,1); 
-
-       /* S = (A *(v^u)) ^ b */
-       mbedtls_mpi_exp_mod(tmp1, v, u, session->ng->N, RR);
-       mbedtls_mpi_mul_mpi(tmp2, A, tmp1);
-       mbedtls_mpi_exp_mod(S, tmp2, keys->b, session->ng->N, RR);
-
-       hash_num(session->hash_alg, S, ver->session_key);
-
-       calculate_M( session->hash_alg, session->ng, ver->M, username, s, A, keys->B, ver->session_key );
-       calculate_H_AMK( session->hash_alg, ver->H_AMK, A, ver->M, ver->session_key );
-
-		if (temp_keys) srp_keypair_delete(keys);
-    }
+/*
+ * srp_verifier_init() in slices. g^b and S = A^b * v^(u*b) are MontExp runs
+ * that srp_verifier_job_step() advances a budget of multiplications at a
+ * time; the hashing and the cheap arithmetic in between happen at the end of
+ * a slice. Groups without an SRPMont do each exponentiation in one slice.
+ */
+enum { JOB_GB, JOB_S, JOB_DONE, JOB_FAILED };
 
- cleanup_and_exit:
-    mbedtls_mpi_free(s);
-    free(s);
-    mbedtls_mpi_free(v);
-    free(v);
-    mbedtls_mpi_free(A);
-    free(A);
-    if (u) {mbedtls_mpi_free(u); free(u);}
+struct SRPVerifierJob
+{
+	SRPSession        *session;
+	const char        *username;
+	NGPrecomp         *pre;
+	int                stage;
+	mbedtls_mpi        A, v, b, B, ub, S;
+	unsigned char     *bytes;       /* s, A, then B */
+	int                len_s, len_A, len_B;
+	mbedtls_mpi_uint  *tab;         /* Straus tables for both runs */
+	size_t             tab_size;
+	SRPMont           *mont;        /* the group's, as it was when the job started */
+	SRPFixedBase      *gtab;        /* reference on the table for g of the first run */
+	MontExp            exp;
+	unsigned char      M           [SHA512_DIGEST_LENGTH];
+	unsigned char      H_AMK       [SHA512_DIGEST_LENGTH];
+	unsigned char      session_key [SHA512_DIGEST_LENGTH];
+};
+
+/* wipes what the job no longer needs once it is done or has failed */
+static void job_clear( SRPVerifierJob *job )
+{
+	mbedtls_mpi_free(&job->A);
+	mbedtls_mpi_free(&job->v);
+	mbedtls_mpi_free(&job->b);
+	mbedtls_mpi_free(&job->B);
+	mbedtls_mpi_free(&job->ub);
+	mbedtls_mpi_free(&job->S);
+	if (job->tab) {
+		memset(job->tab, 0, job->tab_size);
+		srp_free(job->tab);
+		job->tab = NULL;
+	}
+	fixed_base_release(job->gtab);
+	job->gtab = NULL;
+	memset(&job->exp, 0, sizeof(job->exp));
+}
+
+SRPVerifierJob * srp_verifier_job_new( SRPSession * session, const char * username,
+	const unsigned char * bytes_s, int len_s, const unsigned char * bytes_v, int len_v,
+	const unsigned char * bytes_A, int len_A )
+{
+	SRPVerifierJob *job;
+	NGConstant *ng;
+	int rc = -1;
+
+	if (!session || !username || len_s < 0 || len_A < 0) return NULL;
+	ng = session->ng;
+	job = (SRPVerifierJob *) srp_malloc(sizeof(SRPVerifierJob));
+	if (!job) return NULL;
+	memset(job, 0, sizeof(SRPVerifierJob));
+	job->session  = session;
+	job->username = username;
+	mbedtls_mpi_init(&job->A);
+	mbedtls_mpi_init(&job->v);
+	mbedtls_mpi_init(&job->b);
+	mbedtls_mpi_init(&job->B);
+	mbedtls_mpi_init(&job->ub);
+	mbedtls_mpi_init(&job->S);
+
+	job->pre = srp_ng_precomp(ng, session->hash_alg);
+	if (!job->pre) goto cleanup;
+
+	/* the inputs may be gone by the time the hashes need them */
+	job->bytes = (unsigned char *) srp_malloc(len_s + len_A + srp_ng_size(ng));
+	if (!job->bytes) goto cleanup;
+	memcpy(job->bytes, bytes_s, len_s);
+	memcpy(job->bytes + len_s, bytes_A, len_A);
+	job->len_s = len_s;
+	job->len_A = len_A;
+
+	if (mbedtls_mpi_read_binary(&job->A, bytes_A, len_A)!=0) goto cleanup;
+	if (mbedtls_mpi_read_binary(&job->v, bytes_v, len_v)!=0) goto cleanup;
+
+	/* SRP-6a safety check */
+	if (mbedtls_mpi_mod_mpi(&job->S, &job->A, ng->N)!=0) goto cleanup;
+	if (mbedtls_mpi_cmp_int(&job->S, 0)==0) {
+		SRP_STAT_ADD(rejected, 1);
+		goto cleanup;
+	}
+
+#ifdef SRP_TEST_FIXED_b
+	mbedtls_mpi_read_string(&job->b,16,SRP_TEST_FIXED_b_STR);
+#else
+	if (srp_fill_random( &job->b, srp_session_exp_bytes(session) )!=0) goto cleanup;
+#endif
 
-    mbedtls_mpi_free(S);
-    free(S);
-    mbedtls_mpi_free(tmp1);
-    free(tmp1);
-    mbedtls_mpi_free(tmp2);
-    free(tmp2);
+	job->mont = ng_mont(ng);
+	if (job->mont) {
+		job->tab_size = 2 * ((size_t)1 << SRP_MULTI_EXP_W) * job->mont->n * sizeof(mbedtls_mpi_uint);
+		job->tab = (mbedtls_mpi_uint *) srp_malloc(job->tab_size);
+		if (!job->tab) goto cleanup;
+		SRP_STAT_EXP(ng);
+		job->gtab = srp_ng_gtab_get(ng);
+		if (!job->gtab || mont_exp_start_fixed(&job->exp, job->gtab, job->mont, &job->b, 1)!=0) {
+			if (mont_exp_start(&job->exp, job->mont, ng->N, job->tab, ng->g, &job->b, NULL, NULL)!=0) goto cleanup;
+		}
+	}
+	job->stage = JOB_GB;
+	rc = 0;
 
-    return ver;
+cleanup:
+	if (rc!=0) {
+		srp_verifier_job_delete(job);
+		return NULL;
+	}
+	return job;
 }
 
+/* one slice; 0 when it went fine, whether or not the job is done */
+static int job_advance( SRPVerifierJob *job, int budget )
+{
+	SRP_HashAlgorithm alg = job->session->hash_alg;
+	NGConstant *ng = job->session->ng;
+	unsigned char buf_S[ SRP_MAX_N_BYTES ];
+	HashNum hs, hA, hB, hS;
+
+	hn_bytes(&hs, job->bytes, job->len_s);
+	hn_bytes(&hA, job->bytes + job->len_s, job->len_A);
+
+	if (job->stage == JOB_GB) {
+		if (job->mont) {
+			if (!mont_exp_step(&job->exp, budget)) return 0;
+			if (mont_exp_result(&job->exp, &job->B)!=0) return -1;
+		} else if (srp_ng_exp_g(ng, &job->B, &job->b)!=0) {
+			return -1;
+		}
+
+		/* B = kv + g^b, u = H(A, B) */
+		if (mbedtls_mpi_mul_mpi(&job->S, &job->pre->k, &job->v)!=0) return -1;
+		if (mbedtls_mpi_add_mpi(&job->S, &job->S, &job->B)!=0) return -1;
+		if (mbedtls_mpi_mod_mpi(&job->B, &job->S, ng->N)!=0) return -1;
+		job->len_B = (int) mbedtls_mpi_size(&job->B);
+		if (mbedtls_mpi_write_binary(&job->B, job->bytes + job->len_s + job->len_A, job->len_B)!=0) return -1;
+		hn_bytes(&hB, job->bytes + job->len_s + job->len_A, job->len_B);
+		if (H_nn(alg, &job->ub, &hA, &hB, 1)!=0) return -1;
+		if (mbedtls_mpi_mul_mpi(&job->ub, &job->ub, &job->b)!=0) return -1;
+
+		/* S = A^b * v^(u*b) */
+		fixed_base_release(job->gtab);
+		job->gtab = NULL;
+		if (job->mont) {
+			SRP_STAT_EXP(ng);
+			if (mont_exp_start(&job->exp, job->mont, ng->N, job->tab, &job->A, &job->b, &job->v, &job->ub)!=0) return -1;
+		}
+		job->stage = JOB_S;
+		return 0;
+	}
 
+	if (job->mont) {
+		if (!mont_exp_step(&job->exp, budget)) return 0;
+		if (mont_exp_result(&job->exp, &job->S)!=0) return -1;
+	} else if (srp_ng_exp_mod2(ng, &job->S, &job->A, &job->b, &job->v, &job->ub)!=0) {
+		return -1;
+	}
 
+	hn_bytes(&hB, job->bytes + job->len_s + job->len_A, job->len_B);
+	if (hn_mpi(&hS, &job->S, buf_S, sizeof(buf_S))!=0) {
+		hn_free(&hS);
+		return -1;
+	}
+	hash_num(alg, &hS, job->session_key);
+	hn_free(&hS);
+	calculate_M(alg, job->pre, job->M, job->username, &hs, &hA, &hB, job->session_key);
+	calculate_H_AMK(alg, job->H_AMK, &hA, job->M, job->session_key);
+	job->stage = JOB_DONE;
+	return 0;
+}
 
-void srp_verifier_delete( SRPVerifier * ver ){
-	if (ver) {
-		srp_ng_delete( ver->ng );
-		if (ver->username) free( (char *) ver->username );
-		memset(ver, 0, sizeof(*ver));
-		free( ver );
+int srp_verifier_job_step( SRPVerifierJob * job, int budget )
+{
+	if (!job || job->stage == JOB_FAILED) return -1;
+	if (job->stage != JOB_DONE) {
+		if (job_advance(job, budget > 0 ? budget : 1)!=0) {
+			job->stage = JOB_FAILED;
+			job_clear(job);
+			return -1;
+		}
+		if (job->stage == JOB_DONE) job_clear(job);
 	}
+	return job->stage == JOB_DONE;
 }
 
+int srp_verifier_job_finish( SRPVerifierJob * job, SRPVerifier * ver,
+	unsigned char * bytes_B, int * len_B )
+{
+	if (!job || !ver || job->stage != JOB_DONE) return -1;
+	if (bytes_B) {
+		if (!len_B || *len_B < job->len_B) return -1;
+		memcpy(bytes_B, job->bytes + job->len_s + job->len_A, job->len_B);
+		*len_B = job->len_B;
+	}
+	memset(ver, 0, sizeof(SRPVerifier));
+	ver->hash_alg = job->session->hash_alg;
+	ver->ng       = job->session->ng;
+	ver->username = job->username;
+	memcpy(ver->M, job->M, sizeof(ver->M));
+	memcpy(ver->H_AMK, job->H_AMK, sizeof(ver->H_AMK));
+	memcpy(ver->session_key, job->session_key, sizeof(ver->session_key));
+	return 0;
+}
+
+void srp_verifier_job_delete( SRPVerifierJob * job )
+{
+	if (job) {
+		job_clear(job);
+		srp_free(job->bytes);
+		memset(job, 0, sizeof(SRPVerifierJob));
+		srp_free(job);
+	}
+}
 
 
 int srp_verifier_is_authenticated( SRPVerifier * ver )
@@ -989,6 +3095,10 @@ int srp_session_get_key_length( SRPSession * ses ){
 	return hash_length( ses->hash_alg );
 }
 
+NGConstant * srp_session_get_ng( SRPSession * ses ){
+	return ses->ng;
+}
+
 int srp_verifier_get_session_key_length( SRPVerifier * ver )
 {
     return hash_length( ver->hash_alg );
@@ -1021,9 +3131,12 @@ SRPUser * srp_user_new(
 	const unsigned char * bytes_password, int len_password
 ) {
 	NGConstant *ng=srp_ng_new1(session->ng);
+	SRPUser *usr;
 	if (!ng) return NULL;
 	//srp_user_new1 takse ownership of ng
-	return srp_user_new1(session->hash_alg,ng, username,bytes_password,len_password);
+	usr = srp_user_new1(session->hash_alg,ng, username,bytes_password,len_password);
+	if (usr) usr->exp_bits = session->exp_bits;
+	return usr;
 }
 
 //we take wonership of ng here so please don't free in your code
@@ -1035,90 +3148,136 @@ SRPUser * srp_user_new1(
 	if ((unsigned)hash_alg>=(unsigned)SRP_SHA_LAST) return NULL;
 	if (ng==NULL) return NULL;
 
-	SRPUser  *usr  = (SRPUser *) malloc( sizeof(SRPUser) );
+	SRPUser  *usr  = (SRPUser *) srp_malloc( sizeof(SRPUser) );
 	int ulen = strlen(username) + 1;
 
 	if (!usr) goto err_exit;
-	memset(usr,0,sizeof(SRPUser));
-
-
-	usr->hash_alg = hash_alg;
-	usr->ng       = ng;
-
-	usr->a = (mbedtls_mpi *) malloc(sizeof(mbedtls_mpi));
-	if (!usr->a) goto err_exit;
-	mbedtls_mpi_init(usr->a);
-
-	usr->A = (mbedtls_mpi *) malloc(sizeof(mbedtls_mpi));
-	if (!usr->A) goto err_exit;
-	mbedtls_mpi_init(usr->A);
-
-	usr->S = (mbedtls_mpi *) malloc(sizeof(mbedtls_mpi));
-	if (!usr->S) goto err_exit;
-	mbedtls_mpi_init(usr->S);
+	user_init(usr, hash_alg, ng);
+	usr->owned    = 1;
 
-	usr->username     = (const char *) malloc(ulen);
+	usr->username     = (const char *) srp_malloc(ulen);
 	if (!usr->username) goto err_exit;
 	memcpy((char *)usr->username, username, ulen);
 
 	usr->password_len = len_password;
-	usr->password = (const unsigned char *) malloc(len_password);
+	usr->password = (const unsigned char *) srp_malloc(len_password);
 	if (!usr->password) goto err_exit;
 	memcpy((char *)usr->password, bytes_password, len_password);
 
-	usr->authenticated = 0;
-
 	return usr;
 
 err_exit:
 	if (usr) {
-		if (usr->a) {
-			mbedtls_mpi_free(usr->a);
-			free(usr->a);
-		}
-
-		if (usr->A) {
-			mbedtls_mpi_free(usr->A);
-			free(usr->A);
-		}
-		if (usr->S) {
-			mbedtls_mpi_free(usr->S);
-			free(usr->S);
-		}
-		if (usr->ng) srp_ng_delete(usr->ng);
-		if (usr->username) {
-			memset((void*)usr->username, 0, ulen);
-			free((void*)usr->username);
-		}
-		if (usr->password) {
-			memset((void*)usr->password, 0, usr->password_len);
-			free((void*)usr->password);
-		}
-		free(usr);
+		srp_user_delete(usr);
+	} else {
+		srp_ng_delete(ng);
 	}
+	return 0;
+}
+
+static void user_init( SRPUser *usr, SRP_HashAlgorithm hash_alg, NGConstant *ng )
+{
+	memset(usr,0,sizeof(SRPUser));
+	usr->hash_alg = hash_alg;
+	usr->ng       = ng;
+	mbedtls_mpi_init(&usr->a);
+	mbedtls_mpi_init(&usr->A);
+	mbedtls_mpi_init(&usr->S);
+}
 
+int srp_user_init( SRPUser * usr, SRPSession * session, const char * username,
+	const unsigned char * bytes_password, int len_password )
+{
+	if (!usr || !session || !username) return -1;
+	user_init(usr, session->hash_alg, session->ng);
+	usr->exp_bits     = session->exp_bits;
+	usr->username     = username;
+	usr->password     = bytes_password;
+	usr->password_len = len_password;
 	return 0;
 }
 
+int srp_user_init_x( SRPUser * usr, SRPSession * session, const char * username,
+	const unsigned char * bytes_x, int len_x )
+{
+	if (!usr || !session || !username || !bytes_x) return -1;
+	if (len_x!=hash_length(session->hash_alg)) return -1;
+	user_init(usr, session->hash_alg, session->ng);
+	usr->exp_bits = session->exp_bits;
+	usr->username = username;
+	usr->has_x    = 1;
+	memcpy(usr->x, bytes_x, len_x);
+	return 0;
+}
 
+SRPUser * srp_user_new_x( SRPSession * session, const char * username,
+	const unsigned char * bytes_x, int len_x )
+{
+	SRPUser *usr;
+	char    *uname;
+	int      ulen;
+
+	if (!session || !username || !bytes_x || len_x!=hash_length(session->hash_alg)) return NULL;
+
+	usr = (SRPUser *) srp_malloc( sizeof(SRPUser) );
+	if (!usr) return NULL;
+	user_init(usr, session->hash_alg, NULL);
+	usr->owned = 1;
+
+	ulen = strlen(username) + 1;
+	uname = (char *) srp_malloc( ulen );
+	usr->ng = srp_ng_new1(session->ng);
+	if (!uname || !usr->ng) {
+		srp_free(uname);
+		srp_user_delete(usr);
+		return NULL;
+	}
+	memcpy(uname, username, ulen);
+	usr->exp_bits = session->exp_bits;
+	usr->username = uname;
+	usr->has_x    = 1;
+	memcpy(usr->x, bytes_x, len_x);
+	return usr;
+}
 
-void srp_user_delete( SRPUser * usr )
+int srp_calculate_x( SRPSession * session, const char * username,
+	const unsigned char * password, int len_password,
+	const unsigned char * bytes_s, int len_s,
+	unsigned char * bytes_x, int * len_x )
 {
-	if( !usr ) return;
-	mbedtls_mpi_free( usr->a ); free( usr->a );
-	mbedtls_mpi_free( usr->A ); free( usr->A );
-	mbedtls_mpi_free( usr->S ); free( usr->S );
-	
-	srp_ng_delete( usr->ng );
+	SRPUser usr;
+	int rc;
+
+	if (!session || !username || !bytes_s || !bytes_x || !len_x) return -1;
+	if (srp_user_init(&usr, session, username, password, len_password)!=0) return -1;
+	rc = srp_user_x(&usr, bytes_s, len_s, bytes_x);
+	if (rc==0) *len_x = hash_length(session->hash_alg);
+	srp_user_free(&usr);
+	return rc==0 ? 0 : -1;
+}
 
-	memset((void*)usr->password, 0, usr->password_len);
+void srp_user_free( SRPUser * usr )
+{
+	if( !usr ) return;
+	mbedtls_mpi_free( &usr->a );
+	mbedtls_mpi_free( &usr->A );
+	mbedtls_mpi_free( &usr->S );
+	memset(usr, 0, sizeof(SRPUser));
+}
 
-	free((char *)usr->username);
-	free((char *)usr->password);
+void srp_user_delete( SRPUser * usr )
+{
+	if( !usr ) return;
 
+	if (usr->owned) {
+		srp_ng_delete( usr->ng );
+		if (usr->password) memset((void*)usr->password, 0, usr->password_len);
+		srp_free((char *)usr->username);
+		srp_free((char *)usr->password);
+	}
 
-	memset(usr, 0, sizeof(SRPUser));
-	free( usr );
+	srp_user_free( usr );
+	srp_free( usr );
 }
 
 
@@ -1154,37 +3313,82 @@ int                   srp_user_get_session_key_length( SRPUser * usr )
 /* Output: username, bytes_A, len_A */
 void  srp_user_start_authentication( SRPUser * usr, const char ** username,
                                      const unsigned char ** bytes_A, int * len_A )
+{
+	unsigned char *buf;
+	int len = srp_ng_size(usr->ng);
+
+	*bytes_A = NULL;
+	*len_A = 0;
+	if (username) *username = NULL;
+
+	buf = (unsigned char *) srp_malloc( len );
+	if (!buf) return;
+	if (srp_user_start_authentication1(usr, buf, &len)!=0) {
+		srp_free(buf);
+		return;
+	}
+
+	*bytes_A = buf;
+	*len_A = len;
+	if (username) *username = usr->username;
+}
+
+static int user_start( SRPUser * usr, unsigned char * bytes_A, int * len_A )
 {
 
 #ifdef SRP_TEST_FIXED_a
-	mbedtls_mpi_read_string(usr->a, 16,SRP_TEST_FIXED_a_STR);
+	mbedtls_mpi_read_string(&usr->a, 16,SRP_TEST_FIXED_a_STR);
 #else
-	mbedtls_mpi_fill_random( usr->a, SRP_BYTES_IN_PRIVKEY, &mbedtls_ctr_drbg_random, &ctr_drbg_ctx);
+	if (srp_fill_random( &usr->a, usr->exp_bits ? usr->exp_bits / 8 : srp_ng_exp_bytes(usr->ng) )!=0) return -1;
 #endif
-	mbedtls_mpi_exp_mod(usr->A, usr->ng->g, usr->a, usr->ng->N, RR);
+	if (srp_ng_exp_g(usr->ng, &usr->A, &usr->a)!=0) return -1;
 
 #ifdef SRP_TEST_PRINT_a
-	tutils_mpi_print ("server priv (a)",usr->a);
+	tutils_mpi_print ("server priv (a)",&usr->a);
 #endif
 #ifdef SRP_TEST_PRINT_A
-	tutils_mpi_print ("server pub (A)",usr->A);
+	tutils_mpi_print ("server pub (A)",&usr->A);
 #endif
 
+	if (*len_A < (int)mbedtls_mpi_size(&usr->A)) return -1;
+	*len_A = mbedtls_mpi_size(&usr->A);
+	mbedtls_mpi_write_binary( &usr->A, bytes_A, *len_A );
+	return 0;
+}
 
-	*len_A   = mbedtls_mpi_size(usr->A);
-	*bytes_A = malloc( *len_A );
+int  srp_user_start_authentication1( SRPUser * usr, unsigned char * bytes_A, int * len_A )
+{
+	int rc;
 
-	if (!*bytes_A) {
-		*len_A = 0;
-		if (username) *username = NULL;
-		return;
-	}
+	if (!srp_ng_precomp(usr->ng, usr->hash_alg)) return -1;
+	SRP_PHASE_BEGIN(SRP_PHASE_USER_START);
+	rc = user_start(usr, bytes_A, len_A);
+	SRP_PHASE_END(SRP_PHASE_USER_START);
+	return rc;
+}
 
-	mbedtls_mpi_write_binary( usr->A, (unsigned char *) *bytes_A, *len_A );
 
-	if (username) *username = usr->username;
+/* x of usr for salt hs: from the password, or as given to srp_user_init_x() */
+static int user_x( SRPUser * usr, const HashNum * hs, mbedtls_mpi * x )
+{
+    if (usr->has_x)
+        return mbedtls_mpi_read_binary( x, usr->x, hash_length(usr->hash_alg) );
+    return calculate_x( usr->hash_alg, x, hs, usr->username, usr->password, usr->password_len );
 }
 
+int srp_user_x( SRPUser * usr, const unsigned char * bytes_s, int len_s, unsigned char * bytes_x )
+{
+    mbedtls_mpi x;
+    HashNum     hs;
+    int         rc;
+
+    mbedtls_mpi_init(&x);
+    hn_bytes(&hs, bytes_s, len_s);
+    rc = user_x(usr, &hs, &x);
+    if (rc==0) rc = mbedtls_mpi_write_binary(&x, bytes_x, hash_length(usr->hash_alg));
+    mbedtls_mpi_free(&x);
+    return rc;
+}
 
 /* Output: bytes_M. Buffer length is SHA512_DIGEST_LENGTH */
 void  srp_user_process_challenge( SRPUser * usr,
@@ -1192,106 +3396,113 @@ void  srp_user_process_challenge( SRPUser * usr,
                                   const unsigned char * bytes_B, int len_B,
                                   const unsigned char ** bytes_M, int * len_M )
 {
-    mbedtls_mpi *u = NULL;
-    mbedtls_mpi *x = NULL;
-    mbedtls_mpi *k = NULL;
-
-    mbedtls_mpi *s = NULL;
-    mbedtls_mpi *B = NULL;
-    mbedtls_mpi *v = NULL;
-    mbedtls_mpi *tmp1 = NULL;
-    mbedtls_mpi *tmp2 = NULL;
-    mbedtls_mpi *tmp3 = NULL;
-    *len_M = 0;
-    *bytes_M = NULL;
-
-    s = (mbedtls_mpi *) malloc(sizeof(mbedtls_mpi));
-    if( !s ) goto cleanup_and_exit;
-    mbedtls_mpi_init(s);
-    mbedtls_mpi_read_binary(s, bytes_s, len_s);
-
-    B = (mbedtls_mpi *) malloc(sizeof(mbedtls_mpi));
-    if( !B ) goto cleanup_and_exit;
-    mbedtls_mpi_init(B);
-    mbedtls_mpi_read_binary(B, bytes_B, len_B);
-
-    v = (mbedtls_mpi *) malloc(sizeof(mbedtls_mpi));
-    if(  !v ) goto cleanup_and_exit;
-    mbedtls_mpi_init(v);
-
-    tmp1 = (mbedtls_mpi *) malloc(sizeof(mbedtls_mpi));
-    if(  !tmp1 ) goto cleanup_and_exit;
-    mbedtls_mpi_init(tmp1);
-
-    tmp2 = (mbedtls_mpi *) malloc(sizeof(mbedtls_mpi));
-    if(  !tmp2 ) goto cleanup_and_exit;
-    mbedtls_mpi_init(tmp2);
+    srp_user_process_challenge_kgx( usr, bytes_s, len_s, bytes_B, len_B, bytes_M, len_M, NULL, NULL );
+}
 
-    tmp3 = (mbedtls_mpi *) malloc(sizeof(mbedtls_mpi));
-    if(  !tmp3 ) goto cleanup_and_exit;
-    mbedtls_mpi_init(tmp3);
+/*
+ * srp_user_process_challenge() that takes k*g^x mod N from kgx_in when set,
+ * and otherwise hands the one it computed out in kgx_out when that is set.
+ */
+void  srp_user_process_challenge_kgx( SRPUser * usr,
+                                  const unsigned char * bytes_s, int len_s,
+                                  const unsigned char * bytes_B, int len_B,
+                                  const unsigned char ** bytes_M, int * len_M,
+                                  const mbedtls_mpi * kgx_in, mbedtls_mpi * kgx_out )
+{
+    NGPrecomp   *pre = NULL;
+    SRPArena    *arena;
+    mbedtls_mpi u, x, B, S, tmp1, tmp2, tmp3;
+    unsigned char buf_A[ SRP_MAX_N_BYTES ], buf_S[ SRP_MAX_N_BYTES ];
+    HashNum     hs, hA, hB, hS;
 
+    if (len_M) *len_M = 0;
+    *bytes_M = NULL;
 
+    /* before the arena scope: the group constants are built once and kept */
+    pre = srp_ng_precomp(usr->ng, usr->hash_alg);
 
-    u = H_nn(usr->hash_alg, usr->A, B,1);
+    if (!pre)
+       return;
 
-    if (!u)
+    SRP_PHASE_BEGIN(SRP_PHASE_USER_CHALLENGE);
+    arena = arena_enter();
+
+    mbedtls_mpi_init(&u);
+    mbedtls_mpi_init(&x);
+    mbedtls_mpi_init(&B);
+    mbedtls_mpi_init(&S);
+    mbedtls_mpi_init(&tmp1);
+    mbedtls_mpi_init(&tmp2);
+    mbedtls_mpi_init(&tmp3);
+    hA.tmp = hS.tmp = NULL;
+
+    /* s and B are hashed as they came in, A is written out once for u, M and H_AMK */
+    hn_bytes(&hs, bytes_s, len_s);
+    hn_bytes(&hB, bytes_B, len_B);
+    if (mbedtls_mpi_read_binary(&B, bytes_B, len_B)!=0)
        goto cleanup_and_exit;
-
-    x = calculate_x( usr->hash_alg, s, usr->username, usr->password, usr->password_len );
-
-    if (!x)
+    if (hn_mpi(&hA, &usr->A, buf_A, sizeof(buf_A))!=0)
        goto cleanup_and_exit;
 
-    k = H_nn(usr->hash_alg, usr->ng->N, usr->ng->g,1);
+    if (H_nn(usr->hash_alg, &u, &hA, &hB, 1)!=0)
+       goto cleanup_and_exit;
 
-    if (!k)
+    if (user_x( usr, &hs, &x )!=0)
        goto cleanup_and_exit;
 
     /* SRP-6a safety check */
-    if( mbedtls_mpi_cmp_int( B, 0 ) != 0 && mbedtls_mpi_cmp_int( u, 0 ) !=0 )
+    if( mbedtls_mpi_cmp_int( &B, 0 ) != 0 && mbedtls_mpi_cmp_int( &u, 0 ) !=0 )
     {
-        mbedtls_mpi_exp_mod(v, usr->ng->g, x, usr->ng->N, RR);
         /* S = (B - k*(g^x)) ^ (a + ux) */
-        mbedtls_mpi_mul_mpi( tmp1, u, x );
-        mbedtls_mpi_mod_mpi( tmp1, tmp1, usr->ng->N);
-        mbedtls_mpi_add_mpi( tmp2, usr->a, tmp1);
-        mbedtls_mpi_mod_mpi( tmp2, tmp2, usr->ng->N);
+        mbedtls_mpi_mul_mpi( &tmp1, &u, &x );
+        mbedtls_mpi_mod_mpi( &tmp1, &tmp1, usr->ng->N);
+        mbedtls_mpi_add_mpi( &tmp2, &usr->a, &tmp1);
+        mbedtls_mpi_mod_mpi( &tmp2, &tmp2, usr->ng->N);
         /* tmp2 = (a + ux)      */
-        mbedtls_mpi_exp_mod( tmp1, usr->ng->g, x, usr->ng->N, RR);
-        mbedtls_mpi_mul_mpi( tmp3, k, tmp1 );
-        mbedtls_mpi_mod_mpi( tmp3, tmp3, usr->ng->N);
+        if (kgx_in) {
+            mbedtls_mpi_copy( &tmp3, kgx_in );
+        } else {
+            srp_ng_exp_g(usr->ng, &tmp1, &x);
+            mbedtls_mpi_mul_mpi( &tmp3, &pre->k, &tmp1 );
+            mbedtls_mpi_mod_mpi( &tmp3, &tmp3, usr->ng->N);
+            if (kgx_out && mpi_copy_out( arena, kgx_out, &tmp3 )!=0)
+               goto cleanup_and_exit;
+        }
         /* tmp3 = k*(g^x)       */
-        mbedtls_mpi_sub_mpi(tmp1, B, tmp3);
+        mbedtls_mpi_sub_mpi(&tmp1, &B, &tmp3);
         /* tmp1 = (B - K*(g^x)) */
-        mbedtls_mpi_exp_mod( usr->S, tmp1, tmp2, usr->ng->N, RR);
+        if (srp_ng_exp_mod( usr->ng, &S, &tmp1, &tmp2 )!=0)
+           goto cleanup_and_exit;
+        if (mpi_copy_out( arena, &usr->S, &S )!=0)
+           goto cleanup_and_exit;
 
-        hash_num(usr->hash_alg, usr->S, usr->session_key);
+        if (hn_mpi(&hS, &S, buf_S, sizeof(buf_S))!=0)
+           goto cleanup_and_exit;
+        hash_num(usr->hash_alg, &hS, usr->session_key);
 
-        calculate_M( usr->hash_alg, usr->ng, usr->M, usr->username, s, usr->A, B, usr->session_key );
-        calculate_H_AMK( usr->hash_alg, usr->H_AMK, usr->A, usr->M, usr->session_key );
+        calculate_M( usr->hash_alg, pre, usr->M, usr->username, &hs, &hA, &hB, usr->session_key );
+        calculate_H_AMK( usr->hash_alg, usr->H_AMK, &hA, usr->M, usr->session_key );
 
         *bytes_M = usr->M;
-        *len_M = hash_length( usr->hash_alg );
-        
+        if (len_M) *len_M = hash_length( usr->hash_alg );
     }
     else
     {
-        *bytes_M = NULL;
-        if (len_M) *len_M   = 0;
+        SRP_STAT_ADD(rejected, 1);
     }
 
  cleanup_and_exit:
-
-    if (s) { mbedtls_mpi_free(s); free(s);}
-    if (B) { mbedtls_mpi_free(B); free(B);}
-    if (u) { mbedtls_mpi_free(u); free(u);}
-    if (x) { mbedtls_mpi_free(x); free(x);}
-    if (k) { mbedtls_mpi_free(k); free(k);}
-    if (v) { mbedtls_mpi_free(v); free(v);}
-    if (tmp1) { mbedtls_mpi_free(tmp1);free(tmp1);}
-    if (tmp2) { mbedtls_mpi_free(tmp2);free(tmp2);}
-    if (tmp3) { mbedtls_mpi_free(tmp3);free(tmp3);}
+    mbedtls_mpi_free(&u);
+    mbedtls_mpi_free(&x);
+    mbedtls_mpi_free(&B);
+    mbedtls_mpi_free(&S);
+    mbedtls_mpi_free(&tmp1);
+    mbedtls_mpi_free(&tmp2);
+    mbedtls_mpi_free(&tmp3);
+    hn_free(&hA);
+    hn_free(&hS);
+    arena_leave(arena);
+    SRP_PHASE_END(SRP_PHASE_USER_CHALLENGE);
 }
 
 
@@ -71,6 +71,10 @@ extern "C" {
 #ifndef SRP_H
 #define SRP_H
 
+#include <stddef.h>
+
+#include "mbedtls/bignum.h"
+
 #define SHA1_DIGEST_LENGTH 20
 #define SHA224_DIGEST_LENGTH 28
 #define SHA256_DIGEST_LENGTH 32
@@ -106,6 +110,55 @@ typedef enum
     SRP_SHA_LAST
 } SRP_HashAlgorithm;
 
+/*
+ * The handshake structs are complete here only so that the *_init() API
+ * below can work on memory the caller provides (stack, slab, connection
+ * object). Treat every member as private.
+ */
+struct SRPKeyPair
+{
+    mbedtls_mpi     B;
+    mbedtls_mpi     b;
+};
+
+struct SRPVerifier
+{
+    SRP_HashAlgorithm  hash_alg;
+    NGConstant  *ng;
+
+    const char          * username;
+    int                   owns_username;    /* set by srp_verifier_new1() copies */
+    int                   authenticated;
+
+    unsigned char M           [SHA512_DIGEST_LENGTH];
+    unsigned char H_AMK       [SHA512_DIGEST_LENGTH];
+    unsigned char session_key [SHA512_DIGEST_LENGTH];
+};
+
+struct SRPUser
+{
+    SRP_HashAlgorithm  hash_alg;
+    NGConstant  *ng;
+
+    mbedtls_mpi a;
+    mbedtls_mpi A;
+    mbedtls_mpi S;
+
+    int                   authenticated;
+    int                   owned;    /* ng, username and password belong to usr */
+
+    const char *          username;
+    const unsigned char * password;
+    int                   password_len;
+    int                   has_x;    /* x below stands in for the password */
+    int                   exp_bits; /* size of a, 0: the group's */
+    unsigned char         x           [SHA512_DIGEST_LENGTH];
+
+    unsigned char M           [SHA512_DIGEST_LENGTH];
+    unsigned char H_AMK       [SHA512_DIGEST_LENGTH];
+    unsigned char session_key [SHA512_DIGEST_LENGTH];
+};
+
 /* This library will automatically seed the mbedtls random number generator.
  *
  * The random data should include at least as many bits of entropy as the
@@ -123,24 +176,162 @@ typedef enum
 void srp_random_seed( const unsigned char * random_data, int data_length );
 int srp_random_seeded();
 
+/*
+ * Random generator callback, same contract as the f_rng/p_rng pairs of
+ * mbedtls: fill buf with len random bytes and return 0 on success.
+ *
+ * By default every thread lazily gets its own CTR-DRBG seeded from a shared
+ * mbedtls entropy context, so handshakes on different threads never share
+ * generator state. Build with -DSRP_PTHREAD (and link -lpthread) for that;
+ * without it the library keeps a single generator and is not thread safe.
+ */
+typedef int (*srp_rng_func)( void * p_rng, unsigned char * buf, size_t len );
+
+/*
+ * Use f_rng for all salts and private keys, from every thread. f_rng must be
+ * safe to call concurrently if the library is used from several threads.
+ * Set it before any other call; f_rng==NULL restores the built in generator.
+ */
+void srp_set_rng( srp_rng_func f_rng, void * p_rng );
+
+/*
+ * Same as srp_set_rng() but only for the calling thread, e.g. to hand every
+ * worker its own mbedtls_ctr_drbg_context. srp_set_rng() takes precedence.
+ */
+void srp_set_thread_rng( srp_rng_func f_rng, void * p_rng );
+
+/*
+ * Allocator for everything the library allocates, same contract as
+ * calloc/free; NULL restores those. Buffers returned by the *_new API come
+ * from f_calloc, release them with f_free. When mbedtls is built with
+ * MBEDTLS_PLATFORM_MEMORY its allocations are routed here too, through
+ * mbedtls_platform_set_calloc_free(), which affects the whole process.
+ * Set it before any other call into this library or mbedtls.
+ */
+typedef void * (*srp_calloc_func)( size_t nmemb, size_t size );
+typedef void   (*srp_free_func)( void * ptr );
+
+void srp_set_allocator( srp_calloc_func f_calloc, srp_free_func f_free );
+
+/*
+ * Bump allocator for the temporaries of one handshake step. Bound to a
+ * thread, it serves every temporary of srp_verifier_new1/srp_verifier_init
+ * and srp_user_process_challenge, and all of it is wiped and released when
+ * the call returns. Results that outlive the call never live in the arena.
+ * Temporaries that do not fit fall back to the allocator. Without
+ * MBEDTLS_PLATFORM_MEMORY only the library's own temporaries use it, not
+ * mbedtls limbs. srp_arena_peak() reports the most ever used, to size it.
+ */
+typedef struct SRPArena SRPArena;
+
+SRPArena * srp_arena_new( size_t size );
+void       srp_arena_delete( SRPArena * arena );
+/* for the calling thread, NULL unbinds. Not while a call is running on it */
+void       srp_arena_bind( SRPArena * arena );
+size_t     srp_arena_peak( SRPArena * arena );
+
+/*
+ * Instrumentation, built in with -DSRP_STATS. Each thread counts into its
+ * own SRPStats with plain stores, no locks or atomic read-modify-writes;
+ * srp_stats_snapshot() adds up all threads, including ones that have exited.
+ * Without SRP_STATS the counting and the hooks compile to nothing, the
+ * snapshot is all zero and srp_set_phase_hooks() returns -1.
+ */
+typedef enum
+{
+    SRP_PHASE_CREATE_VERIFIER,  /* srp_create_salted_verification_key* */
+    SRP_PHASE_USER_START,       /* srp_user_start_authentication* */
+    SRP_PHASE_KEYPAIR,          /* srp_keypair_*, also inside SRP_PHASE_VERIFIER without keys */
+    SRP_PHASE_VERIFIER,         /* srp_verifier_new*, srp_verifier_init* */
+    SRP_PHASE_USER_CHALLENGE,   /* srp_user_process_challenge */
+    SRP_PHASE_LAST
+} SRP_Phase;
+
+typedef struct SRPStats
+{
+    unsigned long long  exp[SRP_NG_LAST];       /* exponentiations mod N by size of N, SRP_NG_CUSTOM: other sizes */
+    unsigned long long  bytes_hashed;
+    unsigned long long  allocs;                 /* heap and arena */
+    unsigned long long  rejected;               /* A or B refused by the SRP-6a safety checks */
+    unsigned long long  phases[SRP_PHASE_LAST]; /* completed */
+} SRPStats;
+
+/*
+ * begin and end run on the calling thread around every phase, e.g. to read
+ * a clock. Either may be NULL. Set them before other threads use the library.
+ */
+typedef void (*srp_phase_func)( void * ctx, SRP_Phase phase );
+
+int  srp_set_phase_hooks( srp_phase_func begin, srp_phase_func end, void * ctx );
+void srp_stats_snapshot( SRPStats * stats );
+
 int srp_hash_length( SRPSession *ses );
 
+/* "mbedtls", or the accelerated code picked for alg (built with -DSRP_HASH_ACCEL) */
+const char * srp_hash_backend( SRP_HashAlgorithm alg );
+
 /*
  * Create internal representation of given SRP_NGType.
  * if ng_type==SRP_NG_CUSTOM n_hex and g_hex will be used
+ * Groups are reference counted and shared: while a group with the same N
+ * and g is alive this returns another reference to it, so all sessions,
+ * users and verifiers on one group share its caches (k, H(N) xor H(g) per
+ * hash algorithm, R^2 mod N, the table of srp_ng_precompute_g()).
+ * NULL if the hex strings do not parse.
  */
 NGConstant * srp_ng_new( SRP_NGType ng_type, const char * n_hex, const char * g_hex );
 
 /*
- * Allocate new NGConstant and copy internal representation of copy_from_ng
+ * Another reference to copy_from_ng; nothing is copied
  */
 NGConstant * srp_ng_new1( NGConstant * copy_from_ng);
 
 /*
- * Free NGConstant. Make sure it is needed as some functions take ownership of passed ng
+ * Drop a reference, the group goes with the last one. Make sure it is needed as some functions take ownership of passed ng
  */
 void srp_ng_delete( NGConstant * ng ); 
 
+/*
+ * Precompute a fixed base table for g so g^a, g^b and g^x cost a few dozen
+ * modular multiplications instead of a full exponentiation.
+ * window_bits<=0 picks 4, max_exp_bits<=0 covers the largest exponent this
+ * library uses (512 bits, or the exponent size of ng if that is larger). The table holds
+ * ceil(max_exp_bits/window_bits) * 2^window_bits group elements; for
+ * SRP_NG_3072 with the defaults that is 768KB.
+ * Every holder of the group uses the table. It is safe to call while other
+ * threads use ng: a table that already has this shape is kept, otherwise the
+ * new one replaces it and the old one goes once no exponentiation uses it.
+ * Returns 0 on success.
+ */
+int srp_ng_precompute_g( NGConstant * ng, int window_bits, int max_exp_bits );
+
+/*
+ * Size in bits of the private exponents a and b. The default follows the
+ * strength of N: 256 up to 3072 bit groups, 320 for 4096 and 400 for 8192
+ * bits. Shorter is faster, see bench_srp -e. bits<=0 restores the default;
+ * rounded up to whole bytes, at least 128 and below the size of N.
+ * Returns 0 on success.
+ *
+ * srp_session_set_exponent_bits() applies to the session and to the users,
+ * key pairs, jobs and key pools made from it afterwards; other sessions on
+ * the same group keep theirs. Set it before the session is used.
+ *
+ * srp_ng_set_exponent_bits() changes the default of ng itself. Since groups
+ * are shared (see srp_ng_new()), it fails with -1 while anyone else holds
+ * ng; otherwise ng leaves the registry, so it stays private to the caller
+ * and later srp_ng_new() calls get a group with the default.
+ */
+int srp_session_set_exponent_bits( SRPSession * session, int bits );
+int srp_session_get_exponent_bits( SRPSession * session );
+int srp_ng_set_exponent_bits( NGConstant * ng, int bits );
+int srp_ng_get_exponent_bits( NGConstant * ng );
+
+/*
+ * Size of N in bytes. Buffers for v, A and B passed to the *_init() API
+ * must hold this many bytes.
+ */
+int srp_ng_size( NGConstant * ng );
+
 /*
  * The n_hex and g_hex parameters should be 0 unless SRP_NG_CUSTOM is used for ng_type.
  * If provided, they must contain ASCII text of the hexidecimal notation.
@@ -151,6 +342,9 @@ SRPSession * srp_session_new( SRP_HashAlgorithm alg,
 
 int srp_session_get_key_length( SRPSession * ses );
 
+/* The group used by the session, e.g. to call srp_ng_precompute_g() on it */
+NGConstant * srp_session_get_ng( SRPSession * ses );
+
 void srp_session_delete(SRPSession *session);
 
 /* Out: bytes_s, len_s, bytes_v, len_v
@@ -174,6 +368,16 @@ void srp_create_salted_verification_key1( SRPSession * session,
                                          const unsigned char ** bytes_s, int len_s,
                                          const unsigned char ** bytes_v, int * len_v);
 
+/* Same as srp_create_salted_verification_key1 into caller buffers.
+ * bytes_s gets len_s bytes. *len_v is the size of bytes_v on input, at least
+ * srp_ng_size(), and the length written on output. Returns 0 on success.
+ */
+int  srp_create_salted_verification_key2( SRPSession * session,
+                                         const char * username,
+                                         const unsigned char * password, int len_password,
+                                         unsigned char * bytes_s, int len_s,
+                                         unsigned char * bytes_v, int * len_v);
+
 
 //bytes_B=NULL is ok
 SRPKeyPair * srp_keypair_new( SRPSession *session,const unsigned char * bytes_v, int len_v,
@@ -181,6 +385,38 @@ SRPKeyPair * srp_keypair_new( SRPSession *session,const unsigned char * bytes_v,
 							  
 void srp_keypair_delete( SRPKeyPair * keys ) ;
 
+/*
+ * Allocation free variant of srp_keypair_new on a caller owned keys.
+ * *len_B is the size of bytes_B on input (at least srp_ng_size()) and the
+ * length of B on output; bytes_B=NULL is ok. Returns 0 on success, release
+ * with srp_keypair_free.
+ */
+int  srp_keypair_init( SRPKeyPair * keys, SRPSession *session,
+                       const unsigned char * bytes_v, int len_v,
+                       unsigned char * bytes_B, int * len_B );
+void srp_keypair_free( SRPKeyPair * keys );
+
+/*
+ * Pool of precomputed server ephemerals (b, g^b) for the group of session.
+ * A background thread, at idle priority where supported, keeps up to
+ * capacity pairs ready. The pool keeps its own copy of the group, so it may
+ * outlive session. Needs srp_pool.c and -DSRP_PTHREAD.
+ */
+typedef struct SRPKeyPool SRPKeyPool;
+
+SRPKeyPool * srp_keypool_new( SRPSession * session, int capacity );
+void         srp_keypool_delete( SRPKeyPool * pool );
+int          srp_keypool_available( SRPKeyPool * pool );
+
+/*
+ * Same as srp_keypair_new but takes (b, g^b) from pool, leaving only
+ * B = kv + g^b mod N to compute. Falls back to srp_keypair_new when pool is
+ * NULL, empty or made for another group.
+ */
+SRPKeyPair * srp_keypair_new1( SRPSession *session, SRPKeyPool * pool,
+                               const unsigned char * bytes_v, int len_v,
+                               const unsigned char ** bytes_B, int * len_B);
+
 
 /* Out: bytes_B, len_B.
  *
@@ -207,6 +443,106 @@ SRPVerifier *  srp_verifier_new1( SRPSession *session,
 
 void                  srp_verifier_delete( SRPVerifier * ver );
 
+/*
+ * Allocation free variant of srp_verifier_new1 on a caller owned ver.
+ * username is not copied and must outlive ver. When keys is NULL a key pair
+ * is made on the fly and B written to bytes_B, sized as for
+ * srp_keypair_init. Returns 0 on success, -1 on failure including the SRP-6a
+ * safety check. Release with srp_verifier_free, not srp_verifier_delete.
+ * Apart from mbedtls growing limbs nothing is allocated.
+ */
+int                   srp_verifier_init( SRPVerifier * ver, SRPSession * session,
+                                        const char * username,
+                                        const unsigned char * bytes_s, int len_s,
+                                        const unsigned char * bytes_v, int len_v,
+                                        const unsigned char * bytes_A, int len_A,
+                                        unsigned char * bytes_B, int * len_B,
+                                        SRPKeyPair * keys );
+
+void                  srp_verifier_free( SRPVerifier * ver );
+
+/*
+ * A server handshake in slices, for event loops that cannot block for a
+ * whole 4096 or 8192 bit exponentiation. srp_verifier_job_new() takes the
+ * same inputs as srp_verifier_init() (copied, except username, which must
+ * outlive the verifier) and returns NULL on bad input, including the SRP-6a
+ * safety check. Each srp_verifier_job_step() runs at most budget Montgomery
+ * multiplications or squarings and returns 1 when the job is done, 0 when it
+ * wants another call and -1 on failure. srp_verifier_job_finish() then fills
+ * in ver as srp_verifier_init() would and writes B; ver does not depend on
+ * the job, which can be deleted.
+ *
+ * A handshake is about 1050 such operations (800 with a fixed base table for
+ * g) for any group size; one costs roughly (bits/1024)^2 microseconds on a
+ * current x86 core, so a budget of 32 keeps an 8192 bit slice near 2 ms.
+ */
+typedef struct SRPVerifierJob SRPVerifierJob;
+
+SRPVerifierJob *      srp_verifier_job_new( SRPSession * session,
+                                        const char * username,
+                                        const unsigned char * bytes_s, int len_s,
+                                        const unsigned char * bytes_v, int len_v,
+                                        const unsigned char * bytes_A, int len_A );
+int                   srp_verifier_job_step( SRPVerifierJob * job, int budget );
+int                   srp_verifier_job_finish( SRPVerifierJob * job, SRPVerifier * ver,
+                                        unsigned char * bytes_B, int * len_B );
+void                  srp_verifier_job_delete( SRPVerifierJob * job );
+
+/*
+ * Worker threads for srp_verifier_new_batch(). nthreads<=0 means one per
+ * online CPU; the thread calling srp_verifier_new_batch() counts as one of
+ * them. One pool may serve batches from any number of threads and sessions.
+ * Needs srp_pool.c and -DSRP_PTHREAD.
+ */
+typedef struct SRPWorkerPool SRPWorkerPool;
+
+SRPWorkerPool * srp_worker_pool_new( int nthreads );
+void            srp_worker_pool_delete( SRPWorkerPool * pool );
+int             srp_worker_pool_size( SRPWorkerPool * pool );
+
+/* One server handshake of a batch: fill in the inputs, read the outputs */
+typedef struct SRPBatchItem {
+    const char          * username;     /* copied into ver */
+    const unsigned char * bytes_s;  int len_s;
+    const unsigned char * bytes_v;  int len_v;
+    const unsigned char * bytes_A;  int len_A;
+
+    SRPVerifier         * ver;          /* Out: free with srp_verifier_delete */
+    /* Out, NULL on failure: release with the f_free passed to
+     * srp_set_allocator() (free() by default) */
+    const unsigned char * bytes_B;
+    int                   len_B;
+} SRPBatchItem;
+
+/*
+ * srp_verifier_new() for count items at once, spread over pool (NULL runs
+ * the batch on the calling thread). The group constants of session are built
+ * once up front and shared by the whole batch. Returns the number of items
+ * that got both ver and bytes_B, -1 on bad arguments.
+ */
+int             srp_verifier_new_batch( SRPSession * session, SRPWorkerPool * pool,
+                                        SRPBatchItem * items, int count );
+
+/* One account of srp_create_salted_verification_key_batch() */
+typedef struct SRPEnrollItem {
+    const char          * username;
+    const unsigned char * password;  int len_password;
+
+    unsigned char       * bytes_s;   int len_s;   /* Out: len_s random bytes */
+    unsigned char       * bytes_v;   int len_v;   /* In: size, >= srp_ng_size(); Out: length */
+    int                   status;                 /* Out: 0 on success */
+} SRPEnrollItem;
+
+/*
+ * srp_create_salted_verification_key2() for count accounts, spread over pool
+ * like srp_verifier_new_batch(). Each thread draws salts from its own DRBG.
+ * With -DSRP_HASH_ACCEL the x of all accounts are hashed together through
+ * srp_hash_batch() (srp_hash.c) before the threads compute v.
+ * Returns the number of items with status 0, -1 on bad arguments.
+ */
+int             srp_create_salted_verification_key_batch( SRPSession * session, SRPWorkerPool * pool,
+                                        SRPEnrollItem * items, int count );
+
 
 int                   srp_verifier_is_authenticated( SRPVerifier * ver );
 
@@ -248,6 +584,37 @@ SRPUser *      srp_user_new1( SRP_HashAlgorithm  hash_alg, NGConstant *ng,
 
 void                  srp_user_delete( SRPUser * usr );
 
+/*
+ * Allocation free variant of srp_user_new on a caller owned usr. Nothing is
+ * copied: session, username and password must outlive usr. Returns 0 on
+ * success, release with srp_user_free, not srp_user_delete.
+ */
+int                   srp_user_init( SRPUser * usr, SRPSession * session,
+                                    const char * username,
+                                    const unsigned char * bytes_password, int len_password);
+
+void                  srp_user_free( SRPUser * usr );
+
+/*
+ * x = H(s | H(username ":" password)) as srp_user_process_challenge computes
+ * it, written to bytes_x (srp_session_get_key_length() bytes). A client that
+ * logs in with the same salt again can keep x instead of the password.
+ * Returns 0 on success.
+ */
+int                   srp_calculate_x( SRPSession * session, const char * username,
+                                       const unsigned char * password, int len_password,
+                                       const unsigned char * bytes_s, int len_s,
+                                       unsigned char * bytes_x, int * len_x );
+
+/*
+ * srp_user_new / srp_user_init with x from srp_calculate_x in place of the
+ * password. Only a challenge with the salt x was made for can succeed.
+ */
+SRPUser *             srp_user_new_x( SRPSession * session, const char * username,
+                                      const unsigned char * bytes_x, int len_x );
+int                   srp_user_init_x( SRPUser * usr, SRPSession * session, const char * username,
+                                       const unsigned char * bytes_x, int len_x );
+
 int                   srp_user_is_authenticated( SRPUser * usr);
 
 
@@ -262,6 +629,13 @@ int                   srp_user_get_session_key_length( SRPUser * usr );
 void                  srp_user_start_authentication( SRPUser * usr, const char ** username,
                                                      const unsigned char ** bytes_A, int * len_A );
 
+/* Same as srp_user_start_authentication into a caller buffer. *len_A is the
+ * size of bytes_A on input, at least srp_ng_size(), and the length of A on
+ * output. Returns 0 on success.
+ */
+int                   srp_user_start_authentication1( SRPUser * usr,
+                                                      unsigned char * bytes_A, int * len_A );
+
 /* Output: bytes_M, len_M  (len_M may be null and will always be
  *                          srp_user_get_session_key_length() bytes in size) */
 void                  srp_user_process_challenge( SRPUser * usr,
@@ -0,0 +1,573 @@
+/*
+ * Secure Remote Password 6a implementation based on mbedtls.
+ *
+ * Copyright (c) 2019 Stoian Ivanov
+ * https://github.com/sdrsdr/mbedtls-csrp
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+
+/*
+ * Asynchronous handshake offload, see srp_async.h.
+ *
+ * Every pool thread owns a deque of queued ops. Submissions are spread over
+ * the deques round robin; a thread takes from the head of its own and, when
+ * that is empty, steals from the tail of the others, so one slow 8192 bit
+ * handshake never holds up the ops queued behind it.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+
+#include "srp.h"
+#include "srp_internal.h"
+#include "srp_async.h"
+
+#ifndef SRP_PTHREAD
+#error "srp_async.c needs -DSRP_PTHREAD"
+#endif
+
+enum { OP_KEYPAIR, OP_VERIFIER, OP_VKEY, OP_CHALLENGE };
+
+/*
+ * Leaving QUEUED happens under the lock of the deque the op sits in, leaving
+ * RUNNING under as->lock. Atomic, as srp_async_cancel reads it under the former.
+ */
+enum { OP_QUEUED, OP_RUNNING, OP_DONE, OP_ABANDONED, OP_CANCELLED };
+
+typedef struct SRPDeque {
+	pthread_mutex_t     lock;
+	SRPAsyncOp          *head;
+	SRPAsyncOp          *tail;
+} SRPDeque;
+
+struct SRPAsyncOp {
+	SRPAsync            *as;
+	int                 kind;
+	int                 state;
+	int                 waiting;    /* srp_async_cancel waits for a running op */
+	int                 home;       /* deque index */
+	SRPSession          *session;
+	SRPUser             *usr;
+	srp_async_cb        cb;
+	char                *username;  /* these point into in */
+	unsigned char       *in_s;
+	unsigned char       *in_v;
+	unsigned char       *in_AB;     /* A or B */
+	int                 len_in_s;
+	int                 len_in_v;
+	int                 len_in_AB;
+	int                 len_s;      /* salt length to create */
+	SRPAsyncResult      res;
+	SRPAsyncOp          *prev;      /* in a deque or the completion queue */
+	SRPAsyncOp          *next;
+	unsigned char       in[];
+};
+
+struct SRPAsync {
+	int                 nthreads;
+	pthread_t           *threads;
+	SRPDeque            *deques;
+	int                 next_deque; /* round robin, atomic */
+	int                 pending;    /* queued ops, atomic */
+	int                 stop;
+	pthread_mutex_t     lock;
+	pthread_cond_t      work;
+	pthread_cond_t      cancelled;
+
+	pthread_mutex_t     cq_lock;
+	SRPAsyncOp          *cq_head;
+	SRPAsyncOp          *cq_tail;
+	int                 fd[2];      /* fd[0] polled by the caller, fd[1] signalled */
+};
+
+static int op_state( SRPAsyncOp *op )
+{
+	return __atomic_load_n(&op->state, __ATOMIC_RELAXED);
+}
+
+static void op_set_state( SRPAsyncOp *op, int state )
+{
+	__atomic_store_n(&op->state, state, __ATOMIC_RELAXED);
+}
+
+static void op_push( SRPAsyncOp **head, SRPAsyncOp **tail, SRPAsyncOp *op )
+{
+	op->prev = *tail;
+	op->next = NULL;
+	if (*tail) (*tail)->next = op;
+	else *head = op;
+	*tail = op;
+}
+
+static void op_unlink( SRPAsyncOp **head, SRPAsyncOp **tail, SRPAsyncOp *op )
+{
+	if (op->prev) op->prev->next = op->next;
+	else *head = op->next;
+	if (op->next) op->next->prev = op->prev;
+	else *tail = op->prev;
+	op->prev = op->next = NULL;
+}
+
+/* the password of a verification key op is wiped like the one in SRPUser */
+static void op_free( SRPAsyncOp *op )
+{
+	if (op->kind==OP_VKEY) memset(op->in_v, 0, op->len_in_v);
+	srp_free(op);
+}
+
+/* frees outputs nobody is going to collect */
+static void op_discard( SRPAsyncOp *op )
+{
+	srp_keypair_delete(op->res.keys);
+	srp_verifier_delete(op->res.ver);
+	srp_free((void *) op->res.bytes_B);
+	srp_free((void *) op->res.bytes_s);
+	srp_free((void *) op->res.bytes_v);
+	memset(&op->res, 0, sizeof(op->res));
+}
+
+static void op_run( SRPAsyncOp *op )
+{
+	SRPAsyncResult *r = &op->res;
+
+	switch (op->kind) {
+	case OP_KEYPAIR:
+		r->keys = srp_keypair_new(op->session, op->in_v, op->len_in_v, &r->bytes_B, &r->len_B);
+		r->status = r->keys && r->bytes_B ? 0 : -1;
+		break;
+	case OP_VERIFIER:
+		r->ver = srp_verifier_new1(op->session, op->username, 1, op->in_s, op->len_in_s,
+			op->in_v, op->len_in_v, op->in_AB, op->len_in_AB, &r->bytes_B, &r->len_B, NULL);
+		r->status = r->ver && r->bytes_B ? 0 : -1;
+		break;
+	case OP_VKEY:
+		srp_create_salted_verification_key1(op->session, op->username, op->in_v, op->len_in_v,
+			&r->bytes_s, op->len_s, &r->bytes_v, &r->len_v);
+		if (r->bytes_s) r->len_s = op->len_s;
+		r->status = r->bytes_s ? 0 : -1;
+		break;
+	case OP_CHALLENGE:
+		srp_user_process_challenge(op->usr, op->in_s, op->len_in_s, op->in_AB, op->len_in_AB,
+			&r->bytes_M, &r->len_M);
+		r->status = r->bytes_M ? 0 : -1;
+		break;
+	}
+}
+
+static void op_deliver( SRPAsync *as, SRPAsyncOp *op )
+{
+	uint64_t one = 1;
+
+	if (op->cb) {
+		op->cb(op, &op->res);
+		return;
+	}
+	pthread_mutex_lock(&as->cq_lock);
+	/* the fd only turns readable on empty -> not empty, see srp_async_poll */
+	if (!as->cq_head) {
+#ifdef __linux__
+		if (write(as->fd[1], &one, sizeof(one))<0) {}
+#else
+		if (write(as->fd[1], &one, 1)<0) {}
+#endif
+	}
+	op_push(&as->cq_head, &as->cq_tail, op);
+	pthread_mutex_unlock(&as->cq_lock);
+}
+
+/* head of deque i when own, tail otherwise */
+static SRPAsyncOp * deque_take( SRPAsync *as, int i, int own )
+{
+	SRPDeque *d = &as->deques[i];
+	SRPAsyncOp *op;
+
+	pthread_mutex_lock(&d->lock);
+	op = own ? d->head : d->tail;
+	if (op) {
+		op_unlink(&d->head, &d->tail, op);
+		op_set_state(op, OP_RUNNING);
+		__atomic_fetch_sub(&as->pending, 1, __ATOMIC_RELAXED);
+	}
+	pthread_mutex_unlock(&d->lock);
+	return op;
+}
+
+typedef struct SRPAsyncWorker {
+	SRPAsync    *as;
+	int         index;
+} SRPAsyncWorker;
+
+static void * async_worker_main( void *arg )
+{
+	SRPAsyncWorker *w = (SRPAsyncWorker *) arg;
+	SRPAsync *as = w->as;
+	SRPAsyncOp *op;
+	int i, free_op;
+
+	for (;;) {
+		pthread_mutex_lock(&as->lock);
+		while (!as->stop && __atomic_load_n(&as->pending, __ATOMIC_RELAXED)==0)
+			pthread_cond_wait(&as->work, &as->lock);
+		if (as->stop) {
+			pthread_mutex_unlock(&as->lock);
+			break;
+		}
+		pthread_mutex_unlock(&as->lock);
+
+		op = deque_take(as, w->index, 1);
+		for (i=1; !op && i<as->nthreads; i++) op = deque_take(as, (w->index + i) % as->nthreads, 0);
+		if (!op) {
+			/* pending is counted before the op is linked in */
+			sched_yield();
+			continue;
+		}
+
+		op_run(op);
+
+		pthread_mutex_lock(&as->lock);
+		if (op_state(op)==OP_ABANDONED) {
+			op_discard(op);
+			op_set_state(op, OP_CANCELLED);
+			free_op = !op->waiting;
+			if (op->waiting) pthread_cond_broadcast(&as->cancelled);
+			pthread_mutex_unlock(&as->lock);
+			if (free_op) op_free(op);
+			continue;
+		}
+		op_set_state(op, OP_DONE);
+		pthread_mutex_unlock(&as->lock);
+		op_deliver(as, op);
+	}
+	srp_free(w);
+	return NULL;
+}
+
+SRPAsync * srp_async_new( int nthreads )
+{
+	SRPAsync *as;
+	SRPAsyncWorker *w;
+	int i;
+
+	if (nthreads<=0) {
+		long n = sysconf(_SC_NPROCESSORS_ONLN);
+		nthreads = n>1 ? (int) n : 1;
+	}
+
+	as = (SRPAsync *) srp_malloc(sizeof(SRPAsync));
+	if (!as) return NULL;
+	as->threads = (pthread_t *) srp_malloc(nthreads * sizeof(pthread_t));
+	as->deques = (SRPDeque *) srp_malloc(nthreads * sizeof(SRPDeque));
+	if (!as->threads || !as->deques) goto err_exit;
+
+#ifdef __linux__
+	as->fd[0] = as->fd[1] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (as->fd[0]<0) goto err_exit;
+#else
+	if (pipe(as->fd)!=0) goto err_exit;
+	fcntl(as->fd[0], F_SETFL, O_NONBLOCK);
+	fcntl(as->fd[1], F_SETFL, O_NONBLOCK);
+	fcntl(as->fd[0], F_SETFD, FD_CLOEXEC);
+	fcntl(as->fd[1], F_SETFD, FD_CLOEXEC);
+#endif
+
+	pthread_mutex_init(&as->lock, NULL);
+	pthread_mutex_init(&as->cq_lock, NULL);
+	pthread_cond_init(&as->work, NULL);
+	pthread_cond_init(&as->cancelled, NULL);
+	for (i=0; i<nthreads; i++) pthread_mutex_init(&as->deques[i].lock, NULL);
+
+	for (i=0; i<nthreads; i++) {
+		w = (SRPAsyncWorker *) srp_malloc(sizeof(SRPAsyncWorker));
+		if (!w) break;
+		w->as = as;
+		w->index = i;
+		if (pthread_create(&as->threads[i], NULL, async_worker_main, w)!=0) {
+			srp_free(w);
+			break;
+		}
+	}
+	if (i==0) {
+		as->nthreads = 0;
+		srp_async_delete(as);
+		return NULL;
+	}
+	/* only the deques of the threads that started are used */
+	as->nthreads = i;
+	return as;
+
+err_exit:
+	srp_free(as->deques);
+	srp_free(as->threads);
+	srp_free(as);
+	return NULL;
+}
+
+void srp_async_delete( SRPAsync *as )
+{
+	SRPAsyncOp *op;
+	int i;
+
+	if (!as) return;
+
+	pthread_mutex_lock(&as->lock);
+	as->stop = 1;
+	pthread_cond_broadcast(&as->work);
+	pthread_mutex_unlock(&as->lock);
+	for (i=0; i<as->nthreads; i++) pthread_join(as->threads[i], NULL);
+
+	for (i=0; i<as->nthreads; i++) {
+		while ((op = as->deques[i].head)) {
+			op_unlink(&as->deques[i].head, &as->deques[i].tail, op);
+			op_free(op);
+		}
+		pthread_mutex_destroy(&as->deques[i].lock);
+	}
+	while ((op = as->cq_head)) {
+		op_unlink(&as->cq_head, &as->cq_tail, op);
+		op_discard(op);
+		op_free(op);
+	}
+
+	close(as->fd[0]);
+	if (as->fd[1]!=as->fd[0]) close(as->fd[1]);
+	pthread_cond_destroy(&as->cancelled);
+	pthread_cond_destroy(&as->work);
+	pthread_mutex_destroy(&as->cq_lock);
+	pthread_mutex_destroy(&as->lock);
+	srp_free(as->deques);
+	srp_free(as->threads);
+	memset(as, 0, sizeof(SRPAsync));
+	srp_free(as);
+}
+
+int srp_async_fd( SRPAsync *as )
+{
+	return as ? as->fd[0] : -1;
+}
+
+SRPAsyncOp * srp_async_poll( SRPAsync *as )
+{
+	SRPAsyncOp *op;
+	unsigned char buf[64];
+
+	if (!as) return NULL;
+
+	pthread_mutex_lock(&as->cq_lock);
+	op = as->cq_head;
+	if (op) {
+		op_unlink(&as->cq_head, &as->cq_tail, op);
+		/* drained: reset the fd under the same lock that op_deliver signals it */
+		if (!as->cq_head) {
+			while (read(as->fd[0], buf, sizeof(buf))>0) {}
+		}
+	}
+	pthread_mutex_unlock(&as->cq_lock);
+	return op;
+}
+
+const SRPAsyncResult * srp_async_result( SRPAsyncOp *op )
+{
+	return op ? &op->res : NULL;
+}
+
+void srp_async_release( SRPAsyncOp *op )
+{
+	op_free(op);
+}
+
+int srp_async_cancel( SRPAsyncOp *op )
+{
+	SRPAsync *as;
+	SRPDeque *d;
+	int queued;
+
+	if (!op) return -1;
+	as = op->as;
+	d = &as->deques[op->home];
+
+	pthread_mutex_lock(&d->lock);
+	queued = op_state(op)==OP_QUEUED;
+	if (queued) {
+		op_unlink(&d->head, &d->tail, op);
+		op_set_state(op, OP_CANCELLED);
+		__atomic_fetch_sub(&as->pending, 1, __ATOMIC_RELAXED);
+	}
+	pthread_mutex_unlock(&d->lock);
+	if (queued) {
+		op_free(op);
+		return 0;
+	}
+
+	pthread_mutex_lock(&as->lock);
+	if (op_state(op)!=OP_RUNNING) {
+		pthread_mutex_unlock(&as->lock);
+		return -1;
+	}
+	op_set_state(op, OP_ABANDONED);
+	if (op->kind==OP_CHALLENGE) {
+		op->waiting = 1;
+		while (op_state(op)!=OP_CANCELLED) pthread_cond_wait(&as->cancelled, &as->lock);
+		pthread_mutex_unlock(&as->lock);
+		op_free(op);
+		return 0;
+	}
+	pthread_mutex_unlock(&as->lock);
+	return 0;
+}
+
+/* op with room for size bytes of input copies, not yet queued */
+static SRPAsyncOp * op_new( SRPAsync *as, int kind, SRPSession *session, size_t size,
+	srp_async_cb cb, void *ctx )
+{
+	SRPAsyncOp *op;
+
+	op = (SRPAsyncOp *) srp_malloc(sizeof(SRPAsyncOp) + size);
+	if (!op) return NULL;
+	op->as = as;
+	op->kind = kind;
+	op->session = session;
+	op->cb = cb;
+	op->res.ctx = ctx;
+	return op;
+}
+
+static unsigned char * op_copy( SRPAsyncOp *op, size_t *at, const void *p, int len )
+{
+	unsigned char *dst = op->in + *at;
+
+	memcpy(dst, p, len);
+	*at += len;
+	return dst;
+}
+
+static SRPAsyncOp * op_submit( SRPAsyncOp *op )
+{
+	SRPAsync *as = op->as;
+	SRPDeque *d;
+
+	op->home = (unsigned) __atomic_fetch_add(&as->next_deque, 1, __ATOMIC_RELAXED) % as->nthreads;
+	d = &as->deques[op->home];
+	op_set_state(op, OP_QUEUED);
+
+	__atomic_fetch_add(&as->pending, 1, __ATOMIC_RELAXED);
+	pthread_mutex_lock(&d->lock);
+	op_push(&d->head, &d->tail, op);
+	pthread_mutex_unlock(&d->lock);
+
+	pthread_mutex_lock(&as->lock);
+	pthread_cond_signal(&as->work);
+	pthread_mutex_unlock(&as->lock);
+	return op;
+}
+
+SRPAsyncOp * srp_async_keypair_new( SRPAsync *as, SRPSession *session,
+	const unsigned char *bytes_v, int len_v, srp_async_cb cb, void *ctx )
+{
+	SRPAsyncOp *op;
+	size_t at = 0;
+
+	if (!as || !session || !bytes_v || len_v<=0) return NULL;
+
+	op = op_new(as, OP_KEYPAIR, session, len_v, cb, ctx);
+	if (!op) return NULL;
+	op->in_v = op_copy(op, &at, bytes_v, len_v);
+	op->len_in_v = len_v;
+	return op_submit(op);
+}
+
+SRPAsyncOp * srp_async_verifier_new( SRPAsync *as, SRPSession *session,
+	const char *username,
+	const unsigned char *bytes_s, int len_s,
+	const unsigned char *bytes_v, int len_v,
+	const unsigned char *bytes_A, int len_A,
+	srp_async_cb cb, void *ctx )
+{
+	SRPAsyncOp *op;
+	size_t ulen, at = 0;
+
+	if (!as || !session || !username || !bytes_s || !bytes_v || !bytes_A) return NULL;
+	if (len_s<=0 || len_v<=0 || len_A<=0) return NULL;
+
+	ulen = strlen(username) + 1;
+	op = op_new(as, OP_VERIFIER, session, ulen + len_s + len_v + len_A, cb, ctx);
+	if (!op) return NULL;
+	op->username = (char *) op_copy(op, &at, username, ulen);
+	op->in_s = op_copy(op, &at, bytes_s, len_s);
+	op->in_v = op_copy(op, &at, bytes_v, len_v);
+	op->in_AB = op_copy(op, &at, bytes_A, len_A);
+	op->len_in_s = len_s;
+	op->len_in_v = len_v;
+	op->len_in_AB = len_A;
+	return op_submit(op);
+}
+
+SRPAsyncOp * srp_async_create_salted_verification_key( SRPAsync *as, SRPSession *session,
+	const char *username,
+	const unsigned char *password, int len_password,
+	int len_s,
+	srp_async_cb cb, void *ctx )
+{
+	SRPAsyncOp *op;
+	size_t ulen, at = 0;
+
+	if (!as || !session || !username || !password || len_password<0 || len_s<=0) return NULL;
+
+	ulen = strlen(username) + 1;
+	op = op_new(as, OP_VKEY, session, ulen + len_password, cb, ctx);
+	if (!op) return NULL;
+	op->username = (char *) op_copy(op, &at, username, ulen);
+	/* the password rides in the v slot */
+	op->in_v = op_copy(op, &at, password, len_password);
+	op->len_in_v = len_password;
+	op->len_s = len_s;
+	return op_submit(op);
+}
+
+SRPAsyncOp * srp_async_user_process_challenge( SRPAsync *as, SRPUser *usr,
+	const unsigned char *bytes_s, int len_s,
+	const unsigned char *bytes_B, int len_B,
+	srp_async_cb cb, void *ctx )
+{
+	SRPAsyncOp *op;
+	size_t at = 0;
+
+	if (!as || !usr || !bytes_s || !bytes_B || len_s<=0 || len_B<=0) return NULL;
+
+	op = op_new(as, OP_CHALLENGE, NULL, len_s + len_B, cb, ctx);
+	if (!op) return NULL;
+	op->usr = usr;
+	op->in_s = op_copy(op, &at, bytes_s, len_s);
+	op->in_AB = op_copy(op, &at, bytes_B, len_B);
+	op->len_in_s = len_s;
+	op->len_in_AB = len_B;
+	return op_submit(op);
+}
@@ -0,0 +1,145 @@
+#ifndef SRP_ASYNC_H
+#define SRP_ASYNC_H
+
+/*
+ * Secure Remote Password 6a implementation based on mbedtls.
+ *
+ * Copyright (c) 2019 Stoian Ivanov
+ * https://github.com/sdrsdr/mbedtls-csrp
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/*
+ * Asynchronous front-end for the expensive calls. Each srp_async_* submit
+ * function copies its byte inputs, queues the work on a library owned
+ * thread pool and returns at once. Results come back either through a
+ * callback, run on a pool thread, or through a completion queue that an
+ * event loop drains when srp_async_fd() turns readable. Needs srp_async.c
+ * and -DSRP_PTHREAD.
+ */
+
+#include "srp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct SRPAsync SRPAsync;
+typedef struct SRPAsyncOp SRPAsyncOp;
+
+/*
+ * Outputs of one op. The fields a call does not produce stay NULL/0. f_free
+ * is the one passed to srp_set_allocator(), free() by default.
+ */
+typedef struct SRPAsyncResult {
+    void                * ctx;          /* as passed at submission */
+    int                   status;       /* 0 success, -1 failure */
+
+    SRPKeyPair          * keys;         /* keypair: free with srp_keypair_delete */
+    SRPVerifier         * ver;          /* verifier: free with srp_verifier_delete */
+    const unsigned char * bytes_B;      /* keypair, verifier: free with f_free */
+    int                   len_B;
+    const unsigned char * bytes_s;      /* verification key: free with f_free */
+    int                   len_s;
+    const unsigned char * bytes_v;      /* verification key: free with f_free */
+    int                   len_v;
+    const unsigned char * bytes_M;      /* challenge: owned by usr */
+    int                   len_M;
+} SRPAsyncResult;
+
+/*
+ * Called on a pool thread once op is done. The callee owns op from here on
+ * and must end with srp_async_release(op), not necessarily in the callback.
+ */
+typedef void (*srp_async_cb)( SRPAsyncOp * op, const SRPAsyncResult * res );
+
+/* nthreads<=0 starts one thread per online CPU */
+SRPAsync *   srp_async_new( int nthreads );
+
+/*
+ * Stops the pool. Ops still queued are dropped, running ones finish first,
+ * and completed ones nobody polled are freed together with their results.
+ */
+void         srp_async_delete( SRPAsync * as );
+
+/*
+ * Readable while the completion queue is not empty. Poll it with
+ * epoll/io_uring and call srp_async_poll() until it returns NULL.
+ * An eventfd on Linux, the read end of a pipe elsewhere.
+ */
+int          srp_async_fd( SRPAsync * as );
+
+/* Next completed op without a callback, NULL when there is none */
+SRPAsyncOp * srp_async_poll( SRPAsync * as );
+
+const SRPAsyncResult * srp_async_result( SRPAsyncOp * op );
+
+/* Frees op. The outputs in its result now belong to the caller */
+void         srp_async_release( SRPAsyncOp * op );
+
+/*
+ * For a client that went away. Returns 0 if op will never be delivered: it
+ * was dropped from the queue, or its results are thrown away as soon as it
+ * finishes. op is gone for the caller in that case. Returns -1 when op is
+ * already done and is or will be delivered as usual.
+ *
+ * With a callback, serialize srp_async_cancel() with it, e.g. under the
+ * lock of the connection, as the callback may release op.
+ *
+ * Does not block, except for an op of srp_async_user_process_challenge that
+ * is running: it waits for the op to leave usr alone.
+ */
+int          srp_async_cancel( SRPAsyncOp * op );
+
+/*
+ * The submit functions. cb NULL sends op to the completion queue. All byte
+ * inputs are copied; session must outlive the op, and so must usr, which the
+ * op works on in place. NULL on bad arguments or out of memory.
+ */
+SRPAsyncOp * srp_async_keypair_new( SRPAsync * as, SRPSession * session,
+                                    const unsigned char * bytes_v, int len_v,
+                                    srp_async_cb cb, void * ctx );
+
+SRPAsyncOp * srp_async_verifier_new( SRPAsync * as, SRPSession * session,
+                                     const char * username,
+                                     const unsigned char * bytes_s, int len_s,
+                                     const unsigned char * bytes_v, int len_v,
+                                     const unsigned char * bytes_A, int len_A,
+                                     srp_async_cb cb, void * ctx );
+
+SRPAsyncOp * srp_async_create_salted_verification_key( SRPAsync * as, SRPSession * session,
+                                                       const char * username,
+                                                       const unsigned char * password, int len_password,
+                                                       int len_s,
+                                                       srp_async_cb cb, void * ctx );
+
+SRPAsyncOp * srp_async_user_process_challenge( SRPAsync * as, SRPUser * usr,
+                                               const unsigned char * bytes_s, int len_s,
+                                               const unsigned char * bytes_B, int len_B,
+                                               srp_async_cb cb, void * ctx );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
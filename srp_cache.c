@@ -0,0 +1,665 @@
+/*
+ * Secure Remote Password 6a implementation based on mbedtls.
+ *
+ * Copyright (c) 2019 Stoian Ivanov
+ * https://github.com/sdrsdr/mbedtls-csrp
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/*
+ * Decoded verifier cache and client cache of k*g^x, see srp_cache.h. Builds
+ * with or without -DSRP_PTHREAD; without it a cache is for one thread only.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mbedtls/bignum.h"
+
+#include "srp.h"
+#include "srp_internal.h"
+#include "srp_cache.h"
+
+#define CACHE_SHARDS    16
+#define CACHE_VTAB_W    4       /* window of the tables for v */
+
+#ifdef SRP_PTHREAD
+#define SHARD_LOCK(sh)      pthread_mutex_lock(&(sh)->lock)
+#define SHARD_UNLOCK(sh)    pthread_mutex_unlock(&(sh)->lock)
+#else
+#define SHARD_LOCK(sh)
+#define SHARD_UNLOCK(sh)
+#endif
+
+typedef struct CacheEntry {
+	struct CacheEntry   *hnext;     /* bucket chain */
+	struct CacheEntry   *prev;      /* LRU list, most recent first */
+	struct CacheEntry   *next;
+	uint64_t            hash;
+	int                 refs;       /* handshakes using it, +1 while listed */
+	int                 listed;
+	int                 building;   /* a table for v is being built */
+	unsigned int        hits;
+	mbedtls_mpi         v;
+	mbedtls_mpi         kv;         /* k*v mod N */
+	SRPFixedBase        *vtab;      /* set once, under the shard lock */
+	const unsigned char *bytes_v;   /* what v was decoded from, after the struct */
+	int                 len_v;
+	const char          *username;  /* after bytes_v */
+} CacheEntry;
+
+typedef struct CacheShard {
+#ifdef SRP_PTHREAD
+	pthread_mutex_t     lock;
+#endif
+	CacheEntry          **buckets;
+	size_t              mask;
+	CacheEntry          *head;
+	CacheEntry          *tail;
+	int                 count;
+	unsigned long long  hits;
+	unsigned long long  misses;
+	unsigned long long  evictions;
+	unsigned char       pad[SRP_CACHE_LINE];    /* keeps neighbouring locks off this line */
+} CacheShard;
+
+struct SRPVerifierCache {
+	CacheShard          shards[CACHE_SHARDS];
+	SRPSession          *session;
+	int                 shard_capacity;
+	int                 max_tables;
+	int                 tables;     /* built or being built, atomic */
+};
+
+static uint64_t cache_hash( const char *s )
+{
+	uint64_t h = 14695981039346656037ULL;
+	for (; *s; s++) {
+		h ^= (unsigned char) *s;
+		h *= 1099511628211ULL;
+	}
+	return h;
+}
+
+static void entry_free( SRPVerifierCache *cache, CacheEntry *e )
+{
+	if (e->vtab) {
+		srp_ng_table_release(e->vtab);
+		__atomic_sub_fetch(&cache->tables, 1, __ATOMIC_RELAXED);
+	}
+	mbedtls_mpi_free(&e->v);
+	mbedtls_mpi_free(&e->kv);
+	srp_free(e);
+}
+
+/* decodes v and computes kv, NULL on failure */
+static CacheEntry * entry_new( SRPVerifierCache *cache, uint64_t hash, const char *username,
+	const unsigned char *bytes_v, int len_v )
+{
+	NGConstant *ng = cache->session->ng;
+	NGPrecomp *pre;
+	CacheEntry *e;
+	size_t ulen = strlen(username) + 1;
+
+	pre = srp_ng_precomp(ng, cache->session->hash_alg);
+	if (!pre) return NULL;
+
+	e = (CacheEntry *) srp_malloc(sizeof(CacheEntry) + len_v + ulen);
+	if (!e) return NULL;
+	memset(e, 0, sizeof(CacheEntry));
+	e->hash = hash;
+	e->refs = 1;
+	e->len_v = len_v;
+	e->bytes_v = (unsigned char *)(e + 1);
+	e->username = (char *)(e + 1) + len_v;
+	memcpy((unsigned char *)(e + 1), bytes_v, len_v);
+	memcpy((char *)(e + 1) + len_v, username, ulen);
+	mbedtls_mpi_init(&e->v);
+	mbedtls_mpi_init(&e->kv);
+
+	if (mbedtls_mpi_read_binary(&e->v, bytes_v, len_v)!=0
+		|| mbedtls_mpi_mul_mpi(&e->kv, &pre->k, &e->v)!=0
+		|| mbedtls_mpi_mod_mpi(&e->kv, &e->kv, ng->N)!=0) {
+		entry_free(cache, e);
+		return NULL;
+	}
+	return e;
+}
+
+/* the following run under the shard lock */
+
+static void lru_unlink( CacheShard *sh, CacheEntry *e )
+{
+	if (e->prev) e->prev->next = e->next;
+	else sh->head = e->next;
+	if (e->next) e->next->prev = e->prev;
+	else sh->tail = e->prev;
+	e->prev = e->next = NULL;
+}
+
+static void lru_push( CacheShard *sh, CacheEntry *e )
+{
+	e->prev = NULL;
+	e->next = sh->head;
+	if (sh->head) sh->head->prev = e;
+	else sh->tail = e;
+	sh->head = e;
+}
+
+/* takes e out of the shard, returns 1 when the caller must free it */
+static int shard_remove( CacheShard *sh, CacheEntry *e )
+{
+	CacheEntry **pp;
+
+	for (pp = &sh->buckets[e->hash & sh->mask]; *pp; pp = &(*pp)->hnext) {
+		if (*pp == e) {
+			*pp = e->hnext;
+			break;
+		}
+	}
+	lru_unlink(sh, e);
+	e->listed = 0;
+	sh->count--;
+	return --e->refs == 0;
+}
+
+static CacheEntry * shard_find( CacheShard *sh, uint64_t hash, const char *username )
+{
+	CacheEntry *e;
+
+	for (e = sh->buckets[hash & sh->mask]; e; e = e->hnext) {
+		if (e->hash == hash && strcmp(e->username, username) == 0) return e;
+	}
+	return NULL;
+}
+
+static CacheShard * shard_of( SRPVerifierCache *cache, uint64_t hash )
+{
+	/* the buckets use the low bits */
+	return &cache->shards[(hash >> 56) % CACHE_SHARDS];
+}
+
+/*
+ * Returns the entry for (username, v) with a reference for the caller, and
+ * in *vtab the table for v if it has one. NULL when v cannot be decoded.
+ */
+static CacheEntry * cache_acquire( SRPVerifierCache *cache, const char *username,
+	const unsigned char *bytes_v, int len_v, const SRPFixedBase **vtab )
+{
+	uint64_t hash = cache_hash(username);
+	CacheShard *sh = shard_of(cache, hash);
+	CacheEntry *e, *old, *victim = NULL, *stale = NULL;
+	SRPFixedBase *tab;
+	int build = 0;
+
+	SHARD_LOCK(sh);
+	e = shard_find(sh, hash, username);
+	if (e && e->len_v == len_v && memcmp(e->bytes_v, bytes_v, len_v) == 0) {
+		sh->hits++;
+		e->refs++;
+		e->hits++;
+		if (sh->head != e) {
+			lru_unlink(sh, e);
+			lru_push(sh, e);
+		}
+		if (!e->vtab && !e->building && e->hits >= SRP_CACHE_HOT_HITS && cache->max_tables > 0) {
+			if (__atomic_add_fetch(&cache->tables, 1, __ATOMIC_RELAXED) <= cache->max_tables) {
+				e->building = 1;
+				build = 1;
+			} else {
+				__atomic_sub_fetch(&cache->tables, 1, __ATOMIC_RELAXED);
+			}
+		}
+		*vtab = e->vtab;
+		SHARD_UNLOCK(sh);
+
+		if (build) {
+			/* the first handshake past the mark pays for the table, outside the lock */
+			tab = srp_ng_table_new(cache->session->ng, &e->v, CACHE_VTAB_W,
+				8 * srp_session_get_key_length(cache->session));
+			SHARD_LOCK(sh);
+			e->vtab = tab;
+			e->building = 0;
+			SHARD_UNLOCK(sh);
+			if (!tab) __atomic_sub_fetch(&cache->tables, 1, __ATOMIC_RELAXED);
+			*vtab = tab;
+		}
+		return e;
+	}
+	sh->misses++;
+	SHARD_UNLOCK(sh);
+
+	/* decode outside the lock, another thread may race us to it: last one wins */
+	e = entry_new(cache, hash, username, bytes_v, len_v);
+	if (!e) return NULL;
+	e->refs++;
+	e->listed = 1;
+
+	SHARD_LOCK(sh);
+	old = shard_find(sh, hash, username);
+	if (old && shard_remove(sh, old)) stale = old;
+	e->hnext = sh->buckets[hash & sh->mask];
+	sh->buckets[hash & sh->mask] = e;
+	lru_push(sh, e);
+	sh->count++;
+	if (sh->count > cache->shard_capacity) {
+		sh->evictions++;
+		old = sh->tail;
+		if (shard_remove(sh, old)) victim = old;
+	}
+	SHARD_UNLOCK(sh);
+
+	if (stale) entry_free(cache, stale);
+	if (victim) entry_free(cache, victim);
+	*vtab = NULL;
+	return e;
+}
+
+static void cache_release( SRPVerifierCache *cache, CacheEntry *e )
+{
+	CacheShard *sh = shard_of(cache, e->hash);
+	int last;
+
+	SHARD_LOCK(sh);
+	last = --e->refs == 0;
+	SHARD_UNLOCK(sh);
+	if (last) entry_free(cache, e);
+}
+
+SRPVerifierCache * srp_verifier_cache_new( SRPSession *session, int capacity, int max_tables )
+{
+	SRPVerifierCache *cache;
+	size_t nb;
+	int i;
+
+	if (!session || capacity <= 0) return NULL;
+	if (!srp_ng_precomp(session->ng, session->hash_alg)) return NULL;
+
+	cache = (SRPVerifierCache *) srp_malloc(sizeof(SRPVerifierCache));
+	if (!cache) return NULL;
+	memset(cache, 0, sizeof(SRPVerifierCache));
+	cache->session = session;
+	cache->shard_capacity = (capacity + CACHE_SHARDS - 1) / CACHE_SHARDS;
+	cache->max_tables = max_tables > 0 ? max_tables : 0;
+
+	for (nb = 4; nb < (size_t) cache->shard_capacity; nb <<= 1) ;
+	for (i=0; i<CACHE_SHARDS; i++) {
+		CacheShard *sh = &cache->shards[i];
+		sh->buckets = (CacheEntry **) srp_malloc(nb * sizeof(CacheEntry *));
+		if (!sh->buckets) break;
+		memset(sh->buckets, 0, nb * sizeof(CacheEntry *));
+		sh->mask = nb - 1;
+#ifdef SRP_PTHREAD
+		pthread_mutex_init(&sh->lock, NULL);
+#endif
+	}
+	if (i < CACHE_SHARDS) {
+		while (i-- > 0) {
+			srp_free(cache->shards[i].buckets);
+#ifdef SRP_PTHREAD
+			pthread_mutex_destroy(&cache->shards[i].lock);
+#endif
+		}
+		srp_free(cache);
+		return NULL;
+	}
+	return cache;
+}
+
+void srp_verifier_cache_delete( SRPVerifierCache *cache )
+{
+	CacheEntry *e, *next;
+	int i;
+
+	if (!cache) return;
+	for (i=0; i<CACHE_SHARDS; i++) {
+		CacheShard *sh = &cache->shards[i];
+		for (e = sh->head; e; e = next) {
+			next = e->next;
+			entry_free(cache, e);
+		}
+		srp_free(sh->buckets);
+#ifdef SRP_PTHREAD
+		pthread_mutex_destroy(&sh->lock);
+#endif
+	}
+	srp_free(cache);
+}
+
+void srp_verifier_cache_stats( SRPVerifierCache *cache, SRPVerifierCacheStats *stats )
+{
+	int i;
+
+	memset(stats, 0, sizeof(SRPVerifierCacheStats));
+	if (!cache) return;
+	for (i=0; i<CACHE_SHARDS; i++) {
+		CacheShard *sh = &cache->shards[i];
+		SHARD_LOCK(sh);
+		stats->hits      += sh->hits;
+		stats->misses    += sh->misses;
+		stats->evictions += sh->evictions;
+		stats->entries   += sh->count;
+		SHARD_UNLOCK(sh);
+	}
+	stats->tables = __atomic_load_n(&cache->tables, __ATOMIC_RELAXED);
+}
+
+int srp_verifier_init_cached( SRPVerifierCache *cache, SRPVerifier *ver,
+	const char *username, const unsigned char *bytes_s, int len_s,
+	const unsigned char *bytes_v, int len_v, const unsigned char *bytes_A, int len_A,
+	unsigned char *bytes_B, int *len_B, SRPKeyPair *keys )
+{
+	const SRPFixedBase *vtab;
+	CacheEntry *e;
+	int rc;
+
+	if (!cache || !ver || !username || len_v < 0) return -1;
+
+	e = cache_acquire(cache, username, bytes_v, len_v, &vtab);
+	if (!e) {
+		memset(ver, 0, sizeof(SRPVerifier));
+		return -1;
+	}
+	rc = srp_verifier_init_v(ver, cache->session, username, bytes_s, len_s, bytes_A, len_A,
+		bytes_B, len_B, keys, &e->v, &e->kv, vtab);
+	cache_release(cache, e);
+	return rc;
+}
+
+SRPVerifier * srp_verifier_new_cached( SRPVerifierCache *cache,
+	const char *username, int copy_username,
+	const unsigned char *bytes_s, int len_s, const unsigned char *bytes_v, int len_v,
+	const unsigned char *bytes_A, int len_A, const unsigned char **bytes_B, int *len_B,
+	SRPKeyPair *keys )
+{
+	SRPVerifier   *ver;
+	unsigned char *buf = NULL;
+	char          *uname = NULL;
+	int            len = 0;
+
+	if (bytes_B) {
+		*bytes_B = NULL;
+		*len_B = 0;
+	}
+	if (!cache || !username) return NULL;
+
+	ver = (SRPVerifier *) srp_malloc(sizeof(SRPVerifier));
+	if (!ver) return NULL;
+
+	if (bytes_B && !keys) {
+		len = srp_ng_size(cache->session->ng);
+		buf = (unsigned char *) srp_malloc(len);
+		if (!buf) goto err_exit;
+	}
+
+	if (copy_username) {
+		int ulen = strlen(username) + 1;
+		uname = (char *) srp_malloc(ulen);
+		if (!uname) goto err_exit;
+		memcpy(uname, username, ulen);
+		username = uname;
+	}
+
+	/* as with srp_verifier_new1(), a failed handshake still returns ver */
+	if (srp_verifier_init_cached(cache, ver, username, bytes_s, len_s, bytes_v, len_v,
+		bytes_A, len_A, buf, &len, keys)==0 && buf) {
+		*bytes_B = buf;
+		*len_B = len;
+	} else {
+		srp_free(buf);
+	}
+	ver->username = username;
+	ver->owns_username = copy_username;
+	return ver;
+
+err_exit:
+	srp_free(buf);
+	srp_free(ver);
+	return NULL;
+}
+
+
+/***********************************************************************************************************
+ *
+ *  Client cache of k*g^x
+ *
+ ***********************************************************************************************************/
+
+typedef struct UserEntry {
+	struct UserEntry    *hnext;
+	struct UserEntry    *prev;      /* LRU list, most recent first */
+	struct UserEntry    *next;
+	uint64_t            hash;
+	SRP_HashAlgorithm   alg;
+	mbedtls_mpi         N;          /* the group: k and g^x depend on both */
+	mbedtls_mpi         g;
+	mbedtls_mpi         kgx;        /* k*g^x mod N */
+	unsigned char       x[SHA512_DIGEST_LENGTH];
+} UserEntry;
+
+struct SRPUserCache {
+#ifdef SRP_PTHREAD
+	pthread_mutex_t     lock;
+#endif
+	UserEntry           **buckets;
+	size_t              mask;
+	UserEntry           *head;
+	UserEntry           *tail;
+	int                 count;
+	int                 capacity;
+	unsigned long long  hits;
+	unsigned long long  misses;
+	unsigned long long  evictions;
+};
+
+static uint64_t user_hash( const unsigned char *x, int len )
+{
+	uint64_t h = 14695981039346656037ULL;
+	int i;
+
+	for (i=0; i<len; i++) {
+		h ^= x[i];
+		h *= 1099511628211ULL;
+	}
+	return h;
+}
+
+static void user_entry_free( UserEntry *e )
+{
+	mbedtls_mpi_free(&e->N);
+	mbedtls_mpi_free(&e->g);
+	mbedtls_mpi_free(&e->kgx);
+	memset(e->x, 0, sizeof(e->x));
+	srp_free(e);
+}
+
+/* under the lock */
+static UserEntry * user_find( SRPUserCache *cache, uint64_t hash, SRP_HashAlgorithm alg,
+	const mbedtls_mpi *N, const mbedtls_mpi *g, const unsigned char *x, int len )
+{
+	UserEntry *e;
+
+	for (e = cache->buckets[hash & cache->mask]; e; e = e->hnext) {
+		if (e->hash == hash && e->alg == alg && memcmp(e->x, x, len) == 0
+			&& mbedtls_mpi_cmp_mpi(&e->N, N) == 0 && mbedtls_mpi_cmp_mpi(&e->g, g) == 0) return e;
+	}
+	return NULL;
+}
+
+static void user_unlink( SRPUserCache *cache, UserEntry *e )
+{
+	UserEntry **pp;
+
+	for (pp = &cache->buckets[e->hash & cache->mask]; *pp; pp = &(*pp)->hnext) {
+		if (*pp == e) {
+			*pp = e->hnext;
+			break;
+		}
+	}
+	if (e->prev) e->prev->next = e->next;
+	else cache->head = e->next;
+	if (e->next) e->next->prev = e->prev;
+	else cache->tail = e->prev;
+	cache->count--;
+}
+
+static void user_push( SRPUserCache *cache, UserEntry *e )
+{
+	e->hnext = cache->buckets[e->hash & cache->mask];
+	cache->buckets[e->hash & cache->mask] = e;
+	e->prev = NULL;
+	e->next = cache->head;
+	if (cache->head) cache->head->prev = e;
+	else cache->tail = e;
+	cache->head = e;
+	cache->count++;
+}
+
+SRPUserCache * srp_user_cache_new( int capacity )
+{
+	SRPUserCache *cache;
+	size_t nb;
+
+	if (capacity <= 0) return NULL;
+
+	cache = (SRPUserCache *) srp_malloc(sizeof(SRPUserCache));
+	if (!cache) return NULL;
+	memset(cache, 0, sizeof(SRPUserCache));
+	cache->capacity = capacity;
+	for (nb = 4; nb < (size_t) capacity; nb <<= 1) ;
+	cache->buckets = (UserEntry **) srp_malloc(nb * sizeof(UserEntry *));
+	if (!cache->buckets) {
+		srp_free(cache);
+		return NULL;
+	}
+	memset(cache->buckets, 0, nb * sizeof(UserEntry *));
+	cache->mask = nb - 1;
+#ifdef SRP_PTHREAD
+	pthread_mutex_init(&cache->lock, NULL);
+#endif
+	return cache;
+}
+
+void srp_user_cache_delete( SRPUserCache *cache )
+{
+	UserEntry *e, *next;
+
+	if (!cache) return;
+	for (e = cache->head; e; e = next) {
+		next = e->next;
+		user_entry_free(e);
+	}
+	srp_free(cache->buckets);
+#ifdef SRP_PTHREAD
+	pthread_mutex_destroy(&cache->lock);
+#endif
+	srp_free(cache);
+}
+
+void srp_user_cache_stats( SRPUserCache *cache, SRPVerifierCacheStats *stats )
+{
+	memset(stats, 0, sizeof(SRPVerifierCacheStats));
+	if (!cache) return;
+	SHARD_LOCK(cache);
+	stats->hits      = cache->hits;
+	stats->misses    = cache->misses;
+	stats->evictions = cache->evictions;
+	stats->entries   = cache->count;
+	SHARD_UNLOCK(cache);
+}
+
+/*
+ * x is two hashes and always recomputed; what a hit saves is g^x. kgx is
+ * copied out under the lock, so an entry evicted meanwhile does no harm.
+ */
+void srp_user_process_challenge_cached( SRPUserCache *cache, SRPUser *usr,
+	const unsigned char *bytes_s, int len_s,
+	const unsigned char *bytes_B, int len_B,
+	const unsigned char **bytes_M, int *len_M )
+{
+	unsigned char x[SHA512_DIGEST_LENGTH];
+	int len = srp_user_get_session_key_length(usr);
+	UserEntry *e, *victim = NULL;
+	mbedtls_mpi kgx;
+	uint64_t hash;
+	int hit = 0;
+
+	if (!cache || srp_user_x(usr, bytes_s, len_s, x)!=0) {
+		srp_user_process_challenge(usr, bytes_s, len_s, bytes_B, len_B, bytes_M, len_M);
+		return;
+	}
+	hash = user_hash(x, len);
+	mbedtls_mpi_init(&kgx);
+
+	SHARD_LOCK(cache);
+	e = user_find(cache, hash, usr->hash_alg, usr->ng->N, usr->ng->g, x, len);
+	if (e && mbedtls_mpi_copy(&kgx, &e->kgx) == 0) {
+		cache->hits++;
+		user_unlink(cache, e);
+		user_push(cache, e);
+		hit = 1;
+	} else {
+		cache->misses++;
+	}
+	SHARD_UNLOCK(cache);
+
+	srp_user_process_challenge_kgx(usr, bytes_s, len_s, bytes_B, len_B, bytes_M, len_M,
+		hit ? &kgx : NULL, hit ? NULL : &kgx);
+
+	if (!hit && *bytes_M) {
+		e = (UserEntry *) srp_malloc(sizeof(UserEntry));
+		if (e) {
+			memset(e, 0, sizeof(UserEntry));
+			e->hash = hash;
+			e->alg = usr->hash_alg;
+			memcpy(e->x, x, len);
+			mbedtls_mpi_init(&e->N);
+			mbedtls_mpi_init(&e->g);
+			mbedtls_mpi_init(&e->kgx);
+			mbedtls_mpi_swap(&e->kgx, &kgx);
+			if (mbedtls_mpi_copy(&e->N, usr->ng->N) != 0 || mbedtls_mpi_copy(&e->g, usr->ng->g) != 0) {
+				user_entry_free(e);
+				e = NULL;
+			}
+		}
+		if (e) {
+			SHARD_LOCK(cache);
+			/* another thread may have got there first */
+			if (user_find(cache, hash, e->alg, &e->N, &e->g, x, len)) {
+				victim = e;
+			} else {
+				user_push(cache, e);
+				if (cache->count > cache->capacity) {
+					cache->evictions++;
+					victim = cache->tail;
+					user_unlink(cache, victim);
+				}
+			}
+			SHARD_UNLOCK(cache);
+			if (victim) user_entry_free(victim);
+		}
+	}
+	mbedtls_mpi_free(&kgx);
+	memset(x, 0, sizeof(x));
+}
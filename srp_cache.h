@@ -0,0 +1,120 @@
+#ifndef SRP_CACHE_H
+#define SRP_CACHE_H
+
+/*
+ * Secure Remote Password 6a implementation based on mbedtls.
+ *
+ * Copyright (c) 2019 Stoian Ivanov
+ * https://github.com/sdrsdr/mbedtls-csrp
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+
+/*
+ * Decoded verifier cache for accounts that log in often. An entry keeps v
+ * decoded and k*v mod N, so a handshake skips parsing v and computing kv.
+ * Entries hit often enough also get a fixed base table for v, which takes
+ * the squarings out of v^u: S is then computed as (A * v^u)^b.
+ *
+ * The cache is split into shards, each with its own lock and LRU list, so
+ * threads working on different users rarely meet. Entries are keyed by
+ * username and checked against the v passed in, so a changed verifier is
+ * simply a miss. Needs srp_cache.c.
+ */
+
+#include "srp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef SRP_CACHE_HOT_HITS
+#define SRP_CACHE_HOT_HITS  16
+#endif
+
+typedef struct SRPVerifierCache SRPVerifierCache;
+
+typedef struct SRPVerifierCacheStats {
+    unsigned long long  hits;
+    unsigned long long  misses;     /* also counts a v that changed */
+    unsigned long long  evictions;
+    int                 entries;
+    int                 tables;     /* entries with a table for v */
+} SRPVerifierCacheStats;
+
+/*
+ * Holds up to capacity verifiers for session. Up to max_tables of them get a
+ * table for v once they are hit SRP_CACHE_HOT_HITS times; a table takes
+ * 4 * hash bits * size of N bytes, e.g. 256KB for 2048 bit N and SHA256.
+ * max_tables=0 disables the tables. session must outlive the cache.
+ */
+SRPVerifierCache * srp_verifier_cache_new( SRPSession * session, int capacity, int max_tables );
+void               srp_verifier_cache_delete( SRPVerifierCache * cache );
+
+void               srp_verifier_cache_stats( SRPVerifierCache * cache, SRPVerifierCacheStats * stats );
+
+/* Like srp_verifier_init() on the cache's session */
+int                srp_verifier_init_cached( SRPVerifierCache * cache, SRPVerifier * ver,
+                                             const char * username,
+                                             const unsigned char * bytes_s, int len_s,
+                                             const unsigned char * bytes_v, int len_v,
+                                             const unsigned char * bytes_A, int len_A,
+                                             unsigned char * bytes_B, int * len_B,
+                                             SRPKeyPair * keys );
+
+/* Like srp_verifier_new1() on the cache's session */
+SRPVerifier *      srp_verifier_new_cached( SRPVerifierCache * cache,
+                                            const char * username, int copy_username,
+                                            const unsigned char * bytes_s, int len_s,
+                                            const unsigned char * bytes_v, int len_v,
+                                            const unsigned char * bytes_A, int len_A,
+                                            const unsigned char ** bytes_B, int * len_B,
+                                            SRPKeyPair * keys );
+
+/*
+ * Client side: a gateway that logs in to many backends with the same
+ * credentials computes k*g^x mod N once per (username, password, salt,
+ * group, hash) instead of once per login. Entries are keyed by x, which
+ * binds username, password and salt, so a changed password or salt is a
+ * miss, never a stale hit. Up to capacity entries, least recently used go
+ * first; one lock, so it suits tens of backends rather than millions.
+ */
+typedef struct SRPUserCache SRPUserCache;
+
+SRPUserCache *     srp_user_cache_new( int capacity );
+void               srp_user_cache_delete( SRPUserCache * cache );
+
+/* hits, misses, evictions and entries; tables stays 0 */
+void               srp_user_cache_stats( SRPUserCache * cache, SRPVerifierCacheStats * stats );
+
+/* Like srp_user_process_challenge() */
+void               srp_user_process_challenge_cached( SRPUserCache * cache, SRPUser * usr,
+                                                      const unsigned char * bytes_s, int len_s,
+                                                      const unsigned char * bytes_B, int len_B,
+                                                      const unsigned char ** bytes_M, int * len_M );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
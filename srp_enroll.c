@@ -0,0 +1,217 @@
+/*
+ * Secure Remote Password 6a implementation based on mbedtls.
+ *
+ * Copyright (c) 2019 Stoian Ivanov
+ * https://github.com/sdrsdr/mbedtls-csrp
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+
+/*
+ * Bulk enrollment, see srp_enroll.h. Records are read a chunk at a time,
+ * username and password copied into one text buffer, and the chunk goes to
+ * srp_create_salted_verification_key_batch(). Reading and writing happen on
+ * the calling thread between chunks; a chunk holds ENROLL_CHUNK records per
+ * thread, so that cost is small next to the exponentiations.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "srp.h"
+#include "srp_internal.h"
+#include "srp_enroll.h"
+
+#define ENROLL_CHUNK        64
+#define ENROLL_SALT_BYTES   32
+
+typedef struct EnrollText {
+	char    *buf;
+	size_t  len;
+	size_t  size;
+} EnrollText;
+
+/* appends len bytes and a NUL, returns their offset or (size_t)-1 */
+static size_t text_add( EnrollText *t, const void *p, size_t len )
+{
+	size_t off = t->len;
+
+	if (t->len + len + 1 > t->size) {
+		size_t size = t->size ? t->size : 4096;
+		char *buf;
+
+		while (size < t->len + len + 1) size *= 2;
+		buf = (char *) srp_malloc(size);
+		if (!buf) return (size_t) -1;
+		if (t->len) memcpy(buf, t->buf, t->len);
+		/* the old buffer holds passwords too */
+		if (t->buf) memset(t->buf, 0, t->size);
+		srp_free(t->buf);
+		t->buf = buf;
+		t->size = size;
+	}
+	memcpy(t->buf + off, p, len);
+	t->buf[off + len] = 0;
+	t->len += len + 1;
+	return off;
+}
+
+static double enroll_now( void )
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int srp_enroll( SRPSession *session, SRPWorkerPool *pool, int len_s,
+	SRPEnrollRead read, void *read_ctx, SRPEnrollWrite write, void *write_ctx,
+	SRPEnrollProgress progress, void *progress_ctx, SRPEnrollStats *stats )
+{
+	SRPEnrollStats st;
+	SRPEnrollItem *items = NULL;
+	SRPFixedBase *gtab = NULL;
+	EnrollText text;
+	size_t *offs = NULL;
+	unsigned char *salts = NULL, *vs = NULL;
+	int chunk, len_v, n, i, r = 1, rc = -1;
+	double start = enroll_now();
+
+	memset(&st, 0, sizeof(st));
+	memset(&text, 0, sizeof(text));
+	if (!session || !read || !write) goto cleanup;
+	if (len_s<=0) len_s = ENROLL_SALT_BYTES;
+
+	/* one table for g serves every thread; a loaded or tuned one is kept */
+	gtab = srp_ng_gtab_once(session->ng);
+	if (!gtab) goto cleanup;
+
+	chunk = ENROLL_CHUNK * srp_worker_pool_size(pool);
+	len_v = srp_ng_size(session->ng);
+	items = (SRPEnrollItem *) srp_malloc(chunk * sizeof(SRPEnrollItem));
+	offs = (size_t *) srp_malloc(chunk * 2 * sizeof(size_t));
+	salts = (unsigned char *) srp_malloc((size_t) chunk * len_s);
+	vs = (unsigned char *) srp_malloc((size_t) chunk * len_v);
+	if (!items || !offs || !salts || !vs) goto cleanup;
+
+	while (r==1) {
+		const char *username;
+		const unsigned char *password;
+		int len_password;
+
+		text.len = 0;
+		for (n=0; n<chunk && (r = read(read_ctx, &username, &password, &len_password))==1; n++) {
+			if (!username || (!password && len_password>0) || len_password<0) {
+				r = -1;
+				break;
+			}
+			/* the buffer may move while the chunk fills, so keep offsets until it is full */
+			offs[2*n] = text_add(&text, username, strlen(username));
+			offs[2*n+1] = text_add(&text, password, len_password);
+			if (offs[2*n]==(size_t) -1 || offs[2*n+1]==(size_t) -1) {
+				r = -1;
+				break;
+			}
+			items[n].len_password = len_password;
+		}
+		if (r<0) goto cleanup;
+
+		for (i=0; i<n; i++) {
+			items[i].username = text.buf + offs[2*i];
+			items[i].password = (const unsigned char *) text.buf + offs[2*i+1];
+			items[i].bytes_s = salts + (size_t) i * len_s;
+			items[i].len_s = len_s;
+			items[i].bytes_v = vs + (size_t) i * len_v;
+			items[i].len_v = len_v;
+			items[i].status = -1;
+		}
+		if (n>0 && srp_create_salted_verification_key_batch(session, pool, items, n)<0) goto cleanup;
+
+		for (i=0; i<n; i++) {
+			if (items[i].status!=0) {
+				st.failed++;
+				continue;
+			}
+			if (write(write_ctx, items[i].username, items[i].bytes_s, items[i].len_s,
+					items[i].bytes_v, items[i].len_v)!=0) goto cleanup;
+			st.enrolled++;
+		}
+		st.seconds = enroll_now() - start;
+		if (progress && n>0) progress(progress_ctx, &st);
+	}
+	rc = 0;
+
+cleanup:
+	st.seconds = enroll_now() - start;
+	if (stats) *stats = st;
+	/* the text holds passwords */
+	if (text.buf) memset(text.buf, 0, text.size);
+	srp_free(text.buf);
+	srp_free(items);
+	srp_free(offs);
+	srp_free(salts);
+	srp_free(vs);
+	if (gtab) srp_ng_table_release(gtab);
+	return rc;
+}
+
+void srp_enroll_lines_init( SRPEnrollLines *lines, FILE *in )
+{
+	memset(lines, 0, sizeof(SRPEnrollLines));
+	lines->in = in;
+}
+
+int srp_enroll_read_line( void *ctx, const char **username, const unsigned char **password, int *len_password )
+{
+	SRPEnrollLines *lines = (SRPEnrollLines *) ctx;
+	char *sep;
+	size_t len;
+
+	while (fgets(lines->buf, sizeof(lines->buf), lines->in)) {
+		lines->line++;
+		len = strlen(lines->buf);
+		if (len==sizeof(lines->buf)-1 && lines->buf[len-1]!='\n' && !feof(lines->in)) {
+			/* too long: drop the rest of it */
+			int c;
+			while ((c = fgetc(lines->in))!=EOF && c!='\n') ;
+			lines->skipped++;
+			continue;
+		}
+		while (len>0 && (lines->buf[len-1]=='\n' || lines->buf[len-1]=='\r')) lines->buf[--len] = 0;
+		if (len==0 || lines->buf[0]=='#') continue;
+
+		sep = strchr(lines->buf, ',');
+		if (!sep || sep==lines->buf) {
+			lines->skipped++;
+			continue;
+		}
+		*sep = 0;
+		*username = lines->buf;
+		*password = (const unsigned char *) sep + 1;
+		*len_password = (int) (lines->buf + len - (sep + 1));
+		return 1;
+	}
+	return ferror(lines->in) ? -1 : 0;
+}
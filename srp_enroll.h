@@ -0,0 +1,101 @@
+#ifndef SRP_ENROLL_H
+#define SRP_ENROLL_H
+
+/*
+ * Secure Remote Password 6a implementation based on mbedtls.
+ *
+ * Copyright (c) 2019 Stoian Ivanov
+ * https://github.com/sdrsdr/mbedtls-csrp
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/*
+ * Bulk enrollment: streams (username, password) records through
+ * srp_create_salted_verification_key_batch() a chunk at a time and hands the
+ * salts and verifiers back in input order. All threads share the group's
+ * table for g, which is built only if the group has none yet. Needs srp_enroll.c, srp_pool.c and
+ * -DSRP_PTHREAD; enroll_srp.c is a command line front-end.
+ */
+
+#include <stdio.h>
+
+#include "srp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Next record: 1 and the fields set, 0 at the end, -1 on error. The pointers need only stay valid until the next call */
+typedef int  (*SRPEnrollRead)( void * ctx, const char ** username,
+                               const unsigned char ** password, int * len_password );
+
+/* One result, on the thread that called srp_enroll(). Nonzero stops the run */
+typedef int  (*SRPEnrollWrite)( void * ctx, const char * username,
+                                const unsigned char * bytes_s, int len_s,
+                                const unsigned char * bytes_v, int len_v );
+
+typedef struct SRPEnrollStats {
+    unsigned long long  enrolled;
+    unsigned long long  failed;     /* records whose key could not be made */
+    double              seconds;    /* since srp_enroll() started */
+} SRPEnrollStats;
+
+/* Called after every chunk, on the thread that called srp_enroll() */
+typedef void (*SRPEnrollProgress)( void * ctx, const SRPEnrollStats * stats );
+
+/*
+ * Enrolls every record read returns, on pool (NULL: the calling thread).
+ * len_s<=0 picks 32 byte salts. progress may be NULL, stats too.
+ * Returns 0 once read reports the end, -1 on a read or write error or bad
+ * arguments.
+ */
+int  srp_enroll( SRPSession * session, SRPWorkerPool * pool, int len_s,
+                 SRPEnrollRead read, void * read_ctx,
+                 SRPEnrollWrite write, void * write_ctx,
+                 SRPEnrollProgress progress, void * progress_ctx,
+                 SRPEnrollStats * stats );
+
+/*
+ * An SRPEnrollRead for text lines "username,password". The password is the
+ * rest of the line and may contain commas. Empty lines and lines starting
+ * with '#' are ignored; lines without a comma, with an empty username or
+ * longer than the buffer are counted in skipped.
+ */
+#define SRP_ENROLL_MAX_LINE 1024
+
+typedef struct SRPEnrollLines {
+    FILE                * in;
+    unsigned long long    line;       /* number of the last line read */
+    unsigned long long    skipped;
+    char                  buf[SRP_ENROLL_MAX_LINE];
+} SRPEnrollLines;
+
+void srp_enroll_lines_init( SRPEnrollLines * lines, FILE * in );
+int  srp_enroll_read_line( void * lines, const char ** username,
+                           const unsigned char ** password, int * len_password );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
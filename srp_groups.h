@@ -0,0 +1,403 @@
+/* Generated by gen_groups.c, do not edit. */
+
+#ifndef SRP_GROUPS_H
+#define SRP_GROUPS_H
+
+#if defined(MBEDTLS_HAVE_INT64)
+#define SRP_LIMB(hi, lo)  (((mbedtls_mpi_uint)(hi) << 32) | (lo))
+#define SRP_MM(hi, lo)    SRP_LIMB(hi, lo)
+#else
+#define SRP_LIMB(hi, lo)  (lo), (hi)
+/* -N^-1 mod 2^32 is the low half of -N^-1 mod 2^64 */
+#define SRP_MM(hi, lo)    ((mbedtls_mpi_uint)(lo))
+#endif
+
+/* 512 bits */
+static const mbedtls_mpi_uint srp_group_512_N[] = {
+    SRP_LIMB(0xA62D1748, 0xE4249DF3), SRP_LIMB(0x6B0AA59C, 0x14E79D4A), SRP_LIMB(0x102559CE, 0x63D8B6E8),
+    SRP_LIMB(0x2A34AFBD, 0xB3B1B5D0), SRP_LIMB(0xADFD0B9D, 0xA163B29F), SRP_LIMB(0x8FA90A4D, 0x80C71CD2),
+    SRP_LIMB(0x245A199F, 0x62CE61AB), SRP_LIMB(0xD66AAFE8, 0xE245F9AC)
+};
+static const mbedtls_mpi_uint srp_group_512_one[] = {
+    SRP_LIMB(0x59D2E8B7, 0x1BDB620D), SRP_LIMB(0x94F55A63, 0xEB1862B5), SRP_LIMB(0xEFDAA631, 0x9C274917),
+    SRP_LIMB(0xD5CB5042, 0x4C4E4A2F), SRP_LIMB(0x5202F462, 0x5E9C4D60), SRP_LIMB(0x7056F5B2, 0x7F38E32D),
+    SRP_LIMB(0xDBA5E660, 0x9D319E54), SRP_LIMB(0x29955017, 0x1DBA0653)
+};
+static const mbedtls_mpi_uint srp_group_512_RR[] = {
+    SRP_LIMB(0x09EEDD15, 0x4D08D70E), SRP_LIMB(0xA3F23D7E, 0x2729C448), SRP_LIMB(0xEF007C36, 0x0E42E9D7),
+    SRP_LIMB(0x3CD68329, 0xE99C6106), SRP_LIMB(0x927C019F, 0x25B2BF55), SRP_LIMB(0x5C2A49B2, 0x1A311473),
+    SRP_LIMB(0x4759AB83, 0xEF848566), SRP_LIMB(0xAB36AFD6, 0xADAE8D8B)
+};
+
+/* 768 bits */
+static const mbedtls_mpi_uint srp_group_768_N[] = {
+    SRP_LIMB(0x33E0867C, 0x60C3262B), SRP_LIMB(0x94B6A529, 0xA8C6C2BE), SRP_LIMB(0x837ADA63, 0x80B1093E),
+    SRP_LIMB(0x737D9BE9, 0x713CEF8D), SRP_LIMB(0x9575F3D0, 0xDE694AFF), SRP_LIMB(0x36F2099E, 0x6FFF90E7),
+    SRP_LIMB(0x6B93754B, 0xCDDF71B6), SRP_LIMB(0x2653BE71, 0x47F00F57), SRP_LIMB(0x76744D91, 0xF7CC9F40),
+    SRP_LIMB(0x50081639, 0x40B95582), SRP_LIMB(0x1BB4E04F, 0xF8F84EE9), SRP_LIMB(0xB344C7C4, 0xF8C49503)
+};
+static const mbedtls_mpi_uint srp_group_768_one[] = {
+    SRP_LIMB(0xCC1F7983, 0x9F3CD9D5), SRP_LIMB(0x6B495AD6, 0x57393D41), SRP_LIMB(0x7C85259C, 0x7F4EF6C1),
+    SRP_LIMB(0x8C826416, 0x8EC31072), SRP_LIMB(0x6A8A0C2F, 0x2196B500), SRP_LIMB(0xC90DF661, 0x90006F18),
+    SRP_LIMB(0x946C8AB4, 0x32208E49), SRP_LIMB(0xD9AC418E, 0xB80FF0A8), SRP_LIMB(0x898BB26E, 0x083360BF),
+    SRP_LIMB(0xAFF7E9C6, 0xBF46AA7D), SRP_LIMB(0xE44B1FB0, 0x0707B116), SRP_LIMB(0x4CBB383B, 0x073B6AFC)
+};
+static const mbedtls_mpi_uint srp_group_768_RR[] = {
+    SRP_LIMB(0x22A4F9A9, 0x793BB510), SRP_LIMB(0xE21BAAA5, 0xEB347D7E), SRP_LIMB(0x400CDE8F, 0xB559F96E),
+    SRP_LIMB(0xD6B2D83D, 0xE350DA5F), SRP_LIMB(0x151A4B05, 0xA66A2585), SRP_LIMB(0xAACE9082, 0xF131C8AE),
+    SRP_LIMB(0x5198A674, 0x3578799E), SRP_LIMB(0x7DA7F052, 0xC009013C), SRP_LIMB(0x2457EC20, 0x8D03C665),
+    SRP_LIMB(0x0EE9311C, 0xB6A08445), SRP_LIMB(0xC1FA1446, 0xC4A703FB), SRP_LIMB(0x59773497, 0x22DDF893)
+};
+
+/* 1024 bits */
+static const mbedtls_mpi_uint srp_group_1024_N[] = {
+    SRP_LIMB(0x9FC61D2F, 0xC0EB06E3), SRP_LIMB(0xFD5138FE, 0x8376435B), SRP_LIMB(0x2FD4CBF4, 0x976EAA9A),
+    SRP_LIMB(0x68EDBC3C, 0x05726CC0), SRP_LIMB(0xC529F566, 0x660E57EC), SRP_LIMB(0x82559B29, 0x7BCF1885),
+    SRP_LIMB(0xCE8EF4AD, 0x69B15D49), SRP_LIMB(0x5DC7D7B4, 0x6154D6B6), SRP_LIMB(0x8E495C1D, 0x6089DAD1),
+    SRP_LIMB(0xE0D5D8E2, 0x50B98BE4), SRP_LIMB(0x383B4813, 0xD692C6E0), SRP_LIMB(0xD674DF74, 0x96EA81D3),
+    SRP_LIMB(0x9EA2314C, 0x9C256576), SRP_LIMB(0x60726187, 0x75FF3C0B), SRP_LIMB(0x9C33F80A, 0xFA8FC5E8),
+    SRP_LIMB(0xEEAF0AB9, 0xADB38DD6)
+};
+static const mbedtls_mpi_uint srp_group_1024_one[] = {
+    SRP_LIMB(0x6039E2D0, 0x3F14F91D), SRP_LIMB(0x02AEC701, 0x7C89BCA4), SRP_LIMB(0xD02B340B, 0x68915565),
+    SRP_LIMB(0x971243C3, 0xFA8D933F), SRP_LIMB(0x3AD60A99, 0x99F1A813), SRP_LIMB(0x7DAA64D6, 0x8430E77A),
+    SRP_LIMB(0x31710B52, 0x964EA2B6), SRP_LIMB(0xA238284B, 0x9EAB2949), SRP_LIMB(0x71B6A3E2, 0x9F76252E),
+    SRP_LIMB(0x1F2A271D, 0xAF46741B), SRP_LIMB(0xC7C4B7EC, 0x296D391F), SRP_LIMB(0x298B208B, 0x69157E2C),
+    SRP_LIMB(0x615DCEB3, 0x63DA9A89), SRP_LIMB(0x9F8D9E78, 0x8A00C3F4), SRP_LIMB(0x63CC07F5, 0x05703A17),
+    SRP_LIMB(0x1150F546, 0x524C7229)
+};
+static const mbedtls_mpi_uint srp_group_1024_RR[] = {
+    SRP_LIMB(0xBB00BAC6, 0xBC12702A), SRP_LIMB(0xAC1491E7, 0x33D4C1FE), SRP_LIMB(0xDF7A9A09, 0x00BA95BF),
+    SRP_LIMB(0x01F6E750, 0xEB9A4EA3), SRP_LIMB(0x0F53F0F7, 0xCD0388BF), SRP_LIMB(0x4AA79331, 0x9A3092A1),
+    SRP_LIMB(0x016A34E5, 0x856F7FC4), SRP_LIMB(0xF80A26F3, 0xAAEAD635), SRP_LIMB(0x5065C3BA, 0x8F669234),
+    SRP_LIMB(0xB333071C, 0x6F37205F), SRP_LIMB(0x2A07A522, 0x00E6930D), SRP_LIMB(0x321270B0, 0xE65421F7),
+    SRP_LIMB(0xC83139A2, 0x9E4616EA), SRP_LIMB(0xF805807D, 0x1738D913), SRP_LIMB(0x5560067A, 0x97C790A3),
+    SRP_LIMB(0x1BE3B675, 0x66E04DF8)
+};
+
+/* 2048 bits */
+static const mbedtls_mpi_uint srp_group_2048_N[] = {
+    SRP_LIMB(0x0FA7111F, 0x9E4AFF73), SRP_LIMB(0x9B65E372, 0xFCD68EF2), SRP_LIMB(0x35DE236D, 0x525F5475),
+    SRP_LIMB(0x94B5C803, 0xD89F7AE4), SRP_LIMB(0x71AE35F8, 0xE9DBFBB6), SRP_LIMB(0x2A5698F3, 0xA8D0C382),
+    SRP_LIMB(0x9CCC041C, 0x7BC308D8), SRP_LIMB(0xAF874E73, 0x03CE5329), SRP_LIMB(0x61602790, 0x04E57AE6),
+    SRP_LIMB(0x032CFBDB, 0xF52FB378), SRP_LIMB(0x5EA77A27, 0x75D2ECFA), SRP_LIMB(0x544523B5, 0x24B0D57D),
+    SRP_LIMB(0x5B9D32E6, 0x88F87748), SRP_LIMB(0xF1D2B907, 0x8717461A), SRP_LIMB(0x76BD207A, 0x436C6481),
+    SRP_LIMB(0xCA97B43A, 0x23FB8016), SRP_LIMB(0x1D281E44, 0x6B14773B), SRP_LIMB(0x7359D041, 0xD5C33EA7),
+    SRP_LIMB(0xA80D740A, 0xDBF4FF74), SRP_LIMB(0x55F97993, 0xEC975EEA), SRP_LIMB(0x2918A996, 0x2F0B93B8),
+    SRP_LIMB(0x661A05FB, 0xD5FAAAE8), SRP_LIMB(0xCF609517, 0x9A163AB3), SRP_LIMB(0xE8083969, 0xEDB767B0),
+    SRP_LIMB(0xCD7F48A9, 0xDA04FD50), SRP_LIMB(0xD52312AB, 0x4B03310D), SRP_LIMB(0x8193E075, 0x7767A13D),
+    SRP_LIMB(0xA37329CB, 0xB4A099ED), SRP_LIMB(0xFC319294, 0x3DB56050), SRP_LIMB(0xAF72B665, 0x1987EE07),
+    SRP_LIMB(0xF166DE5E, 0x1389582F), SRP_LIMB(0xAC6BDB41, 0x324A9A9B)
+};
+static const mbedtls_mpi_uint srp_group_2048_one[] = {
+    SRP_LIMB(0xF058EEE0, 0x61B5008D), SRP_LIMB(0x649A1C8D, 0x0329710D), SRP_LIMB(0xCA21DC92, 0xADA0AB8A),
+    SRP_LIMB(0x6B4A37FC, 0x2760851B), SRP_LIMB(0x8E51CA07, 0x16240449), SRP_LIMB(0xD5A9670C, 0x572F3C7D),
+    SRP_LIMB(0x6333FBE3, 0x843CF727), SRP_LIMB(0x5078B18C, 0xFC31ACD6), SRP_LIMB(0x9E9FD86F, 0xFB1A8519),
+    SRP_LIMB(0xFCD30424, 0x0AD04C87), SRP_LIMB(0xA15885D8, 0x8A2D1305), SRP_LIMB(0xABBADC4A, 0xDB4F2A82),
+    SRP_LIMB(0xA462CD19, 0x770788B7), SRP_LIMB(0x0E2D46F8, 0x78E8B9E5), SRP_LIMB(0x8942DF85, 0xBC939B7E),
+    SRP_LIMB(0x35684BC5, 0xDC047FE9), SRP_LIMB(0xE2D7E1BB, 0x94EB88C4), SRP_LIMB(0x8CA62FBE, 0x2A3CC158),
+    SRP_LIMB(0x57F28BF5, 0x240B008B), SRP_LIMB(0xAA06866C, 0x1368A115), SRP_LIMB(0xD6E75669, 0xD0F46C47),
+    SRP_LIMB(0x99E5FA04, 0x2A055517), SRP_LIMB(0x309F6AE8, 0x65E9C54C), SRP_LIMB(0x17F7C696, 0x1248984F),
+    SRP_LIMB(0x3280B756, 0x25FB02AF), SRP_LIMB(0x2ADCED54, 0xB4FCCEF2), SRP_LIMB(0x7E6C1F8A, 0x88985EC2),
+    SRP_LIMB(0x5C8CD634, 0x4B5F6612), SRP_LIMB(0x03CE6D6B, 0xC24A9FAF), SRP_LIMB(0x508D499A, 0xE67811F8),
+    SRP_LIMB(0x0E9921A1, 0xEC76A7D0), SRP_LIMB(0x539424BE, 0xCDB56564)
+};
+static const mbedtls_mpi_uint srp_group_2048_RR[] = {
+    SRP_LIMB(0xC1646264, 0x0901DACC), SRP_LIMB(0x135B6EC8, 0xDA577926), SRP_LIMB(0xDAFDA0A8, 0xDD388CE4),
+    SRP_LIMB(0x266CA5E5, 0xA2ED94B6), SRP_LIMB(0x411D08A9, 0x8F8F6366), SRP_LIMB(0xD5E9435E, 0xE9D8A0E6),
+    SRP_LIMB(0xCD0A37F3, 0xB155D1A9), SRP_LIMB(0x0A09599A, 0x6DEA0B27), SRP_LIMB(0x820C9596, 0x548EA6C2),
+    SRP_LIMB(0x65A938E0, 0xB8B06AA4), SRP_LIMB(0x5549E080, 0xABA4BA1A), SRP_LIMB(0x1AFC70D2, 0xF498240E),
+    SRP_LIMB(0x54E53E69, 0x3A1BC842), SRP_LIMB(0x98017945, 0x4EB04B8D), SRP_LIMB(0x5C4D14B0, 0xE00B59EF),
+    SRP_LIMB(0x8B5A988C, 0xFB516308), SRP_LIMB(0xC6D66F1C, 0x08B73589), SRP_LIMB(0x26C398A8, 0x4ACA56EB),
+    SRP_LIMB(0x012CC370, 0x2F6642D2), SRP_LIMB(0x4B530DED, 0x2375F496), SRP_LIMB(0xE2D9B5A7, 0xBB24044A),
+    SRP_LIMB(0xD0C0183E, 0x107AA74F), SRP_LIMB(0x7B1C1C9B, 0x7272DA4C), SRP_LIMB(0x3C206B89, 0x30C8D708),
+    SRP_LIMB(0xAE42853C, 0x8DF13B4A), SRP_LIMB(0xE1E2B5ED, 0x0AE87E15), SRP_LIMB(0x54EC734B, 0xC7DF3336),
+    SRP_LIMB(0x66094E87, 0x7B6A9BF9), SRP_LIMB(0x2584D988, 0x45D6EEFD), SRP_LIMB(0x0A0C1F1E, 0xD637893D),
+    SRP_LIMB(0x1CB08F2D, 0xD93BBE46), SRP_LIMB(0x2A59F79B, 0x0EB83CA8)
+};
+
+/* 3072 bits */
+static const mbedtls_mpi_uint srp_group_3072_N[] = {
+    SRP_LIMB(0xFFFFFFFF, 0xFFFFFFFF), SRP_LIMB(0x4B82D120, 0xA93AD2CA), SRP_LIMB(0x43DB5BFC, 0xE0FD108E),
+    SRP_LIMB(0x08E24FA0, 0x74E5AB31), SRP_LIMB(0x770988C0, 0xBAD946E2), SRP_LIMB(0xBBE11757, 0x7A615D6C),
+    SRP_LIMB(0x521F2B18, 0x177B200C), SRP_LIMB(0xD8760273, 0x3EC86A64), SRP_LIMB(0xF12FFA06, 0xD98A0864),
+    SRP_LIMB(0xCEE3D226, 0x1AD2EE6B), SRP_LIMB(0x1E8C94E0, 0x4A25619D), SRP_LIMB(0xABF5AE8C, 0xDB0933D7),
+    SRP_LIMB(0xB3970F85, 0xA6E1E4C7), SRP_LIMB(0x8AEA7157, 0x5D060C7D), SRP_LIMB(0xECFB8504, 0x58DBEF0A),
+    SRP_LIMB(0xA85521AB, 0xDF1CBA64), SRP_LIMB(0xAD33170D, 0x04507A33), SRP_LIMB(0x15728E5A, 0x8AAAC42D),
+    SRP_LIMB(0x15D22618, 0x98FA0510), SRP_LIMB(0x3995497C, 0xEA956AE5), SRP_LIMB(0xDE2BCBF6, 0x95581718),
+    SRP_LIMB(0xB5C55DF0, 0x6F4C52C9), SRP_LIMB(0x9B2783A2, 0xEC07A28F), SRP_LIMB(0xE39E772C, 0x180E8603),
+    SRP_LIMB(0x32905E46, 0x2E36CE3B), SRP_LIMB(0xF1746C08, 0xCA18217C), SRP_LIMB(0x670C354E, 0x4ABC9804),
+    SRP_LIMB(0x9ED52907, 0x7096966D), SRP_LIMB(0x1C62F356, 0x208552BB), SRP_LIMB(0x83655D23, 0xDCA3AD96),
+    SRP_LIMB(0x69163FA8, 0xFD24CF5F), SRP_LIMB(0x98DA4836, 0x1C55D39A), SRP_LIMB(0xC2007CB8, 0xA163BF05),
+    SRP_LIMB(0x49286651, 0xECE45B3D), SRP_LIMB(0xAE9F2411, 0x7C4B1FE6), SRP_LIMB(0xEE386BFB, 0x5A899FA5),
+    SRP_LIMB(0x0BFF5CB6, 0xF406B7ED), SRP_LIMB(0xF44C42E9, 0xA637ED6B), SRP_LIMB(0xE485B576, 0x625E7EC6),
+    SRP_LIMB(0x4FE1356D, 0x6D51C245), SRP_LIMB(0x302B0A6D, 0xF25F1437), SRP_LIMB(0xEF9519B3, 0xCD3A431B),
+    SRP_LIMB(0x514A0879, 0x8E3404DD), SRP_LIMB(0x020BBEA6, 0x3B139B22), SRP_LIMB(0x29024E08, 0x8A67CC74),
+    SRP_LIMB(0xC4C6628B, 0x80DC1CD1), SRP_LIMB(0xC90FDAA2, 0x2168C234), SRP_LIMB(0xFFFFFFFF, 0xFFFFFFFF)
+};
+static const mbedtls_mpi_uint srp_group_3072_one[] = {
+    SRP_LIMB(0x00000000, 0x00000001), SRP_LIMB(0xB47D2EDF, 0x56C52D35), SRP_LIMB(0xBC24A403, 0x1F02EF71),
+    SRP_LIMB(0xF71DB05F, 0x8B1A54CE), SRP_LIMB(0x88F6773F, 0x4526B91D), SRP_LIMB(0x441EE8A8, 0x859EA293),
+    SRP_LIMB(0xADE0D4E7, 0xE884DFF3), SRP_LIMB(0x2789FD8C, 0xC137959B), SRP_LIMB(0x0ED005F9, 0x2675F79B),
+    SRP_LIMB(0x311C2DD9, 0xE52D1194), SRP_LIMB(0xE1736B1F, 0xB5DA9E62), SRP_LIMB(0x540A5173, 0x24F6CC28),
+    SRP_LIMB(0x4C68F07A, 0x591E1B38), SRP_LIMB(0x75158EA8, 0xA2F9F382), SRP_LIMB(0x13047AFB, 0xA72410F5),
+    SRP_LIMB(0x57AADE54, 0x20E3459B), SRP_LIMB(0x52CCE8F2, 0xFBAF85CC), SRP_LIMB(0xEA8D71A5, 0x75553BD2),
+    SRP_LIMB(0xEA2DD9E7, 0x6705FAEF), SRP_LIMB(0xC66AB683, 0x156A951A), SRP_LIMB(0x21D43409, 0x6AA7E8E7),
+    SRP_LIMB(0x4A3AA20F, 0x90B3AD36), SRP_LIMB(0x64D87C5D, 0x13F85D70), SRP_LIMB(0x1C6188D3, 0xE7F179FC),
+    SRP_LIMB(0xCD6FA1B9, 0xD1C931C4), SRP_LIMB(0x0E8B93F7, 0x35E7DE83), SRP_LIMB(0x98F3CAB1, 0xB54367FB),
+    SRP_LIMB(0x612AD6F8, 0x8F696992), SRP_LIMB(0xE39D0CA9, 0xDF7AAD44), SRP_LIMB(0x7C9AA2DC, 0x235C5269),
+    SRP_LIMB(0x96E9C057, 0x02DB30A0), SRP_LIMB(0x6725B7C9, 0xE3AA2C65), SRP_LIMB(0x3DFF8347, 0x5E9C40FA),
+    SRP_LIMB(0xB6D799AE, 0x131BA4C2), SRP_LIMB(0x5160DBEE, 0x83B4E019), SRP_LIMB(0x11C79404, 0xA576605A),
+    SRP_LIMB(0xF400A349, 0x0BF94812), SRP_LIMB(0x0BB3BD16, 0x59C81294), SRP_LIMB(0x1B7A4A89, 0x9DA18139),
+    SRP_LIMB(0xB01ECA92, 0x92AE3DBA), SRP_LIMB(0xCFD4F592, 0x0DA0EBC8), SRP_LIMB(0x106AE64C, 0x32C5BCE4),
+    SRP_LIMB(0xAEB5F786, 0x71CBFB22), SRP_LIMB(0xFDF44159, 0xC4EC64DD), SRP_LIMB(0xD6FDB1F7, 0x7598338B),
+    SRP_LIMB(0x3B399D74, 0x7F23E32E), SRP_LIMB(0x36F0255D, 0xDE973DCB), SRP_LIMB(0x00000000, 0x00000000)
+};
+static const mbedtls_mpi_uint srp_group_3072_RR[] = {
+    SRP_LIMB(0x2697CA91, 0x38D241CD), SRP_LIMB(0x3587F069, 0x60E7F138), SRP_LIMB(0x4F30B920, 0xE5C1DB66),
+    SRP_LIMB(0x95823215, 0xB15BA577), SRP_LIMB(0x4335AACB, 0x64894D96), SRP_LIMB(0xAE128402, 0x3C6ED6A3),
+    SRP_LIMB(0xFC1187A5, 0xFA8406AB), SRP_LIMB(0x682AAB9A, 0x15B17FFA), SRP_LIMB(0xBC2B64CF, 0x26E335D7),
+    SRP_LIMB(0x8AA61391, 0xABB0B76A), SRP_LIMB(0x1EF22571, 0xE41A52B2), SRP_LIMB(0x1D93075A, 0xA993D147),
+    SRP_LIMB(0xFEA5187F, 0xA77DEDDA), SRP_LIMB(0xAF80D4B5, 0x443561C6), SRP_LIMB(0xB186424B, 0x83DF2859),
+    SRP_LIMB(0x1CAEFC18, 0x8A59BC7F), SRP_LIMB(0x1B9D0127, 0x1D18F0C8), SRP_LIMB(0x3EFEF29D, 0xC3C0B3F4),
+    SRP_LIMB(0x785483C6, 0x08108C0C), SRP_LIMB(0x4F127682, 0x56E88B53), SRP_LIMB(0xBFD961D5, 0x38D6FCDD),
+    SRP_LIMB(0xB41A05F0, 0x78024208), SRP_LIMB(0x19CC8D59, 0x563706FB), SRP_LIMB(0x5A7795D8, 0x6ECC4987),
+    SRP_LIMB(0x9A678BF4, 0x439F12EB), SRP_LIMB(0x7CDA502E, 0xC043F99C), SRP_LIMB(0x0672A33D, 0x61E37F74),
+    SRP_LIMB(0x19C2883E, 0xEFC802AF), SRP_LIMB(0x7DED489E, 0x670D9C6F), SRP_LIMB(0xA73D0103, 0x2C4B8E90),
+    SRP_LIMB(0x8C6CBD34, 0xD5965134), SRP_LIMB(0x77A5C747, 0xD85B0A83), SRP_LIMB(0x109D099E, 0x16FD7568),
+    SRP_LIMB(0xA5DAF736, 0xBC8D5E9E), SRP_LIMB(0x7139D0AB, 0x24B7E495), SRP_LIMB(0x49CD9D70, 0x5DA184D5),
+    SRP_LIMB(0x2276CB40, 0x571F2C1C), SRP_LIMB(0xAF0EC45C, 0xDC396086), SRP_LIMB(0xAA05DA05, 0xC27FDD33),
+    SRP_LIMB(0x9875D4C1, 0x67DB7EDC), SRP_LIMB(0x5CAA6900, 0x9FBF543F), SRP_LIMB(0xFA022336, 0xF28DE772),
+    SRP_LIMB(0xFAE1CD10, 0x648BEE54), SRP_LIMB(0x2AD479FE, 0x69695C75), SRP_LIMB(0x84895A7C, 0x5542F96C),
+    SRP_LIMB(0xA332E8E3, 0xE0669E0F), SRP_LIMB(0x44C4E4E4, 0x31AD0295), SRP_LIMB(0x5AC8B4FB, 0x51DF35DA)
+};
+
+/* 4096 bits */
+static const mbedtls_mpi_uint srp_group_4096_N[] = {
+    SRP_LIMB(0xFFFFFFFF, 0xFFFFFFFF), SRP_LIMB(0x4DF435C9, 0x34063199), SRP_LIMB(0x86FFB7DC, 0x90A6C08F),
+    SRP_LIMB(0x93B4EA98, 0x8D8FDDC1), SRP_LIMB(0xD0069127, 0xD5B05AA9), SRP_LIMB(0xB81BDD76, 0x2170481C),
+    SRP_LIMB(0x1F612970, 0xCEE2D7AF), SRP_LIMB(0x233BA186, 0x515BE7ED), SRP_LIMB(0x99B2964F, 0xA090C3A2),
+    SRP_LIMB(0x287C5947, 0x4E6BC05D), SRP_LIMB(0x2E8EFC14, 0x1FBECAA6), SRP_LIMB(0xDBBBC2DB, 0x04DE8EF9),
+    SRP_LIMB(0x2583E9CA, 0x2AD44CE8), SRP_LIMB(0x1A946834, 0xB6150BDA), SRP_LIMB(0x99C32718, 0x6AF4E23C),
+    SRP_LIMB(0x88719A10, 0xBDBA5B26), SRP_LIMB(0x1A723C12, 0xA787E6D7), SRP_LIMB(0x4B82D120, 0xA9210801),
+    SRP_LIMB(0x43DB5BFC, 0xE0FD108E), SRP_LIMB(0x08E24FA0, 0x74E5AB31), SRP_LIMB(0x770988C0, 0xBAD946E2),
+    SRP_LIMB(0xBBE11757, 0x7A615D6C), SRP_LIMB(0x521F2B18, 0x177B200C), SRP_LIMB(0xD8760273, 0x3EC86A64),
+    SRP_LIMB(0xF12FFA06, 0xD98A0864), SRP_LIMB(0xCEE3D226, 0x1AD2EE6B), SRP_LIMB(0x1E8C94E0, 0x4A25619D),
+    SRP_LIMB(0xABF5AE8C, 0xDB0933D7), SRP_LIMB(0xB3970F85, 0xA6E1E4C7), SRP_LIMB(0x8AEA7157, 0x5D060C7D),
+    SRP_LIMB(0xECFB8504, 0x58DBEF0A), SRP_LIMB(0xA85521AB, 0xDF1CBA64), SRP_LIMB(0xAD33170D, 0x04507A33),
+    SRP_LIMB(0x15728E5A, 0x8AAAC42D), SRP_LIMB(0x15D22618, 0x98FA0510), SRP_LIMB(0x3995497C, 0xEA956AE5),
+    SRP_LIMB(0xDE2BCBF6, 0x95581718), SRP_LIMB(0xB5C55DF0, 0x6F4C52C9), SRP_LIMB(0x9B2783A2, 0xEC07A28F),
+    SRP_LIMB(0xE39E772C, 0x180E8603), SRP_LIMB(0x32905E46, 0x2E36CE3B), SRP_LIMB(0xF1746C08, 0xCA18217C),
+    SRP_LIMB(0x670C354E, 0x4ABC9804), SRP_LIMB(0x9ED52907, 0x7096966D), SRP_LIMB(0x1C62F356, 0x208552BB),
+    SRP_LIMB(0x83655D23, 0xDCA3AD96), SRP_LIMB(0x69163FA8, 0xFD24CF5F), SRP_LIMB(0x98DA4836, 0x1C55D39A),
+    SRP_LIMB(0xC2007CB8, 0xA163BF05), SRP_LIMB(0x49286651, 0xECE45B3D), SRP_LIMB(0xAE9F2411, 0x7C4B1FE6),
+    SRP_LIMB(0xEE386BFB, 0x5A899FA5), SRP_LIMB(0x0BFF5CB6, 0xF406B7ED), SRP_LIMB(0xF44C42E9, 0xA637ED6B),
+    SRP_LIMB(0xE485B576, 0x625E7EC6), SRP_LIMB(0x4FE1356D, 0x6D51C245), SRP_LIMB(0x302B0A6D, 0xF25F1437),
+    SRP_LIMB(0xEF9519B3, 0xCD3A431B), SRP_LIMB(0x514A0879, 0x8E3404DD), SRP_LIMB(0x020BBEA6, 0x3B139B22),
+    SRP_LIMB(0x29024E08, 0x8A67CC74), SRP_LIMB(0xC4C6628B, 0x80DC1CD1), SRP_LIMB(0xC90FDAA2, 0x2168C234),
+    SRP_LIMB(0xFFFFFFFF, 0xFFFFFFFF)
+};
+static const mbedtls_mpi_uint srp_group_4096_one[] = {
+    SRP_LIMB(0x00000000, 0x00000001), SRP_LIMB(0xB20BCA36, 0xCBF9CE66), SRP_LIMB(0x79004823, 0x6F593F70),
+    SRP_LIMB(0x6C4B1567, 0x7270223E), SRP_LIMB(0x2FF96ED8, 0x2A4FA556), SRP_LIMB(0x47E42289, 0xDE8FB7E3),
+    SRP_LIMB(0xE09ED68F, 0x311D2850), SRP_LIMB(0xDCC45E79, 0xAEA41812), SRP_LIMB(0x664D69B0, 0x5F6F3C5D),
+    SRP_LIMB(0xD783A6B8, 0xB1943FA2), SRP_LIMB(0xD17103EB, 0xE0413559), SRP_LIMB(0x24443D24, 0xFB217106),
+    SRP_LIMB(0xDA7C1635, 0xD52BB317), SRP_LIMB(0xE56B97CB, 0x49EAF425), SRP_LIMB(0x663CD8E7, 0x950B1DC3),
+    SRP_LIMB(0x778E65EF, 0x4245A4D9), SRP_LIMB(0xE58DC3ED, 0x58781928), SRP_LIMB(0xB47D2EDF, 0x56DEF7FE),
+    SRP_LIMB(0xBC24A403, 0x1F02EF71), SRP_LIMB(0xF71DB05F, 0x8B1A54CE), SRP_LIMB(0x88F6773F, 0x4526B91D),
+    SRP_LIMB(0x441EE8A8, 0x859EA293), SRP_LIMB(0xADE0D4E7, 0xE884DFF3), SRP_LIMB(0x2789FD8C, 0xC137959B),
+    SRP_LIMB(0x0ED005F9, 0x2675F79B), SRP_LIMB(0x311C2DD9, 0xE52D1194), SRP_LIMB(0xE1736B1F, 0xB5DA9E62),
+    SRP_LIMB(0x540A5173, 0x24F6CC28), SRP_LIMB(0x4C68F07A, 0x591E1B38), SRP_LIMB(0x75158EA8, 0xA2F9F382),
+    SRP_LIMB(0x13047AFB, 0xA72410F5), SRP_LIMB(0x57AADE54, 0x20E3459B), SRP_LIMB(0x52CCE8F2, 0xFBAF85CC),
+    SRP_LIMB(0xEA8D71A5, 0x75553BD2), SRP_LIMB(0xEA2DD9E7, 0x6705FAEF), SRP_LIMB(0xC66AB683, 0x156A951A),
+    SRP_LIMB(0x21D43409, 0x6AA7E8E7), SRP_LIMB(0x4A3AA20F, 0x90B3AD36), SRP_LIMB(0x64D87C5D, 0x13F85D70),
+    SRP_LIMB(0x1C6188D3, 0xE7F179FC), SRP_LIMB(0xCD6FA1B9, 0xD1C931C4), SRP_LIMB(0x0E8B93F7, 0x35E7DE83),
+    SRP_LIMB(0x98F3CAB1, 0xB54367FB), SRP_LIMB(0x612AD6F8, 0x8F696992), SRP_LIMB(0xE39D0CA9, 0xDF7AAD44),
+    SRP_LIMB(0x7C9AA2DC, 0x235C5269), SRP_LIMB(0x96E9C057, 0x02DB30A0), SRP_LIMB(0x6725B7C9, 0xE3AA2C65),
+    SRP_LIMB(0x3DFF8347, 0x5E9C40FA), SRP_LIMB(0xB6D799AE, 0x131BA4C2), SRP_LIMB(0x5160DBEE, 0x83B4E019),
+    SRP_LIMB(0x11C79404, 0xA576605A), SRP_LIMB(0xF400A349, 0x0BF94812), SRP_LIMB(0x0BB3BD16, 0x59C81294),
+    SRP_LIMB(0x1B7A4A89, 0x9DA18139), SRP_LIMB(0xB01ECA92, 0x92AE3DBA), SRP_LIMB(0xCFD4F592, 0x0DA0EBC8),
+    SRP_LIMB(0x106AE64C, 0x32C5BCE4), SRP_LIMB(0xAEB5F786, 0x71CBFB22), SRP_LIMB(0xFDF44159, 0xC4EC64DD),
+    SRP_LIMB(0xD6FDB1F7, 0x7598338B), SRP_LIMB(0x3B399D74, 0x7F23E32E), SRP_LIMB(0x36F0255D, 0xDE973DCB),
+    SRP_LIMB(0x00000000, 0x00000000)
+};
+static const mbedtls_mpi_uint srp_group_4096_RR[] = {
+    SRP_LIMB(0xC14AB0DD, 0xCC03AA20), SRP_LIMB(0x8A1AC024, 0xB30E9B12), SRP_LIMB(0xFA8F75F0, 0x067E82B1),
+    SRP_LIMB(0x37BF90FE, 0x52074F19), SRP_LIMB(0x55EA6F75, 0x41C4F82B), SRP_LIMB(0xB850DE95, 0xD97AC40A),
+    SRP_LIMB(0x3549C577, 0x7A17FB04), SRP_LIMB(0x2A434CEB, 0x230B2DFE), SRP_LIMB(0x524E7C7A, 0x7ED36C41),
+    SRP_LIMB(0xE4404092, 0x1C1E467C), SRP_LIMB(0xA796D182, 0x04A636F7), SRP_LIMB(0xC9C77F0C, 0x352D408C),
+    SRP_LIMB(0x51E75D99, 0x98F001DB), SRP_LIMB(0x8267537D, 0x4A612A18), SRP_LIMB(0x912A0491, 0x3E9EBD87),
+    SRP_LIMB(0x2E52989E, 0xCCF85F34), SRP_LIMB(0xD203A9E0, 0xD7CE25D0), SRP_LIMB(0x53C44FAB, 0x734810F7),
+    SRP_LIMB(0x20BD72B9, 0xB21E6B3D), SRP_LIMB(0x62D21877, 0x1296EF6A), SRP_LIMB(0x8563215F, 0x72C8D989),
+    SRP_LIMB(0x04BA044A, 0xEB4EEFD4), SRP_LIMB(0xAE01E0F3, 0x63A9315D), SRP_LIMB(0x5F666146, 0xCB441F59),
+    SRP_LIMB(0xE60C6EFD, 0xFFB7A9A9), SRP_LIMB(0x6C7951A5, 0x23CEF785), SRP_LIMB(0x09954843, 0x20E739F4),
+    SRP_LIMB(0xFDC65A26, 0x9B51C1EF), SRP_LIMB(0xC93919D1, 0x2A4B1A67), SRP_LIMB(0xB18A9EF1, 0x50C8953A),
+    SRP_LIMB(0x1D7D37A2, 0x3FB8CF61), SRP_LIMB(0x46BDB733, 0x6E8452D9), SRP_LIMB(0x8BD70562, 0xDA60E392),
+    SRP_LIMB(0x4F024193, 0x787A8278), SRP_LIMB(0xCA06DA91, 0xC2B3E7E2), SRP_LIMB(0x8FB4832E, 0xF827DE84),
+    SRP_LIMB(0x7E2C75A5, 0x8E25F142), SRP_LIMB(0x34720869, 0x90DACF1A), SRP_LIMB(0xE8105464, 0xE9F80A5F),
+    SRP_LIMB(0xB616D6FA, 0x8BE2C91D), SRP_LIMB(0xF1D27D0B, 0x5C7DC9C2), SRP_LIMB(0x9E10FDE2, 0x8E54806B),
+    SRP_LIMB(0xE4FCCF1D, 0x638F4566), SRP_LIMB(0x6C09060D, 0x41058639), SRP_LIMB(0xC28A61D4, 0x7411402D),
+    SRP_LIMB(0x67DE8FA0, 0x23864714), SRP_LIMB(0x91A4F557, 0x2929B90C), SRP_LIMB(0xBEACD46F, 0x3CDD1196),
+    SRP_LIMB(0xA89D1DCD, 0x9D381CC5), SRP_LIMB(0xCB225176, 0x259E080F), SRP_LIMB(0x18C3DCE2, 0x0188D84C),
+    SRP_LIMB(0x91F30C52, 0xF798DA6A), SRP_LIMB(0x3AD36FD8, 0x22C39F34), SRP_LIMB(0xFEA80D9A, 0x6EC9FCD3),
+    SRP_LIMB(0xF3E56CC2, 0xBD9F048C), SRP_LIMB(0x70B56F52, 0x7F6F604F), SRP_LIMB(0x5401EA4F, 0x3ED73A2F),
+    SRP_LIMB(0x526A653A, 0x7A674BD5), SRP_LIMB(0x4C2DE67D, 0xAD47527E), SRP_LIMB(0xAA7FBD95, 0x62059F1F),
+    SRP_LIMB(0xF8B11725, 0x339EBC93), SRP_LIMB(0xB7B768C8, 0x9931D78D), SRP_LIMB(0xE65BCC3A, 0xB78FDAA9),
+    SRP_LIMB(0x3DA97659, 0xE280DB0B)
+};
+
+/* 8192 bits */
+static const mbedtls_mpi_uint srp_group_8192_N[] = {
+    SRP_LIMB(0xFFFFFFFF, 0xFFFFFFFF), SRP_LIMB(0x60C980DD, 0x98EDD3DF), SRP_LIMB(0xC81F56E8, 0x80B96E71),
+    SRP_LIMB(0x9E3050E2, 0x765694DF), SRP_LIMB(0x9558E447, 0x5677E9AA), SRP_LIMB(0xC9190DA6, 0xFC026E47),
+    SRP_LIMB(0x889A002E, 0xD5EE382B), SRP_LIMB(0x4009438B, 0x481C6CD7), SRP_LIMB(0x359046F4, 0xEB879F92),
+    SRP_LIMB(0xFAF36BC3, 0x1ECFA268), SRP_LIMB(0xB1D510BD, 0x7EE74D73), SRP_LIMB(0xF9AB4819, 0x5DED7EA1),
+    SRP_LIMB(0x64F31CC5, 0x0846851D), SRP_LIMB(0x4597E899, 0xA0255DC1), SRP_LIMB(0xDF310EE0, 0x74AB6A36),
+    SRP_LIMB(0x6D2A13F8, 0x3F44F82D), SRP_LIMB(0x062B3CF5, 0xB3A278A6), SRP_LIMB(0x79683303, 0xED5BDD3A),
+    SRP_LIMB(0xFA9D4B7F, 0xA2C087E8), SRP_LIMB(0x4BCBC886, 0x2F8385DD), SRP_LIMB(0x3473FC64, 0x6CEA306B),
+    SRP_LIMB(0x13EB57A8, 0x1A23F0C7), SRP_LIMB(0x22222E04, 0xA4037C07), SRP_LIMB(0xE3FDB8BE, 0xFC848AD9),
+    SRP_LIMB(0x238F16CB, 0xE39D652D), SRP_LIMB(0x3423B474, 0x2BF1C978), SRP_LIMB(0x3AAB639C, 0x5AE4F568),
+    SRP_LIMB(0x2576F693, 0x6BA42466), SRP_LIMB(0x741FA7BF, 0x8AFC47ED), SRP_LIMB(0x3BC832B6, 0x8D9DD300),
+    SRP_LIMB(0xD8BEC4D0, 0x73B931BA), SRP_LIMB(0x38777CB6, 0xA932DF8C), SRP_LIMB(0x74A3926F, 0x12FEE5E4),
+    SRP_LIMB(0xE694F91E, 0x6DBE1159), SRP_LIMB(0x12BF2D5B, 0x0B7474D6), SRP_LIMB(0x043E8F66, 0x3F4860EE),
+    SRP_LIMB(0x387FE8D7, 0x6E3C0468), SRP_LIMB(0xDA56C9EC, 0x2EF29632), SRP_LIMB(0xEB19CCB1, 0xA313D55C),
+    SRP_LIMB(0xF550AA3D, 0x8A1FBFF0), SRP_LIMB(0x06A1D58B, 0xB7C5DA76), SRP_LIMB(0xA79715EE, 0xF29BE328),
+    SRP_LIMB(0x14CC5ED2, 0x0F8037E0), SRP_LIMB(0xCC8F6D7E, 0xBF48E1D8), SRP_LIMB(0x4BD407B2, 0x2B4154AA),
+    SRP_LIMB(0x0F1D45B7, 0xFF585AC5), SRP_LIMB(0x23A97A7E, 0x36CC88BE), SRP_LIMB(0x59E7C97F, 0xBEC7E8F3),
+    SRP_LIMB(0xB5A84031, 0x900B1C9E), SRP_LIMB(0xD55E702F, 0x46980C82), SRP_LIMB(0xF482D7CE, 0x6E74FEF6),
+    SRP_LIMB(0xF032EA15, 0xD1721D03), SRP_LIMB(0x5983CA01, 0xC64B92EC), SRP_LIMB(0x6FB8F401, 0x378CD2BF),
+    SRP_LIMB(0x33205151, 0x2BD7AF42), SRP_LIMB(0xDB7F1447, 0xE6CC254B), SRP_LIMB(0x44CE6CBA, 0xCED4BB1B),
+    SRP_LIMB(0xDA3EDBEB, 0xCF9B14ED), SRP_LIMB(0x179727B0, 0x865A8918), SRP_LIMB(0xB06A53ED, 0x9027D831),
+    SRP_LIMB(0xE5DB382F, 0x413001AE), SRP_LIMB(0xF8FF9406, 0xAD9E530E), SRP_LIMB(0xC9751E76, 0x3DBA37BD),
+    SRP_LIMB(0xC1D4DCB2, 0x602646DE), SRP_LIMB(0x36C3FAB4, 0xD27C7026), SRP_LIMB(0x4DF435C9, 0x34028492),
+    SRP_LIMB(0x86FFB7DC, 0x90A6C08F), SRP_LIMB(0x93B4EA98, 0x8D8FDDC1), SRP_LIMB(0xD0069127, 0xD5B05AA9),
+    SRP_LIMB(0xB81BDD76, 0x2170481C), SRP_LIMB(0x1F612970, 0xCEE2D7AF), SRP_LIMB(0x233BA186, 0x515BE7ED),
+    SRP_LIMB(0x99B2964F, 0xA090C3A2), SRP_LIMB(0x287C5947, 0x4E6BC05D), SRP_LIMB(0x2E8EFC14, 0x1FBECAA6),
+    SRP_LIMB(0xDBBBC2DB, 0x04DE8EF9), SRP_LIMB(0x2583E9CA, 0x2AD44CE8), SRP_LIMB(0x1A946834, 0xB6150BDA),
+    SRP_LIMB(0x99C32718, 0x6AF4E23C), SRP_LIMB(0x88719A10, 0xBDBA5B26), SRP_LIMB(0x1A723C12, 0xA787E6D7),
+    SRP_LIMB(0x4B82D120, 0xA9210801), SRP_LIMB(0x43DB5BFC, 0xE0FD108E), SRP_LIMB(0x08E24FA0, 0x74E5AB31),
+    SRP_LIMB(0x770988C0, 0xBAD946E2), SRP_LIMB(0xBBE11757, 0x7A615D6C), SRP_LIMB(0x521F2B18, 0x177B200C),
+    SRP_LIMB(0xD8760273, 0x3EC86A64), SRP_LIMB(0xF12FFA06, 0xD98A0864), SRP_LIMB(0xCEE3D226, 0x1AD2EE6B),
+    SRP_LIMB(0x1E8C94E0, 0x4A25619D), SRP_LIMB(0xABF5AE8C, 0xDB0933D7), SRP_LIMB(0xB3970F85, 0xA6E1E4C7),
+    SRP_LIMB(0x8AEA7157, 0x5D060C7D), SRP_LIMB(0xECFB8504, 0x58DBEF0A), SRP_LIMB(0xA85521AB, 0xDF1CBA64),
+    SRP_LIMB(0xAD33170D, 0x04507A33), SRP_LIMB(0x15728E5A, 0x8AAAC42D), SRP_LIMB(0x15D22618, 0x98FA0510),
+    SRP_LIMB(0x3995497C, 0xEA956AE5), SRP_LIMB(0xDE2BCBF6, 0x95581718), SRP_LIMB(0xB5C55DF0, 0x6F4C52C9),
+    SRP_LIMB(0x9B2783A2, 0xEC07A28F), SRP_LIMB(0xE39E772C, 0x180E8603), SRP_LIMB(0x32905E46, 0x2E36CE3B),
+    SRP_LIMB(0xF1746C08, 0xCA18217C), SRP_LIMB(0x670C354E, 0x4ABC9804), SRP_LIMB(0x9ED52907, 0x7096966D),
+    SRP_LIMB(0x1C62F356, 0x208552BB), SRP_LIMB(0x83655D23, 0xDCA3AD96), SRP_LIMB(0x69163FA8, 0xFD24CF5F),
+    SRP_LIMB(0x98DA4836, 0x1C55D39A), SRP_LIMB(0xC2007CB8, 0xA163BF05), SRP_LIMB(0x49286651, 0xECE45B3D),
+    SRP_LIMB(0xAE9F2411, 0x7C4B1FE6), SRP_LIMB(0xEE386BFB, 0x5A899FA5), SRP_LIMB(0x0BFF5CB6, 0xF406B7ED),
+    SRP_LIMB(0xF44C42E9, 0xA637ED6B), SRP_LIMB(0xE485B576, 0x625E7EC6), SRP_LIMB(0x4FE1356D, 0x6D51C245),
+    SRP_LIMB(0x302B0A6D, 0xF25F1437), SRP_LIMB(0xEF9519B3, 0xCD3A431B), SRP_LIMB(0x514A0879, 0x8E3404DD),
+    SRP_LIMB(0x020BBEA6, 0x3B139B22), SRP_LIMB(0x29024E08, 0x8A67CC74), SRP_LIMB(0xC4C6628B, 0x80DC1CD1),
+    SRP_LIMB(0xC90FDAA2, 0x2168C234), SRP_LIMB(0xFFFFFFFF, 0xFFFFFFFF)
+};
+static const mbedtls_mpi_uint srp_group_8192_one[] = {
+    SRP_LIMB(0x00000000, 0x00000001), SRP_LIMB(0x9F367F22, 0x67122C20), SRP_LIMB(0x37E0A917, 0x7F46918E),
+    SRP_LIMB(0x61CFAF1D, 0x89A96B20), SRP_LIMB(0x6AA71BB8, 0xA9881655), SRP_LIMB(0x36E6F259, 0x03FD91B8),
+    SRP_LIMB(0x7765FFD1, 0x2A11C7D4), SRP_LIMB(0xBFF6BC74, 0xB7E39328), SRP_LIMB(0xCA6FB90B, 0x1478606D),
+    SRP_LIMB(0x050C943C, 0xE1305D97), SRP_LIMB(0x4E2AEF42, 0x8118B28C), SRP_LIMB(0x0654B7E6, 0xA212815E),
+    SRP_LIMB(0x9B0CE33A, 0xF7B97AE2), SRP_LIMB(0xBA681766, 0x5FDAA23E), SRP_LIMB(0x20CEF11F, 0x8B5495C9),
+    SRP_LIMB(0x92D5EC07, 0xC0BB07D2), SRP_LIMB(0xF9D4C30A, 0x4C5D8759), SRP_LIMB(0x8697CCFC, 0x12A422C5),
+    SRP_LIMB(0x0562B480, 0x5D3F7817), SRP_LIMB(0xB4343779, 0xD07C7A22), SRP_LIMB(0xCB8C039B, 0x9315CF94),
+    SRP_LIMB(0xEC14A857, 0xE5DC0F38), SRP_LIMB(0xDDDDD1FB, 0x5BFC83F8), SRP_LIMB(0x1C024741, 0x037B7526),
+    SRP_LIMB(0xDC70E934, 0x1C629AD2), SRP_LIMB(0xCBDC4B8B, 0xD40E3687), SRP_LIMB(0xC5549C63, 0xA51B0A97),
+    SRP_LIMB(0xDA89096C, 0x945BDB99), SRP_LIMB(0x8BE05840, 0x7503B812), SRP_LIMB(0xC437CD49, 0x72622CFF),
+    SRP_LIMB(0x27413B2F, 0x8C46CE45), SRP_LIMB(0xC7888349, 0x56CD2073), SRP_LIMB(0x8B5C6D90, 0xED011A1B),
+    SRP_LIMB(0x196B06E1, 0x9241EEA6), SRP_LIMB(0xED40D2A4, 0xF48B8B29), SRP_LIMB(0xFBC17099, 0xC0B79F11),
+    SRP_LIMB(0xC7801728, 0x91C3FB97), SRP_LIMB(0x25A93613, 0xD10D69CD), SRP_LIMB(0x14E6334E, 0x5CEC2AA3),
+    SRP_LIMB(0x0AAF55C2, 0x75E0400F), SRP_LIMB(0xF95E2A74, 0x483A2589), SRP_LIMB(0x5868EA11, 0x0D641CD7),
+    SRP_LIMB(0xEB33A12D, 0xF07FC81F), SRP_LIMB(0x33709281, 0x40B71E27), SRP_LIMB(0xB42BF84D, 0xD4BEAB55),
+    SRP_LIMB(0xF0E2BA48, 0x00A7A53A), SRP_LIMB(0xDC568581, 0xC9337741), SRP_LIMB(0xA6183680, 0x4138170C),
+    SRP_LIMB(0x4A57BFCE, 0x6FF4E361), SRP_LIMB(0x2AA18FD0, 0xB967F37D), SRP_LIMB(0x0B7D2831, 0x918B0109),
+    SRP_LIMB(0x0FCD15EA, 0x2E8DE2FC), SRP_LIMB(0xA67C35FE, 0x39B46D13), SRP_LIMB(0x90470BFE, 0xC8732D40),
+    SRP_LIMB(0xCCDFAEAE, 0xD42850BD), SRP_LIMB(0x2480EBB8, 0x1933DAB4), SRP_LIMB(0xBB319345, 0x312B44E4),
+    SRP_LIMB(0x25C12414, 0x3064EB12), SRP_LIMB(0xE868D84F, 0x79A576E7), SRP_LIMB(0x4F95AC12, 0x6FD827CE),
+    SRP_LIMB(0x1A24C7D0, 0xBECFFE51), SRP_LIMB(0x07006BF9, 0x5261ACF1), SRP_LIMB(0x368AE189, 0xC245C842),
+    SRP_LIMB(0x3E2B234D, 0x9FD9B921), SRP_LIMB(0xC93C054B, 0x2D838FD9), SRP_LIMB(0xB20BCA36, 0xCBFD7B6D),
+    SRP_LIMB(0x79004823, 0x6F593F70), SRP_LIMB(0x6C4B1567, 0x7270223E), SRP_LIMB(0x2FF96ED8, 0x2A4FA556),
+    SRP_LIMB(0x47E42289, 0xDE8FB7E3), SRP_LIMB(0xE09ED68F, 0x311D2850), SRP_LIMB(0xDCC45E79, 0xAEA41812),
+    SRP_LIMB(0x664D69B0, 0x5F6F3C5D), SRP_LIMB(0xD783A6B8, 0xB1943FA2), SRP_LIMB(0xD17103EB, 0xE0413559),
+    SRP_LIMB(0x24443D24, 0xFB217106), SRP_LIMB(0xDA7C1635, 0xD52BB317), SRP_LIMB(0xE56B97CB, 0x49EAF425),
+    SRP_LIMB(0x663CD8E7, 0x950B1DC3), SRP_LIMB(0x778E65EF, 0x4245A4D9), SRP_LIMB(0xE58DC3ED, 0x58781928),
+    SRP_LIMB(0xB47D2EDF, 0x56DEF7FE), SRP_LIMB(0xBC24A403, 0x1F02EF71), SRP_LIMB(0xF71DB05F, 0x8B1A54CE),
+    SRP_LIMB(0x88F6773F, 0x4526B91D), SRP_LIMB(0x441EE8A8, 0x859EA293), SRP_LIMB(0xADE0D4E7, 0xE884DFF3),
+    SRP_LIMB(0x2789FD8C, 0xC137959B), SRP_LIMB(0x0ED005F9, 0x2675F79B), SRP_LIMB(0x311C2DD9, 0xE52D1194),
+    SRP_LIMB(0xE1736B1F, 0xB5DA9E62), SRP_LIMB(0x540A5173, 0x24F6CC28), SRP_LIMB(0x4C68F07A, 0x591E1B38),
+    SRP_LIMB(0x75158EA8, 0xA2F9F382), SRP_LIMB(0x13047AFB, 0xA72410F5), SRP_LIMB(0x57AADE54, 0x20E3459B),
+    SRP_LIMB(0x52CCE8F2, 0xFBAF85CC), SRP_LIMB(0xEA8D71A5, 0x75553BD2), SRP_LIMB(0xEA2DD9E7, 0x6705FAEF),
+    SRP_LIMB(0xC66AB683, 0x156A951A), SRP_LIMB(0x21D43409, 0x6AA7E8E7), SRP_LIMB(0x4A3AA20F, 0x90B3AD36),
+    SRP_LIMB(0x64D87C5D, 0x13F85D70), SRP_LIMB(0x1C6188D3, 0xE7F179FC), SRP_LIMB(0xCD6FA1B9, 0xD1C931C4),
+    SRP_LIMB(0x0E8B93F7, 0x35E7DE83), SRP_LIMB(0x98F3CAB1, 0xB54367FB), SRP_LIMB(0x612AD6F8, 0x8F696992),
+    SRP_LIMB(0xE39D0CA9, 0xDF7AAD44), SRP_LIMB(0x7C9AA2DC, 0x235C5269), SRP_LIMB(0x96E9C057, 0x02DB30A0),
+    SRP_LIMB(0x6725B7C9, 0xE3AA2C65), SRP_LIMB(0x3DFF8347, 0x5E9C40FA), SRP_LIMB(0xB6D799AE, 0x131BA4C2),
+    SRP_LIMB(0x5160DBEE, 0x83B4E019), SRP_LIMB(0x11C79404, 0xA576605A), SRP_LIMB(0xF400A349, 0x0BF94812),
+    SRP_LIMB(0x0BB3BD16, 0x59C81294), SRP_LIMB(0x1B7A4A89, 0x9DA18139), SRP_LIMB(0xB01ECA92, 0x92AE3DBA),
+    SRP_LIMB(0xCFD4F592, 0x0DA0EBC8), SRP_LIMB(0x106AE64C, 0x32C5BCE4), SRP_LIMB(0xAEB5F786, 0x71CBFB22),
+    SRP_LIMB(0xFDF44159, 0xC4EC64DD), SRP_LIMB(0xD6FDB1F7, 0x7598338B), SRP_LIMB(0x3B399D74, 0x7F23E32E),
+    SRP_LIMB(0x36F0255D, 0xDE973DCB), SRP_LIMB(0x00000000, 0x00000000)
+};
+static const mbedtls_mpi_uint srp_group_8192_RR[] = {
+    SRP_LIMB(0x089AFC52, 0xA9CAFEE8), SRP_LIMB(0x21C090D2, 0x5E13960F), SRP_LIMB(0x811C7FD7, 0x55A928F1),
+    SRP_LIMB(0xFE05C9F1, 0x88E786C2), SRP_LIMB(0xA009B631, 0x2F6C2350), SRP_LIMB(0xF0A0E25B, 0x2A3A14F3),
+    SRP_LIMB(0x7A20A52C, 0xB063AD98), SRP_LIMB(0xD7FF434F, 0xF4926560), SRP_LIMB(0x9232F9FD, 0x500FEDC5),
+    SRP_LIMB(0x7D97D4C4, 0x318F22E7), SRP_LIMB(0xAFA4CA86, 0x547D057B), SRP_LIMB(0xF28F5477, 0xC086521E),
+    SRP_LIMB(0x26E1AE2D, 0x49A52E3F), SRP_LIMB(0xF8E0F27E, 0x32F7CAB7), SRP_LIMB(0xD68C1FBC, 0x17304E6F),
+    SRP_LIMB(0xC5D051C4, 0xF659129F), SRP_LIMB(0x890DF130, 0x78A415BE), SRP_LIMB(0x5F0D557D, 0x21C079AA),
+    SRP_LIMB(0x370BC4A2, 0xCDEA6A14), SRP_LIMB(0x411CE814, 0x9160809D), SRP_LIMB(0xF2CC7FA9, 0x4B8F23CA),
+    SRP_LIMB(0x25E8A7A9, 0x181910C0), SRP_LIMB(0x86E7B983, 0x86CCB443), SRP_LIMB(0xE3922D99, 0x4BEC4527),
+    SRP_LIMB(0x2D71541A, 0x00732DC5), SRP_LIMB(0x8A9BBA0C, 0x31DD9D27), SRP_LIMB(0x5FEB690F, 0x7058D913),
+    SRP_LIMB(0x04039857, 0xB28939F6), SRP_LIMB(0x587B56B7, 0x30464B28), SRP_LIMB(0x784ECBA5, 0x02AB7B0C),
+    SRP_LIMB(0x4752185F, 0x9A9BF03A), SRP_LIMB(0xE23851A7, 0xD6A8720A), SRP_LIMB(0x2A384F7C, 0x1010186A),
+    SRP_LIMB(0xE36F752B, 0x916BD432), SRP_LIMB(0x851C4B6C, 0x830AE8C3), SRP_LIMB(0x34A063B9, 0x01532657),
+    SRP_LIMB(0x71FAC862, 0xB3B8813D), SRP_LIMB(0x9ECE3FF2, 0x16A22743), SRP_LIMB(0x5F600782, 0x503C2EEC),
+    SRP_LIMB(0xBF60DF70, 0x0A08C5FF), SRP_LIMB(0xE4888520, 0xD60D3434), SRP_LIMB(0x667064B0, 0xF5C564C3),
+    SRP_LIMB(0xCD622A64, 0x0643986E), SRP_LIMB(0x81D1A6AB, 0xC08E41A1), SRP_LIMB(0x4230458A, 0xA6544706),
+    SRP_LIMB(0xDAB46B50, 0x116BBAC4), SRP_LIMB(0x465F6357, 0x32886872), SRP_LIMB(0x85AFE399, 0x30F5B7FA),
+    SRP_LIMB(0x7C46EF97, 0x4D010C90), SRP_LIMB(0xC76637B4, 0xF719BD82), SRP_LIMB(0x2699D48D, 0xFADA8A6D),
+    SRP_LIMB(0xFA623E65, 0xD445A3AD), SRP_LIMB(0xBDD0DF25, 0x07FEF8D0), SRP_LIMB(0xDB6B19DA, 0x34C8A497),
+    SRP_LIMB(0xCE805B29, 0xA2E2D6E9), SRP_LIMB(0xDB0EAE68, 0x15280FD6), SRP_LIMB(0xCCDAEBD4, 0x4AFED46E),
+    SRP_LIMB(0x37F24C5C, 0xB4E4A5AC), SRP_LIMB(0x084326C7, 0x659BF93F), SRP_LIMB(0x5D6E12FB, 0xDBA7036A),
+    SRP_LIMB(0x49C2DFDC, 0x7701464D), SRP_LIMB(0x97ED23C9, 0x56112DAB), SRP_LIMB(0x2799372D, 0x282F2DB1),
+    SRP_LIMB(0x8275F30D, 0x0D04B703), SRP_LIMB(0x28806920, 0x70CDAE86), SRP_LIMB(0xC6D4D33F, 0x4FAEB66C),
+    SRP_LIMB(0xF1211436, 0x0D327F15), SRP_LIMB(0xCA936AF4, 0x725F0D47), SRP_LIMB(0x9FCD1161, 0x086C11FF),
+    SRP_LIMB(0x86056CC4, 0x0FBBC443), SRP_LIMB(0x5691A814, 0x73D8A615), SRP_LIMB(0xF5563944, 0x14AAA668),
+    SRP_LIMB(0xD8BD3536, 0x9CD1D286), SRP_LIMB(0x3A877FC4, 0x2FA1B2D7), SRP_LIMB(0x3E65701C, 0xB44478E0),
+    SRP_LIMB(0xC9524609, 0x4B318FFB), SRP_LIMB(0xC06955DF, 0x9B15D7C1), SRP_LIMB(0xBE9748DD, 0x7B857FB7),
+    SRP_LIMB(0x051CA44E, 0xBE1C6CA1), SRP_LIMB(0xC8460FB0, 0xB8A8D9D0), SRP_LIMB(0x19FA98CF, 0xE7FF4CDE),
+    SRP_LIMB(0x4AFD2146, 0x859426B2), SRP_LIMB(0x27992869, 0xDD0DBB1D), SRP_LIMB(0x01500B71, 0x4FB8B29A),
+    SRP_LIMB(0x0B13A2F4, 0x1F7F7ED6), SRP_LIMB(0x95FBF7C0, 0x7173AE50), SRP_LIMB(0xB8FBEAA1, 0x233E2522),
+    SRP_LIMB(0x31DF706D, 0x0CE48E20), SRP_LIMB(0xB74E1A92, 0x002E1F01), SRP_LIMB(0x13D99EA0, 0x2D4DBC93),
+    SRP_LIMB(0x34E40FB8, 0xE306371E), SRP_LIMB(0x666B5E04, 0x2D32964F), SRP_LIMB(0xB56EAFCF, 0x4B8A1C87),
+    SRP_LIMB(0xEE5F8E38, 0x3E99BB13), SRP_LIMB(0x955B00C2, 0x4B8E239D), SRP_LIMB(0x59687CA0, 0x7D2B6A60),
+    SRP_LIMB(0xF6BBAD53, 0x49674386), SRP_LIMB(0x2E32C13E, 0xB870DDBA), SRP_LIMB(0x8F7AFB0C, 0x795A5CDB),
+    SRP_LIMB(0xAC265333, 0x2839E62F), SRP_LIMB(0xE30EC96D, 0x720C3D0F), SRP_LIMB(0x0287B953, 0xABAE39D0),
+    SRP_LIMB(0xAE673DB7, 0xC9CD44D5), SRP_LIMB(0xB6B11D9A, 0xA19BCA87), SRP_LIMB(0x4DBE19E7, 0x9DDCA0FB),
+    SRP_LIMB(0x9350AF30, 0xB28FED61), SRP_LIMB(0x73BA3A6C, 0x1D917D22), SRP_LIMB(0x48616A55, 0x4F777C61),
+    SRP_LIMB(0x23A567C5, 0x6E31446E), SRP_LIMB(0xCE05A847, 0xF71229BF), SRP_LIMB(0x29C1106E, 0xFEAC640A),
+    SRP_LIMB(0xAECA66BF, 0xC9712877), SRP_LIMB(0x172B176E, 0x1938F7E9), SRP_LIMB(0x6A874B1F, 0x32FCC609),
+    SRP_LIMB(0x2C7747FC, 0x1FD567A4), SRP_LIMB(0x45E879B2, 0x2FF780C7), SRP_LIMB(0xE0838C36, 0x6A1529D8),
+    SRP_LIMB(0x52798323, 0x3DAB0B78), SRP_LIMB(0xAE679847, 0x791B0476), SRP_LIMB(0xCCF3682A, 0x865D28B1),
+    SRP_LIMB(0x90BB82D9, 0x3E222108), SRP_LIMB(0xD2FFCBA7, 0xF988E49E), SRP_LIMB(0x53F292F6, 0x783E7D7E),
+    SRP_LIMB(0xF0675997, 0xACE4A1D2), SRP_LIMB(0x7244D800, 0x46F0E30A), SRP_LIMB(0x413EED4F, 0xDE6C407D),
+    SRP_LIMB(0xE4CBDA86, 0xC3B86684), SRP_LIMB(0x16D2E4AA, 0x7433FD52)
+};
+
+static const NGBuiltin srp_groups[] = {
+    { srp_group_512_N, srp_group_512_RR, srp_group_512_one,
+      sizeof(srp_group_512_N) / sizeof(mbedtls_mpi_uint), SRP_MM(0xFC467623, 0xB5DCBCC5), 2, 512, 64 },
+    { srp_group_768_N, srp_group_768_RR, srp_group_768_one,
+      sizeof(srp_group_768_N) / sizeof(mbedtls_mpi_uint), SRP_MM(0x29527256, 0x4119977D), 2, 768, 96 },
+    { srp_group_1024_N, srp_group_1024_RR, srp_group_1024_one,
+      sizeof(srp_group_1024_N) / sizeof(mbedtls_mpi_uint), SRP_MM(0x7B07A0B0, 0x379B9135), 2, 1024, 128 },
+    { srp_group_2048_N, srp_group_2048_RR, srp_group_2048_one,
+      sizeof(srp_group_2048_N) / sizeof(mbedtls_mpi_uint), SRP_MM(0x451F8DAD, 0x09FCC245), 2, 2048, 256 },
+    { srp_group_3072_N, srp_group_3072_RR, srp_group_3072_one,
+      sizeof(srp_group_3072_N) / sizeof(mbedtls_mpi_uint), SRP_MM(0x00000000, 0x00000001), 5, 3072, 384 },
+    { srp_group_4096_N, srp_group_4096_RR, srp_group_4096_one,
+      sizeof(srp_group_4096_N) / sizeof(mbedtls_mpi_uint), SRP_MM(0x00000000, 0x00000001), 5, 4096, 512 },
+    { srp_group_8192_N, srp_group_8192_RR, srp_group_8192_one,
+      sizeof(srp_group_8192_N) / sizeof(mbedtls_mpi_uint), SRP_MM(0x00000000, 0x00000001), 19, 8192, 1024 },
+};
+
+#endif
@@ -0,0 +1,723 @@
+/*
+ * Secure Remote Password 6a implementation based on mbedtls.
+ *
+ * Copyright (c) 2019 Stoian Ivanov
+ * https://github.com/sdrsdr/mbedtls-csrp
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+
+/*
+ * SHA code for x86 CPUs, picked at run time:
+ *
+ * - srp_hash_accel() hands srp.c a single stream implementation that uses the
+ *   SHA extensions for SHA-1 and SHA-224/256 and BMI2 for SHA-384/512.
+ *   srp.c uses it for every hash of the protocol when built with
+ *   -DSRP_HASH_ACCEL.
+ *
+ * - srp_hash_batch() runs independent messages through the compression
+ *   functions side by side, one message per vector lane. AVX2 gives 8 lanes of
+ *   32 bit words for SHA-1 and SHA-224/256 and 4 lanes of 64 bit words for
+ *   SHA-384/512. A lane that runs out of blocks picks up the next message, so
+ *   messages of different lengths keep all lanes busy until the batch runs dry.
+ *
+ * Without the CPU features, or on other architectures, both fall back to mbedtls.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "srp.h"
+#include "srp_hash.h"
+#include "srp_internal.h"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define SRP_HASH_X86
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+#define MB_MAX_LANES    8
+#define MB_MAX_BLOCK    128
+
+/* one compression over lanes blocks; st is state word major: st[word][lane] */
+typedef void (*mb_compress_func)( void *st, const unsigned char * const *blk );
+
+typedef struct MBAlg {
+	int                 lanes;
+	int                 block;      /* bytes */
+	int                 wsize;      /* bytes per state word */
+	int                 words;      /* state words */
+	int                 mdlen;
+	const void          *iv;
+	mb_compress_func    compress;
+} MBAlg;
+
+typedef struct MBLane {
+	int                 msg;        /* index into the batch, -1 when idle */
+	size_t              full;       /* blocks read straight from the message */
+	size_t              nblocks;
+	size_t              next;
+	unsigned char       tail[2 * MB_MAX_BLOCK];
+} MBLane;
+
+static const uint32_t IV1[5] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0 };
+
+static const uint32_t IV224[8] = {
+	0xc1059ed8, 0x367cd507, 0x3070dd17, 0xf70e5939, 0xffc00b31, 0x68581511, 0x64f98fa7, 0xbefa4fa4
+};
+
+static const uint32_t IV256[8] = {
+	0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+static const uint64_t IV384[8] = {
+	0xcbbb9d5dc1059ed8ULL, 0x629a292a367cd507ULL, 0x9159015a3070dd17ULL, 0x152fecd8f70e5939ULL,
+	0x67332667ffc00b31ULL, 0x8eb44a8768581511ULL, 0xdb0c2e0d64f98fa7ULL, 0x47b5481dbefa4fa4ULL
+};
+
+static const uint64_t IV512[8] = {
+	0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL, 0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
+	0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL, 0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL
+};
+
+static const uint32_t K256[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static const uint64_t K512[80] = {
+	0x428a2f98d728ae22ULL, 0x7137449123ef65cdULL, 0xb5c0fbcfec4d3b2fULL, 0xe9b5dba58189dbbcULL,
+	0x3956c25bf348b538ULL, 0x59f111f1b605d019ULL, 0x923f82a4af194f9bULL, 0xab1c5ed5da6d8118ULL,
+	0xd807aa98a3030242ULL, 0x12835b0145706fbeULL, 0x243185be4ee4b28cULL, 0x550c7dc3d5ffb4e2ULL,
+	0x72be5d74f27b896fULL, 0x80deb1fe3b1696b1ULL, 0x9bdc06a725c71235ULL, 0xc19bf174cf692694ULL,
+	0xe49b69c19ef14ad2ULL, 0xefbe4786384f25e3ULL, 0x0fc19dc68b8cd5b5ULL, 0x240ca1cc77ac9c65ULL,
+	0x2de92c6f592b0275ULL, 0x4a7484aa6ea6e483ULL, 0x5cb0a9dcbd41fbd4ULL, 0x76f988da831153b5ULL,
+	0x983e5152ee66dfabULL, 0xa831c66d2db43210ULL, 0xb00327c898fb213fULL, 0xbf597fc7beef0ee4ULL,
+	0xc6e00bf33da88fc2ULL, 0xd5a79147930aa725ULL, 0x06ca6351e003826fULL, 0x142929670a0e6e70ULL,
+	0x27b70a8546d22ffcULL, 0x2e1b21385c26c926ULL, 0x4d2c6dfc5ac42aedULL, 0x53380d139d95b3dfULL,
+	0x650a73548baf63deULL, 0x766a0abb3c77b2a8ULL, 0x81c2c92e47edaee6ULL, 0x92722c851482353bULL,
+	0xa2bfe8a14cf10364ULL, 0xa81a664bbc423001ULL, 0xc24b8b70d0f89791ULL, 0xc76c51a30654be30ULL,
+	0xd192e819d6ef5218ULL, 0xd69906245565a910ULL, 0xf40e35855771202aULL, 0x106aa07032bbd1b8ULL,
+	0x19a4c116b8d2d0c8ULL, 0x1e376c085141ab53ULL, 0x2748774cdf8eeb99ULL, 0x34b0bcb5e19b48a8ULL,
+	0x391c0cb3c5c95a63ULL, 0x4ed8aa4ae3418acbULL, 0x5b9cca4f7763e373ULL, 0x682e6ff3d6b2b8a3ULL,
+	0x748f82ee5defb2fcULL, 0x78a5636f43172f60ULL, 0x84c87814a1f0ab72ULL, 0x8cc702081a6439ecULL,
+	0x90befffa23631e28ULL, 0xa4506cebde82bde9ULL, 0xbef9a3f7b2c67915ULL, 0xc67178f2e372532bULL,
+	0xca273eceea26619cULL, 0xd186b8c721c0c207ULL, 0xeada7dd6cde0eb1eULL, 0xf57d4f7fee6ed178ULL,
+	0x06f067aa72176fbaULL, 0x0a637dc5a2c898a6ULL, 0x113f9804bef90daeULL, 0x1b710b35131c471bULL,
+	0x28db77f523047d84ULL, 0x32caab7b40c72493ULL, 0x3c9ebe0a15c9bebcULL, 0x431d67c49c100d4cULL,
+	0x4cc5d4becb3e42b6ULL, 0x597f299cfc657e2aULL, 0x5fcb6fab3ad6faecULL, 0x6c44198c4a475817ULL,
+};
+
+static const unsigned char mb_zero_block[MB_MAX_BLOCK];
+
+
+#ifdef SRP_HASH_X86
+
+static inline uint32_t be32( const unsigned char *p )
+{
+	return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+}
+
+static inline uint64_t be64( const unsigned char *p )
+{
+	return (uint64_t)be32(p) << 32 | be32(p + 4);
+}
+
+#define ADD32(a, b)     _mm256_add_epi32(a, b)
+#define XOR(a, b)       _mm256_xor_si256(a, b)
+#define AND(a, b)       _mm256_and_si256(a, b)
+#define OR(a, b)        _mm256_or_si256(a, b)
+#define ANDNOT(a, b)    _mm256_andnot_si256(a, b)      /* ~a & b */
+#define ROTL32(x, n)    OR(_mm256_slli_epi32(x, n), _mm256_srli_epi32(x, 32 - (n)))
+#define ROTR32(x, n)    OR(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - (n)))
+#define ADD64(a, b)     _mm256_add_epi64(a, b)
+#define ROTR64(x, n)    OR(_mm256_srli_epi64(x, n), _mm256_slli_epi64(x, 64 - (n)))
+
+/* word t of each lane's block, big endian */
+#define LOAD32X8(blk, t) _mm256_setr_epi32( \
+	(int) be32(blk[0] + 4*(t)), (int) be32(blk[1] + 4*(t)), (int) be32(blk[2] + 4*(t)), (int) be32(blk[3] + 4*(t)), \
+	(int) be32(blk[4] + 4*(t)), (int) be32(blk[5] + 4*(t)), (int) be32(blk[6] + 4*(t)), (int) be32(blk[7] + 4*(t)))
+#define LOAD64X4(blk, t) _mm256_setr_epi64x( \
+	(long long) be64(blk[0] + 8*(t)), (long long) be64(blk[1] + 8*(t)), \
+	(long long) be64(blk[2] + 8*(t)), (long long) be64(blk[3] + 8*(t)))
+
+__attribute__((target("avx2")))
+static void sha1_x8( void *state, const unsigned char * const *blk )
+{
+	uint32_t (*st)[8] = (uint32_t (*)[8]) state;
+	__m256i W[16], a, b, c, d, e, f, k, tmp;
+	int t;
+
+	for (t=0; t<16; t++) W[t] = LOAD32X8(blk, t);
+	a = _mm256_loadu_si256((const __m256i *) st[0]);
+	b = _mm256_loadu_si256((const __m256i *) st[1]);
+	c = _mm256_loadu_si256((const __m256i *) st[2]);
+	d = _mm256_loadu_si256((const __m256i *) st[3]);
+	e = _mm256_loadu_si256((const __m256i *) st[4]);
+
+	for (t=0; t<80; t++) {
+		if (t >= 16) {
+			tmp = XOR(XOR(W[(t-3) & 15], W[(t-8) & 15]), XOR(W[(t-14) & 15], W[t & 15]));
+			W[t & 15] = ROTL32(tmp, 1);
+		}
+		if (t < 20) {
+			f = XOR(AND(b, c), ANDNOT(b, d));
+			k = _mm256_set1_epi32(0x5a827999);
+		} else if (t < 40) {
+			f = XOR(XOR(b, c), d);
+			k = _mm256_set1_epi32(0x6ed9eba1);
+		} else if (t < 60) {
+			f = OR(AND(b, c), AND(d, OR(b, c)));
+			k = _mm256_set1_epi32((int) 0x8f1bbcdc);
+		} else {
+			f = XOR(XOR(b, c), d);
+			k = _mm256_set1_epi32((int) 0xca62c1d6);
+		}
+		tmp = ADD32(ADD32(ROTL32(a, 5), f), ADD32(ADD32(e, k), W[t & 15]));
+		e = d;
+		d = c;
+		c = ROTL32(b, 30);
+		b = a;
+		a = tmp;
+	}
+
+	_mm256_storeu_si256((__m256i *) st[0], ADD32(a, _mm256_loadu_si256((const __m256i *) st[0])));
+	_mm256_storeu_si256((__m256i *) st[1], ADD32(b, _mm256_loadu_si256((const __m256i *) st[1])));
+	_mm256_storeu_si256((__m256i *) st[2], ADD32(c, _mm256_loadu_si256((const __m256i *) st[2])));
+	_mm256_storeu_si256((__m256i *) st[3], ADD32(d, _mm256_loadu_si256((const __m256i *) st[3])));
+	_mm256_storeu_si256((__m256i *) st[4], ADD32(e, _mm256_loadu_si256((const __m256i *) st[4])));
+}
+
+__attribute__((target("avx2")))
+static void sha256_x8( void *state, const unsigned char * const *blk )
+{
+	uint32_t (*st)[8] = (uint32_t (*)[8]) state;
+	__m256i W[16], s[8], t1, t2, x, y;
+	int t, i;
+
+	for (t=0; t<16; t++) W[t] = LOAD32X8(blk, t);
+	for (i=0; i<8; i++) s[i] = _mm256_loadu_si256((const __m256i *) st[i]);
+
+	for (t=0; t<64; t++) {
+		if (t >= 16) {
+			x = W[(t-15) & 15];
+			y = W[(t-2) & 15];
+			x = XOR(XOR(ROTR32(x, 7), ROTR32(x, 18)), _mm256_srli_epi32(x, 3));
+			y = XOR(XOR(ROTR32(y, 17), ROTR32(y, 19)), _mm256_srli_epi32(y, 10));
+			W[t & 15] = ADD32(ADD32(W[t & 15], x), ADD32(W[(t-7) & 15], y));
+		}
+		/* s[0..7] = a b c d e f g h */
+		x = XOR(XOR(ROTR32(s[4], 6), ROTR32(s[4], 11)), ROTR32(s[4], 25));
+		y = XOR(AND(s[4], s[5]), ANDNOT(s[4], s[6]));
+		t1 = ADD32(ADD32(s[7], x), ADD32(y, ADD32(_mm256_set1_epi32((int) K256[t]), W[t & 15])));
+		x = XOR(XOR(ROTR32(s[0], 2), ROTR32(s[0], 13)), ROTR32(s[0], 22));
+		y = OR(AND(s[0], s[1]), AND(s[2], OR(s[0], s[1])));
+		t2 = ADD32(x, y);
+		s[7] = s[6];
+		s[6] = s[5];
+		s[5] = s[4];
+		s[4] = ADD32(s[3], t1);
+		s[3] = s[2];
+		s[2] = s[1];
+		s[1] = s[0];
+		s[0] = ADD32(t1, t2);
+	}
+
+	for (i=0; i<8; i++) {
+		_mm256_storeu_si256((__m256i *) st[i], ADD32(s[i], _mm256_loadu_si256((const __m256i *) st[i])));
+	}
+}
+
+__attribute__((target("avx2")))
+static void sha512_x4( void *state, const unsigned char * const *blk )
+{
+	uint64_t (*st)[4] = (uint64_t (*)[4]) state;
+	__m256i W[16], s[8], t1, t2, x, y;
+	int t, i;
+
+	for (t=0; t<16; t++) W[t] = LOAD64X4(blk, t);
+	for (i=0; i<8; i++) s[i] = _mm256_loadu_si256((const __m256i *) st[i]);
+
+	for (t=0; t<80; t++) {
+		if (t >= 16) {
+			x = W[(t-15) & 15];
+			y = W[(t-2) & 15];
+			x = XOR(XOR(ROTR64(x, 1), ROTR64(x, 8)), _mm256_srli_epi64(x, 7));
+			y = XOR(XOR(ROTR64(y, 19), ROTR64(y, 61)), _mm256_srli_epi64(y, 6));
+			W[t & 15] = ADD64(ADD64(W[t & 15], x), ADD64(W[(t-7) & 15], y));
+		}
+		x = XOR(XOR(ROTR64(s[4], 14), ROTR64(s[4], 18)), ROTR64(s[4], 41));
+		y = XOR(AND(s[4], s[5]), ANDNOT(s[4], s[6]));
+		t1 = ADD64(ADD64(s[7], x), ADD64(y, ADD64(_mm256_set1_epi64x((long long) K512[t]), W[t & 15])));
+		x = XOR(XOR(ROTR64(s[0], 28), ROTR64(s[0], 34)), ROTR64(s[0], 39));
+		y = OR(AND(s[0], s[1]), AND(s[2], OR(s[0], s[1])));
+		t2 = ADD64(x, y);
+		s[7] = s[6];
+		s[6] = s[5];
+		s[5] = s[4];
+		s[4] = ADD64(s[3], t1);
+		s[3] = s[2];
+		s[2] = s[1];
+		s[1] = s[0];
+		s[0] = ADD64(t1, t2);
+	}
+
+	for (i=0; i<8; i++) {
+		_mm256_storeu_si256((__m256i *) st[i], ADD64(s[i], _mm256_loadu_si256((const __m256i *) st[i])));
+	}
+}
+
+#define CPU_AVX2    1
+#define CPU_BMI2    2
+#define CPU_SHA     4
+
+static int hash_cpu( void )
+{
+	static int cpu = -1;
+	unsigned int a, b, c, d;
+	int f = __atomic_load_n(&cpu, __ATOMIC_RELAXED);
+
+	if (f < 0) {
+		f = 0;
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2")) f |= CPU_AVX2;
+		if (__builtin_cpu_supports("bmi2")) f |= CPU_BMI2;
+		/* the SHA extensions need SSE4.1 too, for the blends and extracts */
+		if (__get_cpuid_count(7, 0, &a, &b, &c, &d) && (b & (1u << 29)) &&
+		    __builtin_cpu_supports("sse4.1")) f |= CPU_SHA;
+		__atomic_store_n(&cpu, f, __ATOMIC_RELAXED);
+	}
+	return f;
+}
+
+#endif /* SRP_HASH_X86 */
+
+/* the multi-buffer variant of alg, 0 when there is none on this CPU */
+static int mb_alg( SRP_HashAlgorithm alg, MBAlg *a )
+{
+#ifdef SRP_HASH_X86
+	if (!(hash_cpu() & CPU_AVX2)) return 0;
+	switch (alg) {
+		case SRP_SHA1:
+			a->lanes = 8; a->block = 64; a->wsize = 4; a->words = 5; a->mdlen = 20;
+			a->iv = IV1; a->compress = sha1_x8;
+			return 1;
+		case SRP_SHA224:
+		case SRP_SHA256:
+			a->lanes = 8; a->block = 64; a->wsize = 4; a->words = 8;
+			a->mdlen = alg==SRP_SHA224 ? 28 : 32;
+			a->iv = alg==SRP_SHA224 ? (const void *) IV224 : (const void *) IV256;
+			a->compress = sha256_x8;
+			return 1;
+		case SRP_SHA384:
+		case SRP_SHA512:
+			a->lanes = 4; a->block = 128; a->wsize = 8; a->words = 8;
+			a->mdlen = alg==SRP_SHA384 ? 48 : 64;
+			a->iv = alg==SRP_SHA384 ? (const void *) IV384 : (const void *) IV512;
+			a->compress = sha512_x4;
+			return 1;
+		default:
+			return 0;
+	}
+#else
+	(void) alg;
+	(void) a;
+	return 0;
+#endif
+}
+
+/* pads message msg into the tail blocks of lane l and resets its state */
+static void mb_lane_start( const MBAlg *a, void *st, MBLane *ln, int l, int msg,
+	const unsigned char *data, size_t len )
+{
+	size_t rem = len % a->block, tail, i;
+	unsigned char *lp;
+	uint64_t bits = (uint64_t) len << 3;
+
+	ln->msg = msg;
+	ln->full = len / a->block;
+	ln->next = 0;
+	/* 0x80 and the length field: 8 bytes for 64 byte blocks, 16 for 128 */
+	tail = rem + 1 + (size_t)(a->block / 8) <= (size_t) a->block ? 1 : 2;
+	ln->nblocks = ln->full + tail;
+
+	memset(ln->tail, 0, tail * a->block);
+	memcpy(ln->tail, data + ln->full * a->block, rem);
+	ln->tail[rem] = 0x80;
+	lp = ln->tail + tail * a->block - 8;
+	for (i=0; i<8; i++) lp[i] = (unsigned char)(bits >> (56 - 8*i));
+	if (a->block == 128) ln->tail[tail * a->block - 9] = (unsigned char)((uint64_t) len >> 61);
+
+	for (i=0; i<(size_t) a->words; i++) {
+		if (a->wsize == 4) ((uint32_t *) st)[i * a->lanes + l] = ((const uint32_t *) a->iv)[i];
+		else ((uint64_t *) st)[i * a->lanes + l] = ((const uint64_t *) a->iv)[i];
+	}
+}
+
+static void mb_lane_digest( const MBAlg *a, const void *st, int l, unsigned char *md )
+{
+	int i, j;
+
+	for (i=0; i*a->wsize < a->mdlen; i++) {
+		uint64_t w = a->wsize == 4 ? ((const uint32_t *) st)[i * a->lanes + l]
+		                           : ((const uint64_t *) st)[i * a->lanes + l];
+		for (j=0; j<a->wsize && i*a->wsize + j < a->mdlen; j++) {
+			md[i*a->wsize + j] = (unsigned char)(w >> (8 * (a->wsize - 1 - j)));
+		}
+	}
+}
+
+void srp_hash_batch( SRP_HashAlgorithm alg, const unsigned char * const * msg, const size_t * len,
+	unsigned char * const * md, int count )
+{
+	MBAlg a;
+	MBLane lanes[MB_MAX_LANES];
+	uint64_t st[8 * MB_MAX_LANES / 2];  /* 8 words of 32 bits x 8 lanes, or 64 bits x 4 */
+	const unsigned char *blk[MB_MAX_LANES];
+	int next = 0, active = 0, l, i;
+
+	if (count <= 0) return;
+	if (count == 1 || !mb_alg(alg, &a)) {
+		for (i=0; i<count; i++) srp_hash(alg, msg[i], len[i], md[i]);
+		return;
+	}
+
+	for (l=0; l<a.lanes; l++) {
+		if (next < count) {
+			mb_lane_start(&a, st, &lanes[l], l, next, msg[next], len[next]);
+			next++;
+			active++;
+		} else {
+			lanes[l].msg = -1;
+		}
+	}
+
+	while (active > 0) {
+		for (l=0; l<a.lanes; l++) {
+			MBLane *ln = &lanes[l];
+			if (ln->msg < 0) blk[l] = mb_zero_block;
+			else if (ln->next < ln->full) blk[l] = msg[ln->msg] + ln->next * a.block;
+			else blk[l] = ln->tail + (ln->next - ln->full) * a.block;
+		}
+		a.compress(st, blk);
+		for (l=0; l<a.lanes; l++) {
+			MBLane *ln = &lanes[l];
+			if (ln->msg < 0 || ++ln->next < ln->nblocks) continue;
+			mb_lane_digest(&a, st, l, md[ln->msg]);
+			if (next < count) {
+				mb_lane_start(&a, st, ln, l, next, msg[next], len[next]);
+				next++;
+			} else {
+				ln->msg = -1;
+				active--;
+			}
+		}
+	}
+	memset(lanes, 0, sizeof(lanes));
+	memset(st, 0, sizeof(st));
+}
+
+int srp_hash_batch_lanes( SRP_HashAlgorithm alg )
+{
+	MBAlg a;
+	return mb_alg(alg, &a) ? a.lanes : 1;
+}
+
+
+/*
+ * Single stream. The compression functions take any number of whole blocks;
+ * buffering and padding are shared.
+ */
+
+typedef void (*acc_compress_func)( SRPShaState *st, const unsigned char *p, size_t nblocks );
+
+static void acc_update( SRPShaState *st, const unsigned char *p, size_t len, size_t block,
+	acc_compress_func compress )
+{
+	size_t used = (size_t)(st->len % block), n;
+
+	st->len += len;
+	if (used) {
+		n = block - used < len ? block - used : len;
+		memcpy(st->buf + used, p, n);
+		p += n;
+		len -= n;
+		if (used + n < block) return;
+		compress(st, st->buf, 1);
+	}
+	if (len >= block) {
+		compress(st, p, len / block);
+		p += len - len % block;
+		len %= block;
+	}
+	if (len) memcpy(st->buf, p, len);
+}
+
+static void acc_final( SRPShaState *st, size_t block, int wsize, int mdlen, acc_compress_func compress,
+	unsigned char *md )
+{
+	size_t used = (size_t)(st->len % block), lenpos = block - 8;
+	uint64_t bits = st->len << 3;
+	int i, j;
+
+	st->buf[used++] = 0x80;
+	if (used > block - block / 8) {
+		memset(st->buf + used, 0, block - used);
+		compress(st, st->buf, 1);
+		used = 0;
+	}
+	memset(st->buf + used, 0, block - used);
+	if (block == 128) st->buf[lenpos - 1] = (unsigned char)(st->len >> 61);
+	for (i=0; i<8; i++) st->buf[lenpos + i] = (unsigned char)(bits >> (56 - 8*i));
+	compress(st, st->buf, 1);
+
+	for (i=0; i*wsize < mdlen; i++) {
+		uint64_t w = wsize == 4 ? st->h.w32[i] : st->h.w64[i];
+		for (j=0; j<wsize && i*wsize + j < mdlen; j++) {
+			md[i*wsize + j] = (unsigned char)(w >> (8 * (wsize - 1 - j)));
+		}
+	}
+	memset(st, 0, sizeof(*st));
+}
+
+#ifdef SRP_HASH_X86
+
+/*
+ * SHA-1 with the SHA extensions. Each group does four rounds; the message
+ * schedule for group g + 1 is finished with sha1msg2 in group g, after
+ * sha1msg1 in g - 2 and the xor in g - 1.
+ */
+#define SHA1_GROUP(g, f, e_in, e_out) do { \
+	if ((g) == 0) e_in = _mm_add_epi32(e_in, m[0]); \
+	else e_in = _mm_sha1nexte_epu32(e_in, m[(g) & 3]); \
+	e_out = abcd; \
+	if ((g) >= 3 && (g) <= 18) m[((g)+1) & 3] = _mm_sha1msg2_epu32(m[((g)+1) & 3], m[(g) & 3]); \
+	abcd = _mm_sha1rnds4_epu32(abcd, e_in, f); \
+	if ((g) >= 1 && (g) <= 16) m[((g)-1) & 3] = _mm_sha1msg1_epu32(m[((g)-1) & 3], m[(g) & 3]); \
+	if ((g) >= 2 && (g) <= 17) m[((g)-2) & 3] = _mm_xor_si128(m[((g)-2) & 3], m[(g) & 3]); \
+} while (0)
+
+__attribute__((target("sha,sse4.1")))
+static void sha1_ni( SRPShaState *st, const unsigned char *p, size_t nblocks )
+{
+	const __m128i mask = _mm_set_epi64x(0x0001020304050607LL, 0x08090a0b0c0d0e0fLL);
+	__m128i abcd, e0, e1, abcd_save, e_save, m[4];
+	int i;
+
+	abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *) st->h.w32), 0x1b);
+	e0 = _mm_set_epi32((int) st->h.w32[4], 0, 0, 0);
+
+	while (nblocks--) {
+		abcd_save = abcd;
+		e_save = e0;
+		for (i=0; i<4; i++) m[i] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(p + 16*i)), mask);
+
+		SHA1_GROUP( 0, 0, e0, e1); SHA1_GROUP( 1, 0, e1, e0);
+		SHA1_GROUP( 2, 0, e0, e1); SHA1_GROUP( 3, 0, e1, e0);
+		SHA1_GROUP( 4, 0, e0, e1); SHA1_GROUP( 5, 1, e1, e0);
+		SHA1_GROUP( 6, 1, e0, e1); SHA1_GROUP( 7, 1, e1, e0);
+		SHA1_GROUP( 8, 1, e0, e1); SHA1_GROUP( 9, 1, e1, e0);
+		SHA1_GROUP(10, 2, e0, e1); SHA1_GROUP(11, 2, e1, e0);
+		SHA1_GROUP(12, 2, e0, e1); SHA1_GROUP(13, 2, e1, e0);
+		SHA1_GROUP(14, 2, e0, e1); SHA1_GROUP(15, 3, e1, e0);
+		SHA1_GROUP(16, 3, e0, e1); SHA1_GROUP(17, 3, e1, e0);
+		SHA1_GROUP(18, 3, e0, e1); SHA1_GROUP(19, 3, e1, e0);
+
+		e0 = _mm_sha1nexte_epu32(e0, e_save);
+		abcd = _mm_add_epi32(abcd, abcd_save);
+		p += 64;
+	}
+
+	_mm_storeu_si128((__m128i *) st->h.w32, _mm_shuffle_epi32(abcd, 0x1b));
+	st->h.w32[4] = (uint32_t) _mm_extract_epi32(e0, 3);
+}
+
+/*
+ * SHA-256 with the SHA extensions, state kept as ABEF / CDGH. Group g does
+ * rounds 4g .. 4g+3 and computes W[4g .. 4g+3] from the four groups before.
+ */
+#define SHA256_GROUP(g) do { \
+	__m128i msg; \
+	if ((g) >= 4) { \
+		msg = _mm_add_epi32(_mm_sha256msg1_epu32(m[(g) & 3], m[((g)+1) & 3]), \
+		                    _mm_alignr_epi8(m[((g)+3) & 3], m[((g)+2) & 3], 4)); \
+		m[(g) & 3] = _mm_sha256msg2_epu32(msg, m[((g)+3) & 3]); \
+	} \
+	msg = _mm_add_epi32(m[(g) & 3], _mm_loadu_si128((const __m128i *) &K256[4*(g)])); \
+	cdgh = _mm_sha256rnds2_epu32(cdgh, abef, msg); \
+	abef = _mm_sha256rnds2_epu32(abef, cdgh, _mm_shuffle_epi32(msg, 0x0e)); \
+} while (0)
+
+__attribute__((target("sha,sse4.1")))
+static void sha256_ni( SRPShaState *st, const unsigned char *p, size_t nblocks )
+{
+	const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bLL, 0x0405060700010203LL);
+	__m128i abef, cdgh, tmp, abef_save, cdgh_save, m[4];
+	int i;
+
+	tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *) &st->h.w32[0]), 0xb1);  /* CDAB */
+	cdgh = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *) &st->h.w32[4]), 0x1b); /* EFGH */
+	abef = _mm_alignr_epi8(tmp, cdgh, 8);
+	cdgh = _mm_blend_epi16(cdgh, tmp, 0xf0);
+
+	while (nblocks--) {
+		abef_save = abef;
+		cdgh_save = cdgh;
+		for (i=0; i<4; i++) m[i] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(p + 16*i)), mask);
+
+		SHA256_GROUP( 0); SHA256_GROUP( 1); SHA256_GROUP( 2); SHA256_GROUP( 3);
+		SHA256_GROUP( 4); SHA256_GROUP( 5); SHA256_GROUP( 6); SHA256_GROUP( 7);
+		SHA256_GROUP( 8); SHA256_GROUP( 9); SHA256_GROUP(10); SHA256_GROUP(11);
+		SHA256_GROUP(12); SHA256_GROUP(13); SHA256_GROUP(14); SHA256_GROUP(15);
+
+		abef = _mm_add_epi32(abef, abef_save);
+		cdgh = _mm_add_epi32(cdgh, cdgh_save);
+		p += 64;
+	}
+
+	tmp = _mm_shuffle_epi32(abef, 0x1b);        /* FEBA */
+	cdgh = _mm_shuffle_epi32(cdgh, 0xb1);       /* DCHG */
+	_mm_storeu_si128((__m128i *) &st->h.w32[0], _mm_blend_epi16(tmp, cdgh, 0xf0));
+	_mm_storeu_si128((__m128i *) &st->h.w32[4], _mm_alignr_epi8(cdgh, tmp, 8));
+}
+
+/*
+ * SHA-512 in general purpose registers: fully unrolled, with the message
+ * schedule interleaved into the rounds and BMI2 rorx for the rotates, which
+ * leaves the flags alone and needs no extra moves.
+ */
+#define ROR64(x, n)     (((x) >> (n)) | ((x) << (64 - (n))))
+#define SHA512_W(t)     (W[(t) & 15] += (ROR64(W[((t)-2) & 15], 19) ^ ROR64(W[((t)-2) & 15], 61) ^ (W[((t)-2) & 15] >> 6)) + \
+                                        W[((t)-7) & 15] + \
+                                        (ROR64(W[((t)-15) & 15], 1) ^ ROR64(W[((t)-15) & 15], 8) ^ (W[((t)-15) & 15] >> 7)))
+#define SHA512_ROUND(a, b, c, d, e, f, g, h, t) do { \
+	uint64_t t1 = h + (ROR64(e, 14) ^ ROR64(e, 18) ^ ROR64(e, 41)) + (g ^ (e & (f ^ g))) + K512[t] + \
+	              ((t) < 16 ? W[t] : SHA512_W(t)); \
+	uint64_t t2 = (ROR64(a, 28) ^ ROR64(a, 34) ^ ROR64(a, 39)) + ((a & b) | (c & (a | b))); \
+	d += t1; \
+	h = t1 + t2; \
+} while (0)
+#define SHA512_8ROUNDS(t) do { \
+	SHA512_ROUND(a, b, c, d, e, f, g, h, (t)); \
+	SHA512_ROUND(h, a, b, c, d, e, f, g, (t)+1); \
+	SHA512_ROUND(g, h, a, b, c, d, e, f, (t)+2); \
+	SHA512_ROUND(f, g, h, a, b, c, d, e, (t)+3); \
+	SHA512_ROUND(e, f, g, h, a, b, c, d, (t)+4); \
+	SHA512_ROUND(d, e, f, g, h, a, b, c, (t)+5); \
+	SHA512_ROUND(c, d, e, f, g, h, a, b, (t)+6); \
+	SHA512_ROUND(b, c, d, e, f, g, h, a, (t)+7); \
+} while (0)
+
+__attribute__((target("bmi2")))
+static void sha512_bmi2( SRPShaState *st, const unsigned char *p, size_t nblocks )
+{
+	uint64_t W[16], a, b, c, d, e, f, g, h;
+	int t;
+
+	while (nblocks--) {
+		for (t=0; t<16; t++) W[t] = be64(p + 8*t);
+
+		a = st->h.w64[0]; b = st->h.w64[1]; c = st->h.w64[2]; d = st->h.w64[3];
+		e = st->h.w64[4]; f = st->h.w64[5]; g = st->h.w64[6]; h = st->h.w64[7];
+		SHA512_8ROUNDS(0);  SHA512_8ROUNDS(8);  SHA512_8ROUNDS(16); SHA512_8ROUNDS(24);
+		SHA512_8ROUNDS(32); SHA512_8ROUNDS(40); SHA512_8ROUNDS(48); SHA512_8ROUNDS(56);
+		SHA512_8ROUNDS(64); SHA512_8ROUNDS(72);
+		st->h.w64[0] += a; st->h.w64[1] += b; st->h.w64[2] += c; st->h.w64[3] += d;
+		st->h.w64[4] += e; st->h.w64[5] += f; st->h.w64[6] += g; st->h.w64[7] += h;
+		p += 128;
+	}
+}
+
+static void acc_init( HashCTX *c, const void *iv, size_t size )
+{
+	memset(&c->u.acc, 0, sizeof(c->u.acc));
+	memcpy(c->u.acc.h.w64, iv, size);
+}
+
+static void sha1_ni_init( HashCTX *c )   { acc_init(c, IV1, sizeof(IV1)); }
+static void sha224_ni_init( HashCTX *c ) { acc_init(c, IV224, sizeof(IV224)); }
+static void sha256_ni_init( HashCTX *c ) { acc_init(c, IV256, sizeof(IV256)); }
+static void sha384_bmi2_init( HashCTX *c ) { acc_init(c, IV384, sizeof(IV384)); }
+static void sha512_bmi2_init( HashCTX *c ) { acc_init(c, IV512, sizeof(IV512)); }
+
+static void sha1_ni_update( HashCTX *c, const void *data, size_t len )
+{
+	acc_update(&c->u.acc, data, len, 64, sha1_ni);
+}
+static void sha256_ni_update( HashCTX *c, const void *data, size_t len )
+{
+	acc_update(&c->u.acc, data, len, 64, sha256_ni);
+}
+static void sha512_bmi2_update( HashCTX *c, const void *data, size_t len )
+{
+	acc_update(&c->u.acc, data, len, 128, sha512_bmi2);
+}
+
+static void sha1_ni_final( HashCTX *c, unsigned char *md )      { acc_final(&c->u.acc, 64, 4, 20, sha1_ni, md); }
+static void sha224_ni_final( HashCTX *c, unsigned char *md )    { acc_final(&c->u.acc, 64, 4, 28, sha256_ni, md); }
+static void sha256_ni_final( HashCTX *c, unsigned char *md )    { acc_final(&c->u.acc, 64, 4, 32, sha256_ni, md); }
+static void sha384_bmi2_final( HashCTX *c, unsigned char *md )  { acc_final(&c->u.acc, 128, 8, 48, sha512_bmi2, md); }
+static void sha512_bmi2_final( HashCTX *c, unsigned char *md )  { acc_final(&c->u.acc, 128, 8, 64, sha512_bmi2, md); }
+
+static const SRPHashImpl g_sha_ni[SRP_SHA384] = {
+	{ "sha-ni", sha1_ni_init,   sha1_ni_update,   sha1_ni_final },
+	{ "sha-ni", sha224_ni_init, sha256_ni_update, sha224_ni_final },
+	{ "sha-ni", sha256_ni_init, sha256_ni_update, sha256_ni_final },
+};
+
+static const SRPHashImpl g_sha512_bmi2[2] = {
+	{ "bmi2", sha384_bmi2_init, sha512_bmi2_update, sha384_bmi2_final },
+	{ "bmi2", sha512_bmi2_init, sha512_bmi2_update, sha512_bmi2_final },
+};
+
+#endif /* SRP_HASH_X86 */
+
+const SRPHashImpl * srp_hash_accel( SRP_HashAlgorithm alg )
+{
+#ifdef SRP_HASH_X86
+	int cpu = hash_cpu();
+
+	switch (alg) {
+		case SRP_SHA1:
+		case SRP_SHA224:
+		case SRP_SHA256:
+			return (cpu & CPU_SHA) ? &g_sha_ni[alg] : NULL;
+		case SRP_SHA384:
+		case SRP_SHA512:
+			return (cpu & CPU_BMI2) ? &g_sha512_bmi2[alg - SRP_SHA384] : NULL;
+		default:
+			return NULL;
+	}
+#else
+	(void) alg;
+	return NULL;
+#endif
+}
@@ -0,0 +1,58 @@
+#ifndef SRP_HASH_H
+#define SRP_HASH_H
+
+/*
+ * Secure Remote Password 6a implementation based on mbedtls.
+ *
+ * Copyright (c) 2019 Stoian Ivanov
+ * https://github.com/sdrsdr/mbedtls-csrp
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+
+/*
+ * Multi-buffer hashing of many independent messages, e.g. the x = H(s | H(I:P))
+ * of a bulk enrollment. Needs srp_hash.c. Uses AVX2 when the CPU has it and
+ * falls back to one message at a time otherwise; the digests are the same.
+ */
+
+#include <stddef.h>
+
+#include "srp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* md[i] = H(msg[i][0 .. len[i]-1]) for i < count; md[i] must hold the digest */
+void srp_hash_batch( SRP_HashAlgorithm alg, const unsigned char * const * msg, const size_t * len,
+                     unsigned char * const * md, int count );
+
+/* messages hashed side by side for alg on this CPU, 1 without a vector unit */
+int  srp_hash_batch_lanes( SRP_HashAlgorithm alg );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -35,71 +35,225 @@
 
 
 
+#include <stdint.h>
+
 #include "mbedtls/bignum.h"
 #include "mbedtls/sha1.h"
 #include "mbedtls/sha256.h"
 #include "mbedtls/sha512.h"
 
+#ifdef SRP_PTHREAD
+#include <pthread.h>
+#endif
+
+/*
+ * Values that depend only on the group and the hash algorithm. They are
+ * built on first use by srp_ng_precomp() and reused for every handshake.
+ */
+typedef struct NGPrecomp {
+    int             ready;
+    mbedtls_mpi     k;                              /* k = H(N | PAD(g)) */
+    unsigned char   H_xor[SHA512_DIGEST_LENGTH];    /* H(N) xor H(g) */
+} NGPrecomp;
+
+/*
+ * Montgomery arithmetic for one odd modulus. mbedtls keeps its own helpers
+ * private, so the fixed base tables bring their own.
+ */
+typedef struct SRPMont {
+    size_t              n;      /* limbs in N */
+    mbedtls_mpi_uint    mm;     /* -N^-1 mod 2^biL */
+    mbedtls_mpi_uint    *N;     /* n limbs, own copy */
+    mbedtls_mpi_uint    *RR;    /* R^2 mod N, n limbs */
+    mbedtls_mpi_uint    *one;   /* R mod N, n limbs */
+    /* multiply and square, specialized for the size of N where possible */
+    void              (*mul)( mbedtls_mpi_uint *r, const mbedtls_mpi_uint *a, const mbedtls_mpi_uint *b,
+                              const struct SRPMont *m, mbedtls_mpi_uint *t );
+    void              (*sqr)( mbedtls_mpi_uint *r, const mbedtls_mpi_uint *a, const struct SRPMont *m,
+                              mbedtls_mpi_uint *t );
+    const char          *kernel;    /* "adx", "2048", "3072", "4096" or "any" */
+} SRPMont;
+
+/*
+ * Fixed base table: row i holds base^(j * 2^(i*w)) for j=0..2^w-1 in
+ * Montgomery form, every entry starting on its own cache line. It is never
+ * written after fixed_base_new() returns, so any number of threads may use
+ * it at once. Copies of an NGConstant share it through refs. A table
+ * loaded by srp_ng_load_tables() lives in a file mapping, unmap releases it.
+ */
+typedef struct SRPFixedBase {
+    int                 refs;
+    int                 w;          /* window bits */
+    int                 rows;
+    size_t              n;          /* limbs per entry */
+    size_t              stride;     /* limbs between entries */
+    mbedtls_mpi_uint    *tab;       /* SRP_CACHE_LINE aligned */
+    void                *mem;       /* what to free */
+    size_t              mem_len;
+    void              (*unmap)( void *mem, size_t len );    /* NULL: srp_free(mem) */
+} SRPFixedBase;
+
+#define SRP_CACHE_LINE 64
+
 struct NGConstant {
     mbedtls_mpi     *N;
     mbedtls_mpi     *g;
+    mbedtls_mpi     RR;     /* R^2 mod N, Montgomery speed-up for this N only */
+    NGPrecomp       pre[SRP_SHA_LAST];
+    SRPMont         *mont;  /* only set up once a table is requested */
+    SRPFixedBase    *gtab;  /* optional, see srp_ng_precompute_g() */
+    int             exp_bits;   /* size of a and b, see srp_ng_set_exponent_bits() */
+    int             refs;       /* srp_ng_new1() / srp_ng_delete(), atomic */
+    SRP_NGType      type;       /* the built-in group, or SRP_NG_CUSTOM */
+    NGConstant      *next;      /* registry of live groups, see srp_ng_new() */
+    int             interned;   /* in that registry, under its lock */
+#ifdef SRP_PTHREAD
+    pthread_mutex_t lock;   /* serializes the lazy build of pre[] */
+#endif
 } ;
 
 
-typedef struct NGHex {
-    const char * n_hex;
-    const char * g_hex;
-} NGHex;
+/* a built-in group as srp_groups.h (generated by gen_groups.c) ships it */
+typedef struct NGBuiltin {
+    const mbedtls_mpi_uint  *N;     /* limbs, least significant first */
+    const mbedtls_mpi_uint  *RR;    /* R^2 mod N, R = 2^(biL * limbs) */
+    const mbedtls_mpi_uint  *one;   /* R mod N */
+    size_t                  limbs;
+    mbedtls_mpi_uint        mm;     /* -N^-1 mod 2^biL */
+    unsigned int            g;
+    int                     bits;
+    int                     bytes;
+} NGBuiltin;
 
-struct SRPKeyPair {
-    mbedtls_mpi     *B;
-    mbedtls_mpi     *b;
-};
+/* state of the srp_hash.c implementations */
+typedef struct SRPShaState
+{
+    union {
+        uint32_t    w32[8];
+        uint64_t    w64[8];
+    } h;
+    uint64_t        len;            /* bytes so far */
+    unsigned char   buf[128];
+} SRPShaState;
+
+typedef struct SRPHashImpl SRPHashImpl;
 
-typedef union
+typedef struct
 {
-    mbedtls_sha1_context   sha;
-    mbedtls_sha256_context sha256;
-    mbedtls_sha512_context sha512;
+    const SRPHashImpl *impl;
+    union {
+        mbedtls_sha1_context   sha;
+        mbedtls_sha256_context sha256;
+        mbedtls_sha512_context sha512;
+        SRPShaState            acc;
+    } u;
 } HashCTX;
 
-struct SRPSession
+/* one per algorithm, see hash_impl() in srp.c */
+struct SRPHashImpl
 {
-    SRP_HashAlgorithm  hash_alg;
-    NGConstant   *ng;
+    const char *name;
+    void (*init)( HashCTX *c );
+    void (*update)( HashCTX *c, const void *data, size_t len );
+    void (*final)( HashCTX *c, unsigned char *md );
 };
 
-struct SRPVerifier
+struct SRPSession
 {
     SRP_HashAlgorithm  hash_alg;
-    NGConstant  *ng;
+    NGConstant   *ng;
+    int          exp_bits;      /* a and b, 0: the group's, see srp_session_set_exponent_bits() */
+};
 
-    const char          * username;
-    int                   authenticated;
 
-    unsigned char M           [SHA512_DIGEST_LENGTH];
-    unsigned char H_AMK       [SHA512_DIGEST_LENGTH];
-    unsigned char session_key [SHA512_DIGEST_LENGTH];
-};
+/*
+ * Shared between the srp*.c files, not API.
+ */
+#define SRP_BITS_IN_PRIVKEY 256   /* smallest default, see ng_default_exp_bits() */
+#define SRP_BYTES_IN_PRIVKEY (SRP_BITS_IN_PRIVKEY/8)
+#define SRP_MAX_N_BYTES (8192/8)    /* largest built-in group */
 
+/*
+ * Instrumentation hooks, see srp_set_phase_hooks(). Only the owning thread
+ * writes its counters, the relaxed store lets srp_stats_snapshot() read
+ * them from another thread without tearing.
+ */
+#ifdef SRP_STATS
+SRPStats *   srp_stats_thread( void );
+int          srp_stats_slot( const NGConstant *ng );
+void         srp_phase_begin( SRP_Phase phase );
+void         srp_phase_end( SRP_Phase phase );
 
-struct SRPUser
+static inline void srp_stat_add( unsigned long long *c, unsigned long long n )
 {
-    SRP_HashAlgorithm  hash_alg;
-    NGConstant  *ng;
+    __atomic_store_n(c, *c + n, __ATOMIC_RELAXED);
+}
 
-    mbedtls_mpi *a;
-    mbedtls_mpi *A;
-    mbedtls_mpi *S;
+#define SRP_STAT_ADD(field, n)  srp_stat_add(&srp_stats_thread()->field, (n))
+#define SRP_STAT_EXP(ng)        SRP_STAT_ADD(exp[srp_stats_slot(ng)], 1)
+#define SRP_PHASE_BEGIN(p)      srp_phase_begin(p)
+#define SRP_PHASE_END(p)        srp_phase_end(p)
+#else
+#define SRP_STAT_ADD(field, n)
+#define SRP_STAT_EXP(ng)
+#define SRP_PHASE_BEGIN(p)
+#define SRP_PHASE_END(p)
+#endif
 
-    int                   authenticated;
-
-    const char *          username;
-    const unsigned char * password;
-    int                   password_len;
+void *       srp_malloc( size_t size );
+void         srp_free( void *p );
+void *       srp_tmp_calloc( size_t n, size_t size );
+void         srp_tmp_free( void *p );
+void         srp_hash( SRP_HashAlgorithm alg, const unsigned char *d, size_t n, unsigned char *md );
+void         srp_hmac( SRP_HashAlgorithm alg, const unsigned char *key, size_t key_len,
+                       const unsigned char *d, size_t n, unsigned char *md );
+/* srp_hash.c: the fastest implementation of alg on this CPU, NULL for mbedtls */
+const SRPHashImpl * srp_hash_accel( SRP_HashAlgorithm alg );
+int          srp_fill_random( mbedtls_mpi *X, size_t size );
+int          srp_ng_exp_bytes( const NGConstant *ng );
+int          srp_session_exp_bytes( const SRPSession *session );
+/* like srp_ng_new() but never shared through the registry, e.g. to try kernels on */
+NGConstant * srp_ng_new_private( SRP_NGType ng_type, const char * n_hex, const char * g_hex );
+int          srp_random_bytes( unsigned char *buf, size_t len );
+NGPrecomp *  srp_ng_precomp( NGConstant *ng, SRP_HashAlgorithm alg );
+int          srp_ng_exp_g( NGConstant *ng, mbedtls_mpi *X, const mbedtls_mpi *E );
+int          srp_ng_exp_mod2( NGConstant *ng, mbedtls_mpi *X, const mbedtls_mpi *A, const mbedtls_mpi *a,
+                              const mbedtls_mpi *B, const mbedtls_mpi *b );
+int          srp_ng_exp_mod( NGConstant *ng, mbedtls_mpi *X, const mbedtls_mpi *A, const mbedtls_mpi *a );
+/*
+ * Name of the Montgomery kernel in use, NULL without one. Set it by name, -1
+ * if it does not fit or others share ng; ng leaves the registry then.
+ */
+const char * srp_ng_mont_kernel( const NGConstant *ng );
+int          srp_ng_set_mont_kernel( NGConstant *ng, const char *name );
+SRPFixedBase * srp_ng_table_new( NGConstant *ng, const mbedtls_mpi *base, int window_bits, int max_exp_bits );
+int          srp_ng_table_exp( NGConstant *ng, const SRPFixedBase *fb, mbedtls_mpi *X, const mbedtls_mpi *E );
+void         srp_ng_table_release( SRPFixedBase *fb );
+/*
+ * A reference on the table for g, NULL without one; release it with
+ * srp_ng_table_release(). set_gtab takes over the reference unless fb does
+ * not fit ng (-1), and may replace a table other threads are using.
+ * gtab_once builds a default table first if ng has none, NULL on failure.
+ */
+SRPFixedBase * srp_ng_gtab_get( NGConstant *ng );
+SRPFixedBase * srp_ng_gtab_once( NGConstant *ng );
+int          srp_ng_set_gtab( NGConstant *ng, SRPFixedBase *fb );
+SRPKeyPair * srp_keypair_new_from( SRPSession *session, mbedtls_mpi *b, mbedtls_mpi *gb,
+                                   const unsigned char * bytes_v, int len_v,
+                                   const unsigned char ** bytes_B, int * len_B );
+int          srp_user_x( SRPUser * usr, const unsigned char * bytes_s, int len_s, unsigned char * bytes_x );
+int          srp_salt( unsigned char * bytes_s, int len_s );
+int          srp_verification_key_x( SRPSession * session, const unsigned char * bytes_x, int len_x,
+                                     unsigned char * bytes_v, int * len_v );
+void         srp_user_process_challenge_kgx( SRPUser * usr,
+                                             const unsigned char * bytes_s, int len_s,
+                                             const unsigned char * bytes_B, int len_B,
+                                             const unsigned char ** bytes_M, int * len_M,
+                                             const mbedtls_mpi * kgx_in, mbedtls_mpi * kgx_out );
+int          srp_verifier_init_v( SRPVerifier * ver, SRPSession * session, const char * username,
+                                  const unsigned char * bytes_s, int len_s,
+                                  const unsigned char * bytes_A, int len_A,
+                                  unsigned char * bytes_B, int * len_B, SRPKeyPair * keys,
+                                  const mbedtls_mpi *v, const mbedtls_mpi *kv, const SRPFixedBase *vtab );
 
-    unsigned char M           [SHA512_DIGEST_LENGTH];
-    unsigned char H_AMK       [SHA512_DIGEST_LENGTH];
-    unsigned char session_key [SHA512_DIGEST_LENGTH];
-};
-#endif
\ No newline at end of file
+#endif
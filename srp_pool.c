@@ -0,0 +1,601 @@
+/*
+ * Secure Remote Password 6a implementation based on mbedtls.
+ *
+ * Copyright (c) 2019 Stoian Ivanov
+ * https://github.com/sdrsdr/mbedtls-csrp
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/*
+ * Thread based helpers on top of srp.c. Optional: only needed by programs
+ * that use the APIs below, and only builds with -DSRP_PTHREAD.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include "mbedtls/bignum.h"
+
+#include "srp.h"
+#include "srp_internal.h"
+#ifdef SRP_HASH_ACCEL
+#include "srp_hash.h"
+#endif
+
+#ifndef SRP_PTHREAD
+#error "srp_pool.c needs -DSRP_PTHREAD"
+#endif
+
+
+/***********************************************************************************************************
+ *
+ *  Server ephemeral key pool
+ *
+ ***********************************************************************************************************/
+
+typedef struct SRPKeyPoolEntry {
+	mbedtls_mpi b;
+	mbedtls_mpi gb;     /* g^b mod N */
+} SRPKeyPoolEntry;
+
+struct SRPKeyPool {
+	NGConstant        *ng;      /* own copy, shares the session's fixed base table */
+	int               exp_bytes; /* size of b, the session's at creation */
+	SRPKeyPoolEntry   *ring;
+	int               capacity;
+	int               head;     /* next entry to hand out */
+	int               count;
+	int               stop;
+	pthread_mutex_t   lock;
+	pthread_cond_t    not_full;
+	pthread_t         filler;
+};
+
+static void * keypool_filler( void *arg )
+{
+	SRPKeyPool *pool = (SRPKeyPool *) arg;
+	SRPKeyPoolEntry *e;
+	mbedtls_mpi b, gb;
+
+	mbedtls_mpi_init(&b);
+	mbedtls_mpi_init(&gb);
+
+	for (;;) {
+		int stop;
+		pthread_mutex_lock(&pool->lock);
+		while (!pool->stop && pool->count==pool->capacity) pthread_cond_wait(&pool->not_full, &pool->lock);
+		stop = pool->stop;
+		pthread_mutex_unlock(&pool->lock);
+		if (stop) break;
+
+		/* the expensive part runs unlocked */
+		if (srp_fill_random(&b, pool->exp_bytes)!=0) break;
+		if (srp_ng_exp_g(pool->ng, &gb, &b)!=0) break;
+
+		pthread_mutex_lock(&pool->lock);
+		e = &pool->ring[(pool->head + pool->count) % pool->capacity];
+		mbedtls_mpi_swap(&e->b, &b);
+		mbedtls_mpi_swap(&e->gb, &gb);
+		pool->count++;
+		pthread_mutex_unlock(&pool->lock);
+	}
+
+	mbedtls_mpi_free(&b);
+	mbedtls_mpi_free(&gb);
+	return NULL;
+}
+
+/* moves one (b, g^b) pair into b/gb, -1 when the pool is empty */
+static int keypool_take( SRPKeyPool *pool, mbedtls_mpi *b, mbedtls_mpi *gb )
+{
+	SRPKeyPoolEntry *e;
+
+	pthread_mutex_lock(&pool->lock);
+	if (pool->count==0) {
+		pthread_mutex_unlock(&pool->lock);
+		return -1;
+	}
+	e = &pool->ring[pool->head];
+	mbedtls_mpi_swap(&e->b, b);
+	mbedtls_mpi_swap(&e->gb, gb);
+	pool->head = (pool->head + 1) % pool->capacity;
+	pool->count--;
+	pthread_cond_signal(&pool->not_full);
+	pthread_mutex_unlock(&pool->lock);
+	return 0;
+}
+
+SRPKeyPool * srp_keypool_new( SRPSession *session, int capacity )
+{
+	SRPKeyPool *pool;
+	int i;
+
+	if (!session || capacity<=0) return NULL;
+
+	pool = (SRPKeyPool *) srp_malloc(sizeof(SRPKeyPool));
+	if (!pool) return NULL;
+	memset(pool, 0, sizeof(SRPKeyPool));
+	pool->capacity = capacity;
+	pool->exp_bytes = srp_session_exp_bytes(session);
+
+	pool->ng = srp_ng_new1(session->ng);
+	if (!pool->ng || !srp_ng_precomp(pool->ng, session->hash_alg)) goto err_exit;
+
+	pool->ring = (SRPKeyPoolEntry *) srp_malloc(capacity * sizeof(SRPKeyPoolEntry));
+	if (!pool->ring) goto err_exit;
+	for (i=0; i<capacity; i++) {
+		mbedtls_mpi_init(&pool->ring[i].b);
+		mbedtls_mpi_init(&pool->ring[i].gb);
+	}
+
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->not_full, NULL);
+	if (pthread_create(&pool->filler, NULL, keypool_filler, pool)!=0) {
+		pthread_cond_destroy(&pool->not_full);
+		pthread_mutex_destroy(&pool->lock);
+		goto err_exit;
+	}
+#ifdef SCHED_IDLE
+	{
+		/* only fill while the machine has nothing better to do */
+		struct sched_param sp;
+		memset(&sp, 0, sizeof(sp));
+		pthread_setschedparam(pool->filler, SCHED_IDLE, &sp);
+	}
+#endif
+	return pool;
+
+err_exit:
+	if (pool->ring) {
+		for (i=0; i<capacity; i++) {
+			mbedtls_mpi_free(&pool->ring[i].b);
+			mbedtls_mpi_free(&pool->ring[i].gb);
+		}
+		srp_free(pool->ring);
+	}
+	if (pool->ng) srp_ng_delete(pool->ng);
+	srp_free(pool);
+	return NULL;
+}
+
+void srp_keypool_delete( SRPKeyPool *pool )
+{
+	int i;
+
+	if (!pool) return;
+
+	pthread_mutex_lock(&pool->lock);
+	pool->stop = 1;
+	pthread_cond_broadcast(&pool->not_full);
+	pthread_mutex_unlock(&pool->lock);
+	pthread_join(pool->filler, NULL);
+
+	for (i=0; i<pool->capacity; i++) {
+		mbedtls_mpi_free(&pool->ring[i].b);
+		mbedtls_mpi_free(&pool->ring[i].gb);
+	}
+	srp_free(pool->ring);
+	srp_ng_delete(pool->ng);
+	pthread_cond_destroy(&pool->not_full);
+	pthread_mutex_destroy(&pool->lock);
+	memset(pool, 0, sizeof(SRPKeyPool));
+	srp_free(pool);
+}
+
+int srp_keypool_available( SRPKeyPool *pool )
+{
+	int n;
+	pthread_mutex_lock(&pool->lock);
+	n = pool->count;
+	pthread_mutex_unlock(&pool->lock);
+	return n;
+}
+
+SRPKeyPair * srp_keypair_new1( SRPSession *session, SRPKeyPool *pool,
+                               const unsigned char * bytes_v, int len_v,
+                               const unsigned char ** bytes_B, int * len_B )
+{
+	SRPKeyPair *keys;
+	mbedtls_mpi b, gb;
+
+	if (!session) return NULL;
+	if (!pool
+		|| mbedtls_mpi_cmp_mpi(pool->ng->N, session->ng->N)!=0
+		|| mbedtls_mpi_cmp_mpi(pool->ng->g, session->ng->g)!=0) {
+		return srp_keypair_new_from(session, NULL, NULL, bytes_v, len_v, bytes_B, len_B);
+	}
+
+	mbedtls_mpi_init(&b);
+	mbedtls_mpi_init(&gb);
+	if (keypool_take(pool, &b, &gb)==0) {
+		keys = srp_keypair_new_from(session, &b, &gb, bytes_v, len_v, bytes_B, len_B);
+	} else {
+		/* drained, e.g. right after a restart: compute inline */
+		keys = srp_keypair_new_from(session, NULL, NULL, bytes_v, len_v, bytes_B, len_B);
+	}
+	mbedtls_mpi_free(&b);
+	mbedtls_mpi_free(&gb);
+	return keys;
+}
+
+
+/***********************************************************************************************************
+ *
+ *  Worker pool and batch handshakes
+ *
+ ***********************************************************************************************************/
+
+/*
+ * One parallel-for: fn(arg, i) for i in [0, count). Threads claim indices
+ * with an atomic counter, so a slow item never holds up the rest.
+ */
+typedef struct SRPJob {
+	void            (*fn)( void *arg, int i );
+	void            *arg;
+	int             count;
+	int             next;       /* next unclaimed index, atomic */
+	int             done;       /* under pool->lock */
+	int             queued;     /* under pool->lock */
+	int             active;     /* pool threads inside job_run, under pool->lock */
+	struct SRPJob   *link;
+} SRPJob;
+
+struct SRPWorkerPool {
+	int               nthreads;
+	pthread_t         *threads;
+	SRPJob            *head;
+	SRPJob            *tail;
+	int               stop;
+	pthread_mutex_t   lock;
+	pthread_cond_t    work;
+	pthread_cond_t    finished;
+};
+
+static void job_unlink( SRPWorkerPool *pool, SRPJob *job )
+{
+	SRPJob **pp;
+
+	if (!job->queued) return;
+	for (pp=&pool->head; *pp; pp=&(*pp)->link) {
+		if (*pp==job) {
+			*pp = job->link;
+			break;
+		}
+	}
+	if (pool->tail==job) {
+		pool->tail = NULL;
+		for (pp=&pool->head; *pp; pp=&(*pp)->link) pool->tail = *pp;
+	}
+	job->queued = 0;
+}
+
+/*
+ * Runs items of job until none are left unclaimed. worker says whether the
+ * caller is a pool thread that registered itself in job->active.
+ */
+static void job_run( SRPWorkerPool *pool, SRPJob *job, int worker )
+{
+	int i, n = 0;
+
+	while ((i = __atomic_fetch_add(&job->next, 1, __ATOMIC_RELAXED)) < job->count) {
+		job->fn(job->arg, i);
+		n++;
+	}
+
+	pthread_mutex_lock(&pool->lock);
+	job_unlink(pool, job);
+	job->done += n;
+	if (worker) job->active--;
+	if (job->done==job->count && job->active==0) pthread_cond_broadcast(&pool->finished);
+	pthread_mutex_unlock(&pool->lock);
+}
+
+static void * worker_main( void *arg )
+{
+	SRPWorkerPool *pool = (SRPWorkerPool *) arg;
+	SRPJob *job;
+
+	for (;;) {
+		pthread_mutex_lock(&pool->lock);
+		while (!pool->stop && !pool->head) pthread_cond_wait(&pool->work, &pool->lock);
+		if (pool->stop) {
+			pthread_mutex_unlock(&pool->lock);
+			break;
+		}
+		/* the job lives on the submitter's stack: it waits for active to drop */
+		job = pool->head;
+		job->active++;
+		pthread_mutex_unlock(&pool->lock);
+		job_run(pool, job, 1);
+	}
+	return NULL;
+}
+
+SRPWorkerPool * srp_worker_pool_new( int nthreads )
+{
+	SRPWorkerPool *pool;
+	int i;
+
+	if (nthreads<=0) {
+		long n = sysconf(_SC_NPROCESSORS_ONLN);
+		nthreads = n>1 ? (int) n : 1;
+	}
+
+	pool = (SRPWorkerPool *) srp_malloc(sizeof(SRPWorkerPool));
+	if (!pool) return NULL;
+	memset(pool, 0, sizeof(SRPWorkerPool));
+
+	/* the calling thread works on its own batches too */
+	pool->threads = (pthread_t *) srp_malloc(nthreads * sizeof(pthread_t));
+	if (!pool->threads) {
+		srp_free(pool);
+		return NULL;
+	}
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->work, NULL);
+	pthread_cond_init(&pool->finished, NULL);
+
+	for (i=0; i<nthreads-1; i++) {
+		if (pthread_create(&pool->threads[i], NULL, worker_main, pool)!=0) break;
+	}
+	pool->nthreads = i;
+	return pool;
+}
+
+void srp_worker_pool_delete( SRPWorkerPool *pool )
+{
+	int i;
+
+	if (!pool) return;
+
+	pthread_mutex_lock(&pool->lock);
+	pool->stop = 1;
+	pthread_cond_broadcast(&pool->work);
+	pthread_mutex_unlock(&pool->lock);
+	for (i=0; i<pool->nthreads; i++) pthread_join(pool->threads[i], NULL);
+
+	srp_free(pool->threads);
+	pthread_cond_destroy(&pool->finished);
+	pthread_cond_destroy(&pool->work);
+	pthread_mutex_destroy(&pool->lock);
+	memset(pool, 0, sizeof(SRPWorkerPool));
+	srp_free(pool);
+}
+
+int srp_worker_pool_size( SRPWorkerPool *pool )
+{
+	return pool ? pool->nthreads + 1 : 1;
+}
+
+/* fn(arg, i) for every i in [0, count), returns once all calls are done */
+static void worker_pool_run( SRPWorkerPool *pool, void (*fn)( void *, int ), void *arg, int count )
+{
+	SRPJob job;
+	int i;
+
+	if (count<=0) return;
+	if (!pool || pool->nthreads==0 || count==1) {
+		for (i=0; i<count; i++) fn(arg, i);
+		return;
+	}
+
+	memset(&job, 0, sizeof(job));
+	job.fn = fn;
+	job.arg = arg;
+	job.count = count;
+
+	pthread_mutex_lock(&pool->lock);
+	job.queued = 1;
+	if (pool->tail) pool->tail->link = &job;
+	else pool->head = &job;
+	pool->tail = &job;
+	pthread_cond_broadcast(&pool->work);
+	pthread_mutex_unlock(&pool->lock);
+
+	job_run(pool, &job, 0);
+
+	pthread_mutex_lock(&pool->lock);
+	while (job.done!=job.count || job.active!=0) pthread_cond_wait(&pool->finished, &pool->lock);
+	pthread_mutex_unlock(&pool->lock);
+}
+
+typedef struct SRPBatch {
+	SRPSession     *session;
+	SRPBatchItem   *items;
+} SRPBatch;
+
+static void batch_one( void *arg, int i )
+{
+	SRPBatch *batch = (SRPBatch *) arg;
+	SRPBatchItem *it = &batch->items[i];
+
+	it->ver = srp_verifier_new1(batch->session, it->username, 1,
+		it->bytes_s, it->len_s, it->bytes_v, it->len_v, it->bytes_A, it->len_A,
+		&it->bytes_B, &it->len_B, NULL);
+}
+
+int srp_verifier_new_batch( SRPSession *session, SRPWorkerPool *pool, SRPBatchItem *items, int count )
+{
+	SRPBatch batch;
+	int i, ok = 0;
+
+	if (!session || (!items && count>0)) return -1;
+
+	/* build k, H(N)^H(g) and RR now rather than under the lock in every worker */
+	if (!srp_ng_precomp(session->ng, session->hash_alg)) return -1;
+
+	batch.session = session;
+	batch.items = items;
+	worker_pool_run(pool, batch_one, &batch, count);
+
+	for (i=0; i<count; i++) {
+		if (items[i].ver && items[i].bytes_B) ok++;
+	}
+	return ok;
+}
+
+typedef struct SRPEnrollBatch {
+	SRPSession     *session;
+	SRPEnrollItem  *items;
+	unsigned char  *xs;         /* len_x bytes of x per item */
+	int             len_x;
+} SRPEnrollBatch;
+
+static void enroll_one( void *arg, int i )
+{
+	SRPEnrollBatch *batch = (SRPEnrollBatch *) arg;
+	SRPEnrollItem *it = &batch->items[i];
+
+	it->status = srp_create_salted_verification_key2(batch->session, it->username,
+		it->password, it->len_password, it->bytes_s, it->len_s, it->bytes_v, &it->len_v);
+}
+
+#ifdef SRP_HASH_ACCEL
+/* status 1 until v is done: the salt is drawn and x still to be hashed */
+static void enroll_salt( void *arg, int i )
+{
+	SRPEnrollBatch *batch = (SRPEnrollBatch *) arg;
+	SRPEnrollItem *it = &batch->items[i];
+
+	it->status = it->username && it->len_password>=0 && (it->password || it->len_password==0)
+		&& it->bytes_s && it->bytes_v && srp_salt(it->bytes_s, it->len_s)==0 ? 1 : -1;
+}
+
+static void enroll_v( void *arg, int i )
+{
+	SRPEnrollBatch *batch = (SRPEnrollBatch *) arg;
+	SRPEnrollItem *it = &batch->items[i];
+
+	if (it->status!=1) return;
+	it->status = srp_verification_key_x(batch->session, batch->xs + (size_t) i * batch->len_x,
+		batch->len_x, it->bytes_v, &it->len_v);
+}
+
+/*
+ * x = H(s | H(I:P)) for every item with status 1, both rounds through
+ * srp_hash_batch() so the vector unit hashes 4 or 8 accounts at a time. The
+ * messages sit one after another in text, which is wiped: it holds passwords.
+ */
+static int enroll_hash_x( SRPEnrollBatch *batch, int count )
+{
+	SRPEnrollItem *items = batch->items;
+	const unsigned char **msg;
+	unsigned char **md, *text, *inner;
+	size_t *len, size = 0, off = 0;
+	int hlen = batch->len_x, i, n, rc = -1;
+
+	for (i=0; i<count; i++) {
+		if (items[i].status==1)
+			size += strlen(items[i].username) + 1 + items[i].len_password + items[i].len_s + hlen;
+	}
+	msg = (const unsigned char **) srp_malloc(count * sizeof(*msg));
+	md = (unsigned char **) srp_malloc(count * sizeof(*md));
+	len = (size_t *) srp_malloc(count * sizeof(*len));
+	text = (unsigned char *) srp_malloc(size + 1);
+	inner = (unsigned char *) srp_malloc((size_t) count * hlen);
+	batch->xs = (unsigned char *) srp_malloc((size_t) count * hlen);
+	if (!msg || !md || !len || !text || !inner || !batch->xs) goto cleanup;
+
+	/* H(I:P) */
+	for (i=0, n=0; i<count; i++) {
+		SRPEnrollItem *it = &items[i];
+		size_t ulen;
+
+		if (it->status!=1) continue;
+		ulen = strlen(it->username);
+		memcpy(text + off, it->username, ulen);
+		text[off + ulen] = ':';
+		if (it->len_password>0) memcpy(text + off + ulen + 1, it->password, it->len_password);
+		msg[n] = text + off;
+		len[n] = ulen + 1 + it->len_password;
+		md[n] = inner + (size_t) i * hlen;
+		off += len[n++];
+	}
+	srp_hash_batch(batch->session->hash_alg, msg, len, md, n);
+
+	/* H(s | H(I:P)), s without leading zeros like srp_create_salted_verification_key2() */
+	for (i=0, n=0; i<count; i++) {
+		SRPEnrollItem *it = &items[i];
+		const unsigned char *sp = it->bytes_s;
+		int slen = it->len_s;
+
+		if (it->status!=1) continue;
+		while (slen>0 && *sp==0) {
+			sp++;
+			slen--;
+		}
+		memcpy(text + off, sp, slen);
+		memcpy(text + off + slen, inner + (size_t) i * hlen, hlen);
+		msg[n] = text + off;
+		len[n] = slen + hlen;
+		md[n] = batch->xs + (size_t) i * hlen;
+		off += len[n++];
+	}
+	srp_hash_batch(batch->session->hash_alg, msg, len, md, n);
+	rc = 0;
+
+cleanup:
+	if (text) memset(text, 0, size + 1);
+	if (inner) memset(inner, 0, (size_t) count * hlen);
+	srp_free(text);
+	srp_free(inner);
+	srp_free(msg);
+	srp_free(md);
+	srp_free(len);
+	return rc;
+}
+#endif
+
+int srp_create_salted_verification_key_batch( SRPSession *session, SRPWorkerPool *pool, SRPEnrollItem *items, int count )
+{
+	SRPEnrollBatch batch;
+	int i, ok = 0;
+
+	if (!session || (!items && count>0)) return -1;
+	if (!srp_ng_precomp(session->ng, session->hash_alg)) return -1;
+
+	batch.session = session;
+	batch.items = items;
+	batch.xs = NULL;
+	batch.len_x = srp_session_get_key_length(session);
+#ifdef SRP_HASH_ACCEL
+	/* salts and v on the workers, the hashing in between on this thread */
+	worker_pool_run(pool, enroll_salt, &batch, count);
+	if (count>0 && enroll_hash_x(&batch, count)==0) worker_pool_run(pool, enroll_v, &batch, count);
+	else worker_pool_run(pool, enroll_one, &batch, count);
+	if (batch.xs) {
+		memset(batch.xs, 0, (size_t) count * batch.len_x);
+		srp_free(batch.xs);
+	}
+#else
+	worker_pool_run(pool, enroll_one, &batch, count);
+#endif
+
+	for (i=0; i<count; i++) {
+		if (items[i].status==0) ok++;
+	}
+	return ok;
+}
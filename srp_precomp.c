@@ -0,0 +1,240 @@
+/*
+ * Secure Remote Password 6a implementation based on mbedtls.
+ *
+ * Copyright (c) 2019 Stoian Ivanov
+ * https://github.com/sdrsdr/mbedtls-csrp
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+
+/*
+ * Table files, see srp_precomp.h. Layout, header integers little endian:
+ *
+ *   0     "SRPTABLE", u32 version, u32 0
+ *   16    SHA-256 of the file from offset 48 to the end
+ *   48    u32 bytes per limb, u32 0x01020304 in host byte order,
+ *         u32 window bits, u32 rows, u64 limbs per entry, u64 stride,
+ *         u64 table offset, u64 table size, u32 len_N, u32 len_g
+ *   104   N and g, big endian
+ *   4096  the entries of the SRPFixedBase as they are in memory
+ *
+ * The table starts on a page of its own, so the mapping can be used as it is.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "srp.h"
+#include "srp_internal.h"
+#include "srp_precomp.h"
+
+#define TABLE_MAGIC         "SRPTABLE"
+#define TABLE_VERSION       1
+#define TABLE_HEADER_SIZE   4096
+#define TABLE_SUM_FROM      48
+#define TABLE_FIELDS        104
+#define TABLE_ENDIAN        0x01020304u
+
+static uint64_t get_le( const unsigned char *p, int bytes )
+{
+	uint64_t v = 0;
+	int i;
+	for (i=bytes-1; i>=0; i--) v = v << 8 | p[i];
+	return v;
+}
+
+static void put_le( unsigned char *p, uint64_t v, int bytes )
+{
+	int i;
+	for (i=0; i<bytes; i++, v >>= 8) p[i] = (unsigned char) v;
+}
+
+static size_t table_bytes( const SRPFixedBase *fb )
+{
+	return ((size_t) fb->rows << fb->w) * fb->stride * sizeof(mbedtls_mpi_uint);
+}
+
+static void table_unmap( void *mem, size_t len )
+{
+	munmap(mem, len);
+}
+
+
+/***********************************************************************************************************
+ *
+ *  Writer
+ *
+ ***********************************************************************************************************/
+
+int srp_ng_save_tables( NGConstant *ng, const char *path )
+{
+	unsigned char *head = NULL, *map = NULL;
+	SRPFixedBase *fb;
+	uint32_t endian = TABLE_ENDIAN;
+	char *tmp = NULL;
+	FILE *f = NULL;
+	size_t len_N, size = 0;
+	int rc = -1;
+
+	if (!ng || !path || TABLE_FIELDS + 2 * (size_t) srp_ng_size(ng) > TABLE_HEADER_SIZE) return -1;
+	/* held until the file is written, in case the group gets a new table meanwhile */
+	if (!(fb = srp_ng_gtab_get(ng))) return -1;
+	len_N = (size_t) srp_ng_size(ng);
+
+	head = (unsigned char *) srp_malloc(TABLE_HEADER_SIZE);
+	tmp = (char *) srp_malloc(strlen(path) + 32);
+	if (!head || !tmp) goto cleanup;
+	memcpy(head, TABLE_MAGIC, 8);
+	put_le(head + 8, TABLE_VERSION, 4);
+	put_le(head + 48, sizeof(mbedtls_mpi_uint), 4);
+	memcpy(head + 52, &endian, 4);
+	put_le(head + 56, (uint64_t) fb->w, 4);
+	put_le(head + 60, (uint64_t) fb->rows, 4);
+	put_le(head + 64, fb->n, 8);
+	put_le(head + 72, fb->stride, 8);
+	put_le(head + 80, TABLE_HEADER_SIZE, 8);
+	put_le(head + 88, table_bytes(fb), 8);
+	put_le(head + 96, len_N, 4);
+	put_le(head + 100, len_N, 4);
+	if (mbedtls_mpi_write_binary(ng->N, head + TABLE_FIELDS, len_N) != 0 ||
+	    mbedtls_mpi_write_binary(ng->g, head + TABLE_FIELDS + len_N, len_N) != 0) goto cleanup;
+
+	/* a new file renamed over path, readers never see half of one */
+	sprintf(tmp, "%s.%ld.tmp", path, (long) getpid());
+	f = fopen(tmp, "w+b");
+	if (!f) goto cleanup;
+	if (fwrite(head, 1, TABLE_HEADER_SIZE, f) != TABLE_HEADER_SIZE
+		|| fwrite(fb->tab, 1, table_bytes(fb), f) != table_bytes(fb)
+		|| fflush(f) != 0) goto cleanup;
+
+	size = TABLE_HEADER_SIZE + table_bytes(fb);
+	map = (unsigned char *) mmap(NULL, size, PROT_READ, MAP_SHARED, fileno(f), 0);
+	if (map == MAP_FAILED) {
+		map = NULL;
+		goto cleanup;
+	}
+	srp_hash(SRP_SHA256, map + TABLE_SUM_FROM, size - TABLE_SUM_FROM, head + 16);
+	if (fseek(f, 16, SEEK_SET) != 0 || fwrite(head + 16, 1, 32, f) != 32 || fflush(f) != 0) goto cleanup;
+	if (fsync(fileno(f)) != 0) goto cleanup;
+	rc = 0;
+
+cleanup:
+	if (map) munmap(map, size);
+	if (f && fclose(f) != 0) rc = -1;
+	if (f) {
+		if (rc == 0 && rename(tmp, path) != 0) rc = -1;
+		if (rc != 0) remove(tmp);
+	}
+	srp_free(head);
+	srp_free(tmp);
+	srp_ng_table_release(fb);
+	return rc;
+}
+
+
+/***********************************************************************************************************
+ *
+ *  Reader
+ *
+ ***********************************************************************************************************/
+
+int srp_ng_load_tables( NGConstant *ng, const char *path )
+{
+	unsigned char md[SHA256_DIGEST_LENGTH];
+	unsigned char buf[2 * SRP_MAX_N_BYTES];
+	const size_t line = SRP_CACHE_LINE / sizeof(mbedtls_mpi_uint);
+	const unsigned char *map;
+	SRPFixedBase *fb = NULL;
+	struct stat sb;
+	uint32_t endian;
+	uint64_t w, rows, n, stride, offset, bytes, len_N, len_g;
+	size_t size;
+	int fd;
+
+	if (!ng || !path) return -1;
+	fd = open(path, O_RDONLY);
+	if (fd < 0) return -1;
+	if (fstat(fd, &sb) != 0 || (uint64_t) sb.st_size < TABLE_HEADER_SIZE) {
+		close(fd);
+		return -1;
+	}
+	size = (size_t) sb.st_size;
+	map = (const unsigned char *) mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) return -1;
+
+	memcpy(&endian, map + 52, 4);
+	w      = get_le(map + 56, 4);
+	rows   = get_le(map + 60, 4);
+	n      = get_le(map + 64, 8);
+	stride = get_le(map + 72, 8);
+	offset = get_le(map + 80, 8);
+	bytes  = get_le(map + 88, 8);
+	len_N  = get_le(map + 96, 4);
+	len_g  = get_le(map + 100, 4);
+	if (memcmp(map, TABLE_MAGIC, 8) != 0 || get_le(map + 8, 4) != TABLE_VERSION
+		|| get_le(map + 48, 4) != sizeof(mbedtls_mpi_uint) || endian != TABLE_ENDIAN
+		|| w < 1 || w > 8 || rows == 0 || n == 0 || n > SRP_MAX_N_BYTES / sizeof(mbedtls_mpi_uint)
+		|| stride != (n + line - 1) / line * line || offset != TABLE_HEADER_SIZE
+		|| len_N > SRP_MAX_N_BYTES || len_N != (uint64_t) srp_ng_size(ng) || len_g != len_N
+		|| bytes != (rows << w) * stride * sizeof(mbedtls_mpi_uint) || offset + bytes != size) {
+		goto err_exit;
+	}
+
+	/* the right group, then the contents */
+	if (mbedtls_mpi_write_binary(ng->N, buf, len_N) != 0 || mbedtls_mpi_write_binary(ng->g, buf + len_N, len_N) != 0
+		|| memcmp(buf, map + TABLE_FIELDS, 2 * len_N) != 0) {
+		goto err_exit;
+	}
+	srp_hash(SRP_SHA256, map + TABLE_SUM_FROM, size - TABLE_SUM_FROM, md);
+	if (memcmp(md, map + 16, sizeof(md)) != 0) goto err_exit;
+
+	fb = (SRPFixedBase *) srp_malloc(sizeof(SRPFixedBase));
+	if (!fb) goto err_exit;
+	fb->refs    = 1;
+	fb->w       = (int) w;
+	fb->rows    = (int) rows;
+	fb->n       = (size_t) n;
+	fb->stride  = (size_t) stride;
+	fb->tab     = (mbedtls_mpi_uint *)(map + offset);
+	fb->mem     = (void *) map;
+	fb->mem_len = size;
+	fb->unmap   = table_unmap;
+	/* locked swap; readers of the old table hold references of their own */
+	if (srp_ng_set_gtab(ng, fb) != 0) {
+		/* releases the mapping too */
+		srp_ng_table_release(fb);
+		return -1;
+	}
+	return 0;
+
+err_exit:
+	munmap((void *) map, size);
+	return -1;
+}
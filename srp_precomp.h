@@ -0,0 +1,71 @@
+#ifndef SRP_PRECOMP_H
+#define SRP_PRECOMP_H
+
+/*
+ * Secure Remote Password 6a implementation based on mbedtls.
+ *
+ * Copyright (c) 2019 Stoian Ivanov
+ * https://github.com/sdrsdr/mbedtls-csrp
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/*
+ * Precomputed tables on disk. srp_ng_save_tables() writes the table for g
+ * that srp_ng_precompute_g() built; srp_ng_load_tables() maps such a file
+ * read only and hands it to the group, so many processes on one host share
+ * a single copy through the page cache and a restart costs a file map and
+ * a checksum instead of building the table. Needs srp_precomp.c and a
+ * POSIX system.
+ *
+ *   if (srp_ng_load_tables( ng, path ) != 0) {
+ *       srp_ng_precompute_g( ng, 0, 0 );
+ *       srp_ng_save_tables( ng, path );
+ *   }
+ *
+ * A file belongs to one group (N and g) and to the limb size and byte
+ * order of the host that wrote it. It carries a format version and a
+ * SHA-256 over its contents; a file that does not match is refused.
+ */
+
+#include "srp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Writes a new file and rename()s it over path. -1 if ng has no table */
+int srp_ng_save_tables( NGConstant * ng, const char * path );
+
+/*
+ * 0 when path holds a valid table for ng, which ng then uses. May be called
+ * while other threads use ng: a table ng already has is replaced the way
+ * srp_ng_precompute_g() replaces it, and unmapped or freed once the
+ * exponentiations still reading it are done.
+ */
+int srp_ng_load_tables( NGConstant * ng, const char * path );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,375 @@
+/*
+ * Secure Remote Password 6a implementation based on mbedtls.
+ *
+ * Copyright (c) 2019 Stoian Ivanov
+ * https://github.com/sdrsdr/mbedtls-csrp
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/*
+ * Verifier store, see srp_store.h. File layout, all integers little endian:
+ *
+ *   header   64 bytes    "SRPSTORE", u32 version, u32 0, u64 records_end,
+ *                        u64 index_offset, u64 index_slots, u64 count,
+ *                        u64 nrecords, u64 0
+ *   records  at 64       u16 len_username (with NUL), u8 ng_type, u8 hash_alg,
+ *                        u16 len_s, u16 len_v, username, s, v, zero padded
+ *                        to a multiple of 8
+ *   index    at index_offset, index_slots (a power of two) slots of
+ *                        u64 record offset (0: empty), u64 FNV-1a of username
+ *
+ * The index is kept at most half full and probed linearly.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "srp.h"
+#include "srp_internal.h"
+#include "srp_store.h"
+
+#define STORE_MAGIC         "SRPSTORE"
+#define STORE_VERSION       1
+#define STORE_HEADER_SIZE   64
+#define STORE_RECORD_HEAD   8
+#define STORE_SLOT_SIZE     16
+
+struct SRPStore {
+	const unsigned char   *map;
+	size_t                size;
+	uint64_t              records_end;
+	const unsigned char   *index;
+	uint64_t              mask;         /* index_slots - 1 */
+	uint64_t              count;
+};
+
+struct SRPStoreWriter {
+	FILE                  *f;
+	uint64_t              end;          /* where the next record goes */
+};
+
+static uint64_t get_le16( const unsigned char *p )
+{
+	return (uint64_t)p[0] | (uint64_t)p[1] << 8;
+}
+
+static uint64_t get_le64( const unsigned char *p )
+{
+	uint64_t v = 0;
+	int i;
+	for (i=7; i>=0; i--) v = v << 8 | p[i];
+	return v;
+}
+
+static void put_le16( unsigned char *p, uint64_t v )
+{
+	p[0] = (unsigned char) v;
+	p[1] = (unsigned char)(v >> 8);
+}
+
+static void put_le64( unsigned char *p, uint64_t v )
+{
+	int i;
+	for (i=0; i<8; i++, v >>= 8) p[i] = (unsigned char) v;
+}
+
+static uint64_t store_hash( const char *s, size_t len )
+{
+	uint64_t h = 14695981039346656037ULL;
+	size_t i;
+	for (i=0; i<len; i++) {
+		h ^= (unsigned char) s[i];
+		h *= 1099511628211ULL;
+	}
+	return h;
+}
+
+/* parses the record at off, -1 if it does not fit before end. *size gets its padded size */
+static int record_at( const unsigned char *map, uint64_t end, uint64_t off, SRPStoreRecord *rec, uint64_t *size )
+{
+	const unsigned char *p;
+	uint64_t ulen, len_s, len_v, total;
+
+	if (off < STORE_HEADER_SIZE || off > end || end - off < STORE_RECORD_HEAD) return -1;
+	p = map + off;
+	ulen  = get_le16(p);
+	len_s = get_le16(p + 4);
+	len_v = get_le16(p + 6);
+	total = STORE_RECORD_HEAD + ulen + len_s + len_v;
+	if (ulen == 0 || total > end - off || p[STORE_RECORD_HEAD + ulen - 1] != 0) return -1;
+
+	rec->username = (const char *)(p + STORE_RECORD_HEAD);
+	rec->ng_type  = (SRP_NGType) p[2];
+	rec->hash_alg = (SRP_HashAlgorithm) p[3];
+	rec->bytes_s  = p + STORE_RECORD_HEAD + ulen;
+	rec->len_s    = (int) len_s;
+	rec->bytes_v  = rec->bytes_s + len_s;
+	rec->len_v    = (int) len_v;
+	if (size) *size = (total + 7) & ~(uint64_t)7;
+	return 0;
+}
+
+
+/***********************************************************************************************************
+ *
+ *  Reader
+ *
+ ***********************************************************************************************************/
+
+SRPStore * srp_store_open( const char *path )
+{
+	SRPStore *st;
+	struct stat sb;
+	const unsigned char *map;
+	uint64_t index_offset, slots;
+	int fd;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0) return NULL;
+	if (fstat(fd, &sb) != 0 || (uint64_t)sb.st_size < STORE_HEADER_SIZE) {
+		close(fd);
+		return NULL;
+	}
+	map = (const unsigned char *) mmap(NULL, (size_t)sb.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) return NULL;
+
+	st = (SRPStore *) srp_malloc(sizeof(SRPStore));
+	if (!st) goto err_exit;
+	st->map  = map;
+	st->size = (size_t) sb.st_size;
+
+	index_offset    = get_le64(map + 24);
+	slots           = get_le64(map + 32);
+	st->records_end = get_le64(map + 16);
+	st->count       = get_le64(map + 40);
+	if (memcmp(map, STORE_MAGIC, 8) != 0 || get_le64(map + 8) != STORE_VERSION
+		|| st->records_end < STORE_HEADER_SIZE || st->records_end > index_offset
+		|| slots == 0 || (slots & (slots - 1)) != 0
+		|| index_offset > st->size || slots > (st->size - index_offset) / STORE_SLOT_SIZE) {
+		goto err_exit;
+	}
+	st->index = map + index_offset;
+	st->mask  = slots - 1;
+
+#ifdef MADV_RANDOM
+	/* lookups hop all over a large file, read ahead would only waste memory */
+	madvise((void *) map, st->size, MADV_RANDOM);
+#endif
+	return st;
+
+err_exit:
+	srp_free(st);
+	munmap((void *) map, (size_t) sb.st_size);
+	return NULL;
+}
+
+void srp_store_close( SRPStore *st )
+{
+	if (!st) return;
+	munmap((void *) st->map, st->size);
+	srp_free(st);
+}
+
+size_t srp_store_count( SRPStore *st )
+{
+	return st ? (size_t) st->count : 0;
+}
+
+int srp_store_lookup( SRPStore *st, const char *username, SRPStoreRecord *rec )
+{
+	size_t len;
+	uint64_t h, i, n, off;
+	const unsigned char *slot;
+
+	if (!st || !username || !rec) return -1;
+	len = strlen(username);
+	h = store_hash(username, len);
+
+	for (i = h & st->mask, n = 0; n <= st->mask; i = (i + 1) & st->mask, n++) {
+		slot = st->index + i * STORE_SLOT_SIZE;
+		off = get_le64(slot);
+		if (off == 0) break;
+		if (get_le64(slot + 8) != h) continue;
+		if (record_at(st->map, st->records_end, off, rec, NULL) != 0) break;
+		if (get_le16(st->map + off) == len + 1 && memcmp(rec->username, username, len) == 0) return 0;
+	}
+	memset(rec, 0, sizeof(SRPStoreRecord));
+	return -1;
+}
+
+
+/***********************************************************************************************************
+ *
+ *  Writer
+ *
+ ***********************************************************************************************************/
+
+SRPStoreWriter * srp_store_writer_open( const char *path )
+{
+	SRPStoreWriter *w;
+	unsigned char head[STORE_HEADER_SIZE];
+	size_t got;
+
+	w = (SRPStoreWriter *) srp_malloc(sizeof(SRPStoreWriter));
+	if (!w) return NULL;
+
+	w->f = fopen(path, "r+b");
+	if (!w->f) w->f = fopen(path, "w+b");
+	if (!w->f) goto err_exit;
+
+	got = fread(head, 1, sizeof(head), w->f);
+	if (got == 0) {
+		/* new file, the header is written on close */
+		memset(head, 0, sizeof(head));
+		if (fwrite(head, 1, sizeof(head), w->f) != sizeof(head)) goto err_exit;
+		w->end = STORE_HEADER_SIZE;
+	} else {
+		if (got != sizeof(head) || memcmp(head, STORE_MAGIC, 8) != 0 || get_le64(head + 8) != STORE_VERSION) goto err_exit;
+		/* drop the old index, close() writes a new one after the new records */
+		w->end = get_le64(head + 16);
+		if (fflush(w->f) != 0 || ftruncate(fileno(w->f), (off_t) w->end) != 0) goto err_exit;
+	}
+	if (fseek(w->f, (long) w->end, SEEK_SET) != 0) goto err_exit;
+	return w;
+
+err_exit:
+	if (w->f) fclose(w->f);
+	srp_free(w);
+	return NULL;
+}
+
+int srp_store_writer_add( SRPStoreWriter *w, const char *username,
+	SRP_NGType ng_type, SRP_HashAlgorithm hash_alg,
+	const unsigned char *bytes_s, int len_s, const unsigned char *bytes_v, int len_v )
+{
+	static const unsigned char zeros[8] = { 0 };
+	unsigned char head[STORE_RECORD_HEAD];
+	size_t ulen;
+	uint64_t total, pad;
+
+	if (!w || !username) return -1;
+	ulen = strlen(username) + 1;
+	if (ulen > 0xffff || len_s < 0 || len_s > 0xffff || len_v < 0 || len_v > 0xffff) return -1;
+	if ((unsigned) ng_type >= (unsigned) SRP_NG_LAST || (unsigned) hash_alg >= (unsigned) SRP_SHA_LAST) return -1;
+
+	put_le16(head, ulen);
+	head[2] = (unsigned char) ng_type;
+	head[3] = (unsigned char) hash_alg;
+	put_le16(head + 4, (uint64_t) len_s);
+	put_le16(head + 6, (uint64_t) len_v);
+	total = STORE_RECORD_HEAD + ulen + len_s + len_v;
+	pad = ((total + 7) & ~(uint64_t)7) - total;
+
+	if (fwrite(head, 1, sizeof(head), w->f) != sizeof(head)
+		|| fwrite(username, 1, ulen, w->f) != ulen
+		|| fwrite(bytes_s, 1, len_s, w->f) != (size_t) len_s
+		|| fwrite(bytes_v, 1, len_v, w->f) != (size_t) len_v
+		|| fwrite(zeros, 1, pad, w->f) != pad) {
+		return -1;
+	}
+	w->end += total + pad;
+	return 0;
+}
+
+int srp_store_writer_close( SRPStoreWriter *w )
+{
+	unsigned char head[STORE_HEADER_SIZE];
+	unsigned char *map = NULL;
+	unsigned char *index = NULL;
+	SRPStoreRecord rec, other;
+	uint64_t off, size, nrecords = 0, count = 0, slots, mask, h, i;
+	int rc = -1;
+
+	if (!w) return -1;
+	if (fflush(w->f) != 0) goto cleanup;
+
+	map = (unsigned char *) mmap(NULL, (size_t) w->end, PROT_READ, MAP_SHARED, fileno(w->f), 0);
+	if (map == MAP_FAILED) {
+		map = NULL;
+		goto cleanup;
+	}
+
+	for (off = STORE_HEADER_SIZE; off < w->end; off += size) {
+		if (record_at(map, w->end, off, &rec, &size) != 0) goto cleanup;
+		nrecords++;
+	}
+	for (slots = 16; slots < 2 * nrecords; slots <<= 1) ;
+	mask = slots - 1;
+
+	index = (unsigned char *) srp_malloc(slots * STORE_SLOT_SIZE);
+	if (!index) goto cleanup;
+	memset(index, 0, slots * STORE_SLOT_SIZE);
+
+	/* in file order, so a later record for a username replaces the earlier one */
+	for (off = STORE_HEADER_SIZE; off < w->end; off += size) {
+		record_at(map, w->end, off, &rec, &size);
+		h = store_hash(rec.username, strlen(rec.username));
+		for (i = h & mask; ; i = (i + 1) & mask) {
+			unsigned char *slot = index + i * STORE_SLOT_SIZE;
+			uint64_t o = get_le64(slot);
+			if (o == 0) {
+				put_le64(slot, off);
+				put_le64(slot + 8, h);
+				count++;
+				break;
+			}
+			if (get_le64(slot + 8) == h) {
+				record_at(map, w->end, o, &other, NULL);
+				if (strcmp(other.username, rec.username) == 0) {
+					put_le64(slot, off);
+					break;
+				}
+			}
+		}
+	}
+
+	if (fseek(w->f, (long) w->end, SEEK_SET) != 0) goto cleanup;
+	if (fwrite(index, STORE_SLOT_SIZE, slots, w->f) != slots) goto cleanup;
+
+	memset(head, 0, sizeof(head));
+	memcpy(head, STORE_MAGIC, 8);
+	put_le64(head + 8, STORE_VERSION);
+	put_le64(head + 16, w->end);
+	put_le64(head + 24, w->end);
+	put_le64(head + 32, slots);
+	put_le64(head + 40, count);
+	put_le64(head + 48, nrecords);
+	if (fseek(w->f, 0, SEEK_SET) != 0) goto cleanup;
+	if (fwrite(head, 1, sizeof(head), w->f) != sizeof(head)) goto cleanup;
+	if (fflush(w->f) != 0 || fsync(fileno(w->f)) != 0) goto cleanup;
+	rc = 0;
+
+cleanup:
+	if (map) munmap(map, (size_t) w->end);
+	srp_free(index);
+	if (fclose(w->f) != 0) rc = -1;
+	srp_free(w);
+	return rc;
+}
@@ -0,0 +1,93 @@
+#ifndef SRP_STORE_H
+#define SRP_STORE_H
+
+/*
+ * Secure Remote Password 6a implementation based on mbedtls.
+ *
+ * Copyright (c) 2019 Stoian Ivanov
+ * https://github.com/sdrsdr/mbedtls-csrp
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/*
+ * Verifier store: a binary file of (username, group, hash, salt, v) records
+ * followed by an open addressing hash index on username. Readers mmap it
+ * read only; a lookup is a few memory reads and returns pointers into the
+ * mapping. Needs srp_store.c and a POSIX system.
+ *
+ * Records are only ever appended. A later record for the same username
+ * replaces the earlier one in the index. The index is rebuilt when a writer
+ * closes, so do not append in place while readers have the file open: write
+ * a copy and rename() it over, then reopen.
+ */
+
+#include "srp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct SRPStore SRPStore;
+typedef struct SRPStoreWriter SRPStoreWriter;
+
+/*
+ * One record. All pointers point into the mapping and stay valid until
+ * srp_store_close(); username is NUL terminated, so the fields can go
+ * straight into srp_verifier_new1(..., copy_username=0, ...).
+ */
+typedef struct SRPStoreRecord {
+    const char          * username;
+    SRP_NGType            ng_type;
+    SRP_HashAlgorithm     hash_alg;
+    const unsigned char * bytes_s;
+    int                   len_s;
+    const unsigned char * bytes_v;
+    int                   len_v;
+} SRPStoreRecord;
+
+/* NULL if the file is missing, truncated or not a store */
+SRPStore * srp_store_open( const char * path );
+void       srp_store_close( SRPStore * st );
+
+/* number of distinct usernames */
+size_t     srp_store_count( SRPStore * st );
+
+/* 0 and *rec filled when username is present, -1 otherwise */
+int        srp_store_lookup( SRPStore * st, const char * username, SRPStoreRecord * rec );
+
+/* Creates path, or reopens it to append */
+SRPStoreWriter * srp_store_writer_open( const char * path );
+
+int        srp_store_writer_add( SRPStoreWriter * w, const char * username,
+                                 SRP_NGType ng_type, SRP_HashAlgorithm hash_alg,
+                                 const unsigned char * bytes_s, int len_s,
+                                 const unsigned char * bytes_v, int len_v );
+
+/* Writes the index and header, then frees w. Returns 0 on success */
+int        srp_store_writer_close( SRPStoreWriter * w );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
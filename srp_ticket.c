@@ -0,0 +1,414 @@
+/*
+ * Secure Remote Password 6a implementation based on mbedtls.
+ *
+ * Copyright (c) 2019 Stoian Ivanov
+ * https://github.com/sdrsdr/mbedtls-csrp
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+
+/*
+ * Session resumption tickets, see srp_ticket.h.
+ *
+ * Ticket: id[4] | iv[12] | AES-256-GCM(plain) | tag[16], with the key id as
+ * additional data. plain: version | hash | issued[8] | ulen | username | secret
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#ifdef SRP_PTHREAD
+#include <pthread.h>
+#endif
+
+#include "mbedtls/gcm.h"
+
+#include "srp.h"
+#include "srp_internal.h"
+#include "srp_ticket.h"
+
+#define TICKET_VERSION  1
+#define TICKET_IV       12
+#define TICKET_TAG      16
+#define TICKET_HEAD     (4 + TICKET_IV)
+#define TICKET_PLAIN    11      /* fixed part of plain */
+
+typedef struct SRPTicketKey {
+	unsigned int    id;
+	time_t          created;
+	int             used;
+	unsigned char   key[SRP_TICKET_KEY_BYTES];
+} SRPTicketKey;
+
+struct SRPTicketKeys {
+	int             lifetime;
+	int             rotation;
+	int             count;
+	SRPTicketKey    *keys;
+#ifdef SRP_PTHREAD
+	pthread_mutex_t lock;
+#endif
+};
+
+static void keys_lock( SRPTicketKeys *tk )
+{
+#ifdef SRP_PTHREAD
+	pthread_mutex_lock(&tk->lock);
+#else
+	(void) tk;
+#endif
+}
+
+static void keys_unlock( SRPTicketKeys *tk )
+{
+#ifdef SRP_PTHREAD
+	pthread_mutex_unlock(&tk->lock);
+#else
+	(void) tk;
+#endif
+}
+
+SRPTicketKeys * srp_ticket_keys_new( int lifetime, int rotation )
+{
+	SRPTicketKeys *tk;
+
+	if (lifetime<=0) return NULL;
+
+	tk = (SRPTicketKeys *) srp_malloc(sizeof(SRPTicketKeys));
+	if (!tk) return NULL;
+	tk->lifetime = lifetime;
+	tk->rotation = rotation;
+	/* keys are made at least rotation apart, so this many cover every live ticket */
+	tk->count = rotation>0 ? lifetime / rotation + 2 : 4;
+	tk->keys = (SRPTicketKey *) srp_malloc(tk->count * sizeof(SRPTicketKey));
+	if (!tk->keys) {
+		srp_free(tk);
+		return NULL;
+	}
+#ifdef SRP_PTHREAD
+	pthread_mutex_init(&tk->lock, NULL);
+#endif
+	return tk;
+}
+
+void srp_ticket_keys_delete( SRPTicketKeys *tk )
+{
+	if (!tk) return;
+#ifdef SRP_PTHREAD
+	pthread_mutex_destroy(&tk->lock);
+#endif
+	memset(tk->keys, 0, tk->count * sizeof(SRPTicketKey));
+	srp_free(tk->keys);
+	srp_free(tk);
+}
+
+/* under the lock: the key that issues, NULL if there is none */
+static SRPTicketKey * keys_newest( SRPTicketKeys *tk )
+{
+	SRPTicketKey *k = NULL;
+	int i;
+
+	for (i=0; i<tk->count; i++) {
+		if (tk->keys[i].used && (!k || tk->keys[i].created > k->created)) k = &tk->keys[i];
+	}
+	return k;
+}
+
+/* under the lock: a free slot, or the one of the oldest key */
+static SRPTicketKey * keys_slot( SRPTicketKeys *tk )
+{
+	SRPTicketKey *k = &tk->keys[0];
+	int i;
+
+	for (i=0; i<tk->count; i++) {
+		if (!tk->keys[i].used) return &tk->keys[i];
+		if (tk->keys[i].created < k->created) k = &tk->keys[i];
+	}
+	return k;
+}
+
+static SRPTicketKey * keys_find( SRPTicketKeys *tk, unsigned int id )
+{
+	int i;
+
+	for (i=0; i<tk->count; i++) {
+		if (tk->keys[i].used && tk->keys[i].id==id) return &tk->keys[i];
+	}
+	return NULL;
+}
+
+int srp_ticket_keys_add( SRPTicketKeys *tk, unsigned int id,
+	const unsigned char *key, int len_key, time_t created )
+{
+	SRPTicketKey *k;
+
+	if (!tk || !key || len_key!=SRP_TICKET_KEY_BYTES) return -1;
+
+	keys_lock(tk);
+	k = keys_find(tk, id);
+	if (!k) k = keys_slot(tk);
+	k->id = id;
+	k->created = created;
+	k->used = 1;
+	memcpy(k->key, key, SRP_TICKET_KEY_BYTES);
+	keys_unlock(tk);
+	return 0;
+}
+
+/* copies the key that issues at now into out, rotating first when it is due */
+static int keys_current( SRPTicketKeys *tk, time_t now, SRPTicketKey *out )
+{
+	SRPTicketKey *k, fresh;
+	int rc = -1;
+
+	keys_lock(tk);
+	k = keys_newest(tk);
+	if (tk->rotation>0 && (!k || now - k->created >= tk->rotation)) {
+		do {
+			if (srp_random_bytes((unsigned char *) &fresh.id, sizeof(fresh.id))!=0) goto done;
+		} while (keys_find(tk, fresh.id));
+		if (srp_random_bytes(fresh.key, SRP_TICKET_KEY_BYTES)!=0) goto done;
+		fresh.created = now;
+		fresh.used = 1;
+		k = keys_slot(tk);
+		*k = fresh;
+	}
+	if (k) {
+		*out = *k;
+		rc = 0;
+	}
+done:
+	keys_unlock(tk);
+	memset(&fresh, 0, sizeof(fresh));
+	return rc;
+}
+
+static int keys_get( SRPTicketKeys *tk, unsigned int id, SRPTicketKey *out )
+{
+	SRPTicketKey *k;
+
+	keys_lock(tk);
+	k = keys_find(tk, id);
+	if (k) *out = *k;
+	keys_unlock(tk);
+	return k ? 0 : -1;
+}
+
+static void put_be32( unsigned char *p, unsigned int v )
+{
+	p[0] = (unsigned char)(v >> 24);
+	p[1] = (unsigned char)(v >> 16);
+	p[2] = (unsigned char)(v >> 8);
+	p[3] = (unsigned char) v;
+}
+
+static unsigned int get_be32( const unsigned char *p )
+{
+	return ((unsigned int) p[0] << 24) | ((unsigned int) p[1] << 16) | ((unsigned int) p[2] << 8) | p[3];
+}
+
+/* HMAC(session_key, label): what the ticket carries instead of the key itself */
+static void resumption_secret( SRP_HashAlgorithm alg, const unsigned char *session_key, int len,
+	unsigned char *secret )
+{
+	static const unsigned char label[] = "srp resumption secret";
+
+	srp_hmac(alg, session_key, len, label, sizeof(label) - 1, secret);
+}
+
+/*
+ * Both ends of a resumption: the new session key and the two proofs, each
+ * an HMAC under the secret over the nonces of both sides.
+ */
+static void resumption_keys( SRP_HashAlgorithm alg, const unsigned char *secret, int len,
+	const unsigned char *nonce_c, const unsigned char *nonce_s,
+	unsigned char *key, unsigned char *M, unsigned char *H_AMK )
+{
+	unsigned char msg[8 + 2 * SRP_TICKET_NONCE_BYTES + SHA512_DIGEST_LENGTH];
+	unsigned char *p = msg + 8;
+
+	memcpy(p, nonce_c, SRP_TICKET_NONCE_BYTES);
+	memcpy(p + SRP_TICKET_NONCE_BYTES, nonce_s, SRP_TICKET_NONCE_BYTES);
+	p += 2 * SRP_TICKET_NONCE_BYTES;
+
+	memcpy(msg, "srp key ", 8);
+	srp_hmac(alg, secret, len, msg, p - msg, key);
+	memcpy(msg, "srp user", 8);
+	srp_hmac(alg, secret, len, msg, p - msg, M);
+	memcpy(msg, "srp host", 8);
+	memcpy(p, M, len);
+	srp_hmac(alg, secret, len, msg, p - msg + len, H_AMK);
+	memset(msg, 0, sizeof(msg));
+}
+
+int srp_verifier_issue_ticket( SRPVerifier *ver, SRPTicketKeys *tk, time_t now,
+	unsigned char *ticket, int *len_ticket )
+{
+	SRPTicketKey key;
+	mbedtls_gcm_context gcm;
+	unsigned char plain[TICKET_PLAIN + 255 + SHA512_DIGEST_LENGTH];
+	unsigned long long issued = (unsigned long long) now;
+	int ulen, slen, len, i, rc = -1;
+
+	if (!ver || !tk || !ticket || !len_ticket) return -1;
+	if (!ver->authenticated || !ver->username) return -1;
+	ulen = strlen(ver->username);
+	if (ulen > 255) return -1;
+	slen = srp_verifier_get_session_key_length(ver);
+
+	if (keys_current(tk, now, &key)!=0) return -1;
+
+	plain[0] = TICKET_VERSION;
+	plain[1] = (unsigned char) ver->hash_alg;
+	for (i=0; i<8; i++) plain[2 + i] = (unsigned char)(issued >> (56 - 8 * i));
+	plain[10] = (unsigned char) ulen;
+	memcpy(plain + TICKET_PLAIN, ver->username, ulen);
+	resumption_secret(ver->hash_alg, ver->session_key, slen, plain + TICKET_PLAIN + ulen);
+	len = TICKET_PLAIN + ulen + slen;
+
+	put_be32(ticket, key.id);
+	mbedtls_gcm_init(&gcm);
+	if (srp_random_bytes(ticket + 4, TICKET_IV)!=0) goto cleanup_and_exit;
+	if (mbedtls_gcm_setkey(&gcm, MBEDTLS_CIPHER_ID_AES, key.key, 8 * SRP_TICKET_KEY_BYTES)!=0) goto cleanup_and_exit;
+	if (mbedtls_gcm_crypt_and_tag(&gcm, MBEDTLS_GCM_ENCRYPT, len, ticket + 4, TICKET_IV, ticket, 4,
+		plain, ticket + TICKET_HEAD, TICKET_TAG, ticket + TICKET_HEAD + len)!=0) goto cleanup_and_exit;
+	*len_ticket = TICKET_HEAD + len + TICKET_TAG;
+	rc = 0;
+
+ cleanup_and_exit:
+	mbedtls_gcm_free(&gcm);
+	memset(&key, 0, sizeof(key));
+	memset(plain, 0, sizeof(plain));
+	return rc;
+}
+
+int srp_user_get_resumption_secret( SRPUser *usr, unsigned char *secret, int *len_secret )
+{
+	if (!usr || !secret || !len_secret || !usr->authenticated) return -1;
+	*len_secret = srp_user_get_session_key_length(usr);
+	resumption_secret(usr->hash_alg, usr->session_key, *len_secret, secret);
+	return 0;
+}
+
+/*
+ * Until srp_user_process_resumption() the secret waits in session_key and
+ * nonce_c in M; neither is valid before the handshake is done anyway.
+ */
+int srp_user_init_resumed( SRPUser *usr, SRPSession *session, const char *username,
+	const unsigned char *secret, int len_secret,
+	unsigned char *nonce_c, int *len_nonce_c )
+{
+	if (!usr || !session || !username || !secret || !nonce_c || !len_nonce_c) return -1;
+	if (srp_user_init(usr, session, username, NULL, 0)!=0) return -1;
+	/* usr holds a reference on the group from here on */
+	if (len_secret!=srp_user_get_session_key_length(usr)
+		|| srp_random_bytes(usr->M, SRP_TICKET_NONCE_BYTES)!=0) {
+		srp_user_free(usr);
+		return -1;
+	}
+
+	memcpy(usr->session_key, secret, len_secret);
+	memcpy(nonce_c, usr->M, SRP_TICKET_NONCE_BYTES);
+	*len_nonce_c = SRP_TICKET_NONCE_BYTES;
+	return 0;
+}
+
+void srp_user_process_resumption( SRPUser *usr,
+	const unsigned char *nonce_s, int len_nonce_s,
+	const unsigned char **bytes_M, int *len_M )
+{
+	unsigned char secret[SHA512_DIGEST_LENGTH], nonce_c[SRP_TICKET_NONCE_BYTES];
+	int len;
+
+	if (!bytes_M) return;
+	*bytes_M = NULL;
+	if (len_M) *len_M = 0;
+	if (!usr || !nonce_s || len_nonce_s!=SRP_TICKET_NONCE_BYTES) return;
+	len = srp_user_get_session_key_length(usr);
+
+	memcpy(secret, usr->session_key, len);
+	memcpy(nonce_c, usr->M, SRP_TICKET_NONCE_BYTES);
+	resumption_keys(usr->hash_alg, secret, len, nonce_c, nonce_s, usr->session_key, usr->M, usr->H_AMK);
+	memset(secret, 0, sizeof(secret));
+
+	*bytes_M = usr->M;
+	if (len_M) *len_M = len;
+}
+
+SRPVerifier * srp_verifier_new_resumed( SRPSession *session, SRPTicketKeys *tk, time_t now,
+	const unsigned char *ticket, int len_ticket,
+	const unsigned char *nonce_c, int len_nonce_c,
+	unsigned char *nonce_s, int *len_nonce_s )
+{
+	SRPTicketKey key;
+	SRPVerifier *ver = NULL;
+	mbedtls_gcm_context gcm;
+	unsigned char plain[TICKET_PLAIN + 255 + SHA512_DIGEST_LENGTH];
+	unsigned long long issued = 0;
+	char *username = NULL;
+	int len, ulen, slen, i, ok = 0;
+
+	if (!session || !tk || !ticket || !nonce_c || !nonce_s || !len_nonce_s) return NULL;
+	if (len_nonce_c!=SRP_TICKET_NONCE_BYTES) return NULL;
+	len = len_ticket - TICKET_HEAD - TICKET_TAG;
+	if (len < TICKET_PLAIN || len > (int) sizeof(plain)) return NULL;
+	if (keys_get(tk, get_be32(ticket), &key)!=0) return NULL;
+
+	mbedtls_gcm_init(&gcm);
+	if (mbedtls_gcm_setkey(&gcm, MBEDTLS_CIPHER_ID_AES, key.key, 8 * SRP_TICKET_KEY_BYTES)!=0) goto cleanup_and_exit;
+	if (mbedtls_gcm_auth_decrypt(&gcm, len, ticket + 4, TICKET_IV, ticket, 4,
+		ticket + TICKET_HEAD + len, TICKET_TAG, ticket + TICKET_HEAD, plain)!=0) goto cleanup_and_exit;
+
+	slen = srp_session_get_key_length(session);
+	ulen = plain[10];
+	for (i=0; i<8; i++) issued = (issued << 8) | plain[2 + i];
+	if (plain[0]!=TICKET_VERSION || plain[1]!=(unsigned char) session->hash_alg) goto cleanup_and_exit;
+	if (len!=TICKET_PLAIN + ulen + slen) goto cleanup_and_exit;
+	if ((unsigned long long) now < issued || (unsigned long long) now - issued > (unsigned long long) tk->lifetime)
+		goto cleanup_and_exit;
+
+	ver = (SRPVerifier *) srp_malloc(sizeof(SRPVerifier));
+	username = (char *) srp_malloc(ulen + 1);
+	if (!ver || !username) goto cleanup_and_exit;
+	if (srp_random_bytes(nonce_s, SRP_TICKET_NONCE_BYTES)!=0) goto cleanup_and_exit;
+
+	memcpy(username, plain + TICKET_PLAIN, ulen);
+	ver->hash_alg = session->hash_alg;
+	ver->ng = session->ng;
+	ver->username = username;
+	ver->owns_username = 1;
+	resumption_keys(session->hash_alg, plain + TICKET_PLAIN + ulen, slen, nonce_c, nonce_s,
+		ver->session_key, ver->M, ver->H_AMK);
+	*len_nonce_s = SRP_TICKET_NONCE_BYTES;
+	ok = 1;
+
+ cleanup_and_exit:
+	mbedtls_gcm_free(&gcm);
+	memset(&key, 0, sizeof(key));
+	memset(plain, 0, sizeof(plain));
+	if (!ok) {
+		srp_free(username);
+		srp_free(ver);
+		ver = NULL;
+	}
+	return ver;
+}
@@ -0,0 +1,123 @@
+#ifndef SRP_TICKET_H
+#define SRP_TICKET_H
+
+/*
+ * Secure Remote Password 6a implementation based on mbedtls.
+ *
+ * Copyright (c) 2019 Stoian Ivanov
+ * https://github.com/sdrsdr/mbedtls-csrp
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+/*
+ * Session resumption. After a full handshake the server hands out a ticket:
+ * the username and a resumption secret derived from the session key,
+ * encrypted and authenticated with AES-256-GCM under a rotating server key.
+ * The client keeps the ticket and derives the same secret on its side. A
+ * reconnect then runs the same four messages as SRP, with HMACs in place of
+ * the exponentiations:
+ *
+ *   User -> Host:  ticket, nonce_c      srp_user_init_resumed()
+ *   Host -> User:  nonce_s              srp_verifier_new_resumed()
+ *   User -> Host:  M                    srp_user_process_resumption()
+ *   Host -> User:  H_AMK                srp_verifier_verify_session()
+ *
+ * and srp_user_verify_session() completes it. Both ends get a fresh session
+ * key HMAC(secret, nonce_c | nonce_s), and a resumed session can issue the
+ * next ticket like a full one. Needs srp_ticket.c and mbedtls' GCM.
+ */
+
+#include <time.h>
+
+#include "srp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SRP_TICKET_KEY_BYTES    32
+#define SRP_TICKET_NONCE_BYTES  32
+#define SRP_TICKET_MAX_BYTES    (4 + 12 + 11 + 255 + 64 + 16)
+
+typedef struct SRPTicketKeys SRPTicketKeys;
+
+/*
+ * Ticket keys of one server. A ticket is accepted for lifetime seconds after
+ * it was issued. Every rotation seconds a fresh random key takes over
+ * issuing; older keys stay around only to open tickets that are still live.
+ * rotation<=0 turns automatic rotation off for keys installed with
+ * srp_ticket_keys_add(). Safe to share between threads.
+ */
+SRPTicketKeys * srp_ticket_keys_new( int lifetime, int rotation );
+void            srp_ticket_keys_delete( SRPTicketKeys * tk );
+
+/*
+ * Installs a key made elsewhere, for servers behind one load balancer that
+ * must open each other's tickets. The newest key issues. Returns 0 on success.
+ */
+int             srp_ticket_keys_add( SRPTicketKeys * tk, unsigned int id,
+                                     const unsigned char * key, int len_key, time_t created );
+
+/*
+ * Server, once srp_verifier_verify_session() accepted the user. ticket holds
+ * at least SRP_TICKET_MAX_BYTES. Returns 0 and sets *len_ticket on success.
+ */
+int             srp_verifier_issue_ticket( SRPVerifier * ver, SRPTicketKeys * tk, time_t now,
+                                           unsigned char * ticket, int * len_ticket );
+
+/*
+ * User, once srp_user_verify_session() succeeded: the secret to store with
+ * the ticket, srp_user_get_session_key_length() bytes. Returns 0 on success.
+ */
+int             srp_user_get_resumption_secret( SRPUser * usr, unsigned char * secret, int * len_secret );
+
+/*
+ * User: sets usr up to resume with a stored ticket and writes nonce_c,
+ * SRP_TICKET_NONCE_BYTES. username must outlive usr, release with
+ * srp_user_free(). Returns 0 on success; on failure usr holds nothing.
+ */
+int             srp_user_init_resumed( SRPUser * usr, SRPSession * session, const char * username,
+                                       const unsigned char * secret, int len_secret,
+                                       unsigned char * nonce_c, int * len_nonce_c );
+
+/*
+ * Server: opens ticket and answers with nonce_s, SRP_TICKET_NONCE_BYTES.
+ * NULL when the ticket is forged, expired, made for another hash or its key
+ * is gone; the client then falls back to a full handshake. Free with
+ * srp_verifier_delete().
+ */
+SRPVerifier *   srp_verifier_new_resumed( SRPSession * session, SRPTicketKeys * tk, time_t now,
+                                          const unsigned char * ticket, int len_ticket,
+                                          const unsigned char * nonce_c, int len_nonce_c,
+                                          unsigned char * nonce_s, int * len_nonce_s );
+
+/* User: the reply to nonce_s, like srp_user_process_challenge() */
+void            srp_user_process_resumption( SRPUser * usr,
+                                             const unsigned char * nonce_s, int len_nonce_s,
+                                             const unsigned char ** bytes_M, int * len_M );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
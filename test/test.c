@@ -1,14 +1,1350 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <poll.h>
+#include <malloc.h>
 
 #include "srp.h"
 #include "srp_internal.h"
+#include "srp_store.h"
+#include "srp_cache.h"
+#include "srp_hash.h"
+#include "srp_async.h"
+#include "srp_ticket.h"
+#include "srp_precomp.h"
+#include "srp_enroll.h"
 #include "tutils.h"
 
 #define USERNAME "alice"
 #define PASSWORD "password123"
 
+/* the fixed base table for g must give the same v and B as mbedtls_mpi_exp_mod */
+static int test_fixed_base(SRP_NGType ng_type){
+	int rc=-1;
+	SRPSession *plain=srp_session_new(SRP_SHA256,ng_type,NULL,NULL);
+	SRPSession *fast=srp_session_new(SRP_SHA256,ng_type,NULL,NULL);
+	const unsigned char *s1=NULL,*v1=NULL,*s2=NULL,*v2=NULL,*B1=NULL,*B2=NULL;
+	int v1_len,v2_len,B1_len=0,B2_len=0;
+	SRPKeyPair *k1=NULL,*k2=NULL;
+
+	if (!plain || !fast) goto done;
+	if (srp_ng_precompute_g(srp_session_get_ng(fast),0,0)!=0) goto done;
+
+	srp_create_salted_verification_key1(plain,USERNAME,PASSWORD,strlen(PASSWORD),&s1,16,&v1,&v1_len);
+	srp_create_salted_verification_key1(fast,USERNAME,PASSWORD,strlen(PASSWORD),&s2,16,&v2,&v2_len);
+	if (!v1 || !v2 || v1_len!=v2_len || memcmp(v1,v2,v1_len)!=0) goto done;
+
+	k1=srp_keypair_new(plain,v1,v1_len,&B1,&B1_len);
+	k2=srp_keypair_new(fast,v1,v1_len,&B2,&B2_len);
+	if (!k1 || !k2 || B1_len!=B2_len || memcmp(B1,B2,B1_len)!=0) goto done;
+	rc=0;
+done:
+	printf ("fixed base table for group %d: %s\n",ng_type,rc==0?"ok":"MISMATCH");
+	free((void*)s1); free((void*)v1); free((void*)s2); free((void*)v2);
+	free((void*)B1); free((void*)B2);
+	srp_keypair_delete(k1); srp_keypair_delete(k2);
+	if (plain) srp_session_delete(plain);
+	if (fast) srp_session_delete(fast);
+	return rc;
+}
+
+/* S = A^b * v^(u*b) from srp_ng_exp_mod2() must equal (A * v^u)^b */
+static int test_multi_exp(SRP_NGType ng_type){
+	int rc=-1,i;
+	NGConstant *ng=srp_ng_new(ng_type,NULL,NULL);
+	mbedtls_mpi A,v,u,b,ub,S1,S2,T;
+
+	mbedtls_mpi_init(&A); mbedtls_mpi_init(&v); mbedtls_mpi_init(&u); mbedtls_mpi_init(&b);
+	mbedtls_mpi_init(&ub); mbedtls_mpi_init(&S1); mbedtls_mpi_init(&S2); mbedtls_mpi_init(&T);
+	if (!ng || !srp_ng_precomp(ng,SRP_SHA512)) goto done;
+
+	for (i=0; i<4; i++) {
+		/* A is left unreduced once, and b/u hit the 0 and 1 corner cases */
+		srp_fill_random(&A,mbedtls_mpi_size(ng->N)+(i==1));
+		srp_fill_random(&v,mbedtls_mpi_size(ng->N));
+		mbedtls_mpi_mod_mpi(&v,&v,ng->N);
+		srp_fill_random(&u,SHA512_DIGEST_LENGTH);
+		srp_fill_random(&b,SRP_BYTES_IN_PRIVKEY);
+		if (i==2) mbedtls_mpi_lset(&b,1);
+		if (i==3) mbedtls_mpi_lset(&u,0);
+
+		mbedtls_mpi_exp_mod(&T,&v,&u,ng->N,NULL);
+		mbedtls_mpi_mul_mpi(&T,&A,&T);
+		mbedtls_mpi_exp_mod(&S1,&T,&b,ng->N,NULL);
+
+		mbedtls_mpi_mul_mpi(&ub,&u,&b);
+		if (srp_ng_exp_mod2(ng,&S2,&A,&b,&v,&ub)!=0) goto done;
+		if (mbedtls_mpi_cmp_mpi(&S1,&S2)!=0) goto done;
+	}
+	rc=0;
+done:
+	printf ("multi-exponentiation for group %d: %s\n",ng_type,rc==0?"ok":"MISMATCH");
+	mbedtls_mpi_free(&A); mbedtls_mpi_free(&v); mbedtls_mpi_free(&u); mbedtls_mpi_free(&b);
+	mbedtls_mpi_free(&ub); mbedtls_mpi_free(&S1); mbedtls_mpi_free(&S2); mbedtls_mpi_free(&T);
+	if (ng) srp_ng_delete(ng);
+	return rc;
+}
+
+/* a whole handshake on caller owned structs and buffers */
+static int g_live_allocs,g_calls;
+static void *count_calloc(size_t n,size_t size){
+	__atomic_add_fetch(&g_live_allocs,1,__ATOMIC_RELAXED);
+	__atomic_add_fetch(&g_calls,1,__ATOMIC_RELAXED);
+	return calloc(n,size);
+}
+static void count_free(void *p){ __atomic_sub_fetch(&g_live_allocs,1,__ATOMIC_RELAXED); free(p); }
+
+static int test_init_api(void){
+	int rc=-1,i;
+	SRPSession *ses=srp_session_new(SRP_SHA256,SRP_NG_2048,NULL,NULL);
+	SRPUser usr;
+	SRPVerifier ver;
+	unsigned char s[16],v[SRP_MAX_N_BYTES],A[SRP_MAX_N_BYTES],B[SRP_MAX_N_BYTES];
+	const unsigned char *M=NULL,*HAMK=NULL;
+	int v_len=sizeof(v),A_len=sizeof(A),B_len=sizeof(B),M_len;
+
+	memset(&usr,0,sizeof(usr));
+	memset(&ver,0,sizeof(ver));
+	if (!ses || srp_ng_size(srp_session_get_ng(ses))!=256) goto done;
+	if (srp_create_salted_verification_key2(ses,USERNAME,PASSWORD,strlen(PASSWORD),s,16,v,&v_len)!=0) goto done;
+	if (srp_user_init(&usr,ses,USERNAME,PASSWORD,strlen(PASSWORD))!=0) goto done;
+	if (srp_user_start_authentication1(&usr,A,&A_len)!=0) goto done;
+	if (srp_verifier_init(&ver,ses,USERNAME,s,16,v,v_len,A,A_len,B,&B_len,NULL)!=0) goto done;
+	srp_user_process_challenge(&usr,s,16,B,B_len,&M,&M_len);
+	if (!M || !srp_verifier_verify_session(&ver,M,&HAMK)) goto done;
+	if (!srp_user_verify_session(&usr,HAMK)) goto done;
+	srp_user_free(&usr);
+	srp_verifier_free(&ver);
+
+	/* the group is set up by now: a second handshake allocates nothing */
+	g_calls=0;
+	srp_set_allocator(count_calloc,count_free);
+	v_len=sizeof(v); A_len=sizeof(A); B_len=sizeof(B); M=HAMK=NULL;
+	i=srp_create_salted_verification_key2(ses,USERNAME,PASSWORD,strlen(PASSWORD),s,16,v,&v_len)==0
+		&& srp_user_init(&usr,ses,USERNAME,PASSWORD,strlen(PASSWORD))==0
+		&& srp_user_start_authentication1(&usr,A,&A_len)==0
+		&& srp_verifier_init(&ver,ses,USERNAME,s,16,v,v_len,A,A_len,B,&B_len,NULL)==0;
+	if (i) srp_user_process_challenge(&usr,s,16,B,B_len,&M,&M_len);
+	i=i && M && srp_verifier_verify_session(&ver,M,&HAMK) && srp_user_verify_session(&usr,HAMK);
+	srp_set_allocator(NULL,NULL);
+	if (!i) goto done;
+#if !defined(MBEDTLS_PLATFORM_MEMORY) || defined(MBEDTLS_PLATFORM_CALLOC_MACRO) || defined(MBEDTLS_PLATFORM_FREE_MACRO)
+	/* with MBEDTLS_PLATFORM_MEMORY mbedtls' limbs would be counted too */
+	if (g_calls!=0) goto done;
+#endif
+	/* a zero A must be refused */
+	memset(A,0,A_len);
+	B_len=sizeof(B);
+	if (srp_verifier_init(&ver,ses,USERNAME,s,16,v,v_len,A,A_len,B,&B_len,NULL)==0) goto done;
+	rc=0;
+done:
+	printf ("caller owned handshake: %s\n",rc==0?"ok":"FAILED");
+	srp_user_free(&usr);
+	srp_verifier_free(&ver);
+	if (ses) srp_session_delete(ses);
+	return rc;
+}
+
+
+/* everything goes through the allocator hook, temporaries through the arena */
+static int test_allocator(void){
+	int rc=-1;
+	SRPArena *arena;
+	SRPSession *ses;
+	SRPUser usr;
+	SRPVerifier ver;
+	unsigned char s[16],v[SRP_MAX_N_BYTES],A[SRP_MAX_N_BYTES],B[SRP_MAX_N_BYTES];
+	const unsigned char *M=NULL,*HAMK=NULL;
+	int v_len=sizeof(v),A_len=sizeof(A),B_len=sizeof(B),M_len;
+
+	srp_set_allocator(count_calloc,count_free);
+	arena=srp_arena_new(64*1024);
+	ses=srp_session_new(SRP_SHA256,SRP_NG_2048,NULL,NULL);
+	memset(&usr,0,sizeof(usr));
+	memset(&ver,0,sizeof(ver));
+	if (!arena || !ses) goto done;
+	srp_arena_bind(arena);
+	if (srp_create_salted_verification_key2(ses,USERNAME,PASSWORD,strlen(PASSWORD),s,16,v,&v_len)!=0) goto done;
+	srp_user_init(&usr,ses,USERNAME,PASSWORD,strlen(PASSWORD));
+	if (srp_user_start_authentication1(&usr,A,&A_len)!=0) goto done;
+	if (srp_verifier_init(&ver,ses,USERNAME,s,16,v,v_len,A,A_len,B,&B_len,NULL)!=0) goto done;
+#if defined(MBEDTLS_PLATFORM_MEMORY) && !defined(MBEDTLS_PLATFORM_CALLOC_MACRO) && !defined(MBEDTLS_PLATFORM_FREE_MACRO)
+	/* the library's own temporaries live on the stack, mbedtls' limbs come from the arena */
+	if (srp_arena_peak(arena)==0) goto done;
+#endif
+	srp_user_process_challenge(&usr,s,16,B,B_len,&M,&M_len);
+	if (!M || !srp_verifier_verify_session(&ver,M,&HAMK)) goto done;
+	if (!srp_user_verify_session(&usr,HAMK)) goto done;
+	rc=0;
+done:
+	srp_user_free(&usr);
+	srp_verifier_free(&ver);
+	if (ses) srp_session_delete(ses);
+	srp_arena_delete(arena);
+	if (g_live_allocs!=0) rc=-1;
+	srp_set_allocator(NULL,NULL);
+	printf ("allocator hook and arena: %s\n",rc==0?"ok":"FAILED");
+	return rc;
+}
+
+/* a key pair taken from the pool must give a working handshake */
+static int test_keypool(void){
+	int rc=-1;
+	SRPSession *ses=srp_session_new(SRP_SHA256,SRP_NG_2048,NULL,NULL);
+	SRPKeyPool *pool=NULL;
+	SRPKeyPair *keys=NULL;
+	SRPUser *usr=NULL;
+	SRPVerifier *ver=NULL;
+	const unsigned char *s=NULL,*v=NULL,*A=NULL,*B=NULL,*M=NULL,*HAMK=NULL;
+	int v_len,A_len,B_len,M_len;
+
+	if (!ses) goto done;
+	pool=srp_keypool_new(ses,4);
+	if (!pool) goto done;
+	for (int i=0; i<500 && srp_keypool_available(pool)<4; i++) usleep(10000);
+	if (srp_keypool_available(pool)==0) goto done;
+
+	srp_create_salted_verification_key1(ses,USERNAME,PASSWORD,strlen(PASSWORD),&s,16,&v,&v_len);
+	keys=srp_keypair_new1(ses,pool,v,v_len,&B,&B_len);
+	if (!keys) goto done;
+
+	usr=srp_user_new(ses,USERNAME,PASSWORD,strlen(PASSWORD));
+	srp_user_start_authentication(usr,NULL,&A,&A_len);
+	srp_user_process_challenge(usr,s,16,B,B_len,&M,&M_len);
+	if (!M) goto done;
+	ver=srp_verifier_new1(ses,USERNAME,0,s,16,v,v_len,A,A_len,NULL,NULL,keys);
+	if (!ver || !srp_verifier_verify_session(ver,M,&HAMK)) goto done;
+	if (!srp_user_verify_session(usr,HAMK)) goto done;
+	rc=0;
+done:
+	printf ("pooled key pair: %s\n",rc==0?"ok":"FAILED");
+	free((void*)s); free((void*)v); free((void*)A); free((void*)B);
+	srp_verifier_delete(ver);
+	if (usr) srp_user_delete(usr);
+	srp_keypair_delete(keys);
+	srp_keypool_delete(pool);
+	if (ses) srp_session_delete(ses);
+	return rc;
+}
+
+/* every item of a batch must give a working handshake */
+static int test_batch(void){
+	int rc=-1,i,n=0;
+	SRPSession *ses=srp_session_new(SRP_SHA256,SRP_NG_1024,NULL,NULL);
+	SRPWorkerPool *pool=srp_worker_pool_new(3);
+	SRPUser *usr[8]={0};
+	SRPBatchItem items[8];
+	const unsigned char *s=NULL,*v=NULL,*A[8]={0},*M=NULL,*HAMK=NULL;
+	int v_len,A_len[8],M_len;
+
+	memset(items,0,sizeof(items));
+	if (!ses || !pool) goto done;
+	srp_create_salted_verification_key1(ses,USERNAME,PASSWORD,strlen(PASSWORD),&s,16,&v,&v_len);
+	for (i=0; i<8; i++) {
+		usr[i]=srp_user_new(ses,USERNAME,PASSWORD,strlen(PASSWORD));
+		srp_user_start_authentication(usr[i],NULL,&A[i],&A_len[i]);
+		items[i].username=USERNAME;
+		items[i].bytes_s=s; items[i].len_s=16;
+		items[i].bytes_v=v; items[i].len_v=v_len;
+		items[i].bytes_A=A[i]; items[i].len_A=A_len[i];
+	}
+	if (srp_verifier_new_batch(ses,pool,items,8)!=8) goto done;
+	for (i=0; i<8; i++) {
+		srp_user_process_challenge(usr[i],s,16,items[i].bytes_B,items[i].len_B,&M,&M_len);
+		if (!M || !srp_verifier_verify_session(items[i].ver,M,&HAMK)) break;
+		if (!srp_user_verify_session(usr[i],HAMK)) break;
+		n++;
+	}
+	if (n==8) rc=0;
+done:
+	printf ("batch of 8 on %d threads: %s\n",srp_worker_pool_size(pool),rc==0?"ok":"FAILED");
+	for (i=0; i<8; i++) {
+		srp_verifier_delete(items[i].ver);
+		free((void*)items[i].bytes_B);
+		free((void*)A[i]);
+		if (usr[i]) srp_user_delete(usr[i]);
+	}
+	free((void*)s); free((void*)v);
+	srp_worker_pool_delete(pool);
+	if (ses) srp_session_delete(ses);
+	return rc;
+}
+
+static int test_store(void){
+	int rc=-1,fd;
+	char path[]="/tmp/srp_store_XXXXXX";
+	SRPSession *ses=srp_session_new(SRP_SHA256,SRP_NG_1024,NULL,NULL);
+	SRPStoreWriter *w;
+	SRPStore *st=NULL;
+	SRPStoreRecord rec;
+	SRPUser *usr=NULL;
+	SRPVerifier *ver=NULL;
+	unsigned char s[16],v[SRP_MAX_N_BYTES];
+	const unsigned char *A=NULL,*B=NULL,*M=NULL,*HAMK=NULL;
+	int v_len=sizeof(v),A_len,B_len,M_len;
+
+	fd=mkstemp(path);
+	if (fd<0 || !ses) goto done;
+	close(fd);
+	/* bob first gets a verifier for another password, the update in a second writer wins */
+	if (srp_create_salted_verification_key2(ses,"bob","wrong",5,s,16,v,&v_len)!=0) goto done;
+	if (!(w=srp_store_writer_open(path))) goto done;
+	if (srp_store_writer_add(w,"bob",SRP_NG_1024,SRP_SHA256,s,16,v,v_len)!=0) goto done;
+	if (srp_store_writer_add(w,"carol",SRP_NG_1024,SRP_SHA256,s,16,v,v_len)!=0) goto done;
+	if (srp_store_writer_close(w)!=0) goto done;
+	v_len=sizeof(v);
+	if (srp_create_salted_verification_key2(ses,"bob",PASSWORD,strlen(PASSWORD),s,16,v,&v_len)!=0) goto done;
+	if (!(w=srp_store_writer_open(path))) goto done;
+	if (srp_store_writer_add(w,"bob",SRP_NG_1024,SRP_SHA256,s,16,v,v_len)!=0) goto done;
+	if (srp_store_writer_close(w)!=0) goto done;
+
+	if (!(st=srp_store_open(path)) || srp_store_count(st)!=2) goto done;
+	if (srp_store_lookup(st,"dave",&rec)==0 || srp_store_lookup(st,"bob",&rec)!=0) goto done;
+	if (strcmp(rec.username,"bob")!=0 || rec.ng_type!=SRP_NG_1024 || rec.hash_alg!=SRP_SHA256) goto done;
+
+	usr=srp_user_new(ses,"bob",PASSWORD,strlen(PASSWORD));
+	srp_user_start_authentication(usr,NULL,&A,&A_len);
+	ver=srp_verifier_new1(ses,rec.username,0,rec.bytes_s,rec.len_s,rec.bytes_v,rec.len_v,A,A_len,&B,&B_len,NULL);
+	if (!ver) goto done;
+	srp_user_process_challenge(usr,rec.bytes_s,rec.len_s,B,B_len,&M,&M_len);
+	if (!M || !srp_verifier_verify_session(ver,M,&HAMK)) goto done;
+	if (!srp_user_verify_session(usr,HAMK)) goto done;
+	rc=0;
+done:
+	printf ("verifier store: %s\n",rc==0?"ok":"FAILED");
+	srp_verifier_delete(ver);
+	if (usr) srp_user_delete(usr);
+	free((void*)A); free((void*)B);
+	srp_store_close(st);
+	unlink(path);
+	if (ses) srp_session_delete(ses);
+	return rc;
+}
+
+/* handshakes through the cache, past the point where v gets its table */
+static int test_cache(void){
+	int rc=-1,i,n=0;
+	SRPSession *ses=srp_session_new(SRP_SHA256,SRP_NG_1024,NULL,NULL);
+	SRPVerifierCache *cache=NULL;
+	SRPVerifierCacheStats st;
+	SRPUser usr;
+	SRPVerifier ver;
+	unsigned char s[16],v[SRP_MAX_N_BYTES],A[SRP_MAX_N_BYTES],B[SRP_MAX_N_BYTES];
+	const unsigned char *M=NULL,*HAMK=NULL;
+	int v_len=sizeof(v),A_len,B_len,M_len;
+	char name[16];
+
+	memset(&usr,0,sizeof(usr));
+	memset(&ver,0,sizeof(ver));
+	if (!ses || !(cache=srp_verifier_cache_new(ses,16,1))) goto done;
+	if (srp_create_salted_verification_key2(ses,USERNAME,PASSWORD,strlen(PASSWORD),s,16,v,&v_len)!=0) goto done;
+	for (i=0; i<SRP_CACHE_HOT_HITS+4; i++) {
+		A_len=sizeof(A); B_len=sizeof(B);
+		if (srp_user_init(&usr,ses,USERNAME,PASSWORD,strlen(PASSWORD))!=0) break;
+		if (srp_user_start_authentication1(&usr,A,&A_len)!=0) break;
+		if (srp_verifier_init_cached(cache,&ver,USERNAME,s,16,v,v_len,A,A_len,B,&B_len,NULL)!=0) break;
+		srp_user_process_challenge(&usr,s,16,B,B_len,&M,&M_len);
+		if (!M || !srp_verifier_verify_session(&ver,M,&HAMK)) break;
+		if (!srp_user_verify_session(&usr,HAMK)) break;
+		srp_user_free(&usr);
+		srp_verifier_free(&ver);
+		n++;
+	}
+	if (n!=SRP_CACHE_HOT_HITS+4) goto done;
+	srp_verifier_cache_stats(cache,&st);
+	if (st.hits!=(unsigned)n-1 || st.misses!=1 || st.tables!=1) goto done;
+
+	/* a new verifier for the same name is a miss, a full cache evicts */
+	v[v_len-1]^=1;
+	A_len=sizeof(A); B_len=sizeof(B);
+	srp_user_init(&usr,ses,USERNAME,PASSWORD,strlen(PASSWORD));
+	srp_user_start_authentication1(&usr,A,&A_len);
+	srp_verifier_init_cached(cache,&ver,USERNAME,s,16,v,v_len,A,A_len,B,&B_len,NULL);
+	for (i=0; i<64; i++) {
+		sprintf(name,"user%d",i);
+		B_len=sizeof(B);
+		srp_verifier_init_cached(cache,&ver,name,s,16,v,v_len,A,A_len,B,&B_len,NULL);
+	}
+	srp_verifier_cache_stats(cache,&st);
+	if (st.misses!=66 || st.evictions==0 || st.entries>16 || st.tables!=0) goto done;
+	rc=0;
+done:
+	printf ("verifier cache: %s\n",rc==0?"ok":"FAILED");
+	srp_user_free(&usr);
+	srp_verifier_free(&ver);
+	srp_verifier_cache_delete(cache);
+	if (ses) srp_session_delete(ses);
+	return rc;
+}
+
+static int g_phase_begun[SRP_PHASE_LAST],g_phase_ended[SRP_PHASE_LAST];
+static void phase_begin(void *ctx,SRP_Phase p){ (void)ctx; __atomic_add_fetch(&g_phase_begun[p],1,__ATOMIC_RELAXED); }
+static void phase_end(void *ctx,SRP_Phase p){ (void)ctx; __atomic_add_fetch(&g_phase_ended[p],1,__ATOMIC_RELAXED); }
+
+static void *stats_handshake(void *arg){
+	SRPSession *ses=(SRPSession *)arg;
+	SRPUser usr;
+	SRPVerifier ver;
+	unsigned char s[16],v[SRP_MAX_N_BYTES],A[SRP_MAX_N_BYTES],B[SRP_MAX_N_BYTES];
+	const unsigned char *M=NULL,*HAMK=NULL;
+	int v_len=sizeof(v),A_len=sizeof(A),B_len=sizeof(B),M_len;
+
+	srp_create_salted_verification_key2(ses,USERNAME,PASSWORD,strlen(PASSWORD),s,16,v,&v_len);
+	srp_user_init(&usr,ses,USERNAME,PASSWORD,strlen(PASSWORD));
+	srp_user_start_authentication1(&usr,A,&A_len);
+	srp_verifier_init(&ver,ses,USERNAME,s,16,v,v_len,A,A_len,B,&B_len,NULL);
+	srp_user_process_challenge(&usr,s,16,B,B_len,&M,&M_len);
+	if (M && srp_verifier_verify_session(&ver,M,&HAMK)) srp_user_verify_session(&usr,HAMK);
+	return srp_user_is_authenticated(&usr) ? arg : NULL;
+}
+
+/* counters of a thread that has exited still show up, hooks pair up */
+static int test_stats(void){
+	int rc=-1,i;
+	SRPSession *ses=srp_session_new(SRP_SHA256,SRP_NG_1024,NULL,NULL);
+	SRPStats st0,st1;
+	SRPVerifier ver;
+	pthread_t th;
+	void *ret=NULL;
+	unsigned char s[16]={1},v[SRP_MAX_N_BYTES]={1},A[SRP_MAX_N_BYTES]={0},B[SRP_MAX_N_BYTES];
+	int B_len=sizeof(B);
+
+	if (!ses || srp_set_phase_hooks(phase_begin,phase_end,NULL)!=0) goto done;
+	srp_ng_precomp(ses->ng,ses->hash_alg);
+	srp_stats_snapshot(&st0);
+	if (pthread_create(&th,NULL,stats_handshake,ses)!=0) goto done;
+	pthread_join(th,&ret);
+	if (ret!=ses) goto done;
+	/* a zero A is counted as rejected */
+	srp_verifier_init(&ver,ses,USERNAME,s,16,v,128,A,128,B,&B_len,NULL);
+	srp_stats_snapshot(&st1);
+
+	/* verifier, A, B, S on both sides with g^x on the client */
+	if (st1.exp[SRP_NG_1024]-st0.exp[SRP_NG_1024]!=6) goto done;
+	if (st1.bytes_hashed==st0.bytes_hashed) goto done;
+#if !defined(MBEDTLS_PLATFORM_MEMORY) || defined(MBEDTLS_PLATFORM_CALLOC_MACRO) || defined(MBEDTLS_PLATFORM_FREE_MACRO)
+	/* a handshake through the *_init API does not allocate */
+	if (st1.allocs!=st0.allocs) goto done;
+#endif
+	if (st1.rejected-st0.rejected!=1) goto done;
+	if (st1.phases[SRP_PHASE_VERIFIER]-st0.phases[SRP_PHASE_VERIFIER]!=2) goto done;
+	for (i=0; i<SRP_PHASE_LAST; i++) {
+		if (g_phase_begun[i]!=g_phase_ended[i]) goto done;
+		if (g_phase_ended[i]!=(int)(st1.phases[i]-st0.phases[i])) goto done;
+	}
+	rc=0;
+done:
+	printf ("instrumentation: %s\n",rc==0?"ok":"FAILED");
+	srp_set_phase_hooks(NULL,NULL,NULL);
+	if (ses) srp_session_delete(ses);
+	return rc;
+}
+
+static const size_t g_mdlen[]={SHA1_DIGEST_LENGTH,SHA224_DIGEST_LENGTH,SHA256_DIGEST_LENGTH,
+	SHA384_DIGEST_LENGTH,SHA512_DIGEST_LENGTH};
+
+/* every lane and every padding boundary must give the scalar digest */
+static int test_hash_batch(void){
+	static const size_t lens[]={0,1,3,55,56,57,63,64,65,111,112,113,119,120,127,128,129,
+		191,192,239,240,255,256,300,0,64,128,17,200,55,111,56,112,250,1,127,129};
+	enum { N=sizeof(lens)/sizeof(lens[0]) };
+	unsigned char data[300],out[N][SHA512_DIGEST_LENGTH],ref[SHA512_DIGEST_LENGTH];
+	const unsigned char *msg[N];
+	unsigned char *md[N];
+	size_t len[N];
+	int rc=-1,alg,i,n;
+
+	for (i=0; i<(int)sizeof(data); i++) data[i]=(unsigned char)(i*131+7);
+	for (i=0; i<N; i++) {
+		msg[i]=data+(i%5);
+		len[i]=lens[i]>sizeof(data)-(i%5) ? sizeof(data)-(i%5) : lens[i];
+		md[i]=out[i];
+	}
+	for (alg=SRP_SHA1; alg<SRP_SHA_LAST; alg++) {
+		/* a partial batch leaves lanes idle */
+		for (n=1; n<=N; n+=N/4) {
+			memset(out,0,sizeof(out));
+			srp_hash_batch(alg,msg,len,md,n);
+			for (i=0; i<n; i++) {
+				srp_hash(alg,msg[i],len[i],ref);
+				if (memcmp(ref,out[i],g_mdlen[alg])!=0) goto done;
+			}
+		}
+	}
+	rc=0;
+done:
+	printf ("multi-buffer hash (%d lanes for SHA-256): %s\n",srp_hash_batch_lanes(SRP_SHA256),rc==0?"ok":"FAILED");
+	return rc;
+}
+
+/* the accelerated single stream code must match mbedtls for any split of the input */
+static int test_hash_accel(void){
+	unsigned char data[600],md[SHA512_DIGEST_LENGTH],ref[SHA512_DIGEST_LENGTH];
+	const SRPHashImpl *impl;
+	HashCTX ctx;
+	size_t len,pos,step;
+	int rc=-1,alg,n=0;
+
+	for (len=0; len<sizeof(data); len++) data[len]=(unsigned char)(len*73+11);
+	for (alg=SRP_SHA1; alg<SRP_SHA_LAST; alg++) {
+		if (!(impl=srp_hash_accel(alg))) continue;
+		n++;
+		for (len=0; len<=sizeof(data); len+=(len<260 ? 1 : 37)) {
+			switch (alg) {
+				case SRP_SHA1: mbedtls_sha1(data,len,ref); break;
+				case SRP_SHA224: mbedtls_sha256(data,len,ref,1); break;
+				case SRP_SHA256: mbedtls_sha256(data,len,ref,0); break;
+				case SRP_SHA384: mbedtls_sha512(data,len,ref,1); break;
+				default: mbedtls_sha512(data,len,ref,0); break;
+			}
+			for (step=1; step<=len+1; step=step*3+2) {
+				impl->init(&ctx);
+				for (pos=0; pos<len; pos+=step) impl->update(&ctx,data+pos,len-pos<step ? len-pos : step);
+				memset(md,0,sizeof(md));
+				impl->final(&ctx,md);
+				if (memcmp(md,ref,g_mdlen[alg])!=0) goto done;
+			}
+		}
+	}
+	rc=0;
+done:
+	printf ("accelerated hash (%d algorithms, SHA-256: %s): %s\n",n,srp_hash_backend(SRP_SHA256),rc==0?"ok":"FAILED");
+	return rc;
+}
+
+/* a job stepped in small slices must end where srp_verifier_init() does (b is fixed) */
+static int test_verifier_job(void){
+	int rc=-1,i,steps=0,r;
+	SRPSession *ses[2]={srp_session_new(SRP_SHA256,SRP_NG_1024,NULL,NULL),srp_session_new(SRP_SHA1,SRP_NG_2048,NULL,NULL)};
+	SRPVerifierJob *job=NULL;
+	SRPVerifier ref,ver;
+	SRPUser usr;
+	unsigned char s[16],v[SRP_MAX_N_BYTES],A[SRP_MAX_N_BYTES],B[SRP_MAX_N_BYTES],B_ref[SRP_MAX_N_BYTES];
+	const unsigned char *M=NULL,*HAMK=NULL;
+	int v_len,A_len,B_len,B_ref_len,M_len;
+
+	if (!ses[0] || !ses[1]) goto done;
+	/* one group steps through the fixed base table for g, the other through Straus */
+	if (srp_ng_precompute_g(srp_session_get_ng(ses[1]),0,0)!=0) goto done;
+	for (i=0; i<2; i++) {
+		v_len=A_len=B_ref_len=B_len=SRP_MAX_N_BYTES;
+		if (srp_create_salted_verification_key2(ses[i],USERNAME,(const unsigned char*)PASSWORD,strlen(PASSWORD),s,16,v,&v_len)!=0) goto done;
+		if (srp_user_init(&usr,ses[i],USERNAME,(const unsigned char*)PASSWORD,strlen(PASSWORD))!=0) goto done;
+		if (srp_user_start_authentication1(&usr,A,&A_len)!=0) goto done;
+		if (srp_verifier_init(&ref,ses[i],USERNAME,s,16,v,v_len,A,A_len,B_ref,&B_ref_len,NULL)!=0) goto done;
+
+		job=srp_verifier_job_new(ses[i],USERNAME,s,16,v,v_len,A,A_len);
+		if (!job) goto done;
+		memset(A,0,sizeof(A));      /* the job keeps its own copy */
+		while ((r=srp_verifier_job_step(job,i==0 ? 1 : 16))==0) steps++;
+		if (r!=1 || steps<10) goto done;
+		if (srp_verifier_job_finish(job,&ver,B,&B_len)!=0) goto done;
+		srp_verifier_job_delete(job);
+		job=NULL;
+		if (B_len!=B_ref_len || memcmp(B,B_ref,B_len)!=0) goto done;
+		if (memcmp(ver.M,ref.M,sizeof(ver.M))!=0 || memcmp(ver.H_AMK,ref.H_AMK,sizeof(ver.H_AMK))!=0) goto done;
+		if (memcmp(ver.session_key,ref.session_key,sizeof(ver.session_key))!=0) goto done;
+
+		srp_user_process_challenge(&usr,s,16,B,B_len,&M,&M_len);
+		if (!M) goto done;
+		srp_verifier_verify_session(&ver,M,&HAMK);
+		if (!HAMK || !srp_user_verify_session(&usr,HAMK)) goto done;
+		srp_user_free(&usr);
+		srp_verifier_free(&ref);
+		srp_verifier_free(&ver);
+	}
+	/* the safety check refuses a zero A up front */
+	memset(A,0,sizeof(A));
+	if (srp_verifier_job_new(ses[0],USERNAME,s,16,v,v_len,A,128)!=NULL) goto done;
+	rc=0;
+done:
+	printf ("stepped verifier (%d slices): %s\n",steps,rc==0?"ok":"FAILED");
+	srp_verifier_job_delete(job);
+	for (i=0; i<2; i++) if (ses[i]) srp_session_delete(ses[i]);
+	return rc;
+}
+
+typedef struct AsyncWait {
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	SRPAsyncOp *op;
+} AsyncWait;
+
+static void async_done(SRPAsyncOp *op, const SRPAsyncResult *res){
+	AsyncWait *w=(AsyncWait*)res->ctx;
+	pthread_mutex_lock(&w->lock);
+	w->op=op;
+	pthread_cond_signal(&w->cond);
+	pthread_mutex_unlock(&w->lock);
+}
+
+/* waits on the completion queue fd like an event loop would */
+static SRPAsyncOp * async_next(SRPAsync *as){
+	struct pollfd pfd={srp_async_fd(as),POLLIN,0};
+	SRPAsyncOp *op;
+	while (!(op=srp_async_poll(as))) {
+		if (poll(&pfd,1,10000)!=1) return NULL;
+	}
+	return op;
+}
+
+static int test_async(void){
+	int rc=-1,i,n=0,cancelled=0;
+	SRPSession *ses=srp_session_new(SRP_SHA256,SRP_NG_2048,NULL,NULL);
+	SRPAsync *as=srp_async_new(2);
+	SRPAsyncOp *op=NULL,*ops[16];
+	const SRPAsyncResult *r;
+	AsyncWait w={PTHREAD_MUTEX_INITIALIZER,PTHREAD_COND_INITIALIZER,NULL};
+	SRPUser usr;
+	SRPVerifier *ver=NULL;
+	unsigned char s[16],v[SRP_MAX_N_BYTES],A[SRP_MAX_N_BYTES];
+	const unsigned char *HAMK=NULL;
+	int v_len,A_len=SRP_MAX_N_BYTES,usr_ok=0;
+
+	if (!ses || !as) goto done;
+	if (srp_async_poll(as)!=NULL) goto done;
+
+	/* enrollment through the completion queue */
+	op=srp_async_create_salted_verification_key(as,ses,USERNAME,(const unsigned char*)PASSWORD,strlen(PASSWORD),16,NULL,NULL);
+	if (!op || async_next(as)!=op) goto done;
+	r=srp_async_result(op);
+	if (r->status!=0 || r->len_s!=16 || !r->bytes_v) goto done;
+	v_len=r->len_v;
+	memcpy(s,r->bytes_s,16);
+	memcpy(v,r->bytes_v,v_len);
+	free((void*)r->bytes_s);
+	free((void*)r->bytes_v);
+	srp_async_release(op);
+	op=NULL;
+
+	if (srp_user_init(&usr,ses,USERNAME,(const unsigned char*)PASSWORD,strlen(PASSWORD))!=0) goto done;
+	usr_ok=1;
+	if (srp_user_start_authentication1(&usr,A,&A_len)!=0) goto done;
+
+	/* the server side through a callback */
+	if (!srp_async_verifier_new(as,ses,USERNAME,s,16,v,v_len,A,A_len,async_done,&w)) goto done;
+	pthread_mutex_lock(&w.lock);
+	while (!w.op) pthread_cond_wait(&w.cond,&w.lock);
+	pthread_mutex_unlock(&w.lock);
+	op=w.op;
+	r=srp_async_result(op);
+	if (r->status!=0 || !r->ver || r->len_B!=256) goto done;
+	ver=r->ver;
+
+	op=srp_async_user_process_challenge(as,&usr,s,16,r->bytes_B,r->len_B,NULL,NULL);
+	free((void*)r->bytes_B);
+	srp_async_release(w.op);
+	if (!op || async_next(as)!=op) goto done;
+	r=srp_async_result(op);
+	if (r->status!=0 || !r->bytes_M) goto done;
+	srp_verifier_verify_session(ver,r->bytes_M,&HAMK);
+	if (!HAMK || !srp_user_verify_session(&usr,HAMK)) goto done;
+	srp_async_release(op);
+	op=NULL;
+
+	/* cancel a burst once it got going: what is dropped or abandoned never shows up */
+	for (i=0; i<16; i++) {
+		ops[i]=srp_async_keypair_new(as,ses,v,v_len,NULL,NULL);
+		if (!ops[i]) goto done;
+	}
+	for (;;) {
+		if (!(op=async_next(as))) goto done;
+		r=srp_async_result(op);
+		if (r->status!=0) goto done;
+		srp_keypair_delete(r->keys);
+		free((void*)r->bytes_B);
+		for (i=0; i<16; i++) if (ops[i]==op) ops[i]=NULL;
+		srp_async_release(op);
+		op=NULL;
+		if (++n==2) break;
+	}
+	for (i=0; i<16; i++) if (ops[i] && srp_async_cancel(ops[i])==0) cancelled++;
+	while (n<16-cancelled && (op=async_next(as))) {
+		r=srp_async_result(op);
+		if (r->status!=0) goto done;
+		srp_keypair_delete(r->keys);
+		free((void*)r->bytes_B);
+		srp_async_release(op);
+		op=NULL;
+		n++;
+	}
+	if (n!=16-cancelled || srp_async_poll(as)!=NULL) goto done;
+	rc=0;
+done:
+	printf ("async offload: %s\n",rc==0?"ok":"FAILED");
+	if (op) srp_async_release(op);
+	srp_async_delete(as);
+	if (ver) srp_verifier_delete(ver);
+	if (usr_ok) srp_user_free(&usr);
+	if (ses) srp_session_delete(ses);
+	return rc;
+}
+
+/* one resumption with ticket at now, 0 when both sides agree on a new key */
+static int resume_once(SRPSession *ses, SRPTicketKeys *tk, time_t now, const unsigned char *ticket, int len_ticket,
+		const unsigned char *secret, int len_secret, SRPVerifier **pver){
+	SRPUser usr;
+	SRPVerifier *ver;
+	unsigned char nc[SRP_TICKET_NONCE_BYTES],ns[SRP_TICKET_NONCE_BYTES];
+	const unsigned char *M=NULL,*HAMK=NULL;
+	int nc_len,ns_len,M_len,rc=-1;
+
+	if (srp_user_init_resumed(&usr,ses,USERNAME,secret,len_secret,nc,&nc_len)!=0) return -1;
+	ver=srp_verifier_new_resumed(ses,tk,now,ticket,len_ticket,nc,nc_len,ns,&ns_len);
+	if (ver) {
+		srp_user_process_resumption(&usr,ns,ns_len,&M,&M_len);
+		if (M && srp_verifier_verify_session(ver,M,&HAMK) && srp_user_verify_session(&usr,HAMK)
+				&& strcmp(srp_verifier_get_username(ver),USERNAME)==0
+				&& memcmp(usr.session_key,ver->session_key,M_len)==0) rc=0;
+	}
+	srp_user_free(&usr);
+	if (rc==0 && pver) *pver=ver;
+	else srp_verifier_delete(ver);
+	return rc;
+}
+
+static int test_ticket(void){
+	int rc=-1;
+	SRPSession *ses=srp_session_new(SRP_SHA256,SRP_NG_1024,NULL,NULL);
+	SRPTicketKeys *tk=srp_ticket_keys_new(3600,600);
+	SRPUser usr;
+	SRPVerifier ver,*rver=NULL;
+	unsigned char s[16],v[SRP_MAX_N_BYTES],A[SRP_MAX_N_BYTES],B[SRP_MAX_N_BYTES];
+	unsigned char ticket[SRP_TICKET_MAX_BYTES],ticket2[SRP_TICKET_MAX_BYTES],secret[64];
+	const unsigned char *M=NULL,*HAMK=NULL;
+	int v_len=sizeof(v),A_len=sizeof(A),B_len=sizeof(B),M_len,len_ticket,len_ticket2,len_secret,usr_ok=0,ver_ok=0;
+	time_t t0=1000000;
+
+	if (!ses || !tk) goto done;
+	if (srp_create_salted_verification_key2(ses,USERNAME,(const unsigned char*)PASSWORD,strlen(PASSWORD),s,16,v,&v_len)!=0) goto done;
+	if (srp_user_init(&usr,ses,USERNAME,(const unsigned char*)PASSWORD,strlen(PASSWORD))!=0) goto done;
+	usr_ok=1;
+	if (srp_user_start_authentication1(&usr,A,&A_len)!=0) goto done;
+	if (srp_verifier_init(&ver,ses,USERNAME,s,16,v,v_len,A,A_len,B,&B_len,NULL)!=0) goto done;
+	ver_ok=1;
+	/* no ticket before the user proved the password */
+	if (srp_verifier_issue_ticket(&ver,tk,t0,ticket,&len_ticket)==0) goto done;
+	srp_user_process_challenge(&usr,s,16,B,B_len,&M,&M_len);
+	if (!M || !srp_verifier_verify_session(&ver,M,&HAMK) || !srp_user_verify_session(&usr,HAMK)) goto done;
+
+	if (srp_verifier_issue_ticket(&ver,tk,t0,ticket,&len_ticket)!=0) goto done;
+	if (srp_user_get_resumption_secret(&usr,secret,&len_secret)!=0 || len_secret!=32) goto done;
+
+	if (resume_once(ses,tk,t0+10,ticket,len_ticket,secret,len_secret,&rver)!=0) goto done;
+	/* a resumed session issues the next ticket; the key rotated meanwhile */
+	if (srp_verifier_issue_ticket(rver,tk,t0+700,ticket2,&len_ticket2)!=0) goto done;
+	if (memcmp(ticket,ticket2,4)==0) goto done;
+	if (resume_once(ses,tk,t0+800,ticket,len_ticket,secret,len_secret,NULL)!=0) goto done;
+
+	/* expired, wrong secret, tampered, from the future */
+	if (resume_once(ses,tk,t0+3601,ticket,len_ticket,secret,len_secret,NULL)==0) goto done;
+	secret[0]^=1;
+	if (resume_once(ses,tk,t0+10,ticket,len_ticket,secret,len_secret,NULL)==0) goto done;
+	secret[0]^=1;
+	ticket[len_ticket/2]^=1;
+	if (resume_once(ses,tk,t0+10,ticket,len_ticket,secret,len_secret,NULL)==0) goto done;
+	ticket[len_ticket/2]^=1;
+	if (resume_once(ses,tk,t0-10,ticket,len_ticket,secret,len_secret,NULL)==0) goto done;
+	if (resume_once(ses,tk,t0+10,ticket,len_ticket,secret,len_secret,NULL)!=0) goto done;
+	/* a secret of the wrong size, and no user */
+	if (resume_once(ses,tk,t0+10,ticket,len_ticket,secret,len_secret-1,NULL)==0) goto done;
+	M=HAMK;
+	srp_user_process_resumption(NULL,ticket,SRP_TICKET_NONCE_BYTES,&M,&M_len);
+	if (M) goto done;
+	srp_user_process_resumption(NULL,ticket,SRP_TICKET_NONCE_BYTES,NULL,NULL);
+	rc=0;
+done:
+	printf ("resumption tickets: %s\n",rc==0?"ok":"FAILED");
+	srp_verifier_delete(rver);
+	if (ver_ok) srp_verifier_free(&ver);
+	if (usr_ok) srp_user_free(&usr);
+	srp_ticket_keys_delete(tk);
+	if (ses) srp_session_delete(ses);
+	return rc;
+}
+
+/* one login of usr against (s, v), through cache when it is set */
+static int login_once(SRPSession *ses, SRPUserCache *cache, SRPUser *usr, const unsigned char *s, const unsigned char *v, int v_len){
+	SRPVerifier ver;
+	unsigned char A[SRP_MAX_N_BYTES],B[SRP_MAX_N_BYTES];
+	const unsigned char *M=NULL,*HAMK=NULL;
+	int A_len=sizeof(A),B_len=sizeof(B),M_len,rc=-1;
+
+	if (srp_user_start_authentication1(usr,A,&A_len)!=0) return -1;
+	if (srp_verifier_init(&ver,ses,USERNAME,s,16,v,v_len,A,A_len,B,&B_len,NULL)!=0) return -1;
+	if (cache) srp_user_process_challenge_cached(cache,usr,s,16,B,B_len,&M,&M_len);
+	else srp_user_process_challenge(usr,s,16,B,B_len,&M,&M_len);
+	if (M && srp_verifier_verify_session(&ver,M,&HAMK) && srp_user_verify_session(usr,HAMK)) rc=0;
+	srp_verifier_free(&ver);
+	return rc;
+}
+
+static int test_user_cache(void){
+	int rc=-1,i;
+	SRPSession *ses=srp_session_new(SRP_SHA256,SRP_NG_2048,NULL,NULL),*ses5=NULL;
+	SRPUserCache *cache=srp_user_cache_new(4);
+	SRPVerifierCacheStats st;
+	SRPUser usr,*xusr=NULL;
+	unsigned char s[16],v[SRP_MAX_N_BYTES],v5[SRP_MAX_N_BYTES],x[64];
+	char hex[2*SRP_MAX_N_BYTES+2];
+	size_t olen;
+	int v_len=sizeof(v),v5_len,x_len;
+	mbedtls_mpi X,V;
+
+	mbedtls_mpi_init(&X);
+	mbedtls_mpi_init(&V);
+
+	if (!ses || !cache) goto done;
+	if (srp_create_salted_verification_key2(ses,USERNAME,(const unsigned char*)PASSWORD,strlen(PASSWORD),s,16,v,&v_len)!=0) goto done;
+	for (i=0; i<3; i++) {
+		srp_user_init(&usr,ses,USERNAME,(const unsigned char*)PASSWORD,strlen(PASSWORD));
+		rc=login_once(ses,cache,&usr,s,v,v_len);
+		srp_user_free(&usr);
+		if (rc!=0) goto done;
+	}
+	rc=-1;
+	srp_user_cache_stats(cache,&st);
+	if (st.hits!=2 || st.misses!=1 || st.entries!=1) goto done;
+
+	/* another password is another x: a miss, and the server refuses it */
+	srp_user_init(&usr,ses,USERNAME,(const unsigned char*)"other",5);
+	i=login_once(ses,cache,&usr,s,v,v_len);
+	srp_user_free(&usr);
+	srp_user_cache_stats(cache,&st);
+	if (i==0 || st.misses!=2) goto done;
+
+	/* same N, salt and password but another g: same x, another k*g^x */
+	if (mbedtls_mpi_write_string(srp_session_get_ng(ses)->N,16,hex,sizeof(hex),&olen)!=0) goto done;
+	ses5=srp_session_new(SRP_SHA256,SRP_NG_CUSTOM,hex,"5");
+	if (!ses5 || srp_session_get_ng(ses5)==srp_session_get_ng(ses)) goto done;
+	/* v = 5^x on the first salt; the x is the one cached above */
+	if (srp_calculate_x(ses5,USERNAME,(const unsigned char*)PASSWORD,strlen(PASSWORD),s,16,x,&x_len)!=0) goto done;
+	if (mbedtls_mpi_read_binary(&X,x,x_len)!=0 || mbedtls_mpi_exp_mod(&V,srp_session_get_ng(ses5)->g,&X,srp_session_get_ng(ses5)->N,NULL)!=0) goto done;
+	v5_len=(int)mbedtls_mpi_size(&V);
+	if (mbedtls_mpi_write_binary(&V,v5,v5_len)!=0) goto done;
+	srp_user_init(&usr,ses5,USERNAME,(const unsigned char*)PASSWORD,strlen(PASSWORD));
+	i=login_once(ses5,cache,&usr,s,v5,v5_len);
+	srp_user_free(&usr);
+	srp_user_cache_stats(cache,&st);
+	if (i!=0 || st.misses!=3 || st.hits!=2) goto done;
+
+	/* x in place of the password */
+	if (srp_calculate_x(ses,USERNAME,(const unsigned char*)PASSWORD,strlen(PASSWORD),s,16,x,&x_len)!=0 || x_len!=32) goto done;
+	xusr=srp_user_new_x(ses,USERNAME,x,x_len);
+	if (!xusr || login_once(ses,NULL,xusr,s,v,v_len)!=0) goto done;
+	if (login_once(ses,cache,xusr,s,v,v_len)!=0) goto done;
+	srp_user_cache_stats(cache,&st);
+	if (st.hits!=3) goto done;
+	x[0]^=1;
+	if (srp_user_init_x(&usr,ses,USERNAME,x,x_len)!=0) goto done;
+	i=login_once(ses,NULL,&usr,s,v,v_len);
+	srp_user_free(&usr);
+	if (i==0) goto done;
+	rc=0;
+done:
+	printf ("client cache of k*g^x: %s\n",rc==0?"ok":"FAILED");
+	srp_user_delete(xusr);
+	mbedtls_mpi_free(&X);
+	mbedtls_mpi_free(&V);
+	srp_user_cache_delete(cache);
+	if (ses5) srp_session_delete(ses5);
+	if (ses) srp_session_delete(ses);
+	return rc;
+}
+
+static int test_exponent_bits(void){
+	int rc=-1,i;
+	static const SRP_NGType types[3]={SRP_NG_2048,SRP_NG_4096,SRP_NG_8192};
+	static const int defaults[3]={256,320,400};
+	SRPSession *ses=NULL,*other=NULL;
+	NGConstant *mine=NULL,*shared=NULL;
+	SRPUser usr;
+	unsigned char s[16],v[SRP_MAX_N_BYTES];
+	int v_len=sizeof(v);
+
+	for (i=0; i<3; i++) {
+		NGConstant *ng=srp_ng_new(types[i],NULL,NULL);
+		int bits=srp_ng_get_exponent_bits(ng);
+		srp_ng_delete(ng);
+		if (bits!=defaults[i]) goto done;
+	}
+	ses=srp_session_new(SRP_SHA256,SRP_NG_1024,NULL,NULL);
+	other=srp_session_new(SRP_SHA1,SRP_NG_1024,NULL,NULL);
+	if (!ses || !other || srp_session_get_exponent_bits(ses)!=256) goto done;
+	if (srp_session_set_exponent_bits(ses,64)==0 || srp_session_set_exponent_bits(ses,1024)==0) goto done;
+	if (srp_session_set_exponent_bits(ses,190)!=0 || srp_session_get_exponent_bits(ses)!=192) goto done;
+	/* the group and the other session on it keep the default */
+	if (srp_session_get_exponent_bits(other)!=256 || srp_ng_get_exponent_bits(srp_session_get_ng(ses))!=256) goto done;
+	if (srp_ng_set_exponent_bits(srp_session_get_ng(ses),192)==0) goto done;
+	/* a group nobody shares can be tuned, and leaves the registry */
+	mine=srp_ng_new_private(SRP_NG_1024,NULL,NULL);
+	if (!mine || srp_ng_set_exponent_bits(mine,320)!=0 || srp_ng_get_exponent_bits(mine)!=320) goto done;
+	/* nor once it has been handed out, in or out of the registry */
+	srp_ng_new1(mine);
+	i=srp_ng_set_exponent_bits(mine,384);
+	srp_ng_delete(mine);
+	if (i==0 || srp_ng_get_exponent_bits(mine)!=320) goto done;
+	shared=srp_ng_new(SRP_NG_1024,NULL,NULL);
+	if (shared==mine || srp_ng_get_exponent_bits(shared)!=256) goto done;
+	/* a handshake still works; SRP_TEST fixes a and b, so their size is not checked here */
+	if (srp_create_salted_verification_key2(ses,USERNAME,(const unsigned char*)PASSWORD,strlen(PASSWORD),s,16,v,&v_len)!=0) goto done;
+	if (srp_user_init(&usr,ses,USERNAME,(const unsigned char*)PASSWORD,strlen(PASSWORD))!=0) goto done;
+	i=usr.exp_bits==192 ? login_once(ses,NULL,&usr,s,v,v_len) : -1;
+	srp_user_free(&usr);
+	if (i!=0) goto done;
+	rc=0;
+done:
+	printf ("private exponent size: %s\n",rc==0?"ok":"FAILED");
+	srp_ng_delete(mine);
+	srp_ng_delete(shared);
+	if (ses) srp_session_delete(ses);
+	if (other) srp_session_delete(other);
+	return rc;
+}
+
+/* every Montgomery kernel that fits the group against mbedtls_mpi_exp_mod() */
+static int test_mont_kernels(SRP_NGType ng_type){
+	static const char *names[5]={"adx","2048","3072","4096","any"};
+	int rc=-1,i,k,tried=0;
+	NGConstant *ng=srp_ng_new_private(ng_type,NULL,NULL),*shared=NULL;
+	const char *kernel;
+	mbedtls_mpi A,e,S1,S2;
+
+	mbedtls_mpi_init(&A); mbedtls_mpi_init(&e); mbedtls_mpi_init(&S1); mbedtls_mpi_init(&S2);
+	if (!ng || !srp_ng_precomp(ng,SRP_SHA512)) goto done;
+	/* the standard sizes get a specialized kernel on their own */
+	kernel=srp_ng_mont_kernel(ng);
+	if (!kernel) goto done;
+	if ((ng_type==SRP_NG_2048 || ng_type==SRP_NG_3072 || ng_type==SRP_NG_4096) && strcmp(kernel,"any")==0) goto done;
+
+	for (k=0; k<5; k++) {
+		if (srp_ng_set_mont_kernel(ng,names[k])!=0) continue;
+		tried++;
+		for (i=0; i<3; i++) {
+			/* N-1 carries through every limb */
+			srp_fill_random(&A,mbedtls_mpi_size(ng->N));
+			if (i==2) mbedtls_mpi_sub_int(&A,ng->N,1);
+			srp_fill_random(&e,mbedtls_mpi_size(ng->N));
+			mbedtls_mpi_exp_mod(&S1,&A,&e,ng->N,NULL);
+			if (srp_ng_exp_mod(ng,&S2,&A,&e)!=0) goto done;
+			if (mbedtls_mpi_cmp_mpi(&S1,&S2)!=0) goto done;
+		}
+	}
+	if (tried==0) goto done;
+	/* a kernel is never forced on a group that others hold, private or not */
+	srp_ng_new1(ng);
+	i=srp_ng_set_mont_kernel(ng,"any");
+	srp_ng_delete(ng);
+	if (i==0) goto done;
+	shared=srp_ng_new(ng_type,NULL,NULL);
+	if (!shared || shared==ng) goto done;
+	srp_ng_new1(shared);
+	i=srp_ng_set_mont_kernel(shared,"any");
+	srp_ng_delete(shared);
+	if (i==0) goto done;
+	rc=0;
+done:
+	printf ("montgomery kernels for group %d: %s\n",ng_type,rc==0?"ok":"MISMATCH");
+	mbedtls_mpi_free(&A); mbedtls_mpi_free(&e); mbedtls_mpi_free(&S1); mbedtls_mpi_free(&S2);
+	if (ng) srp_ng_delete(ng);
+	srp_ng_delete(shared);
+	return rc;
+}
+
+static void *ng_churn(void *arg){
+	int i;
+	(void)arg;
+	for (i=0; i<2000; i++) {
+		NGConstant *ng=srp_ng_new(SRP_NG_1024,NULL,NULL);
+		NGConstant *ng2=srp_ng_new1(ng);
+		srp_ng_delete(ng);
+		srp_ng_delete(ng2);
+	}
+	return NULL;
+}
+
+/* groups with the same N and g are one shared object */
+static int test_ng_registry(void){
+	int rc=-1,i;
+	char hex[2*SRP_MAX_N_BYTES+2];
+	size_t olen;
+	pthread_t th[4];
+	SRPSession *ses=srp_session_new(SRP_SHA256,SRP_NG_2048,NULL,NULL);
+	NGConstant *ng=srp_ng_new(SRP_NG_2048,NULL,NULL),*custom=NULL,*other=NULL;
+	SRPUser *usr=NULL;
+
+	if (!ses || !ng || ng!=srp_session_get_ng(ses)) goto done;
+	if (mbedtls_mpi_write_string(ng->N,16,hex,sizeof(hex),&olen)!=0) goto done;
+	custom=srp_ng_new(SRP_NG_CUSTOM,hex,"2");
+	other=srp_ng_new(SRP_NG_CUSTOM,hex,"5");
+	if (custom!=ng || !other || other==ng) goto done;
+	if (srp_ng_new(SRP_NG_CUSTOM,"xyz","2")!=NULL) goto done;
+	usr=srp_user_new(ses,USERNAME,(const unsigned char*)PASSWORD,strlen(PASSWORD));
+	if (!usr || usr->ng!=ng) goto done;
+	for (i=0; i<4; i++) pthread_create(&th[i],NULL,ng_churn,NULL);
+	for (i=0; i<4; i++) pthread_join(th[i],NULL);
+	rc=0;
+done:
+	printf ("group registry: %s\n",rc==0?"ok":"FAILED");
+	if (usr) srp_user_delete(usr);
+	srp_ng_delete(other);
+	srp_ng_delete(custom);
+	srp_ng_delete(ng);
+	if (ses) srp_session_delete(ses);
+	return rc;
+}
+
+/* the constants srp_groups.h ships for the built-in groups, recomputed with mbedtls */
+static int test_builtin_groups(void){
+	static const int bits[SRP_NG_CUSTOM]={512,768,1024,2048,3072,4096,8192};
+	static const int gens[SRP_NG_CUSTOM]={2,2,2,2,5,5,19};
+	int rc=-1,t;
+	size_t n,k;
+	mbedtls_mpi T;
+
+	mbedtls_mpi_init(&T);
+	for (t=SRP_NG_512; t<SRP_NG_CUSTOM; t++) {
+		NGConstant *ng=srp_ng_new((SRP_NGType)t,NULL,NULL);
+		int ok=0;
+		if (!ng) goto done;
+		n=ng->N->n;
+		if (mbedtls_mpi_bitlen(ng->N)==(size_t)bits[t] && mbedtls_mpi_cmp_int(ng->g,gens[t])==0 &&
+		    srp_ng_size(ng)==bits[t]/8 && ng->mont && ng->mont->n==n &&
+		    ng->N->p[0]*ng->mont->mm==(mbedtls_mpi_uint)0-1) {
+			mbedtls_mpi_lset(&T,1);
+			mbedtls_mpi_shift_l(&T,n*8*sizeof(mbedtls_mpi_uint));
+			mbedtls_mpi_mod_mpi(&T,&T,ng->N);
+			for (k=0, ok=1; k<n; k++) ok &= ng->mont->one[k]==(k<T.n ? T.p[k] : 0);
+			mbedtls_mpi_lset(&T,1);
+			mbedtls_mpi_shift_l(&T,2*n*8*sizeof(mbedtls_mpi_uint));
+			mbedtls_mpi_mod_mpi(&T,&T,ng->N);
+			ok &= mbedtls_mpi_cmp_mpi(&T,&ng->RR)==0;
+			for (k=0; k<n; k++) ok &= ng->mont->RR[k]==(k<T.n ? T.p[k] : 0);
+		}
+		srp_ng_delete(ng);
+		if (!ok) goto done;
+	}
+	rc=0;
+done:
+	printf ("built-in group constants: %s\n",rc==0?"ok":"MISMATCH");
+	mbedtls_mpi_free(&T);
+	return rc;
+}
+
+/* a table for g written to a file, mapped back, and refused once damaged */
+static int test_table_file(void){
+	int rc=-1,fd;
+	char path[]="/tmp/srp_table_XXXXXX";
+	NGConstant *ng=srp_ng_new(SRP_NG_1024,NULL,NULL),*other=srp_ng_new(SRP_NG_2048,NULL,NULL);
+	SRPFixedBase *fb=NULL,*now;
+	mbedtls_mpi E,X1,X2;
+	FILE *f;
+
+	mbedtls_mpi_init(&E); mbedtls_mpi_init(&X1); mbedtls_mpi_init(&X2);
+	fd=mkstemp(path);
+	if (fd<0 || !ng || !other) goto done;
+	close(fd);
+	if (srp_ng_precompute_g(ng,5,0)!=0 || srp_ng_save_tables(ng,path)!=0) goto done;
+	srp_ng_delete(ng);
+	ng=srp_ng_new(SRP_NG_1024,NULL,NULL);
+	if (!ng || srp_ng_load_tables(ng,path)!=0) goto done;
+	fb=srp_ng_gtab_get(ng);
+	if (!fb || !fb->unmap || fb->w!=5) goto done;
+	srp_fill_random(&E,32);
+	if (srp_ng_exp_g(ng,&X1,&E)!=0) goto done;
+	mbedtls_mpi_exp_mod(&X2,ng->g,&E,ng->N,NULL);
+	if (mbedtls_mpi_cmp_mpi(&X1,&X2)!=0) goto done;
+	if (srp_ng_load_tables(other,path)==0) goto done;
+
+	f=fopen(path,"r+b");
+	if (!f || fseek(f,4096+100,SEEK_SET)!=0 || fputc(0x5a,f)==EOF) goto done;
+	fclose(f);
+	if (srp_ng_load_tables(ng,path)==0) goto done;
+	now=srp_ng_gtab_get(ng);
+	srp_ng_table_release(now);
+	if (now!=fb) goto done;
+	rc=0;
+done:
+	printf ("table file: %s\n",rc==0?"ok":"FAILED");
+	srp_ng_table_release(fb);
+	mbedtls_mpi_free(&E); mbedtls_mpi_free(&X1); mbedtls_mpi_free(&X2);
+	srp_ng_delete(ng);
+	srp_ng_delete(other);
+	remove(path);
+	return rc;
+}
+
+/* records from a text stream, enrolled on two threads, come out in order and match single calls */
+#define ENROLL_N 130
+typedef struct EnrollOut {
+	int n;
+	int bad;
+	unsigned char v[ENROLL_N][64];
+	int v_len[ENROLL_N];
+} EnrollOut;
+
+static int enroll_write(void *ctx,const char *username,const unsigned char *s,int s_len,const unsigned char *v,int v_len){
+	EnrollOut *out=(EnrollOut*)ctx;
+	char name[16];
+
+	sprintf(name,"u%d",out->n);
+	if (out->n>=ENROLL_N || strcmp(username,name)!=0 || s_len!=16 || v_len>64) {
+		out->bad++;
+		return -1;
+	}
+	memcpy(out->v[out->n],v,v_len);
+	out->v_len[out->n++]=v_len;
+	return 0;
+}
+
+static int test_enroll(void){
+	int rc=-1,i;
+	SRPSession *ses=srp_session_new(SRP_SHA256,SRP_NG_512,NULL,NULL);
+	SRPWorkerPool *pool=srp_worker_pool_new(2);
+	SRPEnrollLines lines;
+	SRPEnrollStats st;
+	static EnrollOut out;
+	SRPFixedBase *fb,*mine=NULL;
+	unsigned char s[16],v[64];
+	char pw[32];
+	int v_len;
+	FILE *f=tmpfile();
+
+	memset(&out,0,sizeof(out));
+	if (!ses || !pool || !f) goto done;
+	fprintf(f,"# comment\n\nno separator\n,empty user\n");
+	for (i=0; i<ENROLL_N; i++) fprintf(f,"u%d,pw,%d%s",i,i,i%2?"\r\n":"\n");
+	rewind(f);
+	srp_enroll_lines_init(&lines,f);
+	/* a table the caller set up stays in place */
+	if (srp_ng_precompute_g(srp_session_get_ng(ses),3,0)!=0) goto done;
+	if (!(mine=srp_ng_gtab_get(srp_session_get_ng(ses)))) goto done;
+	if (srp_enroll(ses,pool,16,srp_enroll_read_line,&lines,enroll_write,&out,NULL,NULL,&st)!=0) goto done;
+	if (out.bad || out.n!=ENROLL_N || st.enrolled!=ENROLL_N || st.failed || lines.skipped!=2) goto done;
+	fb=srp_ng_gtab_get(srp_session_get_ng(ses));
+	if (fb) srp_ng_table_release(fb);
+	if (fb!=mine) goto done;
+	for (i=0; i<ENROLL_N; i+=ENROLL_N/3) {
+		char name[16];
+		sprintf(name,"u%d",i);
+		sprintf(pw,"pw,%d",i);
+		v_len=sizeof(v);
+		if (srp_create_salted_verification_key2(ses,name,(const unsigned char*)pw,strlen(pw),s,16,v,&v_len)!=0) goto done;
+		if (v_len!=out.v_len[i] || memcmp(v,out.v[i],v_len)!=0) goto done;
+	}
+	rc=0;
+done:
+	printf ("enroll %d records on %d threads: %s\n",out.n,srp_worker_pool_size(pool),rc==0?"ok":"FAILED");
+	if (f) fclose(f);
+	if (mine) srp_ng_table_release(mine);
+	srp_worker_pool_delete(pool);
+	if (ses) srp_session_delete(ses);
+	return rc;
+}
+
+/* handshakes on one group while another thread keeps replacing its table for g */
+typedef struct SwapLogin {
+	SRPSession *ses;
+	const unsigned char *s,*v;
+	int v_len;
+	int stop;
+	int failed;
+} SwapLogin;
+
+static void *swap_login(void *arg){
+	SwapLogin *sl=(SwapLogin*)arg;
+	SRPUser usr;
+	int i;
+
+	for (i=0; i<400 && !__atomic_load_n(&sl->stop,__ATOMIC_RELAXED); i++) {
+		srp_user_init(&usr,sl->ses,USERNAME,(const unsigned char*)PASSWORD,strlen(PASSWORD));
+		if (login_once(sl->ses,NULL,&usr,sl->s,sl->v,sl->v_len)!=0) __atomic_add_fetch(&sl->failed,1,__ATOMIC_RELAXED);
+		srp_user_free(&usr);
+	}
+	return NULL;
+}
+
+static int test_gtab_swap(void){
+	int rc=-1,i,v_len;
+	pthread_t th[3];
+	SwapLogin sl;
+	SRPSession *ses=srp_session_new(SRP_SHA256,SRP_NG_1024,NULL,NULL),*other=srp_session_new(SRP_SHA1,SRP_NG_1024,NULL,NULL);
+	unsigned char s[16],v[SRP_MAX_N_BYTES];
+
+	memset(&sl,0,sizeof(sl));
+	v_len=sizeof(v);
+	if (!ses || !other || srp_session_get_ng(ses)!=srp_session_get_ng(other)) goto done;
+	if (srp_create_salted_verification_key2(ses,USERNAME,(const unsigned char*)PASSWORD,strlen(PASSWORD),s,16,v,&v_len)!=0) goto done;
+	sl.ses=ses; sl.s=s; sl.v=v; sl.v_len=v_len;
+	for (i=0; i<3; i++) pthread_create(&th[i],NULL,swap_login,&sl);
+	/* another session on the same group, each call a table of a new shape */
+	for (i=0; i<24; i++) {
+		if (srp_ng_precompute_g(srp_session_get_ng(other),3+i%3,0)!=0) sl.failed++;
+	}
+	__atomic_store_n(&sl.stop,1,__ATOMIC_RELAXED);
+	for (i=0; i<3; i++) pthread_join(th[i],NULL);
+	if (sl.failed==0) rc=0;
+done:
+	printf ("table for g replaced during handshakes: %s\n",rc==0?"ok":"FAILED");
+	if (ses) srp_session_delete(ses);
+	if (other) srp_session_delete(other);
+	return rc;
+}
+
+/* a table file mapped in, again and again, from two threads while handshakes run on the group */
+typedef struct LoadLoop {
+	NGConstant *ng;
+	const char *path;
+	int failed;
+} LoadLoop;
+
+static void *load_loop(void *arg){
+	LoadLoop *ll=(LoadLoop*)arg;
+	int i;
+
+	for (i=0; i<20; i++) {
+		if (srp_ng_load_tables(ll->ng,ll->path)!=0) __atomic_add_fetch(&ll->failed,1,__ATOMIC_RELAXED);
+	}
+	return NULL;
+}
+
+static int test_table_file_concurrent(void){
+	int rc=-1,i,fd,v_len;
+	char path[]="/tmp/srp_table_XXXXXX";
+	pthread_t th[3],ld[2];
+	SwapLogin sl;
+	LoadLoop ll;
+	SRPSession *ses=srp_session_new(SRP_SHA256,SRP_NG_1024,NULL,NULL);
+	unsigned char s[16],v[SRP_MAX_N_BYTES];
+
+	memset(&sl,0,sizeof(sl));
+	memset(&ll,0,sizeof(ll));
+	v_len=sizeof(v);
+	fd=mkstemp(path);
+	if (fd<0 || !ses) goto done;
+	close(fd);
+	ll.ng=srp_session_get_ng(ses);
+	ll.path=path;
+	if (srp_ng_precompute_g(ll.ng,5,0)!=0 || srp_ng_save_tables(ll.ng,path)!=0) goto done;
+	if (srp_create_salted_verification_key2(ses,USERNAME,(const unsigned char*)PASSWORD,strlen(PASSWORD),s,16,v,&v_len)!=0) goto done;
+	sl.ses=ses; sl.s=s; sl.v=v; sl.v_len=v_len;
+	for (i=0; i<3; i++) pthread_create(&th[i],NULL,swap_login,&sl);
+	for (i=0; i<2; i++) pthread_create(&ld[i],NULL,load_loop,&ll);
+	for (i=0; i<2; i++) pthread_join(ld[i],NULL);
+	__atomic_store_n(&sl.stop,1,__ATOMIC_RELAXED);
+	for (i=0; i<3; i++) pthread_join(th[i],NULL);
+	if (sl.failed==0 && ll.failed==0) rc=0;
+done:
+	printf ("table file loaded during handshakes: %s\n",rc==0?"ok":"FAILED");
+	if (ses) srp_session_delete(ses);
+	remove(path);
+	return rc;
+}
+
+/* the batch hashes x for many accounts at once; every v must match the one at a time result */
+static int test_enroll_batch(void){
+	int rc=-1,alg,i,ok;
+	SRPWorkerPool *pool=srp_worker_pool_new(2);
+	SRPEnrollItem items[11];
+	unsigned char s[11][16],v[11][128],s1[16],v1[128],pw[200];
+	char names[11][16];
+	int v_len;
+
+	for (i=0; i<(int)sizeof(pw); i++) pw[i]=(unsigned char)(i*7+1);
+	for (alg=SRP_SHA1; alg<SRP_SHA_LAST; alg++) {
+		SRPSession *ses=srp_session_new((SRP_HashAlgorithm)alg,SRP_NG_1024,NULL,NULL);
+		if (!ses) goto done;
+		memset(items,0,sizeof(items));
+		for (i=0; i<11; i++) {
+			sprintf(names[i],"user%d",i*13);
+			items[i].username=names[i];
+			items[i].password=pw;
+			items[i].len_password=i*19;   /* 0 up to 190 bytes, across block boundaries */
+			items[i].bytes_s=s[i]; items[i].len_s=16;
+			items[i].bytes_v=v[i]; items[i].len_v=sizeof(v[i]);
+		}
+		items[5].username=NULL;
+		ok=srp_create_salted_verification_key_batch(ses,pool,items,11);
+		for (i=0; i<11 && ok==10; i++) {
+			if (i==5) {
+				if (items[i].status==0) ok=-1;
+				continue;
+			}
+			v_len=sizeof(v1);
+			if (items[i].status!=0 || srp_create_salted_verification_key2(ses,names[i],pw,i*19,s1,16,v1,&v_len)!=0
+					|| memcmp(s1,s[i],16)!=0 || v_len!=items[i].len_v || memcmp(v1,v[i],v_len)!=0) ok=-1;
+		}
+		srp_session_delete(ses);
+		if (ok!=10) goto done;
+	}
+	rc=0;
+done:
+	printf ("batch enrollment, %d lanes for SHA-256: %s\n",srp_hash_batch_lanes(SRP_SHA256),rc==0?"ok":"FAILED");
+	srp_worker_pool_delete(pool);
+	return rc;
+}
+
+/* no freed block may still hold a password: the enroll buffers grow and are wiped */
+#define WIPE_MARK "PW-MARK-"
+static int g_unwiped;
+
+static void scan_free(void *p){
+	size_t i,n;
+	if (!p) return;
+	n=malloc_usable_size(p);
+	for (i=0; i+sizeof(WIPE_MARK)-1<=n; i++) {
+		if (memcmp((char*)p+i,WIPE_MARK,sizeof(WIPE_MARK)-1)==0) {
+			g_unwiped=1;
+			break;
+		}
+	}
+	free(p);
+}
+
+typedef struct WipeSrc {
+	int n;
+	char name[16];
+	unsigned char pw[200];
+} WipeSrc;
+
+static int wipe_read(void *ctx,const char **username,const unsigned char **password,int *len_password){
+	WipeSrc *src=(WipeSrc*)ctx;
+	if (src->n==300) return 0;
+	sprintf(src->name,"u%d",src->n++);
+	*username=src->name;
+	*password=src->pw;
+	*len_password=sizeof(src->pw);
+	return 1;
+}
+
+static int wipe_write(void *ctx,const char *username,const unsigned char *bytes_s,int len_s,const unsigned char *bytes_v,int len_v){
+	(void)ctx; (void)username; (void)bytes_s; (void)len_s; (void)bytes_v; (void)len_v;
+	return 0;
+}
+
+static int test_enroll_wipe(void){
+	int rc=-1,i;
+	SRPSession *ses=srp_session_new(SRP_SHA256,SRP_NG_512,NULL,NULL);
+	SRPEnrollStats st;
+	WipeSrc src;
+
+	memset(&src,0,sizeof(src));
+	for (i=0; i+8<=(int)sizeof(src.pw); i+=8) memcpy(src.pw+i,WIPE_MARK,8);
+	/* group constants and the table for g are built before the allocator is swapped */
+	if (!ses || !srp_ng_precomp(srp_session_get_ng(ses),SRP_SHA256) || srp_ng_precompute_g(srp_session_get_ng(ses),0,0)!=0) goto done;
+	g_unwiped=0;
+	srp_set_allocator(calloc,scan_free);
+	i=srp_enroll(ses,NULL,16,wipe_read,&src,wipe_write,NULL,NULL,NULL,&st);
+	srp_set_allocator(NULL,NULL);
+	if (i==0 && st.enrolled==300 && !g_unwiped) rc=0;
+done:
+	printf ("enroll wipes passwords from freed buffers: %s\n",rc==0?"ok":"FAILED");
+	if (ses) srp_session_delete(ses);
+	return rc;
+}
+
 int main(){
 	SRPSession *serv_ses=srp_session_new(SRP_SHA512,SRP_NG_3072, NULL,NULL);
 	printf ("SRPSession created @ %p\n",serv_ses);
@@ -64,5 +1400,37 @@ int main(){
 
 	srp_keypair_delete(server_keys);
 	srp_session_delete(serv_ses);
+
+	for (SRP_NGType t=SRP_NG_512; t<SRP_NG_CUSTOM; t++) {
+		if (test_fixed_base(t)!=0) return -7;
+	}
+	for (SRP_NGType t=SRP_NG_512; t<SRP_NG_CUSTOM; t++) {
+		if (test_multi_exp(t)!=0) return -10;
+	}
+	if (test_keypool()!=0) return -8;
+	if (test_batch()!=0) return -9;
+	if (test_init_api()!=0) return -11;
+	if (test_allocator()!=0) return -12;
+	if (test_store()!=0) return -13;
+	if (test_cache()!=0) return -14;
+	if (test_stats()!=0) return -15;
+	if (test_hash_batch()!=0) return -16;
+	if (test_hash_accel()!=0) return -17;
+	if (test_verifier_job()!=0) return -18;
+	if (test_async()!=0) return -19;
+	if (test_ticket()!=0) return -20;
+	if (test_user_cache()!=0) return -21;
+	if (test_exponent_bits()!=0) return -22;
+	for (SRP_NGType t=SRP_NG_512; t<SRP_NG_CUSTOM; t++) {
+		if (test_mont_kernels(t)!=0) return -23;
+	}
+	if (test_ng_registry()!=0) return -24;
+	if (test_builtin_groups()!=0) return -25;
+	if (test_table_file()!=0) return -26;
+	if (test_enroll()!=0) return -27;
+	if (test_gtab_swap()!=0) return -28;
+	if (test_table_file_concurrent()!=0) return -29;
+	if (test_enroll_batch()!=0) return -30;
+	if (test_enroll_wipe()!=0) return -31;
 	return 0;
 }